@@ -1,3 +1,5 @@
+#pragma once
+
 #include <QByteArray>
 
 namespace Qt515Base64 {
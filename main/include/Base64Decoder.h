@@ -0,0 +1,34 @@
+#ifndef BASE64DECODER_H
+#define BASE64DECODER_H
+
+#include <QByteArray>
+#include <QStringView>
+#include "base64.h"
+
+// Single-pass base64 validation and decoding with SIMD fast paths (AVX2 / SSSE3 on x86,
+// NEON on AArch64) and a scalar fallback. Both the standard and the URL-safe alphabet
+// are accepted, surrounding whitespace is ignored and CR/LF line breaks inside the
+// input are skipped. Anything else is reported through decodingStatus instead of
+// being decoded leniently.
+namespace Base64Decoder {
+    enum class Implementation {
+        Auto,
+        Scalar,
+        Ssse3,
+        Avx2,
+        Neon,
+    };
+
+    Qt515Base64::FromBase64Result Decode(const char *data, qsizetype size);
+    Qt515Base64::FromBase64Result Decode(const QByteArray &input);
+    Qt515Base64::FromBase64Result Decode(QStringView input);
+
+    // Code path used for this CPU ("avx2", "ssse3", "neon" or "scalar")
+    const char *ActiveImplementation();
+    bool IsSupported(Implementation implementation);
+
+    // Pin a code path for tests and benchmarks; false if this CPU cannot run it
+    bool ForceImplementation(Implementation implementation);
+}
+
+#endif // BASE64DECODER_H
@@ -0,0 +1,45 @@
+#ifndef CONFIGDELTA_H
+#define CONFIGDELTA_H
+
+#include <QBitArray>
+#include <QByteArray>
+#include <QHash>
+#include <QVector>
+#include "ConfigStore.h"
+#include "ConfigSnapshot.h"
+
+// Compares freshly collected configs with the previous run's snapshot by identity
+// key. Stores are fed one subscription at a time; whatever the previous snapshot
+// holds that no store matched is reported as removed.
+class ConfigDelta {
+public:
+    struct Counts {
+        qsizetype added = 0;
+        qsizetype unchanged = 0;
+    };
+
+    // previous must stay open while the delta is in use; rows are keyed in
+    // ConfigSnapshot::KeyMode(mode), like the snapshot written from them
+    ConfigDelta(const ConfigSnapshot &previous, Deduplicator::Mode mode);
+
+    // False without a previous snapshot or when it was keyed in another mode;
+    // every config then counts as added
+    bool hasBaseline() const { return m_baseline; }
+
+    // Classify one store's rows; rows not in the previous run go to added
+    Counts compare(const ConfigStore &store, QVector<qsizetype> *added = nullptr);
+
+    // Previous rows no compared store contained
+    QVector<qsizetype> removedRows() const;
+    // Removed rows grouped by their previous source (subscription URL, UTF-8); like
+    // removedRows(), only final once every store has been compared
+    QHash<QByteArray, qsizetype> removedBySource() const;
+
+private:
+    const ConfigSnapshot &m_previous;
+    Deduplicator::Mode m_mode;
+    bool m_baseline;
+    QBitArray m_matched;
+};
+
+#endif // CONFIGDELTA_H
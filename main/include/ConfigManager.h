@@ -21,8 +21,39 @@ public:
         QString workingDirectory;
         int maxConcurrentDownloads;
         int requestTimeout;
+        int runDeadline;        // seconds a run may take; downloads stop deadlineReserve before it. 0 = none
+        int deadlineReserve;    // seconds kept after the download cutoff for dedup, filtering and output
+        int downloadRetries;    // extra attempts after a transient failure (timeout, reset, 408/429/5xx)
+        int retryBaseDelay;     // milliseconds; doubles per attempt, with full jitter
+        int retryMaxDelay;      // milliseconds
+        int circuitBreakerThreshold;    // consecutive transient failures before a host is cut off; 0 = off
+        int circuitBreakerCooldown;     // seconds before a cut-off host is tried again
+        int hedgeDelay;         // milliseconds floor for hedging slow downloads (p95 latency); 0 = off
+        int perHostDownloads;   // downloads in flight per host; 0 = only maxConcurrentDownloads applies
+        bool expandSubscriptions;   // download subscription URLs listed inside subscriptions
+        int maxSubscriptionDepth;   // index levels followed below Sub.txt
+        bool enableSourceHistory;   // order fetches by past yield, back off failing sources (source_history.json)
+        int sourceSkipAfterFailures;    // consecutive failures before a source is skipped; 0 = never skip
+        int sourceMaxSkipRuns;          // longest back-off, in runs
         bool createMissingDirectories;
         bool verboseLogging;
+        bool enableFetchCache;  // conditional GET cache under <dataDirectory>/cache/http
+        bool enableCompression; // negotiate gzip/zstd/br and decode pre-compressed subscription files
+        QString dedupMode;      // proxy identity for deduplication: endpoint, credentials, full or resolved
+        int parseThreads;       // link parsing workers; 0 = one per core, 1 = parse on the ingest thread
+        QString outputShards;   // extra NDJSON shards besides config_NNNN.json: comma-separated "protocol", "country"
+        bool writeLinks;        // links.txt: one canonical share link per config, for the tester
+        bool writeSnapshot;     // binary configs.snapshot next to the JSON output
+        bool incrementalMode;   // added/removed delta files against the previous configs.snapshot
+        bool enableReachabilityFilter;  // drop configs whose endpoint does not answer a TCP/TLS probe
+        int reachabilityConcurrency;    // probes in flight at once
+        int reachabilityPerHost;        // probes in flight per host
+        int reachabilityTimeout;        // per probe, milliseconds
+        bool reachabilityCheckTls;      // TLS handshake (with the config's SNI) for TLS transports
+        int dnsConcurrency;     // server name lookups in flight (resolved dedup / prefilter)
+        int dnsTtl;             // seconds before a resolved name is looked up again
+        int dnsNegativeTtl;     // seconds a failed lookup is remembered
+        bool writeRunReport;    // run_report.json and metrics.prom with per-stage timings
     };
 
     // Load and save configuration
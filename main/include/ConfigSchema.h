@@ -0,0 +1,363 @@
+#ifndef CONFIGSCHEMA_H
+#define CONFIGSCHEMA_H
+
+#include "ProxyBean.h"
+#include "ConfigStore.h"
+#include "Deduplicator.h"
+#include <array>
+#include <initializer_list>
+
+// One declarative field list per bean type. The bean <-> ConfigStore copies, the
+// JSON of beans and rows and the dedup identity key are all generated from it, so
+// adding a field is one line and the representations cannot drift apart. Snapshots
+// store the columns as is and need nothing per type.
+namespace ConfigSchema {
+
+using Field = ConfigStore::Field;
+
+enum class Value : quint8 {
+    Text,       // QString member, string column
+    Number,     // int member, the alterId column
+    Flag,       // bool member, string column holding "1" or ""
+};
+
+enum class Emit : quint8 {
+    Always,
+    IfPresent,  // text: non-empty; number: positive; flag: set
+};
+
+// Which part of the identity key the field belongs to (see Deduplicator::Mode)
+enum class Identity : quint8 {
+    None,
+    Credentials,
+    Transport,
+};
+
+template <typename Bean>
+struct FieldSpec {
+    const char *key;
+    Value value;
+    Field column;
+    Emit emitRule;      // not "emit": Qt defines that as an empty macro
+    Identity identity;
+    QString Bean::*text;
+    int Bean::*number;
+    bool Bean::*flag;
+    ProxyType only;     // written for this kind alone; Unknown for every kind of the bean
+    const char *param;  // share-link query parameter (v2rayN key for VMess); null if not one
+
+    constexpr FieldSpec onlyFor(ProxyType kind) const {
+        FieldSpec spec = *this;
+        spec.only = kind;
+        return spec;
+    }
+
+    constexpr FieldSpec link(const char *name) const {
+        FieldSpec spec = *this;
+        spec.param = name;
+        return spec;
+    }
+};
+
+template <typename Bean>
+constexpr FieldSpec<Bean> Text(const char *key, Field column, QString Bean::*member, Emit emitRule, Identity identity) {
+    return {key, Value::Text, column, emitRule, identity, member, nullptr, nullptr, ProxyType::Unknown, nullptr};
+}
+
+template <typename Bean>
+constexpr FieldSpec<Bean> Number(const char *key, int Bean::*member, Emit emitRule, Identity identity) {
+    return {key, Value::Number, Field::Count, emitRule, identity, nullptr, member, nullptr, ProxyType::Unknown, nullptr};
+}
+
+template <typename Bean>
+constexpr FieldSpec<Bean> Flag(const char *key, Field column, bool Bean::*member) {
+    return {key, Value::Flag, column, Emit::IfPresent, Identity::None, nullptr, nullptr, member, ProxyType::Unknown, nullptr};
+}
+
+// Fields every bean has; type and port are written around them
+inline constexpr FieldSpec<ProxyBean> NameField =
+    Text("name", Field::Name, &ProxyBean::name, Emit::Always, Identity::None);
+inline constexpr FieldSpec<ProxyBean> ServerField =
+    Text("server", Field::Server, &ProxyBean::serverAddress, Emit::Always, Identity::None);
+inline constexpr FieldSpec<ProxyBean> SourceField =
+    Text("source", Field::Source, &ProxyBean::source, Emit::IfPresent, Identity::None);
+
+// Fields in JSON order. Identity fields are hashed credentials first, then
+// transport, each in list order; keys are persisted, so never reorder them.
+// Kind is the type name a bean of the class always writes; Unknown means bean.type.
+// Fields with a link() name are the share-link parameters (see LinkEncoder).
+template <typename Bean>
+struct Schema;
+
+template <>
+struct Schema<VMessBean> {
+    using Bean = VMessBean;
+    static constexpr ProxyType Kind = ProxyType::VMess;
+    static constexpr FieldSpec<Bean> Fields[] = {
+        Text("uuid", Field::Uuid, &Bean::uuid, Emit::Always, Identity::Credentials).link("id"),
+        Number("alterId", &Bean::aid, Emit::Always, Identity::Credentials).link("aid"),
+        Text("cipher", Field::Security, &Bean::security, Emit::Always, Identity::Transport).link("scy"),
+        Text("network", Field::Network, &Bean::network, Emit::Always, Identity::Transport).link("net"),
+        Text("tls", Field::Tls, &Bean::tls, Emit::IfPresent, Identity::Transport).link("tls"),
+        Text("sni", Field::Sni, &Bean::sni, Emit::IfPresent, Identity::Transport).link("sni"),
+        Text("host", Field::Host, &Bean::host, Emit::IfPresent, Identity::Transport).link("host"),
+        Text("path", Field::Path, &Bean::path, Emit::IfPresent, Identity::Transport).link("path"),
+    };
+};
+
+template <>
+struct Schema<ShadowSocksBean> {
+    using Bean = ShadowSocksBean;
+    static constexpr ProxyType Kind = ProxyType::Shadowsocks;
+    static constexpr FieldSpec<Bean> Fields[] = {
+        Text("method", Field::Method, &Bean::method, Emit::Always, Identity::Credentials),
+        Text("password", Field::Password, &Bean::password, Emit::Always, Identity::Credentials),
+    };
+};
+
+template <>
+struct Schema<TrojanVLESSBean> {
+    using Bean = TrojanVLESSBean;
+    static constexpr ProxyType Kind = ProxyType::Unknown;
+    static constexpr FieldSpec<Bean> Fields[] = {
+        Text("password", Field::Password, &Bean::password, Emit::Always, Identity::Credentials),
+        Text("network", Field::Network, &Bean::network, Emit::IfPresent, Identity::Transport).link("type"),
+        Text("security", Field::Security, &Bean::security, Emit::IfPresent, Identity::Transport).link("security"),
+        Text("sni", Field::Sni, &Bean::sni, Emit::IfPresent, Identity::Transport).link("sni"),
+        Text("host", Field::Host, &Bean::host, Emit::IfPresent, Identity::Transport).link("host"),
+        Text("path", Field::Path, &Bean::path, Emit::IfPresent, Identity::Transport).link("path"),
+        // Written for VLESS only, but part of the Trojan identity too
+        Text("flow", Field::Flow, &Bean::flow, Emit::IfPresent, Identity::Transport)
+            .onlyFor(ProxyType::VLESS).link("flow"),
+    };
+};
+
+template <>
+struct Schema<SocksHttpBean> {
+    using Bean = SocksHttpBean;
+    static constexpr ProxyType Kind = ProxyType::Unknown;
+    static constexpr FieldSpec<Bean> Fields[] = {
+        Text("username", Field::Username, &Bean::username, Emit::IfPresent, Identity::Credentials),
+        Text("password", Field::Password, &Bean::password, Emit::IfPresent, Identity::Credentials),
+    };
+};
+
+template <>
+struct Schema<Hysteria2Bean> {
+    using Bean = Hysteria2Bean;
+    static constexpr ProxyType Kind = ProxyType::Hysteria2;
+    static constexpr FieldSpec<Bean> Fields[] = {
+        Text("password", Field::Password, &Bean::password, Emit::Always, Identity::Credentials),
+        Text("sni", Field::Sni, &Bean::sni, Emit::IfPresent, Identity::Transport).link("sni"),
+        Text("obfs", Field::Obfs, &Bean::obfs, Emit::IfPresent, Identity::Transport).link("obfs"),
+        Text("obfs_param", Field::ObfsParam, &Bean::obfsPassword, Emit::IfPresent, Identity::Transport)
+            .link("obfs-password"),
+        Flag("insecure", Field::Insecure, &Bean::insecure).link("insecure"),
+    };
+};
+
+template <>
+struct Schema<TuicBean> {
+    using Bean = TuicBean;
+    static constexpr ProxyType Kind = ProxyType::Tuic;
+    static constexpr FieldSpec<Bean> Fields[] = {
+        Text("uuid", Field::Uuid, &Bean::uuid, Emit::Always, Identity::Credentials),
+        Text("password", Field::Password, &Bean::password, Emit::Always, Identity::Credentials),
+        Text("congestion_control", Field::CongestionControl, &Bean::congestionControl, Emit::IfPresent,
+             Identity::Transport).link("congestion_control"),
+        Text("udp_relay_mode", Field::UdpRelayMode, &Bean::udpRelayMode, Emit::IfPresent, Identity::Transport)
+            .link("udp_relay_mode"),
+        Text("alpn", Field::Alpn, &Bean::alpn, Emit::IfPresent, Identity::Transport).link("alpn"),
+        Text("sni", Field::Sni, &Bean::sni, Emit::IfPresent, Identity::Transport).link("sni"),
+        Flag("insecure", Field::Insecure, &Bean::insecure).link("allow_insecure"),
+    };
+};
+
+template <>
+struct Schema<ShadowSocksRBean> {
+    using Bean = ShadowSocksRBean;
+    static constexpr ProxyType Kind = ProxyType::ShadowsocksR;
+    static constexpr FieldSpec<Bean> Fields[] = {
+        Text("method", Field::Method, &Bean::method, Emit::Always, Identity::Credentials),
+        Text("password", Field::Password, &Bean::password, Emit::Always, Identity::Credentials),
+        Text("protocol", Field::Protocol, &Bean::protocol, Emit::Always, Identity::Credentials),
+        Text("protocol_param", Field::ProtocolParam, &Bean::protocolParam, Emit::IfPresent, Identity::Transport)
+            .link("protoparam"),
+        Text("obfs", Field::Obfs, &Bean::obfs, Emit::Always, Identity::Credentials),
+        Text("obfs_param", Field::ObfsParam, &Bean::obfsParam, Emit::IfPresent, Identity::Transport).link("obfsparam"),
+    };
+};
+
+template <>
+struct Schema<WireGuardBean> {
+    using Bean = WireGuardBean;
+    static constexpr ProxyType Kind = ProxyType::WireGuard;
+    static constexpr FieldSpec<Bean> Fields[] = {
+        Text("private_key", Field::Password, &Bean::privateKey, Emit::Always, Identity::Credentials),
+        Text("public_key", Field::PublicKey, &Bean::publicKey, Emit::Always, Identity::Credentials).link("publickey"),
+        Text("pre_shared_key", Field::PreSharedKey, &Bean::preSharedKey, Emit::IfPresent, Identity::Credentials)
+            .link("presharedkey"),
+        Text("address", Field::LocalAddress, &Bean::localAddress, Emit::IfPresent, Identity::Transport).link("address"),
+        Text("reserved", Field::Reserved, &Bean::reserved, Emit::IfPresent, Identity::Transport).link("reserved"),
+        Number("mtu", &Bean::mtu, Emit::IfPresent, Identity::None).link("mtu"),
+    };
+};
+
+// Just the common fields, for kinds without a bean class
+struct CommonSchema {
+    static constexpr std::array<FieldSpec<ProxyBean>, 0> Fields{};
+};
+
+// Calls fn(Schema<Bean>()) for the bean class that holds the kind; false for Unknown
+template <typename Fn>
+bool Dispatch(ProxyType kind, Fn &&fn) {
+    switch (kind) {
+    case ProxyType::VMess: fn(Schema<VMessBean>()); return true;
+    case ProxyType::Shadowsocks: fn(Schema<ShadowSocksBean>()); return true;
+    case ProxyType::Trojan:
+    case ProxyType::VLESS: fn(Schema<TrojanVLESSBean>()); return true;
+    case ProxyType::Socks:
+    case ProxyType::Http: fn(Schema<SocksHttpBean>()); return true;
+    case ProxyType::Hysteria2: fn(Schema<Hysteria2Bean>()); return true;
+    case ProxyType::Tuic: fn(Schema<TuicBean>()); return true;
+    case ProxyType::ShadowsocksR: fn(Schema<ShadowSocksRBean>()); return true;
+    case ProxyType::WireGuard: fn(Schema<WireGuardBean>()); return true;
+    case ProxyType::Unknown: break;
+    }
+    return false;
+}
+
+// Field access for the generated code, from a bean...
+template <typename Bean>
+class BeanFields {
+public:
+    explicit BeanFields(const Bean &bean) : m_bean(bean) {}
+
+    int port() const { return m_bean.serverPort; }
+
+    template <typename B>
+    bool isEmpty(const FieldSpec<B> &spec) const { return (m_bean.*spec.text).isEmpty(); }
+    template <typename B>
+    void writeText(JsonFieldVisitor &visitor, const FieldSpec<B> &spec) const {
+        visitor.text(spec.key, m_bean.*spec.text);
+    }
+    template <typename B>
+    void hashText(IdentityHasher &hasher, const FieldSpec<B> &spec) const { hasher.add(m_bean.*spec.text); }
+    template <typename B>
+    qint64 number(const FieldSpec<B> &spec) const { return m_bean.*spec.number; }
+    template <typename B>
+    bool flag(const FieldSpec<B> &spec) const { return m_bean.*spec.flag; }
+
+    // Text column by id, for layouts that are not a field list (share links)
+    QByteArray utf8(Field column) const {
+        for (const FieldSpec<ProxyBean> *common : {&NameField, &ServerField, &SourceField}) {
+            if (common->column == column) {
+                return (m_bean.*common->text).toUtf8();
+            }
+        }
+        for (const auto &spec : Schema<Bean>::Fields) {
+            if (spec.value == Value::Text && spec.column == column) {
+                return (m_bean.*spec.text).toUtf8();
+            }
+        }
+        return QByteArray();
+    }
+
+private:
+    const Bean &m_bean;
+};
+
+// ...or from a store row, without converting its UTF-8
+class RowFields {
+public:
+    RowFields(const ConfigStore &store, qsizetype row) : m_store(store), m_row(row) {}
+
+    int port() const { return m_store.port(m_row); }
+
+    template <typename B>
+    bool isEmpty(const FieldSpec<B> &spec) const { return m_store.field(m_row, spec.column).isEmpty(); }
+    template <typename B>
+    void writeText(JsonFieldVisitor &visitor, const FieldSpec<B> &spec) const {
+        visitor.string(spec.key, m_store.field(m_row, spec.column));
+    }
+    template <typename B>
+    void hashText(IdentityHasher &hasher, const FieldSpec<B> &spec) const {
+        hasher.addUtf8(m_store.field(m_row, spec.column));
+    }
+    template <typename B>
+    qint64 number(const FieldSpec<B> &) const { return m_store.alterId(m_row); }
+    template <typename B>
+    bool flag(const FieldSpec<B> &spec) const { return !isEmpty(spec); }
+
+    QByteArrayView utf8(Field column) const { return m_store.field(m_row, column); }
+
+private:
+    const ConfigStore &m_store;
+    qsizetype m_row;
+};
+
+template <typename Fields, typename B>
+void WriteField(const Fields &fields, const FieldSpec<B> &spec, ProxyType kind, JsonFieldVisitor &visitor) {
+    if (spec.only != ProxyType::Unknown && spec.only != kind) {
+        return;
+    }
+    switch (spec.value) {
+    case Value::Text:
+        if (spec.emitRule == Emit::Always || !fields.isEmpty(spec)) {
+            fields.writeText(visitor, spec);
+        }
+        break;
+    case Value::Number: {
+        const qint64 number = fields.number(spec);
+        if (spec.emitRule == Emit::Always || number > 0) {
+            visitor.number(spec.key, number);
+        }
+        break;
+    }
+    case Value::Flag: {
+        const bool flag = fields.flag(spec);
+        if (spec.emitRule == Emit::Always || flag) {
+            visitor.boolean(spec.key, flag);
+        }
+        break;
+    }
+    }
+}
+
+// type, name, server, port, the schema's fields, source
+template <typename S, typename Fields>
+void VisitJson(const Fields &fields, ProxyType kind, JsonFieldVisitor &visitor) {
+    visitor.string("type", ProxyTypeName(kind));
+    WriteField(fields, NameField, kind, visitor);
+    WriteField(fields, ServerField, kind, visitor);
+    visitor.number("port", fields.port());
+    for (const auto &spec : S::Fields) {
+        WriteField(fields, spec, kind, visitor);
+    }
+    WriteField(fields, SourceField, kind, visitor);
+}
+
+// The schema's part of the identity key; type, server and port are hashed by the caller
+template <typename S, typename Fields>
+void Hash(const Fields &fields, Identity part, IdentityHasher &hasher) {
+    for (const auto &spec : S::Fields) {
+        if (spec.identity != part) {
+            continue;
+        }
+        switch (spec.value) {
+        case Value::Text:
+            fields.hashText(hasher, spec);
+            break;
+        case Value::Number:
+            hasher.add(fields.number(spec));
+            break;
+        case Value::Flag:
+            hasher.add(qint64(fields.flag(spec)));
+            break;
+        }
+    }
+}
+
+} // namespace ConfigSchema
+
+#endif // CONFIGSCHEMA_H
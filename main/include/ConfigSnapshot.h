@@ -0,0 +1,79 @@
+#ifndef CONFIGSNAPSHOT_H
+#define CONFIGSNAPSHOT_H
+
+#include <QByteArrayView>
+#include <QFile>
+#include <QList>
+#include <QString>
+#include "ConfigStore.h"
+#include "Deduplicator.h"
+
+// Versioned binary image of a collected config set:
+//
+//   header | records | string refs | string bytes | hash index
+//
+// Records are fixed size and refer to strings by id, exactly like ConfigStore's
+// columns; the index maps identity keys to records. All integers are little-endian.
+// A loaded snapshot is a read-only mapping of the file: opening it costs a header
+// check, and every accessor reads straight from the mapped bytes.
+class ConfigSnapshot {
+public:
+    static constexpr quint32 FormatVersion = 2;
+
+    ConfigSnapshot() = default;
+    ~ConfigSnapshot();
+    ConfigSnapshot(const ConfigSnapshot &) = delete;
+    ConfigSnapshot &operator=(const ConfigSnapshot &) = delete;
+
+    // Write the rows of all stores in order; keys are computed in KeyMode(mode),
+    // which is also what mode() reads back
+    static bool Write(const QString &path, const QList<const ConfigStore*> &stores,
+                      Deduplicator::Mode mode, QString *error = nullptr);
+
+    // Mode a set deduplicated in mode is keyed by on disk. Resolved addresses are
+    // only valid for the run that looked them up, so resolved sets are keyed by
+    // server name (endpoint) and DNS churn does not read as added/removed configs
+    static Deduplicator::Mode KeyMode(Deduplicator::Mode mode);
+
+    bool open(const QString &path);
+    void close();
+    bool isOpen() const { return m_data != nullptr; }
+    QString errorString() const { return m_error; }
+
+    qsizetype size() const { return m_count; }
+    Deduplicator::Mode mode() const { return m_mode; }
+
+    ConfigStore::Kind kind(qsizetype row) const;
+    int port(qsizetype row) const;
+    int alterId(qsizetype row) const;
+    quint64 identityKey(qsizetype row) const;
+    // Points into the mapping; valid until close()
+    QByteArrayView field(qsizetype row, ConfigStore::Field field) const;
+
+    // Row with this identity key, or -1
+    qsizetype find(quint64 key) const;
+    bool contains(quint64 key) const { return find(key) >= 0; }
+
+    // Copy rows into a store (e.g. to merge with freshly parsed configs)
+    qsizetype appendRowTo(ConfigStore &store, qsizetype row) const;
+    void appendTo(ConfigStore &store) const;
+
+private:
+    bool fail(const QString &error);
+    const uchar *record(qsizetype row) const;
+
+    QFile m_file;
+    const uchar *m_data = nullptr;
+    qsizetype m_count = 0;
+    qsizetype m_stringCount = 0;
+    qsizetype m_indexCapacity = 0;
+    const uchar *m_records = nullptr;
+    const uchar *m_stringRefs = nullptr;
+    const uchar *m_stringBytes = nullptr;
+    qsizetype m_stringBytesSize = 0;
+    const uchar *m_index = nullptr;
+    Deduplicator::Mode m_mode = Deduplicator::Mode::Endpoint;
+    QString m_error;
+};
+
+#endif // CONFIGSNAPSHOT_H
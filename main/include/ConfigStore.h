@@ -0,0 +1,182 @@
+#ifndef CONFIGSTORE_H
+#define CONFIGSTORE_H
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QMultiHash>
+#include <QVector>
+#include <QString>
+#include <QJsonObject>
+#include <array>
+#include <functional>
+#include <memory>
+#include "ProxyBean.h"
+#include "Deduplicator.h"
+
+class ConfigStore;
+
+// Read-only view of one stored config; invalidated by any change to the store
+class ConfigRecord {
+public:
+    ConfigRecord(const ConfigStore *store, qsizetype row) : m_store(store), m_row(row) {}
+
+    qsizetype row() const { return m_row; }
+    const ConfigStore &store() const { return *m_store; }
+
+    int port() const;
+    QByteArrayView server() const;
+    QByteArrayView source() const;
+    QString typeName() const;
+
+private:
+    const ConfigStore *m_store;
+    qsizetype m_row;
+};
+
+// Receives the JSON fields of one row in output order (see ConfigStore::visitJson)
+class JsonFieldVisitor {
+public:
+    virtual ~JsonFieldVisitor() = default;
+    virtual void string(const char *key, QByteArrayView utf8) = 0;
+    virtual void number(const char *key, qint64 value) = 0;
+    virtual void boolean(const char *key, bool value) = 0;
+    // Bean fields; visitors that keep QStrings can skip the UTF-8 round trip
+    virtual void text(const char *key, const QString &value) { string(key, value.toUtf8()); }
+};
+
+// Collects the fields into a QJsonObject (ConfigStore::toJson, ProxyBean::ToJson)
+class JsonObjectBuilder : public JsonFieldVisitor {
+public:
+    QJsonObject object;
+
+    void string(const char *key, QByteArrayView utf8) override { object[key] = QString::fromUtf8(utf8); }
+    void number(const char *key, qint64 value) override { object[key] = value; }
+    void boolean(const char *key, bool value) override { object[key] = value; }
+    void text(const char *key, const QString &value) override { object[key] = value; }
+};
+
+// Columnar storage for parsed configs. Every string is interned once as UTF-8 in a
+// single arena and rows hold 32-bit string ids, one column per field, so a million
+// configs cost a few flat arrays instead of a shared_ptr and a dozen QStrings each.
+// Beans and JSON are only materialized on request.
+class ConfigStore {
+public:
+    using Kind = ProxyType;
+
+    enum class Field : quint8 {
+        Name,
+        Server,
+        Source,
+        Uuid,
+        Password,
+        Method,
+        Username,
+        Network,
+        Security,
+        Tls,
+        Sni,
+        Host,
+        Path,
+        Flow,
+        Protocol,           // ShadowsocksR
+        ProtocolParam,
+        Obfs,               // ShadowsocksR, Hysteria2
+        ObfsParam,
+        Alpn,               // TUIC
+        CongestionControl,
+        UdpRelayMode,
+        PublicKey,          // WireGuard; the private key is Password
+        PreSharedKey,
+        LocalAddress,
+        Reserved,
+        Insecure,           // "1" when certificate checks are off (Hysteria2, TUIC)
+        Count
+    };
+
+    ConfigStore();
+
+    // Copy the bean's fields in; -1 for a bean type the store has no kind for
+    qsizetype append(const ProxyBean &bean);
+    // Copy a row from another columnar source (a snapshot, another store)
+    qsizetype append(Kind kind, int port, int alterId,
+                     const std::array<QByteArrayView, size_t(Field::Count)> &fields);
+    void reserve(qsizetype rows);
+    void clear();
+
+    qsizetype size() const { return m_kinds.size(); }
+    bool isEmpty() const { return m_kinds.isEmpty(); }
+
+    Kind kind(qsizetype row) const { return Kind(m_kinds[row]); }
+    int port(qsizetype row) const { return m_ports[row]; }
+    // VMess alterId; WireGuard MTU
+    int alterId(qsizetype row) const { return m_alterIds[row]; }
+    // UTF-8 bytes inside the arena; valid until the next append()
+    QByteArrayView field(qsizetype row, Field field) const;
+    QString fieldString(qsizetype row, Field field) const;
+    QString typeName(qsizetype row) const { return KindName(kind(row)); }
+
+    // Materialize a row
+    std::shared_ptr<ProxyBean> bean(qsizetype row) const;
+    QJsonObject toJson(qsizetype row) const;
+    // The fields toJson() would produce, without building a QJsonObject
+    void visitJson(qsizetype row, JsonFieldVisitor &visitor) const;
+
+    // Same value as Deduplicator::IdentityKey() on the equivalent bean
+    quint64 identityKey(qsizetype row, Deduplicator::Mode mode, const DnsCache *resolver = nullptr) const;
+
+    // Drop rows in place, keeping the order of the rest; returns the number removed
+    qsizetype removeIf(const std::function<bool(const ConfigRecord &record)> &predicate);
+    // Drop rows the deduplicator has seen before (recording the others)
+    qsizetype deduplicate(Deduplicator &dedup);
+
+    // Bytes held by the arena and the columns
+    qsizetype memoryUsage() const;
+    qsizetype uniqueStrings() const { return m_strings.size(); }
+
+    static QString KindName(Kind kind);
+    static bool KindFromName(QStringView name, Kind &kind);
+
+    class const_iterator {
+    public:
+        const_iterator(const ConfigStore *store, qsizetype row) : m_store(store), m_row(row) {}
+        ConfigRecord operator*() const { return ConfigRecord(m_store, m_row); }
+        const_iterator &operator++() { ++m_row; return *this; }
+        bool operator==(const const_iterator &other) const { return m_row == other.m_row; }
+        bool operator!=(const const_iterator &other) const { return m_row != other.m_row; }
+
+    private:
+        const ConfigStore *m_store;
+        qsizetype m_row;
+    };
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, size()); }
+
+private:
+    struct StringRef {
+        quint32 offset = 0;
+        quint32 length = 0;
+    };
+
+    quint32 intern(QStringView text);
+    quint32 internUtf8(QByteArrayView utf8);
+    void setField(Field field, QStringView text);
+    QByteArrayView stringAt(quint32 id) const;
+
+    QByteArray m_arena;
+    QVector<StringRef> m_strings;               // id -> arena slice; id 0 is ""
+    QMultiHash<size_t, quint32> m_internIndex;  // hash of the bytes -> ids
+    QByteArray m_scratch;                       // UTF-8 conversion buffer
+
+    QVector<quint8> m_kinds;
+    QVector<qint32> m_ports;
+    QVector<qint32> m_alterIds;
+    std::array<QVector<quint32>, size_t(Field::Count)> m_fields;
+};
+
+inline int ConfigRecord::port() const { return m_store->port(m_row); }
+inline QByteArrayView ConfigRecord::server() const { return m_store->field(m_row, ConfigStore::Field::Server); }
+inline QByteArrayView ConfigRecord::source() const { return m_store->field(m_row, ConfigStore::Field::Source); }
+inline QString ConfigRecord::typeName() const { return m_store->typeName(m_row); }
+
+#endif // CONFIGSTORE_H
@@ -0,0 +1,57 @@
+#ifndef CONFIGWRITER_H
+#define CONFIGWRITER_H
+
+#include <QByteArray>
+#include <QString>
+#include <QSet>
+#include <memory>
+#include "ConfigStore.h"
+
+class QSaveFile;
+
+// Streams configs to disk as JSON text without building a QJsonDocument. Each
+// config is serialized straight into a small buffer that is flushed to the file
+// whenever it fills, so memory stays flat no matter how many configs are written.
+// Output is replaced atomically on commit(); an uncommitted writer leaves the old file.
+// The Links format writes canonical share links instead (see LinkEncoder).
+class ConfigWriter {
+public:
+    enum class Format {
+        JsonDocument,   // {"subscription": "...", "configs": [ {...}, {...} ]}
+        Ndjson,         // one config object per line
+        Links           // one share link per line, each link once
+    };
+
+    explicit ConfigWriter(Format format, qsizetype bufferSize = 64 * 1024);
+    ~ConfigWriter();
+
+    // subscription is only used by JsonDocument
+    bool open(const QString &path, const QString &subscription = QString());
+    bool write(const ConfigStore &store, qsizetype row);
+    bool write(const ProxyBean &bean);
+    bool commit();
+
+    Format format() const { return m_format; }
+    qsizetype count() const { return m_count; }
+    QString errorString() const { return m_error; }
+
+    // JSON string literal (with quotes) for UTF-8 text
+    static void AppendString(QByteArray &out, QByteArrayView utf8);
+
+private:
+    void beginObject();
+    void endObject();
+    bool writeLink(const QByteArray &link);
+    bool flush();
+    bool fail(const QString &error);
+
+    Format m_format;
+    qsizetype m_bufferSize;
+    std::unique_ptr<QSaveFile> m_file;
+    QByteArray m_buffer;
+    qsizetype m_count = 0;
+    QSet<QByteArray> m_links;   // Links: written so far
+    QString m_error;
+};
+
+#endif // CONFIGWRITER_H
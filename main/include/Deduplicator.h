@@ -0,0 +1,98 @@
+#ifndef DEDUPLICATOR_H
+#define DEDUPLICATOR_H
+
+#include <QString>
+#include <QStringView>
+#include <QByteArrayView>
+#include <QVector>
+#include "ProxyBean.h"
+
+class DnsCache;
+
+// Open-addressing set of 64-bit keys (linear probing, power-of-two capacity).
+// Zero marks an empty slot, so callers never see it as a key value.
+class HashSet64 {
+public:
+    explicit HashSet64(qsizetype expected = 0);
+
+    // True if key was not present before
+    bool insert(quint64 key);
+    bool contains(quint64 key) const;
+
+    void reserve(qsizetype expected);
+    void clear();
+    qsizetype size() const { return m_size; }
+    qsizetype capacity() const { return m_slots.size(); }
+
+private:
+    static quint64 normalized(quint64 key) { return key ? key : 1; }
+    void rehash(qsizetype capacity);
+
+    QVector<quint64> m_slots;
+    qsizetype m_size = 0;
+};
+
+// Incremental 64-bit hash over identity fields. Stable across runs and platforms,
+// so keys can be persisted.
+class IdentityHasher {
+public:
+    void add(QStringView field);
+    void addHost(QStringView host);  // ASCII case-insensitive
+    void add(qint64 value);
+
+    // UTF-8 fields hash exactly like the same text passed as QStringView
+    void addUtf8(QByteArrayView field);
+    void addHostUtf8(QByteArrayView host);
+
+    quint64 result() const;
+
+private:
+    void mix(quint64 word);
+    template <typename Unit> void addUnits(const Unit *data, qsizetype size);
+
+    quint64 m_hash = 0x6a09e667f3bcc908ULL;
+    quint64 m_length = 0;
+};
+
+// Drops proxies that were already seen. What counts as "the same proxy" is set by
+// the mode; display names never take part.
+class Deduplicator {
+public:
+    enum class Mode {
+        Endpoint,       // type + server + port
+        Credentials,    // endpoint + uuid / password / method / user
+        Full,           // credentials + transport (network, TLS, SNI, host, path, flow)
+        Resolved,       // type + resolved server address + port (needs a DnsCache)
+    };
+
+    explicit Deduplicator(Mode mode = Mode::Endpoint, qsizetype expected = 0);
+
+    // Record the bean; false if an identical one was inserted before
+    bool insert(const ProxyBean &bean);
+    bool contains(const ProxyBean &bean) const;
+    // Same for a key computed elsewhere (for example by ConfigStore)
+    bool insertKey(quint64 key) { return m_seen.insert(key); }
+
+    Mode mode() const { return m_mode; }
+    qsizetype size() const { return m_seen.size(); }
+    void reserve(qsizetype expected) { m_seen.reserve(expected); }
+    void clear() { m_seen.clear(); }
+
+    // Resolved mode hashes the server's canonical address; names the resolver has no
+    // answer for (or no resolver at all) fall back to the name itself
+    void setResolver(const DnsCache *resolver) { m_resolver = resolver; }
+    const DnsCache *resolver() const { return m_resolver; }
+
+    static quint64 IdentityKey(const ProxyBean &bean, Mode mode, const DnsCache *resolver = nullptr);
+
+    // "endpoint", "credentials", "full" or "resolved"; false for anything else
+    static bool ParseMode(const QString &name, Mode &mode);
+    static QString ModeName(Mode mode);
+
+private:
+    Mode m_mode;
+    const DnsCache *m_resolver = nullptr;
+    HashSet64 m_seen;
+};
+
+#endif // DEDUPLICATOR_H
@@ -0,0 +1,90 @@
+#ifndef DNSCACHE_H
+#define DNSCACHE_H
+
+#include <QString>
+#include <QHash>
+#include <QQueue>
+#include <QList>
+#include <QHostAddress>
+#include <QDeadlineTimer>
+#include <functional>
+#include <memory>
+
+class QObject;
+
+// Resolver cache shared by everything that needs a server's address in one run.
+// Each name is looked up once with an asynchronous QHostInfo query; at most
+// maxConcurrent queries are outstanding, answers are kept for the TTL and failures
+// for the (shorter) negative TTL. An expired answer is still served until its
+// refresh arrives, so a slow run never loses names it has already resolved.
+// IP literals never hit the resolver.
+class DnsCache {
+public:
+    struct Options {
+        int maxConcurrent = 32;
+        int ttlMs = 5 * 60 * 1000;
+        int negativeTtlMs = 60 * 1000;
+    };
+
+    enum class Status {
+        Unknown,    // never queued, or its first lookup is still pending
+        Resolved,
+        Failed
+    };
+
+    DnsCache();
+    explicit DnsCache(const Options &options);
+    ~DnsCache();
+
+    DnsCache(const DnsCache&) = delete;
+    DnsCache& operator=(const DnsCache&) = delete;
+
+    // Queue a lookup unless the name has a fresh entry; answers arrive on the event loop,
+    // so lookups overlap with whatever else the loop is doing (e.g. downloads)
+    void prefetch(const QString &host);
+    // Refresh every expired answer, then block in a local event loop until every
+    // queued lookup has finished
+    void run();
+
+    Status status(const QString &host) const;
+    QList<QHostAddress> addresses(const QString &host) const;
+    // Lowest resolved address (IPv4 first) as text, stable however the resolver orders
+    // its answers; empty unless resolved
+    QString canonicalAddress(const QString &host) const;
+
+    qsizetype size() const { return m_entries.size(); }
+    int lookups() const { return m_lookups; }
+    int failures() const { return m_failures; }
+    // Resolver time summed over lookups; they overlap, so this can exceed wall time
+    qint64 lookupNs() const { return m_lookupNs; }
+    int pending() const { return int(m_queue.size()) + m_active; }
+
+    static QString NormalizedHost(const QString &host);
+
+private:
+    struct Entry {
+        QList<QHostAddress> addresses;
+        QString canonical;
+        bool failed = false;
+        bool answered = false;  // a lookup has finished; addresses/failed hold its result
+        bool pending = false;
+        QDeadlineTimer expires;
+    };
+
+    const Entry *answeredEntry(const QString &key) const;
+    void queue(const QString &key, Entry &entry);
+    void startNext();
+    void finished(const QString &key, const QList<QHostAddress> &addresses, bool failed);
+
+    Options m_options;
+    std::unique_ptr<QObject> m_context;     // receiver for QHostInfo callbacks
+    QHash<QString, Entry> m_entries;
+    QQueue<QString> m_queue;
+    int m_active = 0;
+    int m_lookups = 0;
+    int m_failures = 0;
+    qint64 m_lookupNs = 0;
+    std::function<void()> m_idleCallback;
+};
+
+#endif // DNSCACHE_H
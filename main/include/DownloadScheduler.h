@@ -0,0 +1,156 @@
+#ifndef DOWNLOADSCHEDULER_H
+#define DOWNLOADSCHEDULER_H
+
+#include <QString>
+#include <QStringList>
+#include <QQueue>
+#include <QHash>
+#include <QElapsedTimer>
+#include <QDeadlineTimer>
+#include <functional>
+#include <memory>
+#include "HttpHelper.h"
+#include "RetryPolicy.h"
+#include "StreamDecompressor.h"
+
+class QObject;
+class QNetworkReply;
+class QSaveFile;
+class FetchCache;
+
+// Asynchronous subscription downloader. All requests go through one shared
+// HttpHelper client and at most maxConcurrent jobs are in flight at once; each
+// result is handed to the finished handler as soon as it is final. Transient
+// failures can be retried with backoff, hosts that keep failing are cut off by a
+// circuit breaker, and a job slow to answer can be hedged with a second request.
+class DownloadScheduler {
+public:
+    using FinishedHandler = std::function<void(int id, const QString &url, const HttpResponse &response)>;
+    using ChunkHandler = std::function<void(int id, const QByteArray &chunk)>;
+    using RestartHandler = std::function<void(int id)>;
+
+    DownloadScheduler(int maxConcurrent, int timeoutMs, HttpHelper &client = HttpHelper::shared());
+    ~DownloadScheduler();
+
+    DownloadScheduler(const DownloadScheduler&) = delete;
+    DownloadScheduler& operator=(const DownloadScheduler&) = delete;
+
+    // Queue a URL and return its job id (ids are assigned in enqueue order); may be
+    // called while run() is active
+    int enqueue(const QString &url);
+    void onFinished(FinishedHandler handler) { m_finishedHandler = std::move(handler); }
+
+    // Stream bodies instead of buffering them: successful response data is passed to
+    // the chunk handler as it arrives and HttpResponse::data stays empty
+    void onChunk(ChunkHandler handler) { m_chunkHandler = std::move(handler); }
+
+    // Called when a job that already streamed chunks starts over (retry); the
+    // consumer must drop what it received so far
+    void onRestart(RestartHandler handler) { m_restartHandler = std::move(handler); }
+
+    // Revalidate against cached copies; a 304 is answered from the cache
+    void setCache(FetchCache *cache) { m_cache = cache; }
+
+    void setRetryPolicy(const RetryPolicy &policy) { m_retryPolicy = policy; }
+    void setCircuitBreaker(const CircuitBreaker::Options &options) { m_breaker = CircuitBreaker(options); }
+    // Send a duplicate request when a job has no response headers after the recent
+    // p95 latency (at least minDelayMs) and keep whichever answers first; 0 disables
+    void setHedgeDelay(int minDelayMs) { m_hedgeDelayMs = minDelayMs; }
+    // Jobs in flight per host; queued jobs for a busy host let later ones for other
+    // hosts go first. 0 disables the cap.
+    void setPerHostLimit(int limit) { m_perHostLimit = limit; }
+
+    // Decode compressed bodies before they reach the handlers: Content-Encoding
+    // negotiated for every format the build supports, and pre-compressed files
+    // (.gz, .zst, .br, or gzip/zstd magic bytes). Handlers and the cache see plain text.
+    void setDecompression(bool enabled) { m_decompress = enabled; }
+
+    // Jobs still running, queued or waiting for a retry when the deadline passes are
+    // cancelled and finished with HttpResponse::cancelled set; chunks streamed before
+    // stay delivered. Later run() calls cancel whatever was queued since.
+    void setDeadline(QDeadlineTimer deadline) { m_deadline = deadline; }
+    // Cancel everything now, the same way
+    void cancelAll(const QString &reason);
+
+    // Start queued jobs and block in a local event loop until all have finished
+    void run();
+
+    int maxConcurrent() const { return m_maxConcurrent; }
+    int inFlight() const { return m_attempts.size(); }
+    // Queued jobs, including those waiting out a retry delay
+    int pending() const { return int(m_queue.size() + m_delayed.size()); }
+
+    int retries() const { return m_retries; }
+    int hedges() const { return m_hedges; }
+    int hedgeWins() const { return m_hedgeWins; }
+    int rejected() const { return m_rejected; }     // failed fast on an open circuit
+    int cancelled() const { return m_cancelled; }
+    const CircuitBreaker &circuitBreaker() const { return m_breaker; }
+
+private:
+    struct Job {
+        int id = 0;
+        QString url;
+        bool conditional = false;   // request carried cache validators
+        bool bypassCache = false;   // cached body turned out unusable, fetch in full
+        qint64 bytesStreamed = 0;
+        std::shared_ptr<QSaveFile> cacheBody;  // streamed copy for FetchCache
+        QElapsedTimer started;
+        qint64 sentNs = -1;
+        qint64 headersNs = -1;
+        int attempt = 1;
+        bool hedge = false;         // the duplicate request of a hedged pair
+        qint64 transferBytes = 0;
+        std::shared_ptr<StreamDecompressor> decoder;
+        QString decodeError;
+    };
+
+    void startNext();
+    int jobsInFlight(const QString &host) const;
+    QNetworkReply *launch(Job job);
+    void startHedge(int id, int attempt);
+    // The reply answered first; abort the other request of a hedged pair
+    void commit(QNetworkReply *reply);
+    void abortAttempts(int id, QNetworkReply *except = nullptr);
+    void finishRejected(const Job &job, const QString &host);
+    void finishCancelled(const Job &job, const QString &reason);
+    void handleReadyRead(QNetworkReply *reply);
+    // Hand decoded body bytes to the cache and the chunk handler
+    void deliver(Job &job, QNetworkReply *reply, const QByteArray &chunk);
+    StreamDecompressor::Format bodyFormat(QNetworkReply *reply, const Job &job) const;
+    bool negotiatesEncoding() const;
+    void handleFinished(QNetworkReply *reply);
+    bool isSuccessfulBody(QNetworkReply *reply) const;
+    void notifyIfIdle();
+
+    HttpHelper &m_client;
+    FetchCache *m_cache = nullptr;
+    int m_maxConcurrent;
+    int m_timeoutMs;
+    int m_nextId = 0;
+    QQueue<Job> m_queue;
+    QHash<QNetworkReply*, Job> m_inFlight;
+    QHash<int, QList<QNetworkReply*>> m_attempts;   // job id -> its running requests
+    FinishedHandler m_finishedHandler;
+    ChunkHandler m_chunkHandler;
+    RestartHandler m_restartHandler;
+    std::function<void()> m_idleCallback;
+
+    RetryPolicy m_retryPolicy;
+    CircuitBreaker m_breaker{CircuitBreaker::Options{0, 0}};
+    LatencyEstimator m_latency;
+    int m_hedgeDelayMs = 0;
+    int m_perHostLimit = 0;
+    bool m_decompress = false;
+    QRandomGenerator m_rng{QRandomGenerator::securelySeeded()};
+    std::unique_ptr<QObject> m_context;     // receiver for retry and hedge timers
+    QDeadlineTimer m_deadline{QDeadlineTimer::Forever};
+    QHash<int, Job> m_delayed;      // retries waiting out their backoff, by job id
+    int m_retries = 0;
+    int m_hedges = 0;
+    int m_hedgeWins = 0;
+    int m_rejected = 0;
+    int m_cancelled = 0;
+};
+
+#endif // DOWNLOADSCHEDULER_H
@@ -0,0 +1,58 @@
+#ifndef FETCHCACHE_H
+#define FETCHCACHE_H
+
+#include <QString>
+#include <QByteArray>
+#include "HttpHelper.h"
+#include <functional>
+#include <memory>
+
+class QSaveFile;
+
+// On-disk conditional GET cache for subscription fetches. For every URL it keeps the
+// last body together with its ETag / Last-Modified validators, so an unchanged feed
+// costs one 304 revalidation instead of a full download.
+class FetchCache {
+public:
+    struct Entry {
+        QString url;
+        QByteArray etag;
+        QByteArray lastModified;
+        QString storedAt;
+        qint64 size = 0;
+
+        bool isValid() const { return !url.isEmpty(); }
+        bool hasValidators() const { return !etag.isEmpty() || !lastModified.isEmpty(); }
+    };
+
+    explicit FetchCache(const QString &directory = defaultDirectory());
+
+    // <dataDirectory>/cache/http
+    static QString defaultDirectory();
+    QString directory() const { return m_directory; }
+
+    // Lookup and validators
+    Entry lookup(const QString &url) const;
+    static void addValidators(const Entry &entry, HttpRequestOptions &options);
+
+    // Body storage (written atomically, metadata last)
+    bool loadBody(const QString &url, QByteArray &body) const;
+    bool store(const QString &url, const QByteArray &etag, const QByteArray &lastModified, const QByteArray &body);
+    bool remove(const QString &url);
+
+    // Streaming variants: write the body chunk by chunk and commit once complete,
+    // or replay a cached body in chunks without loading it whole
+    std::unique_ptr<QSaveFile> beginBody(const QString &url);
+    bool commitBody(const QString &url, const QByteArray &etag, const QByteArray &lastModified,
+                    QSaveFile &body);
+    bool readBody(const QString &url, const std::function<void(const QByteArray &chunk)> &sink,
+                  qint64 chunkSize = 256 * 1024) const;
+
+private:
+    QString entryPath(const QString &url, const QString &suffix) const;
+    bool writeMeta(const QString &url, const QByteArray &etag, const QByteArray &lastModified, qint64 size);
+
+    QString m_directory;
+};
+
+#endif // FETCHCACHE_H
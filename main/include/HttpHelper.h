@@ -3,15 +3,79 @@
 
 #include <QString>
 #include <QByteArray>
+#include <QList>
+#include <QPair>
+#include <QPointer>
+
+class QNetworkAccessManager;
+class QNetworkReply;
+class QNetworkRequest;
 
 struct HttpResponse {
     QString error;
     QByteArray data;
+    int statusCode = 0;
+    qint64 bytesReceived = 0;  // body size, also counted when the body was streamed
+    qint64 transferBytes = 0;  // body bytes as received, before DownloadScheduler decompressed them
+
+    // Cache validators returned by the server
+    QByteArray etag;
+    QByteArray lastModified;
+    bool notModified = false;  // 304 to a conditional request
+    bool fromCache = false;    // data was served from FetchCache
+    bool transient = false;    // failure worth retrying: timeout, reset, 408/429/5xx
+    int attempts = 1;          // requests DownloadScheduler made, retries included
+    bool hedged = false;       // body came from a hedged duplicate request
+    bool cancelled = false;    // cut off by DownloadScheduler's deadline; streamed chunks are a prefix
+
+    // Request phases in nanoseconds since the request was issued; -1 where not observed
+    // (only DownloadScheduler records them). Qt resolves the host inside the connect,
+    // so connectNs covers lookup, TCP and TLS, and is near zero on a reused connection.
+    qint64 connectNs = -1;     // until the request went out
+    qint64 ttfbNs = -1;        // until the response headers arrived
+    qint64 totalNs = -1;       // until the body was complete
 };
 
+// Per-request options; timeoutMs <= 0 means ConfigManager's requestTimeout
+struct HttpRequestOptions {
+    int timeoutMs = 0;
+    QList<QPair<QByteArray, QByteArray>> headers;
+};
+
+// Long-lived HTTP client. One QNetworkAccessManager is kept for the lifetime of the
+// client so DNS results, keep-alive connections, HTTP/2 sessions and TLS sessions
+// are reused across requests to the same host.
 class HttpHelper {
 public:
+    HttpHelper();
+    ~HttpHelper();
+
+    HttpHelper(const HttpHelper&) = delete;
+    HttpHelper& operator=(const HttpHelper&) = delete;
+
+    // Process-wide client shared by the scheduler and the static helpers
+    static HttpHelper& shared();
+
+    // Asynchronous GET; the caller owns the reply and must deleteLater() it
+    QNetworkReply* get(const QString &url, const HttpRequestOptions &options = HttpRequestOptions());
+
+    // Blocking GET through this client's connection pool
+    HttpResponse fetch(const QString &url, const HttpRequestOptions &options = HttpRequestOptions());
+
+    QNetworkAccessManager* manager();
+
+    // Build the request used by get(), with HTTP/2 and TLS session reuse enabled
+    static QNetworkRequest buildRequest(const QString &url, const HttpRequestOptions &options);
+    static HttpResponse responseFromReply(QNetworkReply *reply);
+    // QNetworkReply::NetworkError and HTTP status of a failed reply; true if a retry may succeed
+    static bool IsTransient(int networkError, int statusCode);
+    static int defaultTimeout();
+
+    // Legacy blocking helper, now a thin wrapper around shared()
     static HttpResponse HttpGet(const QString &url);
+
+private:
+    QPointer<QNetworkAccessManager> m_manager;
 };
 
-#endif // HTTPHELPER_H
\ No newline at end of file
+#endif // HTTPHELPER_H
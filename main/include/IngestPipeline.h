@@ -0,0 +1,89 @@
+#ifndef INGESTPIPELINE_H
+#define INGESTPIPELINE_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include "HttpHelper.h"
+#include "RingBuffer.h"
+
+class QThread;
+
+// Moves decoding, parsing and storing off the download event loop. The event loop
+// (fetch) posts messages into a bounded lock-free SPSC ring and one ingest thread hands
+// them to the handler in order, which decodes, parses (fanning out to the parse
+// pool) and stores. A full ring makes the poster wait, so a parse stage that falls
+// behind slows the downloads instead of queueing their bodies in memory. Small
+// download chunks are coalesced per subscription to amortize the hand-off.
+class IngestPipeline {
+public:
+    struct Message {
+        enum class Type : quint8 {
+            Chunk,      // data: next part of the body
+            Restart,    // the download starts over (retry)
+            Finished,   // text: URL, response: final result
+            LocalFile,  // text: path of a local dump
+            Stop
+        };
+
+        Type type = Type::Chunk;
+        int id = -1;
+        QByteArray data;
+        QString text;
+        HttpResponse response;
+    };
+
+    using Handler = std::function<void(Message &message)>;
+
+    static constexpr qsizetype DefaultCapacity = 256;
+    static constexpr qsizetype DefaultChunkBytes = 64 * 1024;
+
+    explicit IngestPipeline(qsizetype capacity = DefaultCapacity, qsizetype chunkBytes = DefaultChunkBytes);
+    ~IngestPipeline();
+
+    IngestPipeline(const IngestPipeline&) = delete;
+    IngestPipeline& operator=(const IngestPipeline&) = delete;
+
+    // Runs on the ingest thread; set before start()
+    void onMessage(Handler handler) { m_handler = std::move(handler); }
+    void start();
+
+    // Posting side; all from the same thread
+    void chunk(int id, const QByteArray &data);
+    void restart(int id);
+    void finished(int id, const QString &url, const HttpResponse &response);
+    void localFile(int id, const QString &path);
+    // Flush and wait until the handler has seen every message posted so far,
+    // running postBack() tasks meanwhile; the thread keeps running
+    void sync();
+    // Same, then stop the thread
+    void finish();
+
+    // Ingest thread: run task on the posting thread the next time it posts or finishes
+    void postBack(std::function<void()> task);
+
+    qint64 messages() const { return m_messages; }
+    // Posts that had to wait for a full ring
+    qint64 stalls() const { return m_stalls; }
+
+private:
+    void post(Message &&message);
+    void flush(int id);
+    void runPostedBack();
+    void run();
+
+    Handler m_handler;
+    qsizetype m_chunkBytes;
+    SpscRing<Message> m_inbox;
+    SpscRing<std::function<void()>> m_outbox;
+    QHash<int, QByteArray> m_pending;       // coalesced chunks, posting thread only
+    std::unique_ptr<QThread> m_thread;
+    qint64 m_messages = 0;
+    std::atomic<qint64> m_handled{0};
+    qint64 m_stalls = 0;
+};
+
+#endif // INGESTPIPELINE_H
@@ -0,0 +1,28 @@
+#ifndef LINKENCODER_H
+#define LINKENCODER_H
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include "ProxyType.h"
+
+class ProxyBean;
+class ConfigStore;
+
+// Canonical share links, from a bean or straight from a store row. Only fields a
+// bean keeps are encoded, so unknown and tracking query parameters are gone; the
+// parameters come sorted by name and every value and the name are percent-encoded
+// the same way. Equal configs give byte-identical links that the bean parsers read
+// back unchanged.
+namespace LinkEncoder {
+    // Empty for an Unknown type or a config without a server
+    QByteArray Encode(const ProxyBean &bean);
+    QByteArray Encode(const ConfigStore &store, qsizetype row);
+
+    // "vmess", "ss", "ssr", ...; empty for Unknown
+    const char *Scheme(ProxyType type);
+
+    // RFC 3986: everything but unreserved characters as %XX
+    void AppendPercentEncoded(QByteArray &out, QByteArrayView utf8);
+}
+
+#endif // LINKENCODER_H
@@ -0,0 +1,53 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <QFile>
+#include <QString>
+#include <QByteArrayView>
+
+// Read-only, memory-mapped view of a local file handed out as lines or blocks of
+// whole lines. Only a window of the file is mapped at a time, so files larger than
+// RAM (or the address space) can be read; the window slides forward and grows when
+// a single line does not fit. Views stay valid until the next read or close.
+class MappedFile {
+public:
+    static constexpr qint64 DefaultWindow = 64 * 1024 * 1024;
+
+    explicit MappedFile(qint64 windowSize = DefaultWindow);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const QString &path);
+    void close();
+
+    qint64 size() const { return m_size; }
+    qint64 position() const { return m_position; }
+    bool atEnd() const { return m_position >= m_size; }
+    // Set when open() or a read failed; a clean end of file leaves it empty
+    QString errorString() const { return m_error; }
+
+    // Next line without its "\n" or "\r\n"; false at the end or on error
+    bool readLine(QByteArrayView &line);
+    // Whole lines up to the window size (one longer line on its own), line breaks
+    // included; the last block may end without one
+    bool readBlock(QByteArrayView &block);
+
+private:
+    // Make [m_position, ...) mapped; grows the window when the line at m_position
+    // already starts the mapping
+    bool advanceWindow(bool grow);
+    bool fail(const QString &error);
+
+    QFile m_file;
+    qint64 m_window;
+    uchar *m_map = nullptr;
+    qint64 m_mapOffset = 0;
+    qint64 m_mapLength = 0;
+    qint64 m_size = 0;
+    qint64 m_position = 0;
+    QString m_error;
+};
+
+#endif // MAPPEDFILE_H
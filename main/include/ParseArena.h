@@ -0,0 +1,90 @@
+#ifndef PARSEARENA_H
+#define PARSEARENA_H
+
+#include <memory>
+#include <memory_resource>
+
+// Bump allocator for the objects one parse batch creates. While a Scope is active
+// on a thread, ParseArena::Make places the bean and its shared_ptr control block in
+// one monotonic arena instead of a malloc/free pair each, so parse workers stop
+// contending in the global allocator. Every allocation holds a reference to its
+// arena, which is released as a whole once the last bean from it is gone. Qt
+// members (QString, QByteArray) keep using Qt's allocator.
+class ParseArena {
+public:
+    static constexpr size_t DefaultInitialBytes = 64 * 1024;
+    // Serial parsing switches to a fresh arena after this many bytes, so a long
+    // stream never pins more than one arena's worth of freed beans
+    static constexpr size_t RotateBytes = 1024 * 1024;
+
+    explicit ParseArena(size_t initialBytes = DefaultInitialBytes)
+        : m_resource(initialBytes) {
+    }
+
+    ParseArena(const ParseArena&) = delete;
+    ParseArena& operator=(const ParseArena&) = delete;
+
+    // Owner thread only (the one holding the Scope)
+    void *allocate(size_t bytes, size_t alignment) {
+        m_bytes += bytes;
+        return m_resource.allocate(bytes, alignment);
+    }
+
+    size_t bytesAllocated() const { return m_bytes; }
+
+    // std::allocate_shared allocator; deallocation is a no-op
+    template <typename T>
+    class Allocator {
+    public:
+        using value_type = T;
+
+        explicit Allocator(std::shared_ptr<ParseArena> arena) : m_arena(std::move(arena)) {}
+        template <typename U>
+        Allocator(const Allocator<U> &other) : m_arena(other.m_arena) {}
+
+        T *allocate(size_t n) { return static_cast<T*>(m_arena->allocate(n * sizeof(T), alignof(T))); }
+        void deallocate(T *, size_t) {}
+
+        template <typename U>
+        bool operator==(const Allocator<U> &other) const { return m_arena == other.m_arena; }
+        template <typename U>
+        bool operator!=(const Allocator<U> &other) const { return m_arena != other.m_arena; }
+
+    private:
+        template <typename U> friend class Allocator;
+        std::shared_ptr<ParseArena> m_arena;
+    };
+
+    // Makes the arena current on this thread; scopes nest
+    class Scope {
+    public:
+        explicit Scope(std::shared_ptr<ParseArena> arena);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        std::shared_ptr<ParseArena> m_arena;
+        const std::shared_ptr<ParseArena> *m_previous;
+    };
+
+    // From the current arena, or std::make_shared outside any scope
+    template <typename T>
+    static std::shared_ptr<T> Make() {
+        if (t_current && *t_current) {
+            return std::allocate_shared<T>(Allocator<T>(*t_current));
+        }
+        return std::make_shared<T>();
+    }
+
+    static std::shared_ptr<ParseArena> Current() { return t_current ? *t_current : nullptr; }
+
+private:
+    std::pmr::monotonic_buffer_resource m_resource;
+    size_t m_bytes = 0;
+
+    static thread_local const std::shared_ptr<ParseArena> *t_current;
+};
+
+#endif // PARSEARENA_H
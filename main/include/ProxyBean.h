@@ -3,10 +3,14 @@
 
 #include <QString>
 #include <QJsonObject>
+#include "ProxyType.h"
+
+class IdentityHasher;
+class JsonFieldVisitor;
 
 class ProxyBean {
 public:
-    QString type;
+    ProxyType type = ProxyType::Unknown;
     QString name;
     QString serverAddress;
     int serverPort = 0;
@@ -14,11 +18,22 @@ public:
 
     virtual ~ProxyBean() = default;
     virtual bool TryParseLink(const QString &link) = 0;
-    virtual QJsonObject ToJson() = 0;
+
+    // Generated from the type's field list in ConfigSchema.h, like ConfigStore's rows
+    virtual void visitJson(JsonFieldVisitor &visitor) const = 0;
+    QJsonObject ToJson() const;
+    // Canonical share link (see LinkEncoder); empty for an Unknown type
+    QString ToLink() const;
+
+    // Identity fields beyond type/server/port, used by Deduplicator
+    virtual void HashCredentials(IdentityHasher &) const {}
+    virtual void HashTransport(IdentityHasher &) const {}
 };
 
 class VMessBean : public ProxyBean {
 public:
+    VMessBean() { type = ProxyType::VMess; }
+
     QString uuid;
     int aid = 0;
     QString security = "auto";
@@ -29,18 +44,24 @@ public:
     QString path = "";
 
     bool TryParseLink(const QString &link) override;
-    QJsonObject ToJson() override;
+    void visitJson(JsonFieldVisitor &visitor) const override;
+    void HashCredentials(IdentityHasher &hasher) const override;
+    void HashTransport(IdentityHasher &hasher) const override;
 };
 
 class ShadowSocksBean : public ProxyBean {
 public:
+    ShadowSocksBean() { type = ProxyType::Shadowsocks; }
+
     QString method;
     QString password;
 
     bool TryParseLink(const QString &link) override;
-    QJsonObject ToJson() override;
+    void visitJson(JsonFieldVisitor &visitor) const override;
+    void HashCredentials(IdentityHasher &hasher) const override;
 };
 
+// Trojan or VLESS; type is set by TryParseLink or by hand
 class TrojanVLESSBean : public ProxyBean {
 public:
     QString password;
@@ -52,16 +73,88 @@ public:
     QString path = "";
 
     bool TryParseLink(const QString &link) override;
-    QJsonObject ToJson() override;
+    void visitJson(JsonFieldVisitor &visitor) const override;
+    void HashCredentials(IdentityHasher &hasher) const override;
+    void HashTransport(IdentityHasher &hasher) const override;
 };
 
+// Socks or Http; type is set by TryParseLink or by hand
 class SocksHttpBean : public ProxyBean {
 public:
     QString username;
     QString password;
 
     bool TryParseLink(const QString &link) override;
-    QJsonObject ToJson() override;
+    void visitJson(JsonFieldVisitor &visitor) const override;
+    void HashCredentials(IdentityHasher &hasher) const override;
+};
+
+class Hysteria2Bean : public ProxyBean {
+public:
+    Hysteria2Bean() { type = ProxyType::Hysteria2; }
+
+    QString password;           // auth; "user:password" for userpass auth
+    QString sni = "";
+    QString obfs = "";          // "salamander" or empty
+    QString obfsPassword = "";
+    bool insecure = false;
+
+    bool TryParseLink(const QString &link) override;
+    void visitJson(JsonFieldVisitor &visitor) const override;
+    void HashCredentials(IdentityHasher &hasher) const override;
+    void HashTransport(IdentityHasher &hasher) const override;
+};
+
+class TuicBean : public ProxyBean {
+public:
+    TuicBean() { type = ProxyType::Tuic; }
+
+    QString uuid;
+    QString password;
+    QString congestionControl = "";
+    QString udpRelayMode = "";
+    QString alpn = "";
+    QString sni = "";
+    bool insecure = false;
+
+    bool TryParseLink(const QString &link) override;
+    void visitJson(JsonFieldVisitor &visitor) const override;
+    void HashCredentials(IdentityHasher &hasher) const override;
+    void HashTransport(IdentityHasher &hasher) const override;
+};
+
+class ShadowSocksRBean : public ProxyBean {
+public:
+    ShadowSocksRBean() { type = ProxyType::ShadowsocksR; }
+
+    QString method;
+    QString password;
+    QString protocol = "origin";
+    QString protocolParam = "";
+    QString obfs = "plain";
+    QString obfsParam = "";
+
+    bool TryParseLink(const QString &link) override;
+    void visitJson(JsonFieldVisitor &visitor) const override;
+    void HashCredentials(IdentityHasher &hasher) const override;
+    void HashTransport(IdentityHasher &hasher) const override;
+};
+
+class WireGuardBean : public ProxyBean {
+public:
+    WireGuardBean() { type = ProxyType::WireGuard; }
+
+    QString privateKey;
+    QString publicKey;          // the peer's
+    QString preSharedKey = "";
+    QString localAddress = "";  // interface addresses, comma separated
+    QString reserved = "";
+    int mtu = 0;
+
+    bool TryParseLink(const QString &link) override;
+    void visitJson(JsonFieldVisitor &visitor) const override;
+    void HashCredentials(IdentityHasher &hasher) const override;
+    void HashTransport(IdentityHasher &hasher) const override;
 };
 
 #endif // PROXYBEAN_H
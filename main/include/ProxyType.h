@@ -0,0 +1,149 @@
+#ifndef PROXYTYPE_H
+#define PROXYTYPE_H
+
+#include <QtGlobal>
+#include <QStringView>
+#include <QByteArrayView>
+
+// Protocol of a proxy. The values are stored in ConfigStore columns and on-disk
+// snapshots, so new types go before Unknown and existing ones are never renumbered.
+enum class ProxyType : quint8 {
+    VMess,
+    Shadowsocks,
+    Trojan,
+    VLESS,
+    Socks,
+    Http,
+    Hysteria2,
+    Tuic,
+    ShadowsocksR,
+    WireGuard,
+    Unknown = 0xff
+};
+
+namespace ProxyTypeDetail {
+    template <typename Char>
+    constexpr bool hasPrefix(const Char *text, qsizetype size, const char *prefix) {
+        for (qsizetype i = 0; prefix[i] != '\0'; ++i) {
+            if (i >= size || text[i] != Char(prefix[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // One switch on the first byte, then a single prefix compare per candidate
+    template <typename Char>
+    constexpr ProxyType fromLink(const Char *text, qsizetype size) {
+        if (size < 5) {
+            return ProxyType::Unknown;
+        }
+        const Char *rest = text + 1;
+        const qsizetype restSize = size - 1;
+        switch (text[0]) {
+        case 'v':
+            if (hasPrefix(rest, restSize, "mess://")) {
+                return ProxyType::VMess;
+            }
+            return hasPrefix(rest, restSize, "less://") ? ProxyType::VLESS : ProxyType::Unknown;
+        case 's':
+            if (hasPrefix(rest, restSize, "s://")) {
+                return ProxyType::Shadowsocks;
+            }
+            if (hasPrefix(rest, restSize, "sr://")) {
+                return ProxyType::ShadowsocksR;
+            }
+            // socks://, socks4://, socks5:// ...
+            return hasPrefix(rest, restSize, "ocks") ? ProxyType::Socks : ProxyType::Unknown;
+        case 't':
+            if (hasPrefix(rest, restSize, "rojan://")) {
+                return ProxyType::Trojan;
+            }
+            return hasPrefix(rest, restSize, "uic://") ? ProxyType::Tuic : ProxyType::Unknown;
+        case 'h':
+            if (hasPrefix(rest, restSize, "ttp://") || hasPrefix(rest, restSize, "ttps://")) {
+                return ProxyType::Http;
+            }
+            if (hasPrefix(rest, restSize, "ysteria2://") || hasPrefix(rest, restSize, "y2://")) {
+                return ProxyType::Hysteria2;
+            }
+            return ProxyType::Unknown;
+        case 'w':
+            if (hasPrefix(rest, restSize, "ireguard://") || hasPrefix(rest, restSize, "g://")) {
+                return ProxyType::WireGuard;
+            }
+            return ProxyType::Unknown;
+        default:
+            return ProxyType::Unknown;
+        }
+    }
+}
+
+// Protocol implied by a link's scheme; case-sensitive like the parsers
+constexpr ProxyType ProxyTypeFromLink(QStringView link) {
+    return ProxyTypeDetail::fromLink(link.utf16(), link.size());
+}
+
+constexpr ProxyType ProxyTypeFromLink(QByteArrayView link) {
+    return ProxyTypeDetail::fromLink(link.data(), link.size());
+}
+
+// Name used in JSON output and identity keys; empty for Unknown
+constexpr const char *ProxyTypeName(ProxyType type) {
+    switch (type) {
+    case ProxyType::VMess:
+        return "vmess";
+    case ProxyType::Shadowsocks:
+        return "shadowsocks";
+    case ProxyType::Trojan:
+        return "trojan";
+    case ProxyType::VLESS:
+        return "vless";
+    case ProxyType::Socks:
+        return "socks";
+    case ProxyType::Http:
+        return "http";
+    case ProxyType::Hysteria2:
+        return "hysteria2";
+    case ProxyType::Tuic:
+        return "tuic";
+    case ProxyType::ShadowsocksR:
+        return "shadowsocksr";
+    case ProxyType::WireGuard:
+        return "wireguard";
+    case ProxyType::Unknown:
+        break;
+    }
+    return "";
+}
+
+// QUIC / UDP protocols, which a TCP connect cannot probe
+constexpr bool ProxyTypeUsesUdp(ProxyType type) {
+    return type == ProxyType::Hysteria2 || type == ProxyType::Tuic || type == ProxyType::WireGuard;
+}
+
+// Inverse of ProxyTypeName; Unknown for anything else
+inline ProxyType ProxyTypeFromName(QStringView name) {
+    for (ProxyType type : {ProxyType::VMess, ProxyType::Shadowsocks, ProxyType::Trojan,
+                           ProxyType::VLESS, ProxyType::Socks, ProxyType::Http, ProxyType::Hysteria2,
+                           ProxyType::Tuic, ProxyType::ShadowsocksR, ProxyType::WireGuard}) {
+        if (name == QLatin1String(ProxyTypeName(type))) {
+            return type;
+        }
+    }
+    return ProxyType::Unknown;
+}
+
+static_assert(ProxyTypeDetail::fromLink("vmess://e30=", 12) == ProxyType::VMess);
+static_assert(ProxyTypeDetail::fromLink("vless://id@h:1", 14) == ProxyType::VLESS);
+static_assert(ProxyTypeDetail::fromLink("ss://", 5) == ProxyType::Shadowsocks);
+static_assert(ProxyTypeDetail::fromLink("socks5://h:1", 12) == ProxyType::Socks);
+static_assert(ProxyTypeDetail::fromLink("https://h", 9) == ProxyType::Http);
+static_assert(ProxyTypeDetail::fromLink("hy2://pw@h:443", 14) == ProxyType::Hysteria2);
+static_assert(ProxyTypeDetail::fromLink("ssr://aG9zdA", 11) == ProxyType::ShadowsocksR);
+static_assert(ProxyTypeDetail::fromLink("tuic://id:pw@h:443", 18) == ProxyType::Tuic);
+static_assert(ProxyTypeDetail::fromLink("wg://key@h:51820", 16) == ProxyType::WireGuard);
+static_assert(ProxyTypeDetail::fromLink("vmessx://", 9) == ProxyType::Unknown);
+static_assert(ProxyTypeDetail::fromLink("ss:/", 4) == ProxyType::Unknown);
+
+#endif // PROXYTYPE_H
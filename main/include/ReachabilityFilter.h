@@ -0,0 +1,86 @@
+#ifndef REACHABILITYFILTER_H
+#define REACHABILITYFILTER_H
+
+#include <QString>
+#include <QHash>
+#include <QQueue>
+#include <QVector>
+#include <functional>
+#include "ConfigStore.h"
+
+class QAbstractSocket;
+class DnsCache;
+
+// Cheap liveness probe for collected endpoints: a non-blocking TCP connect, or a
+// TLS handshake with the config's SNI for TLS transports. Many endpoints in public
+// feeds are dead, and rejecting them here is far cheaper than starting xray for
+// them in the tester. Probes run on the event loop with a bounded window overall
+// and per host; duplicate endpoints are probed once.
+class ReachabilityFilter {
+public:
+    struct Options {
+        int maxConcurrent = 256;
+        int timeoutMs = 3000;
+        int perHostConcurrent = 4;  // keeps a feed full of one server's ports from hammering it
+        bool checkTls = true;       // handshake instead of a bare connect where the config uses TLS
+    };
+
+    explicit ReachabilityFilter(const Options &options);
+    ~ReachabilityFilter();
+
+    // Connect to cached addresses instead of resolving every probe again; names the
+    // cache failed to resolve are reported unreachable without a probe. Probes are
+    // then shared, and rate limited, per address rather than per name.
+    void setResolver(const DnsCache *resolver) { m_resolver = resolver; }
+
+    ReachabilityFilter(const ReachabilityFilter&) = delete;
+    ReachabilityFilter& operator=(const ReachabilityFilter&) = delete;
+
+    // Queue an endpoint and return its probe id; an empty server name means plain TCP.
+    // The same endpoint queued twice shares one probe.
+    int enqueue(const QString &host, quint16 port, const QString &tlsServerName = QString());
+
+    // Run all queued probes, blocking in a local event loop until they are done
+    void run();
+
+    bool isReachable(int id) const { return m_results.value(id) == Reachable; }
+    int probeCount() const { return m_results.size(); }
+    int reachableCount() const;
+
+    // Probe every row and drop the ones that did not answer; returns the number removed per store.
+    // UDP protocols (Hysteria2, TUIC, WireGuard) are kept without a probe.
+    QVector<qsizetype> filter(const QList<ConfigStore*> &stores);
+
+    // SNI to handshake with when the row's transport is TLS, otherwise empty
+    static QString TlsServerName(const ConfigStore &store, qsizetype row);
+
+private:
+    enum State : quint8 {
+        Pending,
+        Reachable,
+        Unreachable
+    };
+
+    struct Probe {
+        int id = 0;
+        QString host;       // what to connect to: the resolved address, or the name
+        quint16 port = 0;
+        QString serverName;
+    };
+
+    void startNext();
+    void start(const Probe &probe);
+    void finish(QAbstractSocket *socket, bool reachable);
+
+    Options m_options;
+    const DnsCache *m_resolver = nullptr;
+    QHash<QString, int> m_ids;                  // endpoint -> probe id
+    QVector<State> m_results;
+    QQueue<Probe> m_queue;
+    QHash<QString, QQueue<Probe>> m_deferred;   // host at its limit -> waiting probes
+    QHash<QString, int> m_hostActive;
+    QHash<QAbstractSocket*, Probe> m_inFlight;
+    std::function<void()> m_idleCallback;
+};
+
+#endif // REACHABILITYFILTER_H
@@ -0,0 +1,85 @@
+#ifndef RETRYPOLICY_H
+#define RETRYPOLICY_H
+
+#include <QString>
+#include <QHash>
+#include <QVector>
+#include <QDeadlineTimer>
+#include <QRandomGenerator>
+
+// When and how often DownloadScheduler tries a failed download again. Only
+// transient failures are retried (see HttpResponse::transient); the delay before
+// attempt n+1 is drawn uniformly from [0, min(maxDelay, baseDelay * 2^(n-1))]
+// ("full jitter"), so feeds failing together do not retry in lockstep.
+struct RetryPolicy {
+    int maxAttempts = 1;        // including the first; 1 disables retries
+    int baseDelayMs = 500;
+    int maxDelayMs = 10000;
+
+    // Delay before the attempt that follows failed attempt number attempt (1-based)
+    int delayMs(int attempt, QRandomGenerator &rng) const;
+};
+
+// Per-host circuit breaker. After failureThreshold consecutive transient failures a
+// host is "open" and further requests to it fail at once, without a connection,
+// until the cooldown has passed; the next result then closes or reopens it.
+class CircuitBreaker {
+public:
+    struct Options {
+        int failureThreshold = 3;   // 0 disables the breaker
+        int cooldownMs = 60 * 1000;
+    };
+
+    enum class State {
+        Closed,
+        Open,
+        HalfOpen    // cooldown over, requests allowed until the next result
+    };
+
+    CircuitBreaker() = default;
+    explicit CircuitBreaker(const Options &options) : m_options(options) {}
+
+    bool enabled() const { return m_options.failureThreshold > 0; }
+    bool allow(const QString &host) const { return state(host) != State::Open; }
+    State state(const QString &host) const;
+
+    void recordSuccess(const QString &host);
+    void recordFailure(const QString &host);
+
+    int openCount() const;
+
+private:
+    struct Host {
+        int failures = 0;
+        bool tripped = false;
+        QDeadlineTimer reopens;
+    };
+
+    Options m_options;
+    QHash<QString, Host> m_hosts;
+};
+
+// Recent response latencies, for choosing when to hedge: a request still waiting
+// for headers after the p95 of its peers is likely stuck on a slow mirror.
+class LatencyEstimator {
+public:
+    explicit LatencyEstimator(int window = 64) : m_window(qMax(1, window)) {}
+
+    void add(qint64 ms);
+    qsizetype samples() const { return m_samples.size(); }
+
+    // quantile in (0, 1]; 0 without samples
+    qint64 percentile(double quantile) const;
+
+    // p95 once enough samples are in, never below minimumMs
+    qint64 hedgeDelay(qint64 minimumMs) const;
+
+    static constexpr int MinimumSamples = 8;
+
+private:
+    int m_window;
+    QVector<qint64> m_samples;  // ring buffer
+    qsizetype m_next = 0;
+};
+
+#endif // RETRYPOLICY_H
@@ -0,0 +1,122 @@
+#ifndef RINGBUFFER_H
+#define RINGBUFFER_H
+
+#include <QtGlobal>
+#include <QThread>
+#include <atomic>
+#include <memory>
+#include <utility>
+
+namespace RingBufferDetail {
+    constexpr size_t CacheLine = 64;
+
+    inline size_t roundUpPow2(qsizetype n) {
+        size_t capacity = 2;
+        while (capacity < size_t(n)) {
+            capacity <<= 1;
+        }
+        return capacity;
+    }
+
+    // Waiting without a lock: spin briefly, then yield, then sleep
+    class Backoff {
+    public:
+        void pause() {
+            if (m_step < 32) {
+                ++m_step;
+            } else if (m_step < 64) {
+                ++m_step;
+                QThread::yieldCurrentThread();
+            } else {
+                QThread::usleep(50);
+            }
+        }
+
+    private:
+        int m_step = 0;
+    };
+}
+
+// Bounded single-producer / single-consumer queue. tryPush/tryPop never lock or
+// allocate; push/pop wait with back-off while the ring is full / empty, which is
+// how a slow consumer slows its producer down. Capacity is rounded up to a power
+// of two; popped slots are reset so they do not keep payloads alive.
+template <typename T>
+class SpscRing {
+public:
+    explicit SpscRing(qsizetype capacity)
+        : m_mask(RingBufferDetail::roundUpPow2(capacity) - 1),
+          m_slots(std::make_unique<T[]>(m_mask + 1)) {
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    // Producer thread only; value is left untouched when the ring is full
+    bool tryPush(T &&value) {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_headCache > m_mask) {
+            m_headCache = m_head.load(std::memory_order_acquire);
+            if (tail - m_headCache > m_mask) {
+                return false;
+            }
+        }
+        m_slots[tail & m_mask] = std::move(value);
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer thread only
+    bool tryPop(T &value) {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tailCache) {
+            m_tailCache = m_tail.load(std::memory_order_acquire);
+            if (head == m_tailCache) {
+                return false;
+            }
+        }
+        T &slot = m_slots[head & m_mask];
+        value = std::move(slot);
+        slot = T();
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // True if the producer had to wait
+    bool push(T &&value) {
+        if (tryPush(std::move(value))) {
+            return false;
+        }
+        RingBufferDetail::Backoff backoff;
+        do {
+            backoff.pause();
+        } while (!tryPush(std::move(value)));
+        return true;
+    }
+
+    void pop(T &value) {
+        RingBufferDetail::Backoff backoff;
+        while (!tryPop(value)) {
+            backoff.pause();
+        }
+    }
+
+    qsizetype capacity() const { return qsizetype(m_mask + 1); }
+    // Approximate when called while the other side is active
+    qsizetype size() const {
+        return qsizetype(m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire));
+    }
+    bool isEmpty() const { return size() == 0; }
+
+private:
+    const size_t m_mask;
+    std::unique_ptr<T[]> m_slots;
+
+    // Each side's index and its cached copy of the other side's share a line
+    alignas(RingBufferDetail::CacheLine) std::atomic<size_t> m_head{0};
+    size_t m_tailCache = 0;
+    alignas(RingBufferDetail::CacheLine) std::atomic<size_t> m_tail{0};
+    size_t m_headCache = 0;
+};
+
+#endif // RINGBUFFER_H
@@ -0,0 +1,89 @@
+#ifndef RUNMETRICS_H
+#define RUNMETRICS_H
+
+#include <QString>
+#include <QByteArray>
+#include <QJsonObject>
+#include <QMap>
+#include <QElapsedTimer>
+#include <array>
+#include <map>
+
+// Per-stage timings and counters for one collector run, globally and per
+// subscription, written next to the output as run_report.json and in Prometheus
+// text format as metrics.prom. Times are monotonic (QElapsedTimer). Stages of
+// different subscriptions overlap, so their sums can exceed the run's wall time.
+// Not thread-safe: one writer at a time. While downloads run that is the ingest
+// thread (see IngestPipeline); the main thread may record after sync() or
+// finish() returns, until it posts again.
+class RunMetrics {
+public:
+    enum class Stage {
+        Dns,        // DnsCache lookups, summed
+        Connect,    // request issued until sent: Qt's own lookup, TCP and TLS
+        Ttfb,       // request sent until response headers
+        Download,   // headers until the body was complete
+        Decode,     // base64 subscription bodies
+        Parse,      // link parsing on the ingest thread and parse pool, excluding decode
+        Dedup,
+        Filter,     // reachability prefilter
+        Write,      // JSON, NDJSON, delta and snapshot output
+        Count
+    };
+
+    // Subscription id for run-wide records
+    static constexpr int Global = -1;
+
+    // Adds the elapsed time to a stage when it goes out of scope
+    class Timer {
+    public:
+        Timer(RunMetrics &metrics, Stage stage, int subscription = Global);
+        ~Timer();
+
+        Timer(const Timer&) = delete;
+        Timer& operator=(const Timer&) = delete;
+
+    private:
+        RunMetrics &m_metrics;
+        Stage m_stage;
+        int m_subscription;
+        QElapsedTimer m_timer;
+    };
+
+    RunMetrics();
+
+    void setSubscription(int id, const QString &url);
+
+    // Records for a subscription also count towards the run-wide totals
+    void addTime(Stage stage, qint64 ns, int subscription = Global);
+    void addCount(const QString &name, qint64 delta, int subscription = Global);
+    void addParseFailures(const QString &protocol, qint64 count, int subscription = Global);
+
+    qint64 time(Stage stage, int subscription = Global) const;
+    qint64 count(const QString &name, int subscription = Global) const;
+    qint64 parseFailures(const QString &protocol, int subscription = Global) const;
+    qint64 elapsedNs() const { return m_run.nsecsElapsed(); }
+
+    QJsonObject toJson() const;
+    QByteArray toPrometheus() const;
+
+    // Write run_report.json and metrics.prom into directory
+    bool write(const QString &directory, QString *error = nullptr) const;
+
+    static const char *StageName(Stage stage);
+
+private:
+    struct Scope {
+        QString url;
+        std::array<qint64, size_t(Stage::Count)> stageNs{};
+        QMap<QString, qint64> counts;
+        QMap<QString, qint64> parseFailures;
+    };
+
+    const Scope *scope(int subscription) const;
+
+    QElapsedTimer m_run;
+    std::map<int, Scope> m_scopes;  // Global first, then subscriptions by id
+};
+
+#endif // RUNMETRICS_H
@@ -0,0 +1,81 @@
+#ifndef SHARDEDWRITER_H
+#define SHARDEDWRITER_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QHash>
+#include <QByteArrayView>
+#include "ConfigStore.h"
+#include "ConfigWriter.h"
+
+class QThreadPool;
+
+// Writes one run's configs as many output files. Rows are collected into shards
+// (a subscription's document, a per-protocol or per-country NDJSON file, ...) and
+// each shard is serialized by its own ConfigWriter on a pool worker, committed
+// through QSaveFile. Directories are created once before any worker starts. The
+// stores must stay alive and unmodified until write() returns.
+class ShardedWriter {
+public:
+    enum class Key {
+        Source,     // one JsonDocument per subscription (config_NNNN.json)
+        Protocol,   // protocols/<type>.ndjson
+        Country     // countries/<CC>.ndjson, from the flag emoji in the name
+    };
+
+    struct Result {
+        QString path;           // relative to the output directory
+        qsizetype count = 0;
+        QString error;          // empty on success
+    };
+
+    explicit ShardedWriter(const QString &directory);
+
+    // Shard at relativePath, created on first use; subscription is only used by JsonDocument
+    int shard(const QString &relativePath, ConfigWriter::Format format, const QString &subscription = QString());
+    void add(int shard, const ConfigStore &store, qsizetype row);
+    void addAll(int shard, const ConfigStore &store);
+    // Route every row of the store into the NDJSON shard for its protocol or country
+    void route(Key key, const ConfigStore &store);
+
+    // Serialize all shards, in parallel when a pool is given; false if any failed
+    bool write(QThreadPool *pool = nullptr);
+
+    qsizetype shardCount() const { return m_shards.size(); }
+    // One entry per shard, in creation order, after write()
+    const QVector<Result> &results() const { return m_results; }
+
+    // "protocols" / "countries"; empty for Source
+    static QString KeyDirectory(Key key);
+    static QString KeyName(Key key);
+    static bool KeyFromName(QStringView name, Key &key);
+    // Comma-separated key names, e.g. "protocol,country"; false on an unknown name
+    static bool ParseKeys(const QString &list, QList<Key> &keys);
+    // Upper-case ISO code from the first regional-indicator pair, otherwise "unknown"
+    static QString CountryCode(QByteArrayView utf8Name);
+    // Shard file (relative path) a row goes to for Protocol or Country
+    static QString ShardPath(Key key, const ConfigStore &store, qsizetype row);
+
+private:
+    struct Row {
+        const ConfigStore *store;
+        qsizetype row;
+    };
+
+    struct Shard {
+        QString relativePath;
+        ConfigWriter::Format format;
+        QString subscription;
+        QVector<Row> rows;
+    };
+
+    Result writeShard(const Shard &shard) const;
+
+    QString m_directory;
+    QVector<Shard> m_shards;
+    QHash<QString, int> m_index;
+    QVector<Result> m_results;
+};
+
+#endif // SHARDEDWRITER_H
@@ -0,0 +1,70 @@
+#ifndef SOURCEHISTORY_H
+#define SOURCEHISTORY_H
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QSet>
+#include <QList>
+
+// What each subscription URL delivered in earlier runs, kept in a small JSON file.
+// Fetches are ordered by it (productive sources first, so their data is in before
+// a deadline) and sources that keep failing are skipped for a growing number of
+// runs instead of costing a timeout every time.
+class SourceHistory {
+public:
+    struct Record {
+        QString url;
+        int runs = 0;               // fetch attempts recorded
+        qint64 latencyMs = -1;      // last successful fetch
+        qint64 bytes = 0;           // last successful fetch
+        int uniqueConfigs = 0;      // last successful fetch, after dedup
+        double duplicateRatio = 0;  // duplicates / total configs, last successful fetch
+        double yield = 0;           // unique configs per run, exponentially smoothed
+        int failureStreak = 0;      // consecutive failed fetches
+        int skipRuns = 0;           // runs still to skip before the next attempt
+        QString lastFetched;        // ISO 8601, UTC
+
+        bool isKnown() const { return runs > 0; }
+    };
+
+    struct Options {
+        int failureThreshold = 3;   // failures in a row before a source is skipped; 0 = never
+        int maxSkipRuns = 8;        // the skip doubles per further failure up to this
+    };
+
+    explicit SourceHistory(const QString &path = defaultPath(), Options options = Options());
+
+    // <dataDirectory>/source_history.json
+    static QString defaultPath();
+    QString path() const { return m_path; }
+
+    // A missing file is an empty history; an unreadable one fails and leaves it empty
+    bool load();
+    // Only URLs touched since load() are kept, so removed sources age out
+    bool save() const;
+
+    Record record(const QString &url) const;
+    int size() const { return int(m_records.size()); }
+
+    // Whether the url sits out this run; counts its skip down when it does
+    bool takeSkip(const QString &url);
+
+    void recordSuccess(const QString &url, qint64 latencyMs, qint64 bytes, int uniqueConfigs, int totalConfigs);
+    void recordFailure(const QString &url);
+
+    // Indices into urls, most valuable first: unknown sources (to measure them),
+    // then by smoothed yield discounted by duplicates and failures. Stable.
+    QList<int> prioritize(const QStringList &urls) const;
+    static double Score(const Record &record);
+
+private:
+    Record &touch(const QString &url);
+
+    QString m_path;
+    Options m_options;
+    QHash<QString, Record> m_records;
+    QSet<QString> m_touched;
+};
+
+#endif // SOURCEHISTORY_H
@@ -0,0 +1,70 @@
+#ifndef STREAMDECOMPRESSOR_H
+#define STREAMDECOMPRESSOR_H
+
+#include <QString>
+#include <QByteArray>
+#include <QByteArrayView>
+#include <memory>
+
+// Incremental decoder for compressed subscription bodies: gzip and zlib through
+// zlib, zstd through libzstd and brotli through libbrotlidec, each only when the
+// build found the library (CONFIGCOLLECTOR_HAVE_ZLIB / _ZSTD / _BROTLI). Auto
+// picks the format from the first bytes and passes unrecognized input through
+// untouched; brotli has no magic number, so it is only chosen by name.
+class StreamDecompressor {
+public:
+    enum class Format {
+        Identity,
+        Auto,       // gzip or zstd by magic bytes, otherwise identity
+        Gzip,
+        Zlib,       // HTTP "deflate"
+        Zstd,
+        Brotli
+    };
+
+    explicit StreamDecompressor(Format format = Format::Auto);
+    ~StreamDecompressor();
+
+    StreamDecompressor(const StreamDecompressor&) = delete;
+    StreamDecompressor& operator=(const StreamDecompressor&) = delete;
+
+    // Append the output for the next piece of input; false on corrupt input
+    bool feed(QByteArrayView input, QByteArray &output);
+    // Flush buffered input; false if the compressed stream ended early
+    bool finish(QByteArray &output);
+
+    // Resolved after the first bytes when constructed with Auto
+    Format format() const { return m_format; }
+    QString errorString() const { return m_error; }
+    qint64 bytesIn() const { return m_bytesIn; }
+
+    static bool IsSupported(Format format);
+    static const char *FormatName(Format format);
+
+    // Accept-Encoding value listing what this build can decode
+    static QByteArray AcceptEncoding();
+    // Format for a Content-Encoding header value; Identity if unknown or absent
+    static Format FromContentEncoding(QByteArrayView encoding);
+    // Format implied by a file name or URL path (.gz, .zst, .br), otherwise Auto
+    static Format FromFileName(QStringView name);
+    // Gzip or Zstd when data starts with their magic number, otherwise Identity
+    static Format Detect(QByteArrayView head);
+
+    // One-shot helper; false (and output unspecified) on error
+    static bool Decode(Format format, QByteArrayView input, QByteArray &output, QString *error = nullptr);
+
+private:
+    struct Codec;
+
+    bool start(Format format);
+    bool fail(const QString &error);
+
+    Format m_format;
+    std::unique_ptr<Codec> m_codec;
+    QByteArray m_head;          // Auto: bytes held back until the format is known
+    QString m_error;
+    qint64 m_bytesIn = 0;
+    bool m_failed = false;
+};
+
+#endif // STREAMDECOMPRESSOR_H
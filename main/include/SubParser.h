@@ -3,17 +3,133 @@
 
 #include <QString>
 #include <QList>
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QStringList>
 #include <QJsonObject>
+#include <QMap>
 #include "ProxyBean.h"
+#include <functional>
 #include <memory>
+#include <deque>
+
+class QThreadPool;
+class ParseArena;
 
 class SubParser {
 public:
     static QList<std::shared_ptr<ProxyBean>> ParseSubscription(const QString &content);
+    // Same result, with lines parsed on the pool in line-aligned batches
+    static QList<std::shared_ptr<ProxyBean>> ParseSubscription(const QByteArray &body, QThreadPool *pool);
+
+    // An http(s) URL with a path or query and no credentials: another subscription
+    // listed by an index, not an HTTP proxy
+    static bool IsSubscriptionUrl(QByteArrayView link);
+
+    // Hostile feeds wrap bodies in base64 over and over; layers beyond this depth
+    // are read as plain text
+    static constexpr int MaxNestingDepth = 4;
+
+    // No share link comes close; longer lines are skipped without being buffered
+    // or parsed
+    static constexpr qsizetype MaxLineBytes = 64 * 1024;
 
 private:
+    friend class SubStreamParser;
+
+    static QList<std::shared_ptr<ProxyBean>> ParseSubscription(const QString &content, int depth);
     static QList<std::shared_ptr<ProxyBean>> ParseMultiLine(const QString &str);
     static std::shared_ptr<ProxyBean> ParseSingleLink(const QString &str);
 };
 
-#endif // SUBPARSER_H
\ No newline at end of file
+// Incremental subscription parser. Chunks are fed as they arrive (for example from
+// QNetworkReply::readyRead) and beans are emitted as soon as their line is complete;
+// only the unfinished last line is buffered. A base64-encoded body is decoded on the
+// fly into a nested parser, so peak memory depends on line length, not file size.
+class SubStreamParser {
+public:
+    using BeanHandler = std::function<void(const std::shared_ptr<ProxyBean> &bean)>;
+    using SubscriptionHandler = std::function<void(const QString &url)>;
+
+    // What went into the beans, for run metrics
+    struct Stats {
+        qint64 decodeNs = 0;        // spent in base64 decoding
+        qint64 decodedBytes = 0;
+        int failedLines = 0;        // non-comment lines that gave no bean
+        int oversizedLines = 0;     // longer than SubParser::MaxLineBytes, skipped
+        QMap<QString, int> failuresByScheme;  // "vmess", "ss", ...; "unknown" without a scheme
+
+        void merge(const Stats &other);
+    };
+
+    explicit SubStreamParser(BeanHandler handler, int depth = 0);
+    ~SubStreamParser();
+
+    SubStreamParser(const SubStreamParser&) = delete;
+    SubStreamParser& operator=(const SubStreamParser&) = delete;
+
+    // Parse complete lines on this pool in batches; beans are still handed to the
+    // handler on the calling thread and in input order. Set before the first feed().
+    void setThreadPool(QThreadPool *pool) { m_pool = pool; }
+    // Lines that name another subscription (SubParser::IsSubscriptionUrl) go here
+    // instead of being parsed as HTTP proxies, on the calling thread and in input
+    // order. Set before the first feed().
+    void onSubscription(SubscriptionHandler handler) { m_subscriptionHandler = std::move(handler); }
+
+    void feed(const char *data, qsizetype size);
+    void feed(const QByteArray &chunk) { feed(chunk.constData(), chunk.size()); }
+
+    // Flush the trailing line / base64 quantum; no more data may be fed afterwards.
+    // A truncated body (download cut off) drops its unfinished last line instead,
+    // since a link cut short can still parse, with the wrong values.
+    void finish(bool truncated = false);
+
+    int parsedCount() const;
+    qint64 bytesFed() const { return m_bytesFed; }
+    // Including nested base64 layers
+    Stats stats() const;
+
+    // Bytes of complete lines collected before a batch is handed to the pool
+    static constexpr qsizetype ParallelBatchBytes = 256 * 1024;
+
+private:
+    enum class Mode { Detecting, Lines, Base64 };
+    struct ParseBatch;
+
+    void detect(bool atEnd);
+    void feedLines(const char *data, qsizetype size);
+    void keepPartialLine(const char *data, qsizetype size);
+    void feedBase64(const char *data, qsizetype size);
+    void decodePendingBase64(bool atEnd);
+    void processLine(const char *data, qsizetype size);
+    void emitBean(const std::shared_ptr<ProxyBean> &bean);
+    void queueLines(const char *data, qsizetype size);
+    void submitBatch();
+    bool emitFrontBatch(bool wait);
+    void drainBatches(bool wait);
+
+    // Trim, skip comments and parse one line, counting failures in stats; safe to
+    // call from pool threads. With subscriptions set, subscription URLs are appended
+    // there instead.
+    static std::shared_ptr<ProxyBean> parseLine(const char *data, qsizetype size, Stats &stats,
+                                                QStringList *subscriptions = nullptr);
+
+    BeanHandler m_handler;
+    SubscriptionHandler m_subscriptionHandler;
+    int m_depth;
+    Mode m_mode = Mode::Detecting;
+    QByteArray m_pending;          // partial line, undecided prefix or < 4 base64 chars
+    bool m_paddingSeen = false;
+    bool m_skippingLine = false;   // dropping an oversized line up to its newline
+    bool m_finished = false;
+    int m_parsedCount = 0;
+    qint64 m_bytesFed = 0;
+    Stats m_stats;
+    std::unique_ptr<SubStreamParser> m_inner;  // receives the decoded base64 layer
+    QThreadPool *m_pool = nullptr;
+    std::shared_ptr<ParseArena> m_arena;        // beans parsed on the calling thread
+    QByteArray m_batch;                         // complete lines not yet submitted
+    std::deque<std::shared_ptr<ParseBatch>> m_batches;  // submitted, in input order
+};
+
+#endif // SUBPARSER_H
@@ -18,6 +18,7 @@
 #include <QDateTime>
 #include <QUrl>
 #include <QRegularExpression>
+#include <functional>
 
 // Logging category for Utils
 Q_DECLARE_LOGGING_CATEGORY(UTILS)
@@ -43,6 +44,9 @@ public:
     static bool appendFileText(const QString& filePath, const QString& content);
     static QStringList readFileLines(const QString& filePath);
     static bool writeFileLines(const QString& filePath, const QStringList& lines);
+    // Memory-mapped, for files of any size: each line is handed out as a view into
+    // the mapping, without UTF-16 conversion or a copy. Return false to stop early.
+    static bool forEachLine(const QString& filePath, const std::function<bool(QByteArrayView line)>& handler);
 
     // Legacy compatibility
     static QString ReadFileText(const QString& path) { return readFileText(path); }
@@ -63,6 +67,8 @@ public:
     static QString getAbsolutePath(const QString& relativePath, const QString& basePath = QString());
     static QString getRelativePath(const QString& absolutePath, const QString& basePath = QString());
     static QString normalizePath(const QString& path);
+    // Path for a file:// URL or an existing plain path; empty for anything else
+    static QString localFilePath(const QString& link);
 
     // Validation utilities
     static bool isValidUrl(const QString& url);
@@ -106,7 +112,8 @@ public:
     static void clearError();
 
 private:
-    static QString m_lastError;
+    // Per thread, so parse workers do not overwrite each other's errors
+    static thread_local QString m_lastError;
 };
 
 // Helper to get query from URL
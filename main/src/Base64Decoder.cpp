@@ -0,0 +1,504 @@
+#include "../include/Base64Decoder.h"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BASE64_X86 1
+#include <immintrin.h>
+#define BASE64_TARGET_SSSE3 __attribute__((target("ssse3")))
+#define BASE64_TARGET_AVX2 __attribute__((target("avx2")))
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define BASE64_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace {
+    using Qt515Base64::Base64DecodingStatus;
+    using Base64Decoder::Implementation;
+
+    // Sextet values 0..63; the markers below cover everything else
+    enum : uint8_t {
+        Invalid = 0xFF,
+        Skip = 0xFE,    // CR / LF inside wrapped input
+        Pad = 0xFD,
+    };
+
+    struct DecodeTable {
+        uint8_t values[256];
+
+        constexpr DecodeTable() : values() {
+            for (int i = 0; i < 256; ++i) {
+                values[i] = Invalid;
+            }
+            for (int i = 0; i < 26; ++i) {
+                values['A' + i] = uint8_t(i);
+                values['a' + i] = uint8_t(26 + i);
+            }
+            for (int i = 0; i < 10; ++i) {
+                values['0' + i] = uint8_t(52 + i);
+            }
+            values['+'] = 62;
+            values['-'] = 62;
+            values['/'] = 63;
+            values['_'] = 63;
+            values['\r'] = Skip;
+            values['\n'] = Skip;
+            values['='] = Pad;
+        }
+    };
+
+    constexpr DecodeTable Table;
+
+    // Largest store past the decoded end made by a SIMD kernel
+    constexpr size_t OutputSlack = 32;
+
+    template <typename Char>
+    inline uint8_t lookup(Char c) {
+        uint32_t u = static_cast<uint32_t>(static_cast<std::make_unsigned_t<Char>>(c));
+        return u < 256 ? Table.values[u] : uint8_t(Invalid);
+    }
+
+    template <typename Char>
+    inline bool isTrimSpace(Char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+    }
+
+    // A block kernel decodes as many whole blocks as are valid and returns the number
+    // of input characters consumed (always a multiple of 4)
+    template <typename Char>
+    using BlockKernel = size_t (*)(const Char *in, size_t n, uint8_t *out);
+
+#if defined(BASE64_X86)
+    // SSSE3: 16 characters -> 12 bytes per step
+
+    BASE64_TARGET_SSSE3 inline __m128i load16(const char *in) {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+    }
+
+    BASE64_TARGET_SSSE3 inline __m128i load16(const char16_t *in) {
+        // Code units above 0xFF saturate to 0x00/0xFF, both outside the alphabet
+        __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+        __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 8));
+        return _mm_packus_epi16(lo, hi);
+    }
+
+    BASE64_TARGET_SSSE3 inline bool translate16(__m128i v, __m128i &values) {
+        const __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('A' - 1)),
+                                            _mm_cmplt_epi8(v, _mm_set1_epi8('Z' + 1)));
+        const __m128i lower = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('a' - 1)),
+                                            _mm_cmplt_epi8(v, _mm_set1_epi8('z' + 1)));
+        const __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('0' - 1)),
+                                            _mm_cmplt_epi8(v, _mm_set1_epi8('9' + 1)));
+        const __m128i plus = _mm_cmpeq_epi8(v, _mm_set1_epi8('+'));
+        const __m128i minus = _mm_cmpeq_epi8(v, _mm_set1_epi8('-'));
+        const __m128i slash = _mm_cmpeq_epi8(v, _mm_set1_epi8('/'));
+        const __m128i underscore = _mm_cmpeq_epi8(v, _mm_set1_epi8('_'));
+
+        const __m128i valid = _mm_or_si128(_mm_or_si128(_mm_or_si128(upper, lower), _mm_or_si128(digit, plus)),
+                                           _mm_or_si128(_mm_or_si128(minus, slash), underscore));
+        if (_mm_movemask_epi8(valid) != 0xFFFF) {
+            return false;
+        }
+
+        // The classes are disjoint, so the per-class offsets can simply be OR-ed
+        __m128i offset = _mm_and_si128(upper, _mm_set1_epi8(-65));
+        offset = _mm_or_si128(offset, _mm_and_si128(lower, _mm_set1_epi8(-71)));
+        offset = _mm_or_si128(offset, _mm_and_si128(digit, _mm_set1_epi8(4)));
+        offset = _mm_or_si128(offset, _mm_and_si128(plus, _mm_set1_epi8(19)));
+        offset = _mm_or_si128(offset, _mm_and_si128(minus, _mm_set1_epi8(17)));
+        offset = _mm_or_si128(offset, _mm_and_si128(slash, _mm_set1_epi8(16)));
+        offset = _mm_or_si128(offset, _mm_and_si128(underscore, _mm_set1_epi8(-32)));
+        values = _mm_add_epi8(v, offset);
+        return true;
+    }
+
+    template <typename Char>
+    BASE64_TARGET_SSSE3 size_t decodeBlocksSsse3(const Char *in, size_t n, uint8_t *out) {
+        size_t done = 0;
+        while (n - done >= 16) {
+            __m128i values;
+            if (!translate16(load16(in + done), values)) {
+                break;
+            }
+
+            // Merge sextet pairs into 12-bit words, then word pairs into 24-bit groups
+            const __m128i merged = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+            __m128i packed = _mm_madd_epi16(merged, _mm_set1_epi32(0x00011000));
+            packed = _mm_shuffle_epi8(packed, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12,
+                                                            -1, -1, -1, -1));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out), packed);
+
+            out += 12;
+            done += 16;
+        }
+        return done;
+    }
+
+    // AVX2: 32 characters -> 24 bytes per step
+
+    BASE64_TARGET_AVX2 inline __m256i load32(const char *in) {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in));
+    }
+
+    BASE64_TARGET_AVX2 inline __m256i load32(const char16_t *in) {
+        __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in));
+        __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + 16));
+        // packus works per 128-bit lane; restore the original order afterwards
+        return _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi), 0xD8);
+    }
+
+    BASE64_TARGET_AVX2 inline __m256i inRange32(__m256i v, char first, char last) {
+        return _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(char(first - 1))),
+                                _mm256_cmpgt_epi8(_mm256_set1_epi8(char(last + 1)), v));
+    }
+
+    BASE64_TARGET_AVX2 inline bool translate32(__m256i v, __m256i &values) {
+        const __m256i upper = inRange32(v, 'A', 'Z');
+        const __m256i lower = inRange32(v, 'a', 'z');
+        const __m256i digit = inRange32(v, '0', '9');
+        const __m256i plus = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('+'));
+        const __m256i minus = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('-'));
+        const __m256i slash = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('/'));
+        const __m256i underscore = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_'));
+
+        const __m256i valid = _mm256_or_si256(
+            _mm256_or_si256(_mm256_or_si256(upper, lower), _mm256_or_si256(digit, plus)),
+            _mm256_or_si256(_mm256_or_si256(minus, slash), underscore));
+        if (_mm256_movemask_epi8(valid) != -1) {
+            return false;
+        }
+
+        __m256i offset = _mm256_and_si256(upper, _mm256_set1_epi8(-65));
+        offset = _mm256_or_si256(offset, _mm256_and_si256(lower, _mm256_set1_epi8(-71)));
+        offset = _mm256_or_si256(offset, _mm256_and_si256(digit, _mm256_set1_epi8(4)));
+        offset = _mm256_or_si256(offset, _mm256_and_si256(plus, _mm256_set1_epi8(19)));
+        offset = _mm256_or_si256(offset, _mm256_and_si256(minus, _mm256_set1_epi8(17)));
+        offset = _mm256_or_si256(offset, _mm256_and_si256(slash, _mm256_set1_epi8(16)));
+        offset = _mm256_or_si256(offset, _mm256_and_si256(underscore, _mm256_set1_epi8(-32)));
+        values = _mm256_add_epi8(v, offset);
+        return true;
+    }
+
+    template <typename Char>
+    BASE64_TARGET_AVX2 size_t decodeBlocksAvx2(const Char *in, size_t n, uint8_t *out) {
+        const __m256i shuffle = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+                                                 2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+        const __m256i compact = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7);
+
+        size_t done = 0;
+        while (n - done >= 32) {
+            __m256i values;
+            if (!translate32(load32(in + done), values)) {
+                break;
+            }
+
+            const __m256i merged = _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140));
+            __m256i packed = _mm256_madd_epi16(merged, _mm256_set1_epi32(0x00011000));
+            packed = _mm256_shuffle_epi8(packed, shuffle);
+            // Each lane now starts with 12 output bytes; move them next to each other
+            packed = _mm256_permutevar8x32_epi32(packed, compact);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), packed);
+
+            out += 24;
+            done += 32;
+        }
+        return done;
+    }
+
+    Implementation detectBest() {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            return Implementation::Avx2;
+        }
+        if (__builtin_cpu_supports("ssse3")) {
+            return Implementation::Ssse3;
+        }
+        return Implementation::Scalar;
+    }
+#elif defined(BASE64_NEON)
+    // NEON: 64 characters -> 48 bytes per step, de-interleaved by vld4 / vst3
+
+    inline uint8x16x4_t load64(const char *in) {
+        return vld4q_u8(reinterpret_cast<const uint8_t*>(in));
+    }
+
+    inline uint8x16x4_t load64(const char16_t *in) {
+        // Saturating narrow maps code units above 0xFF to 0xFF, outside the alphabet
+        uint16x8x4_t lo = vld4q_u16(reinterpret_cast<const uint16_t*>(in));
+        uint16x8x4_t hi = vld4q_u16(reinterpret_cast<const uint16_t*>(in + 32));
+        uint8x16x4_t result;
+        for (int k = 0; k < 4; ++k) {
+            result.val[k] = vcombine_u8(vqmovn_u16(lo.val[k]), vqmovn_u16(hi.val[k]));
+        }
+        return result;
+    }
+
+    inline uint8x16_t inRange(uint8x16_t v, uint8_t first, uint8_t last) {
+        return vandq_u8(vcgeq_u8(v, vdupq_n_u8(first)), vcleq_u8(v, vdupq_n_u8(last)));
+    }
+
+    inline uint8x16_t translate(uint8x16_t v, uint8x16_t &validAll) {
+        const uint8x16_t upper = inRange(v, 'A', 'Z');
+        const uint8x16_t lower = inRange(v, 'a', 'z');
+        const uint8x16_t digit = inRange(v, '0', '9');
+        const uint8x16_t plus = vceqq_u8(v, vdupq_n_u8('+'));
+        const uint8x16_t minus = vceqq_u8(v, vdupq_n_u8('-'));
+        const uint8x16_t slash = vceqq_u8(v, vdupq_n_u8('/'));
+        const uint8x16_t underscore = vceqq_u8(v, vdupq_n_u8('_'));
+
+        uint8x16_t valid = vorrq_u8(vorrq_u8(vorrq_u8(upper, lower), vorrq_u8(digit, plus)),
+                                    vorrq_u8(vorrq_u8(minus, slash), underscore));
+        validAll = vandq_u8(validAll, valid);
+
+        uint8x16_t offset = vandq_u8(upper, vdupq_n_u8(uint8_t(-65)));
+        offset = vorrq_u8(offset, vandq_u8(lower, vdupq_n_u8(uint8_t(-71))));
+        offset = vorrq_u8(offset, vandq_u8(digit, vdupq_n_u8(4)));
+        offset = vorrq_u8(offset, vandq_u8(plus, vdupq_n_u8(19)));
+        offset = vorrq_u8(offset, vandq_u8(minus, vdupq_n_u8(17)));
+        offset = vorrq_u8(offset, vandq_u8(slash, vdupq_n_u8(16)));
+        offset = vorrq_u8(offset, vandq_u8(underscore, vdupq_n_u8(uint8_t(-32))));
+        return vaddq_u8(v, offset);
+    }
+
+    template <typename Char>
+    size_t decodeBlocksNeon(const Char *in, size_t n, uint8_t *out) {
+        size_t done = 0;
+        while (n - done >= 64) {
+            uint8x16x4_t chars = load64(in + done);
+            uint8x16_t validAll = vdupq_n_u8(0xFF);
+            const uint8x16_t a = translate(chars.val[0], validAll);
+            const uint8x16_t b = translate(chars.val[1], validAll);
+            const uint8x16_t c = translate(chars.val[2], validAll);
+            const uint8x16_t d = translate(chars.val[3], validAll);
+            if (vminvq_u8(validAll) != 0xFF) {
+                break;
+            }
+
+            uint8x16x3_t bytes;
+            bytes.val[0] = vorrq_u8(vshlq_n_u8(a, 2), vshrq_n_u8(b, 4));
+            bytes.val[1] = vorrq_u8(vshlq_n_u8(b, 4), vshrq_n_u8(c, 2));
+            bytes.val[2] = vorrq_u8(vshlq_n_u8(c, 6), d);
+            vst3q_u8(out, bytes);
+
+            out += 48;
+            done += 64;
+        }
+        return done;
+    }
+
+    Implementation detectBest() {
+        return Implementation::Neon;
+    }
+#else
+    Implementation detectBest() {
+        return Implementation::Scalar;
+    }
+#endif
+
+    Implementation bestImplementation() {
+        static const Implementation best = detectBest();
+        return best;
+    }
+
+    std::atomic<Implementation> forcedImplementation{Implementation::Auto};
+
+    Implementation currentImplementation() {
+        Implementation forced = forcedImplementation.load(std::memory_order_relaxed);
+        return forced == Implementation::Auto ? bestImplementation() : forced;
+    }
+
+    template <typename Char>
+    BlockKernel<Char> blockKernel(Implementation implementation, size_t &blockWidth) {
+        switch (implementation) {
+#if defined(BASE64_X86)
+        case Implementation::Avx2:
+            blockWidth = 32;
+            return &decodeBlocksAvx2<Char>;
+        case Implementation::Ssse3:
+            blockWidth = 16;
+            return &decodeBlocksSsse3<Char>;
+#elif defined(BASE64_NEON)
+        case Implementation::Neon:
+            blockWidth = 64;
+            return &decodeBlocksNeon<Char>;
+#endif
+        default:
+            blockWidth = 0;
+            return nullptr;
+        }
+    }
+
+    // Decode n characters into out (capacity >= maxDecodedSize(n)) and set outLength
+    template <typename Char>
+    Base64DecodingStatus decodeInto(const Char *in, size_t n, uint8_t *out, size_t &outLength) {
+        size_t blockWidth = 0;
+        const BlockKernel<Char> kernel = blockKernel<Char>(currentImplementation(), blockWidth);
+
+        size_t outPos = 0;
+        uint32_t buf = 0;
+        int quantum = 0;
+        size_t i = 0;
+        outLength = 0;
+
+        while (i < n) {
+            if (kernel && quantum == 0) {
+                size_t consumed = kernel(in + i, n - i, out + outPos);
+                i += consumed;
+                outPos += consumed / 4 * 3;
+                if (i >= n) {
+                    break;
+                }
+            }
+
+            // Scalar until the block the kernel refused is behind us and we are back on a
+            // quantum boundary (or, without a kernel, until the end)
+            const size_t scalarEnd = kernel ? std::min(n, i + blockWidth) : n;
+            while (i < n && (i < scalarEnd || quantum != 0)) {
+                const uint8_t v = lookup(in[i]);
+                if (v < 64) {
+                    buf = (buf << 6) | v;
+                    if (++quantum == 4) {
+                        out[outPos++] = uint8_t(buf >> 16);
+                        out[outPos++] = uint8_t(buf >> 8);
+                        out[outPos++] = uint8_t(buf);
+                        buf = 0;
+                        quantum = 0;
+                    }
+                } else if (v == Pad) {
+                    // 1 or 2 '=' may close a quantum of 2, one may close a quantum of 3;
+                    // only line breaks may follow
+                    if (quantum < 2) {
+                        return Base64DecodingStatus::IllegalPadding;
+                    }
+                    int pads = 0;
+                    for (; i < n; ++i) {
+                        const uint8_t p = lookup(in[i]);
+                        if (p == Pad) {
+                            ++pads;
+                        } else if (p != Skip) {
+                            return Base64DecodingStatus::IllegalPadding;
+                        }
+                    }
+                    if (pads > 4 - quantum) {
+                        return Base64DecodingStatus::IllegalPadding;
+                    }
+                    break;
+                } else if (v != Skip) {
+                    return Base64DecodingStatus::IllegalCharacter;
+                }
+                ++i;
+            }
+        }
+
+        switch (quantum) {
+        case 1:
+            return Base64DecodingStatus::IllegalInputLength;
+        case 2:
+            out[outPos++] = uint8_t(buf >> 4);
+            break;
+        case 3:
+            out[outPos++] = uint8_t(buf >> 10);
+            out[outPos++] = uint8_t(buf >> 2);
+            break;
+        default:
+            break;
+        }
+
+        outLength = outPos;
+        return Base64DecodingStatus::Ok;
+    }
+
+    inline size_t maxDecodedSize(size_t n) {
+        return (n / 4) * 3 + 3 + OutputSlack;
+    }
+
+    template <typename Char>
+    void trim(const Char *&data, size_t &size) {
+        while (size > 0 && isTrimSpace(data[0])) {
+            ++data;
+            --size;
+        }
+        while (size > 0 && isTrimSpace(data[size - 1])) {
+            --size;
+        }
+    }
+}
+
+// Qt entry points
+
+namespace {
+    template <typename Char>
+    Qt515Base64::FromBase64Result decode(const Char *data, size_t size) {
+        trim(data, size);
+        if (size == 0) {
+            return {QByteArray(), Base64DecodingStatus::Ok};
+        }
+
+        QByteArray decoded(qsizetype(maxDecodedSize(size)), Qt::Uninitialized);
+        size_t length = 0;
+        Base64DecodingStatus status = decodeInto(data, size, reinterpret_cast<uint8_t*>(decoded.data()), length);
+        if (status != Base64DecodingStatus::Ok) {
+            return {QByteArray(), status};
+        }
+
+        decoded.truncate(qsizetype(length));
+        return {std::move(decoded), status};
+    }
+}
+
+namespace Base64Decoder {
+    Qt515Base64::FromBase64Result Decode(const char *data, qsizetype size) {
+        return decode(data, size_t(qMax<qsizetype>(size, 0)));
+    }
+
+    Qt515Base64::FromBase64Result Decode(const QByteArray &input) {
+        return decode(input.constData(), size_t(input.size()));
+    }
+
+    Qt515Base64::FromBase64Result Decode(QStringView input) {
+        return decode(input.utf16(), size_t(input.size()));
+    }
+
+    const char *ActiveImplementation() {
+        switch (currentImplementation()) {
+        case Implementation::Avx2:
+            return "avx2";
+        case Implementation::Ssse3:
+            return "ssse3";
+        case Implementation::Neon:
+            return "neon";
+        default:
+            return "scalar";
+        }
+    }
+
+    bool IsSupported(Implementation implementation) {
+        switch (implementation) {
+        case Implementation::Auto:
+        case Implementation::Scalar:
+            return true;
+#if defined(BASE64_X86)
+        case Implementation::Avx2:
+            return bestImplementation() == Implementation::Avx2;
+        case Implementation::Ssse3:
+            return bestImplementation() != Implementation::Scalar;
+#elif defined(BASE64_NEON)
+        case Implementation::Neon:
+            return true;
+#endif
+        default:
+            return false;
+        }
+    }
+
+    bool ForceImplementation(Implementation implementation) {
+        if (!IsSupported(implementation)) {
+            return false;
+        }
+        forcedImplementation.store(implementation, std::memory_order_relaxed);
+        return true;
+    }
+}
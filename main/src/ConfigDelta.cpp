@@ -0,0 +1,43 @@
+#include "../include/ConfigDelta.h"
+
+ConfigDelta::ConfigDelta(const ConfigSnapshot &previous, Deduplicator::Mode mode)
+    : m_previous(previous),
+      m_mode(ConfigSnapshot::KeyMode(mode)),
+      m_baseline(previous.isOpen() && previous.mode() == m_mode),
+      m_matched(m_baseline ? previous.size() : 0) {
+}
+
+ConfigDelta::Counts ConfigDelta::compare(const ConfigStore &store, QVector<qsizetype> *added) {
+    Counts counts;
+    for (qsizetype row = 0; row < store.size(); ++row) {
+        const qsizetype previousRow = m_baseline ? m_previous.find(store.identityKey(row, m_mode)) : -1;
+        if (previousRow >= 0) {
+            m_matched.setBit(previousRow);
+            ++counts.unchanged;
+        } else {
+            ++counts.added;
+            if (added) {
+                added->append(row);
+            }
+        }
+    }
+    return counts;
+}
+
+QVector<qsizetype> ConfigDelta::removedRows() const {
+    QVector<qsizetype> rows;
+    for (qsizetype row = 0; row < m_matched.size(); ++row) {
+        if (!m_matched.testBit(row)) {
+            rows.append(row);
+        }
+    }
+    return rows;
+}
+
+QHash<QByteArray, qsizetype> ConfigDelta::removedBySource() const {
+    QHash<QByteArray, qsizetype> counts;
+    for (qsizetype row : removedRows()) {
+        ++counts[m_previous.field(row, ConfigStore::Field::Source).toByteArray()];
+    }
+    return counts;
+}
@@ -1,4 +1,6 @@
 #include "ConfigManager.h"
+#include "Deduplicator.h"
+#include "ShardedWriter.h"
 #include <QFile>
 #include <QTextStream>
 #include <QDebug>
@@ -20,8 +22,39 @@ void ConfigManager::initializeDefaultConfig()
     m_config.workingDirectory = getAbsolutePath("../data/working");
     m_config.maxConcurrentDownloads = 10;
     m_config.requestTimeout = 30000; // 30 seconds
+    m_config.runDeadline = 0;
+    m_config.deadlineReserve = 60;
+    m_config.downloadRetries = 2;
+    m_config.retryBaseDelay = 500;
+    m_config.retryMaxDelay = 10000;
+    m_config.circuitBreakerThreshold = 3;
+    m_config.circuitBreakerCooldown = 60;
+    m_config.hedgeDelay = 0;
+    m_config.perHostDownloads = 0;
+    m_config.expandSubscriptions = false;
+    m_config.maxSubscriptionDepth = 2;
+    m_config.enableSourceHistory = true;
+    m_config.sourceSkipAfterFailures = 3;
+    m_config.sourceMaxSkipRuns = 8;
     m_config.createMissingDirectories = true;
     m_config.verboseLogging = true;
+    m_config.enableFetchCache = true;
+    m_config.enableCompression = true;
+    m_config.dedupMode = "endpoint";
+    m_config.parseThreads = 0;
+    m_config.outputShards = "";
+    m_config.writeLinks = true;
+    m_config.writeSnapshot = true;
+    m_config.incrementalMode = true;
+    m_config.enableReachabilityFilter = false;
+    m_config.reachabilityConcurrency = 256;
+    m_config.reachabilityPerHost = 4;
+    m_config.reachabilityTimeout = 3000;
+    m_config.reachabilityCheckTls = true;
+    m_config.dnsConcurrency = 32;
+    m_config.dnsTtl = 300;
+    m_config.dnsNegativeTtl = 60;
+    m_config.writeRunReport = true;
 }
 
 QString ConfigManager::getDefaultDataPath() const
@@ -104,8 +137,39 @@ bool ConfigManager::loadConfig(const QString& configPath)
     m_config.workingDirectory = config["workingDirectory"].toString(getAbsolutePath("../data/working"));
     m_config.maxConcurrentDownloads = config["maxConcurrentDownloads"].toInt(10);
     m_config.requestTimeout = config["requestTimeout"].toInt(30000);
+    m_config.runDeadline = config["runDeadline"].toInt(0);
+    m_config.deadlineReserve = config["deadlineReserve"].toInt(60);
+    m_config.downloadRetries = config["downloadRetries"].toInt(2);
+    m_config.retryBaseDelay = config["retryBaseDelay"].toInt(500);
+    m_config.retryMaxDelay = config["retryMaxDelay"].toInt(10000);
+    m_config.circuitBreakerThreshold = config["circuitBreakerThreshold"].toInt(3);
+    m_config.circuitBreakerCooldown = config["circuitBreakerCooldown"].toInt(60);
+    m_config.hedgeDelay = config["hedgeDelay"].toInt(0);
+    m_config.perHostDownloads = config["perHostDownloads"].toInt(0);
+    m_config.expandSubscriptions = config["expandSubscriptions"].toBool(false);
+    m_config.maxSubscriptionDepth = config["maxSubscriptionDepth"].toInt(2);
+    m_config.enableSourceHistory = config["enableSourceHistory"].toBool(true);
+    m_config.sourceSkipAfterFailures = config["sourceSkipAfterFailures"].toInt(3);
+    m_config.sourceMaxSkipRuns = config["sourceMaxSkipRuns"].toInt(8);
     m_config.createMissingDirectories = config["createMissingDirectories"].toBool(true);
     m_config.verboseLogging = config["verboseLogging"].toBool(true);
+    m_config.enableFetchCache = config["enableFetchCache"].toBool(true);
+    m_config.enableCompression = config["enableCompression"].toBool(true);
+    m_config.dedupMode = config["dedupMode"].toString("endpoint");
+    m_config.parseThreads = config["parseThreads"].toInt(0);
+    m_config.outputShards = config["outputShards"].toString("");
+    m_config.writeLinks = config["writeLinks"].toBool(true);
+    m_config.writeSnapshot = config["writeSnapshot"].toBool(true);
+    m_config.incrementalMode = config["incrementalMode"].toBool(true);
+    m_config.enableReachabilityFilter = config["enableReachabilityFilter"].toBool(false);
+    m_config.reachabilityConcurrency = config["reachabilityConcurrency"].toInt(256);
+    m_config.reachabilityPerHost = config["reachabilityPerHost"].toInt(4);
+    m_config.reachabilityTimeout = config["reachabilityTimeout"].toInt(3000);
+    m_config.reachabilityCheckTls = config["reachabilityCheckTls"].toBool(true);
+    m_config.dnsConcurrency = config["dnsConcurrency"].toInt(32);
+    m_config.dnsTtl = config["dnsTtl"].toInt(300);
+    m_config.dnsNegativeTtl = config["dnsNegativeTtl"].toInt(60);
+    m_config.writeRunReport = config["writeRunReport"].toBool(true);
 
     m_configFilePath = configFilePath;
 
@@ -130,8 +194,39 @@ bool ConfigManager::saveConfig(const QString& configPath)
     config["workingDirectory"] = m_config.workingDirectory;
     config["maxConcurrentDownloads"] = m_config.maxConcurrentDownloads;
     config["requestTimeout"] = m_config.requestTimeout;
+    config["runDeadline"] = m_config.runDeadline;
+    config["deadlineReserve"] = m_config.deadlineReserve;
+    config["downloadRetries"] = m_config.downloadRetries;
+    config["retryBaseDelay"] = m_config.retryBaseDelay;
+    config["retryMaxDelay"] = m_config.retryMaxDelay;
+    config["circuitBreakerThreshold"] = m_config.circuitBreakerThreshold;
+    config["circuitBreakerCooldown"] = m_config.circuitBreakerCooldown;
+    config["hedgeDelay"] = m_config.hedgeDelay;
+    config["perHostDownloads"] = m_config.perHostDownloads;
+    config["expandSubscriptions"] = m_config.expandSubscriptions;
+    config["maxSubscriptionDepth"] = m_config.maxSubscriptionDepth;
+    config["enableSourceHistory"] = m_config.enableSourceHistory;
+    config["sourceSkipAfterFailures"] = m_config.sourceSkipAfterFailures;
+    config["sourceMaxSkipRuns"] = m_config.sourceMaxSkipRuns;
     config["createMissingDirectories"] = m_config.createMissingDirectories;
     config["verboseLogging"] = m_config.verboseLogging;
+    config["enableFetchCache"] = m_config.enableFetchCache;
+    config["enableCompression"] = m_config.enableCompression;
+    config["dedupMode"] = m_config.dedupMode;
+    config["parseThreads"] = m_config.parseThreads;
+    config["outputShards"] = m_config.outputShards;
+    config["writeLinks"] = m_config.writeLinks;
+    config["writeSnapshot"] = m_config.writeSnapshot;
+    config["incrementalMode"] = m_config.incrementalMode;
+    config["enableReachabilityFilter"] = m_config.enableReachabilityFilter;
+    config["reachabilityConcurrency"] = m_config.reachabilityConcurrency;
+    config["reachabilityPerHost"] = m_config.reachabilityPerHost;
+    config["reachabilityTimeout"] = m_config.reachabilityTimeout;
+    config["reachabilityCheckTls"] = m_config.reachabilityCheckTls;
+    config["dnsConcurrency"] = m_config.dnsConcurrency;
+    config["dnsTtl"] = m_config.dnsTtl;
+    config["dnsNegativeTtl"] = m_config.dnsNegativeTtl;
+    config["writeRunReport"] = m_config.writeRunReport;
     config["lastModified"] = QDateTime::currentDateTime().toString(Qt::ISODate);
     config["applicationVersion"] = "2.0.0";
     config["configVersion"] = "1.0";
@@ -299,6 +394,57 @@ bool ConfigManager::validateConfig() const
         m_errors.append("Request timeout must be positive");
     }
 
+    if (m_config.runDeadline < 0 || m_config.deadlineReserve < 0 ||
+        (m_config.runDeadline > 0 && m_config.deadlineReserve >= m_config.runDeadline)) {
+        m_errors.append("Run deadline and reserve must not be negative, and the reserve must leave time to download");
+    }
+
+    if (m_config.downloadRetries < 0 || m_config.retryBaseDelay < 0 ||
+        m_config.retryMaxDelay < m_config.retryBaseDelay) {
+        m_errors.append("Download retries and delays must not be negative, and the maximum delay must not be below the base");
+    }
+
+    if (m_config.circuitBreakerThreshold < 0 || m_config.circuitBreakerCooldown < 0 || m_config.hedgeDelay < 0) {
+        m_errors.append("Circuit breaker and hedging settings must not be negative");
+    }
+
+    if (m_config.perHostDownloads < 0 || m_config.maxSubscriptionDepth < 0) {
+        m_errors.append("Per-host download limit and subscription depth must not be negative");
+    }
+
+    if (m_config.sourceSkipAfterFailures < 0 || m_config.sourceMaxSkipRuns < 1) {
+        m_errors.append("Source skip threshold must not be negative and the longest skip must be at least one run");
+    }
+
+    if (m_config.parseThreads < 0) {
+        m_errors.append("Parse threads must not be negative");
+    }
+
+    Deduplicator::Mode dedupMode;
+    if (!Deduplicator::ParseMode(m_config.dedupMode, dedupMode)) {
+        m_errors.append("Unknown dedup mode: " + m_config.dedupMode);
+    }
+
+    QList<ShardedWriter::Key> shardKeys;
+    if (!ShardedWriter::ParseKeys(m_config.outputShards, shardKeys)) {
+        m_errors.append("Unknown output shard key in: " + m_config.outputShards);
+    }
+
+    if (m_config.incrementalMode && !m_config.writeSnapshot) {
+        // The baseline would never advance past the last snapshot written
+        m_errors.append("Incremental mode requires writeSnapshot");
+    }
+
+    if (m_config.enableReachabilityFilter &&
+        (m_config.reachabilityConcurrency <= 0 || m_config.reachabilityPerHost <= 0 ||
+         m_config.reachabilityTimeout <= 0)) {
+        m_errors.append("Reachability concurrency, per-host limit and timeout must be positive");
+    }
+
+    if (m_config.dnsConcurrency <= 0 || m_config.dnsTtl < 0 || m_config.dnsNegativeTtl < 0) {
+        m_errors.append("DNS concurrency must be positive and TTLs must not be negative");
+    }
+
     return m_errors.isEmpty();
 }
 
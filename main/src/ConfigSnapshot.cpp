@@ -0,0 +1,383 @@
+#include "../include/ConfigSnapshot.h"
+#include <QSaveFile>
+#include <QHash>
+#include <QVector>
+#include <QtEndian>
+#include <cstring>
+#include <limits>
+
+namespace {
+    using Field = ConfigStore::Field;
+
+    constexpr char Magic[8] = {'C', 'C', 'S', 'N', 'A', 'P', '\0', '\0'};
+    constexpr qsizetype FieldCount = qsizetype(Field::Count);
+    constexpr qsizetype WriteChunk = 256 * 1024;
+
+    // On-disk header; every integer little-endian
+    struct Header {
+        char magic[8];
+        quint32 version;
+        quint32 headerSize;
+        quint32 recordSize;
+        quint32 fieldCount;
+        quint32 mode;
+        quint32 reserved;
+        quint64 recordCount;
+        quint64 stringCount;
+        quint64 indexCapacity;
+        quint64 recordsOffset;
+        quint64 stringRefsOffset;
+        quint64 stringBytesOffset;
+        quint64 stringBytesSize;
+        quint64 indexOffset;
+    };
+    static_assert(sizeof(Header) == 96, "snapshot header layout");
+
+    // Record: key u64 | kind u8 | pad[3] | port i32 | alterId i32 | string ids u32[fieldCount]
+    constexpr qsizetype KeyOffset = 0;
+    constexpr qsizetype KindOffset = 8;
+    constexpr qsizetype PortOffset = 12;
+    constexpr qsizetype AlterIdOffset = 16;
+    constexpr qsizetype FieldsOffset = 20;
+    // String ref: offset u32 | length u32
+    constexpr qsizetype StringRefSize = 8;
+
+    constexpr qsizetype align8(qsizetype size) { return (size + 7) & ~qsizetype(7); }
+
+    constexpr qsizetype recordSizeFor(qsizetype fieldCount) {
+        return align8(FieldsOffset + 4 * fieldCount);
+    }
+
+    qsizetype indexCapacityFor(qsizetype count) {
+        qsizetype capacity = 16;
+        while (capacity < count * 2) {
+            capacity *= 2;
+        }
+        return capacity;
+    }
+
+    template <typename T>
+    T readLE(const uchar *p) {
+        return qFromLittleEndian<T>(p);
+    }
+
+    template <typename T>
+    void appendLE(QByteArray &out, T value) {
+        uchar bytes[sizeof(T)];
+        qToLittleEndian(value, bytes);
+        out.append(reinterpret_cast<const char*>(bytes), sizeof(T));
+    }
+
+    bool inBounds(quint64 offset, quint64 size, quint64 fileSize) {
+        return offset <= fileSize && size <= fileSize - offset;
+    }
+}
+
+ConfigSnapshot::~ConfigSnapshot() {
+    close();
+}
+
+Deduplicator::Mode ConfigSnapshot::KeyMode(Deduplicator::Mode mode) {
+    return mode == Deduplicator::Mode::Resolved ? Deduplicator::Mode::Endpoint : mode;
+}
+
+bool ConfigSnapshot::Write(const QString &path, const QList<const ConfigStore*> &stores,
+                           Deduplicator::Mode mode, QString *error) {
+    mode = KeyMode(mode);
+    auto fail = [&](const QString &message) {
+        if (error) {
+            *error = message;
+        }
+        return false;
+    };
+
+    qsizetype total = 0;
+    for (const ConfigStore *store : stores) {
+        total += store->size();
+    }
+    if (total > qsizetype(std::numeric_limits<quint32>::max()) - 1) {
+        return fail("Too many configs for one snapshot");
+    }
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return fail(file.errorString());
+    }
+
+    // Header is rewritten once the section sizes are known
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    if (file.write(reinterpret_cast<const char*>(&header), sizeof(header)) != qint64(sizeof(header))) {
+        return fail(file.errorString());
+    }
+
+    // Records stream out while strings are re-interned into one table for all stores
+    QByteArray stringBytes;
+    QByteArray stringRefs;
+    QHash<QByteArrayView, quint32> stringIds;
+    appendLE<quint32>(stringRefs, 0);
+    appendLE<quint32>(stringRefs, 0);
+    quint32 stringCount = 1;
+
+    const qsizetype recordSize = recordSizeFor(FieldCount);
+    const qsizetype indexCapacity = indexCapacityFor(total);
+    QVector<quint32> index(indexCapacity, 0);
+    const quint64 mask = quint64(indexCapacity - 1);
+
+    QByteArray buffer;
+    buffer.reserve(WriteChunk + recordSize);
+    quint32 row = 0;
+    for (const ConfigStore *store : stores) {
+        for (qsizetype r = 0; r < store->size(); ++r, ++row) {
+            const quint64 key = store->identityKey(r, mode);
+            appendLE<quint64>(buffer, key);
+            buffer.append(char(store->kind(r)));
+            buffer.append(3, '\0');
+            appendLE<qint32>(buffer, store->port(r));
+            appendLE<qint32>(buffer, store->alterId(r));
+
+            for (qsizetype f = 0; f < FieldCount; ++f) {
+                const QByteArrayView value = store->field(r, Field(f));
+                quint32 id = 0;
+                if (!value.isEmpty()) {
+                    auto it = stringIds.constFind(value);
+                    if (it == stringIds.cend()) {
+                        id = stringCount++;
+                        appendLE<quint32>(stringRefs, quint32(stringBytes.size()));
+                        appendLE<quint32>(stringRefs, quint32(value.size()));
+                        stringBytes.append(value.data(), value.size());
+                        stringIds.insert(value, id);
+                    } else {
+                        id = it.value();
+                    }
+                }
+                appendLE<quint32>(buffer, id);
+            }
+            buffer.append(recordSize - FieldsOffset - 4 * FieldCount, '\0');
+
+            // Linear probing keeps equal keys in insertion order, so find() returns the
+            // first row when the set was not deduplicated in this mode
+            quint64 slot = key & mask;
+            while (index[slot] != 0) {
+                slot = (slot + 1) & mask;
+            }
+            index[slot] = row + 1;
+
+            if (buffer.size() >= WriteChunk) {
+                if (file.write(buffer) != buffer.size()) {
+                    return fail(file.errorString());
+                }
+                buffer.clear();
+            }
+        }
+    }
+    if (file.write(buffer) != buffer.size()) {
+        return fail(file.errorString());
+    }
+
+    if (stringBytes.size() > qsizetype(std::numeric_limits<quint32>::max())) {
+        return fail("String table too large for one snapshot");
+    }
+
+    const quint64 recordsOffset = sizeof(Header);
+    const quint64 stringRefsOffset = recordsOffset + quint64(total) * recordSize;
+    const quint64 stringBytesOffset = stringRefsOffset + stringRefs.size();
+    const quint64 indexOffset = align8(stringBytesOffset + stringBytes.size());
+
+    QByteArray tail = stringRefs;
+    tail.append(stringBytes);
+    tail.append(qsizetype(indexOffset - stringBytesOffset - stringBytes.size()), '\0');
+    for (quint32 slot : index) {
+        appendLE<quint32>(tail, slot);
+    }
+    if (file.write(tail) != tail.size()) {
+        return fail(file.errorString());
+    }
+
+    std::memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = qToLittleEndian<quint32>(FormatVersion);
+    header.headerSize = qToLittleEndian<quint32>(sizeof(Header));
+    header.recordSize = qToLittleEndian<quint32>(quint32(recordSize));
+    header.fieldCount = qToLittleEndian<quint32>(quint32(FieldCount));
+    header.mode = qToLittleEndian<quint32>(quint32(mode));
+    header.recordCount = qToLittleEndian<quint64>(quint64(total));
+    header.stringCount = qToLittleEndian<quint64>(stringCount);
+    header.indexCapacity = qToLittleEndian<quint64>(quint64(indexCapacity));
+    header.recordsOffset = qToLittleEndian<quint64>(recordsOffset);
+    header.stringRefsOffset = qToLittleEndian<quint64>(stringRefsOffset);
+    header.stringBytesOffset = qToLittleEndian<quint64>(stringBytesOffset);
+    header.stringBytesSize = qToLittleEndian<quint64>(quint64(stringBytes.size()));
+    header.indexOffset = qToLittleEndian<quint64>(indexOffset);
+
+    if (!file.seek(0) ||
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header)) != qint64(sizeof(header))) {
+        return fail(file.errorString());
+    }
+    if (!file.commit()) {
+        return fail(file.errorString());
+    }
+    return true;
+}
+
+bool ConfigSnapshot::open(const QString &path) {
+    close();
+    m_error.clear();
+
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        return fail(m_file.errorString());
+    }
+
+    const quint64 fileSize = quint64(m_file.size());
+    if (fileSize < sizeof(Header)) {
+        return fail("Snapshot is truncated");
+    }
+
+    const uchar *data = m_file.map(0, qint64(fileSize));
+    if (!data) {
+        return fail(m_file.errorString());
+    }
+
+    Header header;
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, Magic, sizeof(Magic)) != 0) {
+        m_file.unmap(const_cast<uchar*>(data));
+        return fail("Not a config snapshot");
+    }
+    if (qFromLittleEndian(header.version) != FormatVersion) {
+        m_file.unmap(const_cast<uchar*>(data));
+        return fail(QString("Unsupported snapshot version %1").arg(qFromLittleEndian(header.version)));
+    }
+
+    const quint64 recordSize = qFromLittleEndian(header.recordSize);
+    const quint64 fieldCount = qFromLittleEndian(header.fieldCount);
+    const quint64 count = qFromLittleEndian(header.recordCount);
+    const quint64 stringCount = qFromLittleEndian(header.stringCount);
+    const quint64 indexCapacity = qFromLittleEndian(header.indexCapacity);
+    const quint64 recordsOffset = qFromLittleEndian(header.recordsOffset);
+    const quint64 stringRefsOffset = qFromLittleEndian(header.stringRefsOffset);
+    const quint64 stringBytesOffset = qFromLittleEndian(header.stringBytesOffset);
+    const quint64 stringBytesSize = qFromLittleEndian(header.stringBytesSize);
+    const quint64 indexOffset = qFromLittleEndian(header.indexOffset);
+    const quint32 mode = qFromLittleEndian(header.mode);
+
+    // Sections must lie inside the file; per-record ids are checked on access
+    const bool valid = qFromLittleEndian(header.headerSize) == sizeof(Header) &&
+                       fieldCount == quint64(FieldCount) &&
+                       recordSize == quint64(recordSizeFor(FieldCount)) &&
+                       count < std::numeric_limits<quint32>::max() &&
+                       stringCount >= 1 && stringCount <= std::numeric_limits<quint32>::max() &&
+                       indexCapacity >= 16 && (indexCapacity & (indexCapacity - 1)) == 0 &&
+                       indexCapacity <= fileSize && mode <= quint32(Deduplicator::Mode::Full) &&
+                       inBounds(recordsOffset, count * recordSize, fileSize) &&
+                       inBounds(stringRefsOffset, stringCount * StringRefSize, fileSize) &&
+                       inBounds(stringBytesOffset, stringBytesSize, fileSize) &&
+                       inBounds(indexOffset, indexCapacity * 4, fileSize);
+    if (!valid) {
+        m_file.unmap(const_cast<uchar*>(data));
+        return fail("Snapshot header is corrupt");
+    }
+
+    m_data = data;
+    m_count = qsizetype(count);
+    m_stringCount = qsizetype(stringCount);
+    m_indexCapacity = qsizetype(indexCapacity);
+    m_records = data + recordsOffset;
+    m_stringRefs = data + stringRefsOffset;
+    m_stringBytes = data + stringBytesOffset;
+    m_stringBytesSize = qsizetype(stringBytesSize);
+    m_index = data + indexOffset;
+    m_mode = Deduplicator::Mode(mode);
+    return true;
+}
+
+void ConfigSnapshot::close() {
+    if (m_data) {
+        m_file.unmap(const_cast<uchar*>(m_data));
+    }
+    m_file.close();
+    m_data = nullptr;
+    m_count = 0;
+    m_stringCount = 0;
+    m_indexCapacity = 0;
+    m_records = m_stringRefs = m_stringBytes = m_index = nullptr;
+    m_stringBytesSize = 0;
+}
+
+bool ConfigSnapshot::fail(const QString &error) {
+    m_error = error;
+    m_file.close();
+    return false;
+}
+
+const uchar *ConfigSnapshot::record(qsizetype row) const {
+    return m_records + row * recordSizeFor(FieldCount);
+}
+
+ConfigStore::Kind ConfigSnapshot::kind(qsizetype row) const {
+    return ConfigStore::Kind(record(row)[KindOffset]);
+}
+
+int ConfigSnapshot::port(qsizetype row) const {
+    return readLE<qint32>(record(row) + PortOffset);
+}
+
+int ConfigSnapshot::alterId(qsizetype row) const {
+    return readLE<qint32>(record(row) + AlterIdOffset);
+}
+
+quint64 ConfigSnapshot::identityKey(qsizetype row) const {
+    return readLE<quint64>(record(row) + KeyOffset);
+}
+
+QByteArrayView ConfigSnapshot::field(qsizetype row, ConfigStore::Field field) const {
+    const quint32 id = readLE<quint32>(record(row) + FieldsOffset + 4 * qsizetype(field));
+    if (id == 0 || id >= quint64(m_stringCount)) {
+        return QByteArrayView();
+    }
+
+    const uchar *ref = m_stringRefs + qsizetype(id) * StringRefSize;
+    const quint32 offset = readLE<quint32>(ref);
+    const quint32 length = readLE<quint32>(ref + 4);
+    if (!inBounds(offset, length, quint64(m_stringBytesSize))) {
+        return QByteArrayView();
+    }
+    return QByteArrayView(reinterpret_cast<const char*>(m_stringBytes) + offset, length);
+}
+
+qsizetype ConfigSnapshot::find(quint64 key) const {
+    if (!m_data) {
+        return -1;
+    }
+
+    const quint64 mask = quint64(m_indexCapacity - 1);
+    quint64 slot = key & mask;
+    // Bounded so a corrupt (full) index cannot loop forever
+    for (qsizetype probes = 0; probes < m_indexCapacity; ++probes) {
+        const quint32 entry = readLE<quint32>(m_index + slot * 4);
+        if (entry == 0) {
+            return -1;
+        }
+        const qsizetype row = qsizetype(entry) - 1;
+        if (row < m_count && identityKey(row) == key) {
+            return row;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return -1;
+}
+
+qsizetype ConfigSnapshot::appendRowTo(ConfigStore &store, qsizetype row) const {
+    std::array<QByteArrayView, size_t(Field::Count)> fields;
+    for (qsizetype f = 0; f < FieldCount; ++f) {
+        fields[size_t(f)] = field(row, Field(f));
+    }
+    return store.append(kind(row), port(row), alterId(row), fields);
+}
+
+void ConfigSnapshot::appendTo(ConfigStore &store) const {
+    store.reserve(store.size() + m_count);
+    for (qsizetype row = 0; row < m_count; ++row) {
+        appendRowTo(store, row);
+    }
+}
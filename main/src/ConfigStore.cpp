@@ -0,0 +1,298 @@
+#include "../include/ConfigStore.h"
+#include "../include/ConfigSchema.h"
+#include "../include/DnsCache.h"
+#include <QHashFunctions>
+
+namespace {
+    using Kind = ConfigStore::Kind;
+    using Field = ConfigStore::Field;
+
+    bool isAscii(QStringView text) {
+        for (QChar c : text) {
+            if (c.unicode() >= 0x80) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+ConfigStore::ConfigStore() {
+    clear();
+}
+
+void ConfigStore::clear() {
+    m_arena.clear();
+    m_strings.clear();
+    m_internIndex.clear();
+    m_kinds.clear();
+    m_ports.clear();
+    m_alterIds.clear();
+    for (auto &column : m_fields) {
+        column.clear();
+    }
+
+    // Id 0 is the empty string, so default-initialized columns read as ""
+    m_strings.append(StringRef());
+}
+
+void ConfigStore::reserve(qsizetype rows) {
+    m_kinds.reserve(rows);
+    m_ports.reserve(rows);
+    m_alterIds.reserve(rows);
+    for (auto &column : m_fields) {
+        column.reserve(rows);
+    }
+}
+
+// String arena
+
+quint32 ConfigStore::intern(QStringView text) {
+    if (text.isEmpty()) {
+        return 0;
+    }
+
+    // Nearly every value is ASCII; narrow it without going through a temporary QString
+    if (isAscii(text)) {
+        m_scratch.resize(text.size());
+        char *out = m_scratch.data();
+        for (qsizetype i = 0; i < text.size(); ++i) {
+            out[i] = char(text[i].unicode());
+        }
+    } else {
+        m_scratch = text.toUtf8();
+    }
+    return internUtf8(m_scratch);
+}
+
+quint32 ConfigStore::internUtf8(QByteArrayView utf8) {
+    if (utf8.isEmpty()) {
+        return 0;
+    }
+
+    const size_t hash = qHash(utf8);
+    for (auto it = m_internIndex.constFind(hash); it != m_internIndex.cend() && it.key() == hash; ++it) {
+        if (stringAt(it.value()) == utf8) {
+            return it.value();
+        }
+    }
+
+    StringRef ref;
+    ref.offset = quint32(m_arena.size());
+    ref.length = quint32(utf8.size());
+    m_arena.append(utf8.data(), utf8.size());
+
+    const quint32 id = quint32(m_strings.size());
+    m_strings.append(ref);
+    m_internIndex.insert(hash, id);
+    return id;
+}
+
+QByteArrayView ConfigStore::stringAt(quint32 id) const {
+    const StringRef &ref = m_strings[id];
+    return QByteArrayView(m_arena.constData() + ref.offset, ref.length);
+}
+
+QByteArrayView ConfigStore::field(qsizetype row, Field field) const {
+    return stringAt(m_fields[size_t(field)][row]);
+}
+
+QString ConfigStore::fieldString(qsizetype row, Field field) const {
+    return QString::fromUtf8(this->field(row, field));
+}
+
+void ConfigStore::setField(Field field, QStringView text) {
+    m_fields[size_t(field)].last() = intern(text);
+}
+
+// Rows
+
+qsizetype ConfigStore::append(const ProxyBean &bean) {
+    const Kind kind = bean.type;
+    if (kind == Kind::Unknown) {
+        return -1;
+    }
+
+    const qsizetype row = size();
+    m_kinds.append(quint8(kind));
+    m_ports.append(bean.serverPort);
+    m_alterIds.append(0);
+    for (auto &column : m_fields) {
+        column.append(0);
+    }
+
+    setField(Field::Name, bean.name);
+    setField(Field::Server, bean.serverAddress);
+    setField(Field::Source, bean.source);
+
+    ConfigSchema::Dispatch(kind, [&](auto schema) {
+        using S = decltype(schema);
+        auto typed = dynamic_cast<const typename S::Bean*>(&bean);
+        if (!typed) {
+            return;
+        }
+        for (const auto &spec : S::Fields) {
+            switch (spec.value) {
+            case ConfigSchema::Value::Text:
+                setField(spec.column, typed->*spec.text);
+                break;
+            case ConfigSchema::Value::Number:
+                m_alterIds.last() = typed->*spec.number;
+                break;
+            case ConfigSchema::Value::Flag:
+                setField(spec.column, typed->*spec.flag ? u"1" : u"");
+                break;
+            }
+        }
+    });
+
+    return row;
+}
+
+qsizetype ConfigStore::append(Kind kind, int port, int alterId,
+                              const std::array<QByteArrayView, size_t(Field::Count)> &fields) {
+    const qsizetype row = size();
+    m_kinds.append(quint8(kind));
+    m_ports.append(port);
+    m_alterIds.append(alterId);
+    for (size_t f = 0; f < fields.size(); ++f) {
+        m_fields[f].append(internUtf8(fields[f]));
+    }
+    return row;
+}
+
+std::shared_ptr<ProxyBean> ConfigStore::bean(qsizetype row) const {
+    std::shared_ptr<ProxyBean> result;
+    ConfigSchema::Dispatch(kind(row), [&](auto schema) {
+        using S = decltype(schema);
+        auto typed = std::make_shared<typename S::Bean>();
+        for (const auto &spec : S::Fields) {
+            switch (spec.value) {
+            case ConfigSchema::Value::Text:
+                typed.get()->*spec.text = fieldString(row, spec.column);
+                break;
+            case ConfigSchema::Value::Number:
+                typed.get()->*spec.number = alterId(row);
+                break;
+            case ConfigSchema::Value::Flag:
+                typed.get()->*spec.flag = !field(row, spec.column).isEmpty();
+                break;
+            }
+        }
+        result = typed;
+    });
+    if (!result) {
+        return nullptr;
+    }
+
+    result->type = kind(row);
+    result->name = fieldString(row, Field::Name);
+    result->serverAddress = fieldString(row, Field::Server);
+    result->serverPort = port(row);
+    result->source = fieldString(row, Field::Source);
+    return result;
+}
+
+void ConfigStore::visitJson(qsizetype row, JsonFieldVisitor &visitor) const {
+    const Kind k = kind(row);
+    const ConfigSchema::RowFields fields(*this, row);
+    const bool known = ConfigSchema::Dispatch(k, [&](auto schema) {
+        ConfigSchema::VisitJson<decltype(schema)>(fields, k, visitor);
+    });
+    if (!known) {
+        ConfigSchema::VisitJson<ConfigSchema::CommonSchema>(fields, k, visitor);
+    }
+}
+
+QJsonObject ConfigStore::toJson(qsizetype row) const {
+    JsonObjectBuilder builder;
+    visitJson(row, builder);
+    return builder.object;
+}
+
+quint64 ConfigStore::identityKey(qsizetype row, Deduplicator::Mode mode, const DnsCache *resolver) const {
+    // Same generated field order as the beans' HashCredentials / HashTransport
+    IdentityHasher hasher;
+    hasher.addUtf8(ProxyTypeName(kind(row)));
+    const QString address = mode == Deduplicator::Mode::Resolved && resolver
+                                ? resolver->canonicalAddress(fieldString(row, Field::Server))
+                                : QString();
+    if (address.isEmpty()) {
+        hasher.addHostUtf8(field(row, Field::Server));
+    } else {
+        hasher.addHost(address);
+    }
+    hasher.add(qint64(port(row)));
+
+    const bool credentials = mode == Deduplicator::Mode::Credentials || mode == Deduplicator::Mode::Full;
+    const bool transport = mode == Deduplicator::Mode::Full;
+    const ConfigSchema::RowFields fields(*this, row);
+    ConfigSchema::Dispatch(kind(row), [&](auto schema) {
+        using S = decltype(schema);
+        if (credentials) {
+            ConfigSchema::Hash<S>(fields, ConfigSchema::Identity::Credentials, hasher);
+        }
+        if (transport) {
+            ConfigSchema::Hash<S>(fields, ConfigSchema::Identity::Transport, hasher);
+        }
+    });
+    return hasher.result();
+}
+
+qsizetype ConfigStore::removeIf(const std::function<bool(const ConfigRecord &record)> &predicate) {
+    // Compact every column with the same read/write cursors; the arena is left as is
+    qsizetype kept = 0;
+    const qsizetype rows = size();
+    for (qsizetype row = 0; row < rows; ++row) {
+        if (predicate(ConfigRecord(this, row))) {
+            continue;
+        }
+        if (kept != row) {
+            m_kinds[kept] = m_kinds[row];
+            m_ports[kept] = m_ports[row];
+            m_alterIds[kept] = m_alterIds[row];
+            for (auto &column : m_fields) {
+                column[kept] = column[row];
+            }
+        }
+        ++kept;
+    }
+
+    m_kinds.resize(kept);
+    m_ports.resize(kept);
+    m_alterIds.resize(kept);
+    for (auto &column : m_fields) {
+        column.resize(kept);
+    }
+    return rows - kept;
+}
+
+qsizetype ConfigStore::deduplicate(Deduplicator &dedup) {
+    const Deduplicator::Mode mode = dedup.mode();
+    const DnsCache *resolver = dedup.resolver();
+    return removeIf([&dedup, mode, resolver](const ConfigRecord &record) {
+        return !dedup.insertKey(record.store().identityKey(record.row(), mode, resolver));
+    });
+}
+
+qsizetype ConfigStore::memoryUsage() const {
+    qsizetype bytes = m_arena.capacity();
+    bytes += m_strings.capacity() * qsizetype(sizeof(StringRef));
+    bytes += m_internIndex.size() * qsizetype(sizeof(size_t) + sizeof(quint32));
+    bytes += m_kinds.capacity() * qsizetype(sizeof(quint8));
+    bytes += m_ports.capacity() * qsizetype(sizeof(qint32));
+    bytes += m_alterIds.capacity() * qsizetype(sizeof(qint32));
+    for (const auto &column : m_fields) {
+        bytes += column.capacity() * qsizetype(sizeof(quint32));
+    }
+    return bytes;
+}
+
+QString ConfigStore::KindName(Kind kind) {
+    return QString::fromLatin1(ProxyTypeName(kind));
+}
+
+bool ConfigStore::KindFromName(QStringView name, Kind &kind) {
+    kind = ProxyTypeFromName(name);
+    return kind != Kind::Unknown;
+}
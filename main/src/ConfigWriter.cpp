@@ -0,0 +1,197 @@
+#include "../include/ConfigWriter.h"
+#include "../include/LinkEncoder.h"
+#include <QSaveFile>
+
+namespace {
+    const char HexDigits[] = "0123456789abcdef";
+
+    // Appends "key":value pairs for one object to the writer's buffer
+    class BufferVisitor : public JsonFieldVisitor {
+    public:
+        explicit BufferVisitor(QByteArray &out) : m_out(out) {}
+
+        void string(const char *key, QByteArrayView utf8) override {
+            appendKey(key);
+            ConfigWriter::AppendString(m_out, utf8);
+        }
+
+        void number(const char *key, qint64 value) override {
+            appendKey(key);
+            m_out.append(QByteArray::number(value));
+        }
+
+        void boolean(const char *key, bool value) override {
+            appendKey(key);
+            m_out.append(value ? "true" : "false");
+        }
+
+    private:
+        void appendKey(const char *key) {
+            if (!m_first) {
+                m_out.append(',');
+            }
+            m_first = false;
+            ConfigWriter::AppendString(m_out, QByteArrayView(key));
+            m_out.append(':');
+        }
+
+        QByteArray &m_out;
+        bool m_first = true;
+    };
+}
+
+ConfigWriter::ConfigWriter(Format format, qsizetype bufferSize)
+    : m_format(format), m_bufferSize(qMax<qsizetype>(bufferSize, 1024)) {
+}
+
+ConfigWriter::~ConfigWriter() {
+    if (m_file) {
+        m_file->cancelWriting();
+    }
+}
+
+bool ConfigWriter::open(const QString &path, const QString &subscription) {
+    m_file = std::make_unique<QSaveFile>(path);
+    m_buffer.clear();
+    m_buffer.reserve(m_bufferSize + 4096);
+    m_count = 0;
+    m_links.clear();
+    m_error.clear();
+
+    if (!m_file->open(QIODevice::WriteOnly)) {
+        return fail(m_file->errorString());
+    }
+
+    if (m_format == Format::JsonDocument) {
+        m_buffer.append("{\"subscription\":");
+        AppendString(m_buffer, subscription.toUtf8());
+        m_buffer.append(",\"configs\":[");
+    }
+    return true;
+}
+
+void ConfigWriter::beginObject() {
+    if (m_format == Format::JsonDocument) {
+        m_buffer.append(m_count == 0 ? "\n" : ",\n");
+    }
+}
+
+void ConfigWriter::endObject() {
+    if (m_format == Format::Ndjson) {
+        m_buffer.append('\n');
+    }
+    ++m_count;
+}
+
+bool ConfigWriter::write(const ConfigStore &store, qsizetype row) {
+    if (!m_file) {
+        return fail("Writer is not open");
+    }
+    if (m_format == Format::Links) {
+        return writeLink(LinkEncoder::Encode(store, row));
+    }
+
+    beginObject();
+    m_buffer.append('{');
+    BufferVisitor visitor(m_buffer);
+    store.visitJson(row, visitor);
+    m_buffer.append('}');
+    endObject();
+
+    return m_buffer.size() < m_bufferSize || flush();
+}
+
+bool ConfigWriter::write(const ProxyBean &bean) {
+    if (!m_file) {
+        return fail("Writer is not open");
+    }
+    if (m_format == Format::Links) {
+        return writeLink(LinkEncoder::Encode(bean));
+    }
+
+    beginObject();
+    m_buffer.append('{');
+    BufferVisitor visitor(m_buffer);
+    bean.visitJson(visitor);
+    m_buffer.append('}');
+    endObject();
+
+    return m_buffer.size() < m_bufferSize || flush();
+}
+
+bool ConfigWriter::writeLink(const QByteArray &link) {
+    // Configs that differ only in fields a link does not carry give the same line
+    if (link.isEmpty() || m_links.contains(link)) {
+        return true;
+    }
+    m_links.insert(link);
+    m_buffer.append(link);
+    m_buffer.append('\n');
+    ++m_count;
+
+    return m_buffer.size() < m_bufferSize || flush();
+}
+
+bool ConfigWriter::flush() {
+    if (!m_buffer.isEmpty() && m_file->write(m_buffer) != m_buffer.size()) {
+        return fail(m_file->errorString());
+    }
+    m_buffer.clear();
+    return true;
+}
+
+bool ConfigWriter::commit() {
+    if (!m_file) {
+        return fail("Writer is not open");
+    }
+
+    if (m_format == Format::JsonDocument) {
+        m_buffer.append(m_count == 0 ? "]}\n" : "\n]}\n");
+    }
+
+    bool ok = flush() && m_file->commit();
+    if (!ok && m_error.isEmpty()) {
+        m_error = m_file->errorString();
+    }
+    m_file.reset();
+    return ok;
+}
+
+bool ConfigWriter::fail(const QString &error) {
+    m_error = error;
+    return false;
+}
+
+void ConfigWriter::AppendString(QByteArray &out, QByteArrayView utf8) {
+    out.append('"');
+
+    // Copy runs of plain bytes at once; UTF-8 sequences pass through unchanged
+    const char *data = utf8.data();
+    qsizetype runStart = 0;
+    for (qsizetype i = 0; i < utf8.size(); ++i) {
+        const uchar c = uchar(data[i]);
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+
+        out.append(data + runStart, i - runStart);
+        runStart = i + 1;
+        switch (c) {
+        case '"': out.append("\\\""); break;
+        case '\\': out.append("\\\\"); break;
+        case '\n': out.append("\\n"); break;
+        case '\r': out.append("\\r"); break;
+        case '\t': out.append("\\t"); break;
+        case '\b': out.append("\\b"); break;
+        case '\f': out.append("\\f"); break;
+        default:
+            out.append("\\u00");
+            out.append(HexDigits[c >> 4]);
+            out.append(HexDigits[c & 0xf]);
+            break;
+        }
+    }
+    out.append(data + runStart, utf8.size() - runStart);
+
+    out.append('"');
+}
@@ -0,0 +1,234 @@
+#include "../include/Deduplicator.h"
+#include "../include/DnsCache.h"
+
+namespace {
+    constexpr quint64 MurmurMultiplier = 0xc6a4a7935bd1e995ULL;
+    constexpr int MurmurShift = 47;
+
+    // Keep the table at most half full; probes stay short even for clustered keys
+    constexpr qsizetype MinCapacity = 16;
+
+    qsizetype capacityFor(qsizetype expected) {
+        qsizetype capacity = MinCapacity;
+        while (capacity < expected * 2) {
+            capacity *= 2;
+        }
+        return capacity;
+    }
+
+    quint64 finalize(quint64 h) {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return h;
+    }
+}
+
+// HashSet64
+
+HashSet64::HashSet64(qsizetype expected) {
+    m_slots.fill(0, capacityFor(expected));
+}
+
+bool HashSet64::insert(quint64 key) {
+    key = normalized(key);
+    if ((m_size + 1) * 2 > m_slots.size()) {
+        rehash(m_slots.size() * 2);
+    }
+
+    const qsizetype mask = m_slots.size() - 1;
+    qsizetype index = qsizetype(finalize(key)) & mask;
+    while (true) {
+        quint64 &slot = m_slots[index];
+        if (slot == 0) {
+            slot = key;
+            ++m_size;
+            return true;
+        }
+        if (slot == key) {
+            return false;
+        }
+        index = (index + 1) & mask;
+    }
+}
+
+bool HashSet64::contains(quint64 key) const {
+    key = normalized(key);
+    const qsizetype mask = m_slots.size() - 1;
+    qsizetype index = qsizetype(finalize(key)) & mask;
+    while (true) {
+        const quint64 slot = m_slots[index];
+        if (slot == 0) {
+            return false;
+        }
+        if (slot == key) {
+            return true;
+        }
+        index = (index + 1) & mask;
+    }
+}
+
+void HashSet64::reserve(qsizetype expected) {
+    qsizetype capacity = capacityFor(expected);
+    if (capacity > m_slots.size()) {
+        rehash(capacity);
+    }
+}
+
+void HashSet64::clear() {
+    m_slots.fill(0, MinCapacity);
+    m_size = 0;
+}
+
+void HashSet64::rehash(qsizetype capacity) {
+    QVector<quint64> old;
+    old.swap(m_slots);
+    m_slots.fill(0, capacity);
+
+    const qsizetype mask = capacity - 1;
+    for (quint64 key : old) {
+        if (key == 0) {
+            continue;
+        }
+        qsizetype index = qsizetype(finalize(key)) & mask;
+        while (m_slots[index] != 0) {
+            index = (index + 1) & mask;
+        }
+        m_slots[index] = key;
+    }
+}
+
+// IdentityHasher
+
+void IdentityHasher::mix(quint64 word) {
+    word *= MurmurMultiplier;
+    word ^= word >> MurmurShift;
+    word *= MurmurMultiplier;
+    m_hash ^= word;
+    m_hash *= MurmurMultiplier;
+}
+
+template <typename Unit>
+void IdentityHasher::addUnits(const Unit *data, qsizetype size) {
+    // Four UTF-16 code units per word, then the length so ("ab","c") != ("a","bc")
+    qsizetype i = 0;
+    for (; i + 4 <= size; i += 4) {
+        mix(quint64(data[i]) | quint64(data[i + 1]) << 16 | quint64(data[i + 2]) << 32 |
+            quint64(data[i + 3]) << 48);
+    }
+    quint64 tail = 0;
+    for (int shift = 0; i < size; ++i, shift += 16) {
+        tail |= quint64(data[i]) << shift;
+    }
+    mix(tail);
+    mix(quint64(size));
+    m_length += quint64(size) + 1;
+}
+
+void IdentityHasher::add(QStringView field) {
+    addUnits(field.utf16(), field.size());
+}
+
+void IdentityHasher::addHost(QStringView host) {
+    for (QChar c : host) {
+        if (c.unicode() >= 'A' && c.unicode() <= 'Z') {
+            add(host.toString().toLower());
+            return;
+        }
+    }
+    add(host);
+}
+
+void IdentityHasher::addUtf8(QByteArrayView field) {
+    // ASCII bytes are their own UTF-16 code units
+    const uchar *data = reinterpret_cast<const uchar*>(field.data());
+    for (qsizetype i = 0; i < field.size(); ++i) {
+        if (data[i] >= 0x80) {
+            add(QString::fromUtf8(field));
+            return;
+        }
+    }
+    addUnits(data, field.size());
+}
+
+void IdentityHasher::addHostUtf8(QByteArrayView host) {
+    for (char c : host) {
+        if ((c >= 'A' && c <= 'Z') || uchar(c) >= 0x80) {
+            addHost(QString::fromUtf8(host));
+            return;
+        }
+    }
+    addUtf8(host);
+}
+
+void IdentityHasher::add(qint64 value) {
+    mix(quint64(value));
+    m_length += 1;
+}
+
+quint64 IdentityHasher::result() const {
+    return finalize(m_hash ^ m_length);
+}
+
+// Deduplicator
+
+Deduplicator::Deduplicator(Mode mode, qsizetype expected)
+    : m_mode(mode), m_seen(expected) {
+}
+
+bool Deduplicator::insert(const ProxyBean &bean) {
+    return m_seen.insert(IdentityKey(bean, m_mode, m_resolver));
+}
+
+bool Deduplicator::contains(const ProxyBean &bean) const {
+    return m_seen.contains(IdentityKey(bean, m_mode, m_resolver));
+}
+
+quint64 Deduplicator::IdentityKey(const ProxyBean &bean, Mode mode, const DnsCache *resolver) {
+    IdentityHasher hasher;
+    // The name, not the enum value, so keys saved in earlier snapshots still match
+    hasher.addUtf8(ProxyTypeName(bean.type));
+    const QString address = mode == Mode::Resolved && resolver ? resolver->canonicalAddress(bean.serverAddress)
+                                                               : QString();
+    hasher.addHost(address.isEmpty() ? bean.serverAddress : address);
+    hasher.add(qint64(bean.serverPort));
+
+    if (mode == Mode::Credentials || mode == Mode::Full) {
+        bean.HashCredentials(hasher);
+    }
+    if (mode == Mode::Full) {
+        bean.HashTransport(hasher);
+    }
+    return hasher.result();
+}
+
+bool Deduplicator::ParseMode(const QString &name, Mode &mode) {
+    const QString key = name.trimmed().toLower();
+    if (key == "endpoint") {
+        mode = Mode::Endpoint;
+    } else if (key == "credentials") {
+        mode = Mode::Credentials;
+    } else if (key == "full") {
+        mode = Mode::Full;
+    } else if (key == "resolved") {
+        mode = Mode::Resolved;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+QString Deduplicator::ModeName(Mode mode) {
+    switch (mode) {
+    case Mode::Credentials:
+        return "credentials";
+    case Mode::Full:
+        return "full";
+    case Mode::Resolved:
+        return "resolved";
+    default:
+        return "endpoint";
+    }
+}
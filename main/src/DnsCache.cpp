@@ -0,0 +1,165 @@
+#include "../include/DnsCache.h"
+#include <QHostInfo>
+#include <QObject>
+#include <QEventLoop>
+#include <QElapsedTimer>
+#include <QLoggingCategory>
+#include <algorithm>
+
+Q_LOGGING_CATEGORY(DNS_CACHE, "config.dns")
+
+namespace {
+    bool addressLess(const QHostAddress &a, const QHostAddress &b) {
+        const bool a4 = a.protocol() == QAbstractSocket::IPv4Protocol;
+        const bool b4 = b.protocol() == QAbstractSocket::IPv4Protocol;
+        if (a4 != b4) {
+            return a4;
+        }
+        return a.toString() < b.toString();
+    }
+}
+
+DnsCache::DnsCache()
+    : DnsCache(Options()) {
+}
+
+DnsCache::DnsCache(const Options &options)
+    : m_options(options),
+      m_context(std::make_unique<QObject>()) {
+    m_options.maxConcurrent = qMax(1, m_options.maxConcurrent);
+}
+
+DnsCache::~DnsCache() {
+    // Outstanding lookups lose their receiver and are dropped
+    m_context.reset();
+}
+
+QString DnsCache::NormalizedHost(const QString &host) {
+    QString key = host.trimmed().toLower();
+    if (key.startsWith('[') && key.endsWith(']')) {
+        key = key.mid(1, key.size() - 2);
+    }
+    return key;
+}
+
+const DnsCache::Entry *DnsCache::answeredEntry(const QString &key) const {
+    auto it = m_entries.constFind(key);
+    if (it == m_entries.cend() || !it->answered) {
+        return nullptr;
+    }
+    return &it.value();
+}
+
+void DnsCache::queue(const QString &key, Entry &entry) {
+    entry.pending = true;
+    m_queue.enqueue(key);
+}
+
+void DnsCache::prefetch(const QString &host) {
+    const QString key = NormalizedHost(host);
+    if (key.isEmpty()) {
+        return;
+    }
+
+    auto it = m_entries.find(key);
+    if (it != m_entries.end() && (it->pending || !it->expires.hasExpired())) {
+        return;
+    }
+
+    Entry &entry = m_entries[key];
+    QHostAddress literal;
+    if (literal.setAddress(key)) {
+        // Nothing to resolve
+        entry.addresses = {literal};
+        entry.canonical = literal.toString();
+        entry.failed = false;
+        entry.answered = true;
+        entry.pending = false;
+        entry.expires = QDeadlineTimer(QDeadlineTimer::Forever);
+        return;
+    }
+
+    queue(key, entry);
+    startNext();
+}
+
+void DnsCache::run() {
+    // Names prefetched early in a long run may have expired since; look them up
+    // again so callers see this run's answers rather than falling back to names
+    for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+        if (it->answered && !it->pending && it->expires.hasExpired()) {
+            queue(it.key(), it.value());
+        }
+    }
+    if (pending() == 0) {
+        return;
+    }
+
+    QEventLoop loop;
+    m_idleCallback = [&loop]() { loop.quit(); };
+
+    startNext();
+    if (pending() > 0) {
+        loop.exec();
+    }
+
+    m_idleCallback = nullptr;
+}
+
+void DnsCache::startNext() {
+    while (m_active < m_options.maxConcurrent && !m_queue.isEmpty()) {
+        const QString key = m_queue.dequeue();
+        ++m_active;
+        ++m_lookups;
+        QElapsedTimer timer;
+        timer.start();
+        QHostInfo::lookupHost(key, m_context.get(), [this, key, timer](const QHostInfo &info) {
+            m_lookupNs += timer.nsecsElapsed();
+            finished(key, info.addresses(), info.error() != QHostInfo::NoError || info.addresses().isEmpty());
+        });
+    }
+}
+
+void DnsCache::finished(const QString &key, const QList<QHostAddress> &addresses, bool failed) {
+    --m_active;
+
+    Entry &entry = m_entries[key];
+    entry.pending = false;
+    entry.answered = true;
+    entry.failed = failed;
+    if (failed) {
+        ++m_failures;
+        entry.addresses.clear();
+        entry.canonical.clear();
+        entry.expires = QDeadlineTimer(m_options.negativeTtlMs);
+        qCDebug(DNS_CACHE) << "Lookup failed:" << key;
+    } else {
+        entry.addresses = addresses;
+        entry.canonical = std::min_element(addresses.begin(), addresses.end(), addressLess)->toString();
+        entry.expires = QDeadlineTimer(m_options.ttlMs);
+    }
+
+    startNext();
+
+    if (pending() == 0 && m_idleCallback) {
+        m_idleCallback();
+    }
+}
+
+DnsCache::Status DnsCache::status(const QString &host) const {
+    const Entry *entry = answeredEntry(NormalizedHost(host));
+    if (!entry) {
+        return Status::Unknown;
+    }
+    return entry->failed ? Status::Failed : Status::Resolved;
+}
+
+QList<QHostAddress> DnsCache::addresses(const QString &host) const {
+    const Entry *entry = answeredEntry(NormalizedHost(host));
+    return entry ? entry->addresses : QList<QHostAddress>();
+}
+
+QString DnsCache::canonicalAddress(const QString &host) const {
+    const Entry *entry = answeredEntry(NormalizedHost(host));
+    return entry ? entry->canonical : QString();
+}
@@ -0,0 +1,527 @@
+#include "../include/DownloadScheduler.h"
+#include "../include/FetchCache.h"
+#include <QNetworkReply>
+#include <QSaveFile>
+#include <QEventLoop>
+#include <QTimer>
+#include <QUrl>
+#include <QLoggingCategory>
+#include <climits>
+
+Q_LOGGING_CATEGORY(SCHEDULER, "config.scheduler")
+
+namespace {
+    const char DeadlineReason[] = "Cancelled at the run deadline";
+}
+
+DownloadScheduler::DownloadScheduler(int maxConcurrent, int timeoutMs, HttpHelper &client)
+    : m_client(client),
+      m_maxConcurrent(qMax(1, maxConcurrent)),
+      m_timeoutMs(timeoutMs > 0 ? timeoutMs : HttpHelper::defaultTimeout()),
+      m_context(std::make_unique<QObject>()) {
+}
+
+DownloadScheduler::~DownloadScheduler() {
+    // Pending retry and hedge timers lose their receiver
+    m_context.reset();
+
+    // Abort anything still running without re-entering handleFinished
+    const auto replies = m_inFlight.keys();
+    m_inFlight.clear();
+    m_attempts.clear();
+    for (QNetworkReply *reply : replies) {
+        reply->disconnect();
+        reply->abort();
+        reply->deleteLater();
+    }
+}
+
+int DownloadScheduler::enqueue(const QString &url) {
+    Job job;
+    job.id = m_nextId++;
+    job.url = url;
+    m_queue.enqueue(job);
+    if (m_idleCallback) {
+        // Queued from a handler while run() is active; start it once the handler has returned
+        QTimer::singleShot(0, m_context.get(), [this]() { startNext(); });
+    }
+    return job.id;
+}
+
+void DownloadScheduler::run() {
+    if (m_queue.isEmpty() && m_attempts.isEmpty() && m_delayed.isEmpty()) {
+        return;
+    }
+    if (m_deadline.hasExpired()) {
+        cancelAll(DeadlineReason);
+        return;
+    }
+
+    QEventLoop loop;
+    m_idleCallback = [&loop]() { loop.quit(); };
+
+    QTimer deadlineTimer;
+    if (!m_deadline.isForever()) {
+        deadlineTimer.setSingleShot(true);
+        QObject::connect(&deadlineTimer, &QTimer::timeout, &deadlineTimer, [this]() {
+            cancelAll(DeadlineReason);
+        });
+        deadlineTimer.start(int(qBound<qint64>(0, m_deadline.remainingTime(), INT_MAX)));
+    }
+
+    startNext();
+    if (!m_queue.isEmpty() || !m_attempts.isEmpty() || !m_delayed.isEmpty()) {
+        loop.exec();
+    }
+
+    m_idleCallback = nullptr;
+}
+
+void DownloadScheduler::notifyIfIdle() {
+    if (m_attempts.isEmpty() && m_queue.isEmpty() && m_delayed.isEmpty() && m_idleCallback) {
+        m_idleCallback();
+    }
+}
+
+void DownloadScheduler::startNext() {
+    if (m_deadline.hasExpired() && !m_queue.isEmpty()) {
+        // Queued by a handler after the cutoff
+        cancelAll(DeadlineReason);
+        return;
+    }
+
+    qsizetype index = 0;
+    while (m_attempts.size() < m_maxConcurrent && index < m_queue.size()) {
+        const QString host = QUrl(m_queue.at(index).url).host();
+        if (m_perHostLimit > 0 && !host.isEmpty() && jobsInFlight(host) >= m_perHostLimit) {
+            // Stays queued; a finishing job for this host calls startNext() again
+            ++index;
+            continue;
+        }
+        Job job = m_queue.takeAt(index);
+
+        if (!host.isEmpty() && !m_breaker.allow(host)) {
+            finishRejected(job, host);
+            continue;
+        }
+
+        launch(job);
+        if (m_hedgeDelayMs > 0 && !host.isEmpty()) {
+            const int delay = int(m_latency.hedgeDelay(m_hedgeDelayMs));
+            QTimer::singleShot(delay, m_context.get(), [this, id = job.id, attempt = job.attempt]() {
+                startHedge(id, attempt);
+            });
+        }
+
+        qCDebug(SCHEDULER) << "Started" << job.url << "in flight:" << m_attempts.size()
+                           << "queued:" << m_queue.size();
+    }
+}
+
+int DownloadScheduler::jobsInFlight(const QString &host) const {
+    int count = 0;
+    for (const QList<QNetworkReply*> &replies : m_attempts) {
+        if (replies.isEmpty()) {
+            continue;
+        }
+        auto it = m_inFlight.constFind(replies.first());
+        if (it != m_inFlight.cend() && QUrl(it->url).host() == host) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+QNetworkReply *DownloadScheduler::launch(Job job) {
+    HttpRequestOptions options;
+    options.timeoutMs = m_timeoutMs;
+    if (negotiatesEncoding()) {
+        // Qt stops decoding on its own once the header is set; bodies go through bodyFormat()
+        options.headers.append({"Accept-Encoding", StreamDecompressor::AcceptEncoding()});
+    }
+
+    if (m_cache && !job.bypassCache) {
+        FetchCache::Entry entry = m_cache->lookup(job.url);
+        if (entry.isValid() && entry.hasValidators()) {
+            FetchCache::addValidators(entry, options);
+            job.conditional = true;
+        }
+    }
+
+    job.started.start();
+    QNetworkReply *reply = m_client.get(job.url, options);
+    m_inFlight.insert(reply, job);
+    m_attempts[job.id].append(reply);
+    QObject::connect(reply, &QNetworkReply::finished, reply, [this, reply]() {
+        handleFinished(reply);
+    });
+    // Phase marks for run metrics
+    QObject::connect(reply, &QNetworkReply::requestSent, reply, [this, reply]() {
+        auto it = m_inFlight.find(reply);
+        if (it != m_inFlight.end() && it->sentNs < 0) {
+            it->sentNs = it->started.nsecsElapsed();
+        }
+    });
+    QObject::connect(reply, &QNetworkReply::metaDataChanged, reply, [this, reply]() {
+        auto it = m_inFlight.find(reply);
+        if (it == m_inFlight.end() || it->headersNs >= 0) {
+            return;
+        }
+        it->headersNs = it->started.nsecsElapsed();
+        const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+        if (isSuccessfulBody(reply) || status == 304) {
+            commit(reply);
+        }
+    });
+    if (m_chunkHandler) {
+        QObject::connect(reply, &QNetworkReply::readyRead, reply, [this, reply]() {
+            handleReadyRead(reply);
+        });
+    }
+    return reply;
+}
+
+void DownloadScheduler::startHedge(int id, int attempt) {
+    auto it = m_attempts.constFind(id);
+    if (it == m_attempts.cend() || it->size() != 1) {
+        return;
+    }
+
+    const Job &running = m_inFlight[it->first()];
+    if (running.attempt != attempt || running.headersNs >= 0 || running.bytesStreamed > 0) {
+        // Already answering, or a later attempt has its own timer
+        return;
+    }
+
+    Job hedge;
+    hedge.id = running.id;
+    hedge.url = running.url;
+    hedge.bypassCache = running.bypassCache;
+    hedge.attempt = running.attempt;
+    hedge.hedge = true;
+    ++m_hedges;
+    qCDebug(SCHEDULER) << "Hedging slow request:" << hedge.url;
+    launch(hedge);
+}
+
+void DownloadScheduler::commit(QNetworkReply *reply) {
+    auto it = m_inFlight.constFind(reply);
+    if (it == m_inFlight.cend() || m_attempts.value(it->id).size() < 2) {
+        return;
+    }
+    if (it->hedge) {
+        ++m_hedgeWins;
+    }
+    abortAttempts(it->id, reply);
+}
+
+void DownloadScheduler::abortAttempts(int id, QNetworkReply *except) {
+    const QList<QNetworkReply*> replies = m_attempts.value(id);
+    QList<QNetworkReply*> kept;
+    for (QNetworkReply *other : replies) {
+        if (other == except) {
+            kept.append(other);
+            continue;
+        }
+        m_inFlight.remove(other);
+        other->disconnect();
+        other->abort();
+        other->deleteLater();
+    }
+    if (kept.isEmpty()) {
+        m_attempts.remove(id);
+    } else {
+        m_attempts[id] = kept;
+    }
+}
+
+void DownloadScheduler::finishRejected(const Job &job, const QString &host) {
+    ++m_rejected;
+    qCDebug(SCHEDULER) << "Circuit open, not requesting:" << job.url;
+
+    HttpResponse response;
+    response.error = QString("Circuit open for %1 after repeated failures").arg(host);
+    response.attempts = job.attempt;
+    if (m_finishedHandler) {
+        m_finishedHandler(job.id, job.url, response);
+    }
+}
+
+void DownloadScheduler::cancelAll(const QString &reason) {
+    // Take everything out first; handlers may queue more, which the loop picks up
+    QList<Job> cancelled;
+    for (auto it = m_attempts.cbegin(); it != m_attempts.cend(); ++it) {
+        // After the first chunk only the streaming request of a hedged pair is left
+        const Job *streaming = nullptr;
+        for (QNetworkReply *reply : it.value()) {
+            auto job = m_inFlight.constFind(reply);
+            if (job != m_inFlight.cend() && (!streaming || job->bytesStreamed > streaming->bytesStreamed)) {
+                streaming = &job.value();
+            }
+        }
+        if (streaming) {
+            cancelled.append(*streaming);
+        }
+    }
+    for (const Job &job : std::as_const(cancelled)) {
+        abortAttempts(job.id);
+    }
+    for (const Job &job : std::as_const(m_delayed)) {
+        cancelled.append(job);
+    }
+    m_delayed.clear();
+
+    qsizetype next = 0;
+    while (next < cancelled.size() || !m_queue.isEmpty()) {
+        if (next == cancelled.size()) {
+            cancelled.append(m_queue.dequeue());
+        }
+        finishCancelled(cancelled.at(next++), reason);
+    }
+    notifyIfIdle();
+}
+
+void DownloadScheduler::finishCancelled(const Job &job, const QString &reason) {
+    ++m_cancelled;
+    qCDebug(SCHEDULER) << reason << job.url;
+
+    HttpResponse response;
+    response.error = reason;
+    response.cancelled = true;
+    response.attempts = job.attempt;
+    response.hedged = job.hedge;
+    response.bytesReceived = job.bytesStreamed;
+    response.transferBytes = job.transferBytes;
+    response.connectNs = job.sentNs;
+    response.ttfbNs = job.headersNs;
+    response.totalNs = job.started.isValid() ? job.started.nsecsElapsed() : -1;
+    if (m_finishedHandler) {
+        m_finishedHandler(job.id, job.url, response);
+    }
+}
+
+bool DownloadScheduler::negotiatesEncoding() const {
+    // Without zlib, Qt's built-in gzip handling beats offering nothing
+    return m_decompress && StreamDecompressor::IsSupported(StreamDecompressor::Format::Gzip);
+}
+
+StreamDecompressor::Format DownloadScheduler::bodyFormat(QNetworkReply *reply, const Job &job) const {
+    if (negotiatesEncoding()) {
+        const auto encoding = StreamDecompressor::FromContentEncoding(reply->rawHeader("Content-Encoding"));
+        if (encoding != StreamDecompressor::Format::Identity) {
+            return encoding;
+        }
+    }
+    // Pre-compressed feeds: by extension, otherwise by magic bytes
+    return StreamDecompressor::FromFileName(QUrl(job.url).path());
+}
+
+bool DownloadScheduler::isSuccessfulBody(QNetworkReply *reply) const {
+    // Local files carry no status code; for HTTP only 2xx bodies are content
+    QVariant status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute);
+    if (!status.isValid()) {
+        return reply->error() == QNetworkReply::NoError;
+    }
+    int code = status.toInt();
+    return code >= 200 && code < 300;
+}
+
+void DownloadScheduler::handleReadyRead(QNetworkReply *reply) {
+    auto it = m_inFlight.find(reply);
+    if (it == m_inFlight.end() || !isSuccessfulBody(reply)) {
+        return;
+    }
+
+    QByteArray chunk = reply->readAll();
+    if (chunk.isEmpty()) {
+        return;
+    }
+
+    // Only one request of a hedged pair may stream into the consumer
+    commit(reply);
+    it = m_inFlight.find(reply);
+
+    Job &job = it.value();
+    job.transferBytes += chunk.size();
+    if (m_decompress) {
+        if (!job.decoder) {
+            job.decoder = std::make_shared<StreamDecompressor>(bodyFormat(reply, job));
+        }
+        QByteArray decoded;
+        if (!job.decoder->feed(chunk, decoded)) {
+            job.decodeError = job.decoder->errorString();
+            reply->abort();
+            return;
+        }
+        if (decoded.isEmpty()) {
+            return;
+        }
+        chunk = std::move(decoded);
+    }
+    deliver(job, reply, chunk);
+}
+
+void DownloadScheduler::deliver(Job &job, QNetworkReply *reply, const QByteArray &chunk) {
+    if (m_cache && job.bytesStreamed == 0 &&
+        (reply->hasRawHeader("ETag") || reply->hasRawHeader("Last-Modified"))) {
+        job.cacheBody = std::shared_ptr<QSaveFile>(m_cache->beginBody(job.url));
+    }
+    if (job.cacheBody) {
+        job.cacheBody->write(chunk);
+    }
+    job.bytesStreamed += chunk.size();
+
+    const int id = job.id;
+    m_chunkHandler(id, chunk);
+}
+
+void DownloadScheduler::handleFinished(QNetworkReply *reply) {
+    if (m_chunkHandler && reply->bytesAvailable() > 0) {
+        // Deliver whatever arrived after the last readyRead
+        handleReadyRead(reply);
+    }
+
+    auto it = m_inFlight.find(reply);
+    if (it == m_inFlight.end()) {
+        // A corrupt chunk aborted the reply and it was already finished from there
+        return;
+    }
+    if (it->decoder && it->decodeError.isEmpty() &&
+        reply->error() == QNetworkReply::NoError) {
+        QByteArray tail;
+        if (!it->decoder->finish(tail)) {
+            it->decodeError = it->decoder->errorString();
+        } else if (!tail.isEmpty()) {
+            deliver(*it, reply, tail);
+        }
+    }
+
+    const Job job = m_inFlight.take(reply);
+    QList<QNetworkReply*> &siblings = m_attempts[job.id];
+    siblings.removeOne(reply);
+
+    HttpResponse response = HttpHelper::responseFromReply(reply);
+    response.transferBytes = m_chunkHandler ? job.transferBytes : response.data.size();
+    if (!job.decodeError.isEmpty()) {
+        // Our own abort; fetching the same bytes again will not help
+        response.error = "Cannot decompress body: " + job.decodeError;
+        response.transient = false;
+    } else if (m_decompress && !m_chunkHandler && response.error.isEmpty() && !response.data.isEmpty()) {
+        QByteArray decoded;
+        QString decodeError;
+        if (StreamDecompressor::Decode(bodyFormat(reply, job), response.data, decoded, &decodeError)) {
+            response.data = std::move(decoded);
+            response.bytesReceived = response.data.size();
+        } else {
+            response.error = "Cannot decompress body: " + decodeError;
+        }
+    }
+    reply->deleteLater();
+    response.connectNs = job.sentNs;
+    response.ttfbNs = job.headersNs;
+    response.totalNs = job.started.nsecsElapsed();
+    response.attempts = job.attempt;
+    response.hedged = job.hedge;
+    if (m_chunkHandler) {
+        response.bytesReceived = job.bytesStreamed;
+    }
+
+    const QString host = QUrl(job.url).host();
+    if (!response.error.isEmpty() && !siblings.isEmpty()) {
+        // The other request of the pair may still succeed
+        if (response.transient && !host.isEmpty()) {
+            m_breaker.recordFailure(host);
+        }
+        return;
+    }
+    // This result is final for the attempt; anything still running lost the race
+    abortAttempts(job.id);
+
+    if (!host.isEmpty()) {
+        if (response.error.isEmpty()) {
+            m_breaker.recordSuccess(host);
+            if (job.headersNs >= 0) {
+                m_latency.add(job.headersNs / 1000000);
+            }
+        } else if (response.transient) {
+            m_breaker.recordFailure(host);
+        }
+    }
+
+    if (!response.error.isEmpty() && response.transient && job.attempt < m_retryPolicy.maxAttempts &&
+        (host.isEmpty() || m_breaker.allow(host))) {
+        if (job.bytesStreamed > 0 && m_restartHandler) {
+            m_restartHandler(job.id);
+        }
+
+        Job retry;
+        retry.id = job.id;
+        retry.url = job.url;
+        retry.bypassCache = job.bypassCache;
+        retry.attempt = job.attempt + 1;
+        const int delay = m_retryPolicy.delayMs(job.attempt, m_rng);
+        ++m_retries;
+        m_delayed.insert(retry.id, retry);
+        qCDebug(SCHEDULER) << "Retrying" << job.url << "in" << delay << "ms after:" << response.error;
+        QTimer::singleShot(delay, m_context.get(), [this, id = retry.id]() {
+            auto delayed = m_delayed.find(id);
+            if (delayed == m_delayed.end()) {
+                // Cancelled meanwhile
+                return;
+            }
+            m_queue.prepend(delayed.value());
+            m_delayed.erase(delayed);
+            startNext();
+            notifyIfIdle();
+        });
+
+        startNext();
+        return;
+    }
+
+    if (m_cache && response.error.isEmpty()) {
+        if (response.notModified && job.conditional) {
+            bool loaded;
+            if (m_chunkHandler) {
+                response.bytesReceived = 0;
+                loaded = m_cache->readBody(job.url, [&](const QByteArray &chunk) {
+                    response.bytesReceived += chunk.size();
+                    m_chunkHandler(job.id, chunk);
+                });
+            } else {
+                loaded = m_cache->loadBody(job.url, response.data);
+                response.bytesReceived = response.data.size();
+            }
+
+            if (loaded) {
+                response.fromCache = true;
+                qCDebug(SCHEDULER) << "Not modified, using cached copy:" << job.url;
+            } else {
+                // Validators matched but the body is gone; drop the entry and refetch in full
+                m_cache->remove(job.url);
+                Job retry;
+                retry.id = job.id;
+                retry.url = job.url;
+                retry.bypassCache = true;
+                retry.attempt = job.attempt;
+                m_queue.prepend(retry);
+                startNext();
+                return;
+            }
+        } else if (response.statusCode == 200) {
+            if (job.cacheBody) {
+                m_cache->commitBody(job.url, response.etag, response.lastModified, *job.cacheBody);
+            } else if (!m_chunkHandler) {
+                m_cache->store(job.url, response.etag, response.lastModified, response.data);
+            }
+        }
+    }
+
+    if (m_finishedHandler) {
+        m_finishedHandler(job.id, job.url, response);
+    }
+
+    // Refill the window; the handler may also have queued more work
+    startNext();
+    notifyIfIdle();
+}
@@ -0,0 +1,151 @@
+#include "../include/FetchCache.h"
+#include "../include/ConfigManager.h"
+#include "../include/Utils.h"
+#include <QCryptographicHash>
+#include <QSaveFile>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QDateTime>
+#include <QJsonObject>
+#include <QJsonDocument>
+
+FetchCache::FetchCache(const QString &directory)
+    : m_directory(directory) {
+}
+
+QString FetchCache::defaultDirectory() {
+    return QDir(ConfigManager::getInstance().getDataDirectory()).filePath("cache/http");
+}
+
+QString FetchCache::entryPath(const QString &url, const QString &suffix) const {
+    QByteArray key = QCryptographicHash::hash(url.toUtf8(), QCryptographicHash::Sha1).toHex();
+    return QDir(m_directory).filePath(QString::fromLatin1(key) + suffix);
+}
+
+FetchCache::Entry FetchCache::lookup(const QString &url) const {
+    QByteArray data;
+    QFile file(entryPath(url, ".meta"));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return Entry();
+    }
+    data = file.readAll();
+    file.close();
+
+    QJsonParseError error;
+    QJsonDocument doc = QJsonDocument::fromJson(data, &error);
+    if (error.error != QJsonParseError::NoError || !doc.isObject()) {
+        return Entry();
+    }
+
+    QJsonObject obj = doc.object();
+    Entry entry;
+    entry.url = obj["url"].toString();
+    entry.etag = obj["etag"].toString().toLatin1();
+    entry.lastModified = obj["lastModified"].toString().toLatin1();
+    entry.storedAt = obj["storedAt"].toString();
+    entry.size = obj["size"].toInteger();
+
+    // A hash collision or a stale body without metadata is treated as a miss
+    if (entry.url != url || QFileInfo(entryPath(url, ".body")).size() != entry.size) {
+        return Entry();
+    }
+    return entry;
+}
+
+void FetchCache::addValidators(const Entry &entry, HttpRequestOptions &options) {
+    if (!entry.etag.isEmpty()) {
+        options.headers.append(qMakePair(QByteArray("If-None-Match"), entry.etag));
+    }
+    if (!entry.lastModified.isEmpty()) {
+        options.headers.append(qMakePair(QByteArray("If-Modified-Since"), entry.lastModified));
+    }
+}
+
+bool FetchCache::loadBody(const QString &url, QByteArray &body) const {
+    return Utils::readFile(entryPath(url, ".body"), body);
+}
+
+bool FetchCache::store(const QString &url, const QByteArray &etag, const QByteArray &lastModified,
+                       const QByteArray &body) {
+    if (etag.isEmpty() && lastModified.isEmpty()) {
+        // Nothing to revalidate against next time
+        return false;
+    }
+
+    std::unique_ptr<QSaveFile> bodyFile = beginBody(url);
+    if (!bodyFile || bodyFile->write(body) != body.size()) {
+        return false;
+    }
+    return commitBody(url, etag, lastModified, *bodyFile);
+}
+
+std::unique_ptr<QSaveFile> FetchCache::beginBody(const QString &url) {
+    if (!Utils::ensureDirectoryExists(m_directory)) {
+        return nullptr;
+    }
+
+    auto bodyFile = std::make_unique<QSaveFile>(entryPath(url, ".body"));
+    if (!bodyFile->open(QIODevice::WriteOnly)) {
+        Utils::setLastError(QString("Cannot write cache body for %1: %2").arg(url, bodyFile->errorString()));
+        return nullptr;
+    }
+    return bodyFile;
+}
+
+bool FetchCache::commitBody(const QString &url, const QByteArray &etag, const QByteArray &lastModified,
+                            QSaveFile &body) {
+    if (etag.isEmpty() && lastModified.isEmpty()) {
+        body.cancelWriting();
+        return false;
+    }
+
+    qint64 size = body.pos();
+    if (!body.commit()) {
+        Utils::setLastError(QString("Cannot write cache body for %1: %2").arg(url, body.errorString()));
+        return false;
+    }
+    return writeMeta(url, etag, lastModified, size);
+}
+
+bool FetchCache::writeMeta(const QString &url, const QByteArray &etag, const QByteArray &lastModified,
+                           qint64 size) {
+    QJsonObject obj;
+    obj["url"] = url;
+    obj["etag"] = QString::fromLatin1(etag);
+    obj["lastModified"] = QString::fromLatin1(lastModified);
+    obj["storedAt"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    obj["size"] = size;
+
+    QSaveFile metaFile(entryPath(url, ".meta"));
+    QByteArray meta = QJsonDocument(obj).toJson(QJsonDocument::Compact);
+    if (!metaFile.open(QIODevice::WriteOnly) || metaFile.write(meta) != meta.size() || !metaFile.commit()) {
+        Utils::setLastError(QString("Cannot write cache metadata for %1: %2").arg(url, metaFile.errorString()));
+        return false;
+    }
+
+    return true;
+}
+
+bool FetchCache::readBody(const QString &url, const std::function<void(const QByteArray &chunk)> &sink,
+                          qint64 chunkSize) const {
+    QFile file(entryPath(url, ".body"));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    while (!file.atEnd()) {
+        QByteArray chunk = file.read(chunkSize);
+        if (chunk.isEmpty()) {
+            return false;
+        }
+        sink(chunk);
+    }
+    return true;
+}
+
+bool FetchCache::remove(const QString &url) {
+    bool metaRemoved = Utils::removeFile(entryPath(url, ".meta"));
+    bool bodyRemoved = Utils::removeFile(entryPath(url, ".body"));
+    return metaRemoved && bodyRemoved;
+}
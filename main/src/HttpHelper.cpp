@@ -1,35 +1,129 @@
 #include "../include/HttpHelper.h"
+#include "../include/ConfigManager.h"
+#include <QCoreApplication>
 #include <QNetworkAccessManager>
 #include <QNetworkRequest>
 #include <QNetworkReply>
 #include <QEventLoop>
-#include <QTimer>
+#include <QUrl>
+#if QT_CONFIG(ssl)
+#include <QSslConfiguration>
+#endif
 
-HttpResponse HttpHelper::HttpGet(const QString &url) {
-    QNetworkRequest request;
-    QNetworkAccessManager accessManager;
-    accessManager.setTransferTimeout(10000);
-    request.setUrl(url);
+HttpHelper::HttpHelper() = default;
+
+HttpHelper::~HttpHelper() {
+    // The manager is parented to the application, so it may already be gone at exit
+    delete m_manager.data();
+}
+
+HttpHelper& HttpHelper::shared() {
+    static HttpHelper instance;
+    return instance;
+}
+
+QNetworkAccessManager* HttpHelper::manager() {
+    if (!m_manager) {
+        m_manager = new QNetworkAccessManager(QCoreApplication::instance());
+        m_manager->setTransferTimeout(defaultTimeout());
+    }
+    return m_manager.data();
+}
+
+int HttpHelper::defaultTimeout() {
+    int timeout = ConfigManager::getInstance().getConfig().requestTimeout;
+    return timeout > 0 ? timeout : 30000;
+}
+
+QNetworkRequest HttpHelper::buildRequest(const QString &url, const HttpRequestOptions &options) {
+    QNetworkRequest request{QUrl(url)};
 
     // Set User-Agent
     request.setHeader(QNetworkRequest::UserAgentHeader, "ConfigCollector/1.0");
+    request.setTransferTimeout(options.timeoutMs > 0 ? options.timeoutMs : defaultTimeout());
 
-    auto reply = accessManager.get(request);
+    // Multiplex requests to the same host over one HTTP/2 connection when the server offers it
+    request.setAttribute(QNetworkRequest::Http2AllowedAttribute, true);
 
-    // Wait for response
-    QEventLoop loop;
-    QObject::connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
-    loop.exec();
+#if QT_CONFIG(ssl)
+    // Keep TLS sessions so later connections to the same host can resume instead of
+    // doing a full handshake
+    QSslConfiguration ssl = request.sslConfiguration();
+    ssl.setSslOption(QSsl::SslOptionDisableSessionSharing, false);
+    ssl.setSslOption(QSsl::SslOptionDisableSessionPersistence, false);
+    request.setSslConfiguration(ssl);
+#endif
+
+    for (const auto &header : options.headers) {
+        request.setRawHeader(header.first, header.second);
+    }
 
+    return request;
+}
+
+QNetworkReply* HttpHelper::get(const QString &url, const HttpRequestOptions &options) {
+    return manager()->get(buildRequest(url, options));
+}
+
+HttpResponse HttpHelper::responseFromReply(QNetworkReply *reply) {
     HttpResponse result;
+    result.statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    result.notModified = (result.statusCode == 304);
+    result.etag = reply->rawHeader("ETag");
+    result.lastModified = reply->rawHeader("Last-Modified");
+
     if (reply->error() == QNetworkReply::NoError) {
         result.error = "";
         result.data = reply->readAll();
+        result.bytesReceived = result.data.size();
     } else {
         result.error = reply->errorString();
         result.data = "";
+        result.transient = IsTransient(reply->error(), result.statusCode);
     }
+    return result;
+}
+
+bool HttpHelper::IsTransient(int networkError, int statusCode) {
+    if (statusCode == 408 || statusCode == 429 || statusCode >= 500) {
+        return true;
+    }
+    if (statusCode > 0) {
+        // Any other HTTP answer is the server's final word
+        return false;
+    }
+
+    switch (QNetworkReply::NetworkError(networkError)) {
+    case QNetworkReply::ConnectionRefusedError:
+    case QNetworkReply::RemoteHostClosedError:
+    case QNetworkReply::TimeoutError:
+    case QNetworkReply::OperationCanceledError:     // transfer timeout
+    case QNetworkReply::TemporaryNetworkFailureError:
+    case QNetworkReply::NetworkSessionFailedError:
+    case QNetworkReply::ProxyConnectionClosedError:
+    case QNetworkReply::ProxyTimeoutError:
+    case QNetworkReply::UnknownNetworkError:
+        return true;
+    default:
+        return false;
+    }
+}
+
+HttpResponse HttpHelper::fetch(const QString &url, const HttpRequestOptions &options) {
+    auto reply = get(url, options);
 
+    // Wait for response
+    QEventLoop loop;
+    QObject::connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
+    if (!reply->isFinished()) {
+        loop.exec();
+    }
+
+    HttpResponse result = responseFromReply(reply);
     reply->deleteLater();
     return result;
-}
\ No newline at end of file
+}
+
+HttpResponse HttpHelper::HttpGet(const QString &url) {
+    return shared().fetch(url);
+}
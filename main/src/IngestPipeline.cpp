@@ -0,0 +1,143 @@
+#include "../include/IngestPipeline.h"
+#include <QThread>
+
+IngestPipeline::IngestPipeline(qsizetype capacity, qsizetype chunkBytes)
+    : m_chunkBytes(chunkBytes), m_inbox(capacity), m_outbox(capacity * 4) {
+}
+
+IngestPipeline::~IngestPipeline() {
+    finish();
+}
+
+void IngestPipeline::start() {
+    if (m_thread) {
+        return;
+    }
+    m_thread.reset(QThread::create([this]() { run(); }));
+    m_thread->start();
+}
+
+void IngestPipeline::chunk(int id, const QByteArray &data) {
+    QByteArray &pending = m_pending[id];
+    pending.append(data);
+    if (pending.size() >= m_chunkBytes) {
+        flush(id);
+    }
+    runPostedBack();
+}
+
+void IngestPipeline::restart(int id) {
+    m_pending.remove(id);
+    Message message;
+    message.type = Message::Type::Restart;
+    message.id = id;
+    post(std::move(message));
+}
+
+void IngestPipeline::finished(int id, const QString &url, const HttpResponse &response) {
+    flush(id);
+    m_pending.remove(id);
+    Message message;
+    message.type = Message::Type::Finished;
+    message.id = id;
+    message.text = url;
+    message.response = response;
+    post(std::move(message));
+}
+
+void IngestPipeline::localFile(int id, const QString &path) {
+    Message message;
+    message.type = Message::Type::LocalFile;
+    message.id = id;
+    message.text = path;
+    post(std::move(message));
+}
+
+void IngestPipeline::sync() {
+    if (!m_thread) {
+        return;
+    }
+    for (auto it = m_pending.begin(); it != m_pending.end(); ++it) {
+        if (!it.value().isEmpty()) {
+            Message message;
+            message.id = it.key();
+            message.data.swap(it.value());
+            post(std::move(message));
+        }
+    }
+    m_pending.clear();
+
+    RingBufferDetail::Backoff backoff;
+    while (m_handled.load(std::memory_order_acquire) < m_messages) {
+        runPostedBack();
+        backoff.pause();
+    }
+    runPostedBack();
+}
+
+void IngestPipeline::finish() {
+    if (!m_thread) {
+        return;
+    }
+    sync();
+
+    Message stop;
+    stop.type = Message::Type::Stop;
+    post(std::move(stop));
+    // The ingest thread may be waiting for room to post back
+    while (!m_thread->wait(1)) {
+        runPostedBack();
+    }
+    runPostedBack();
+    m_thread.reset();
+}
+
+void IngestPipeline::postBack(std::function<void()> task) {
+    m_outbox.push(std::move(task));
+}
+
+void IngestPipeline::post(Message &&message) {
+    ++m_messages;
+    if (m_inbox.tryPush(std::move(message))) {
+        return;
+    }
+    // Backpressure; keep draining postBack() tasks so the two sides never wait on each other
+    ++m_stalls;
+    RingBufferDetail::Backoff backoff;
+    do {
+        runPostedBack();
+        backoff.pause();
+    } while (!m_inbox.tryPush(std::move(message)));
+}
+
+void IngestPipeline::flush(int id) {
+    auto it = m_pending.find(id);
+    if (it == m_pending.end() || it.value().isEmpty()) {
+        return;
+    }
+    Message message;
+    message.id = id;
+    message.data.swap(it.value());
+    post(std::move(message));
+}
+
+void IngestPipeline::runPostedBack() {
+    std::function<void()> task;
+    while (m_outbox.tryPop(task)) {
+        task();
+    }
+}
+
+void IngestPipeline::run() {
+    Message message;
+    for (;;) {
+        m_inbox.pop(message);
+        if (message.type == Message::Type::Stop) {
+            return;
+        }
+        if (m_handler) {
+            m_handler(message);
+        }
+        m_handled.fetch_add(1, std::memory_order_release);
+    }
+}
@@ -0,0 +1,239 @@
+#include "../include/LinkEncoder.h"
+#include "../include/ConfigSchema.h"
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QVarLengthArray>
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <type_traits>
+
+namespace {
+    using ConfigSchema::Field;
+    using ConfigSchema::Value;
+
+    constexpr QByteArray::Base64Options UrlSafe = QByteArray::Base64UrlEncoding | QByteArray::OmitTrailingEquals;
+
+    bool isUnreserved(char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+               c == '-' || c == '.' || c == '_' || c == '~';
+    }
+
+    // Owning copy of a bean value or a store view
+    QByteArray bytes(QByteArrayView utf8) {
+        return utf8.toByteArray();
+    }
+
+    bool isIpv6(QByteArrayView host) {
+        return std::memchr(host.data(), ':', size_t(host.size())) != nullptr;
+    }
+
+    // Host names compare case-insensitively, so the canonical form is lower case
+    void appendAuthority(QByteArray &out, QByteArrayView host, int port) {
+        const QByteArray lower = host.toByteArray().toLower();
+        if (isIpv6(lower)) {
+            out.append('[');
+            out.append(lower);
+            out.append(']');
+        } else {
+            LinkEncoder::AppendPercentEncoded(out, lower);
+        }
+        out.append(':');
+        out.append(QByteArray::number(port));
+    }
+
+    void appendName(QByteArray &out, QByteArrayView name) {
+        if (!name.isEmpty()) {
+            out.append('#');
+            LinkEncoder::AppendPercentEncoded(out, name);
+        }
+    }
+
+    void appendParam(QByteArray &out, int &written, const char *prefix, const char *key, QByteArrayView value,
+                     bool base64) {
+        if (value.isEmpty()) {
+            return;
+        }
+        out.append(written++ == 0 ? prefix : "&");
+        out.append(key);
+        out.append('=');
+        if (base64) {
+            out.append(value.toByteArray().toBase64(UrlSafe));
+        } else {
+            LinkEncoder::AppendPercentEncoded(out, value);
+        }
+    }
+
+    // The schema's link parameters that are set, sorted by key; returns how many
+    template <typename S, typename Fields>
+    int appendParams(QByteArray &out, const Fields &fields, ProxyType kind, const char *prefix, bool base64) {
+        QVarLengthArray<int, 16> order;
+        for (int i = 0; i < int(std::size(S::Fields)); ++i) {
+            const auto &spec = S::Fields[i];
+            if (spec.param && (spec.only == ProxyType::Unknown || spec.only == kind)) {
+                order.append(i);
+            }
+        }
+        std::sort(order.begin(), order.end(), [](int a, int b) {
+            return qstrcmp(S::Fields[a].param, S::Fields[b].param) < 0;
+        });
+
+        // gRPC keeps its service name in the path column
+        const bool grpc = QByteArrayView(fields.utf8(Field::Network)) == QByteArrayView("grpc");
+        int written = 0;
+        for (int i : order) {
+            const auto &spec = S::Fields[i];
+            switch (spec.value) {
+            case Value::Text: {
+                const char *key = grpc && spec.column == Field::Path ? "serviceName" : spec.param;
+                appendParam(out, written, prefix, key, fields.utf8(spec.column), base64);
+                break;
+            }
+            case Value::Number:
+                if (fields.number(spec) > 0) {
+                    appendParam(out, written, prefix, spec.param, QByteArray::number(fields.number(spec)), base64);
+                }
+                break;
+            case Value::Flag:
+                if (fields.flag(spec)) {
+                    appendParam(out, written, prefix, spec.param, "1", base64);
+                }
+                break;
+            }
+        }
+        return written;
+    }
+
+    // v2rayN: base64 of a JSON object; QJsonDocument sorts its keys
+    template <typename S, typename Fields>
+    QByteArray vmessLink(const Fields &fields) {
+        QJsonObject obj;
+        obj["v"] = "2";
+        obj["ps"] = QString::fromUtf8(fields.utf8(Field::Name));
+        obj["add"] = QString::fromUtf8(fields.utf8(Field::Server));
+        obj["port"] = QString::number(fields.port());
+        obj["type"] = "none";
+        for (const auto &spec : S::Fields) {
+            if (!spec.param) {
+                continue;
+            }
+            obj[spec.param] = spec.value == Value::Number ? QString::number(fields.number(spec))
+                                                          : QString::fromUtf8(fields.utf8(spec.column));
+        }
+        return "vmess://" + QJsonDocument(obj).toJson(QJsonDocument::Compact).toBase64();
+    }
+
+    // ssr://base64(host:port:protocol:method:obfs:base64(password)/?obfsparam=...&remarks=...)
+    template <typename S, typename Fields>
+    QByteArray ssrLink(const Fields &fields, ProxyType kind) {
+        QByteArray body;
+        appendAuthority(body, fields.utf8(Field::Server), fields.port());
+        for (Field column : {Field::Protocol, Field::Method, Field::Obfs}) {
+            body.append(':');
+            body.append(fields.utf8(column));
+        }
+        body.append(':');
+        body.append(bytes(fields.utf8(Field::Password)).toBase64(UrlSafe));
+        int written = appendParams<S>(body, fields, kind, "/?", true);
+        appendParam(body, written, "/?", "remarks", fields.utf8(Field::Name), true);
+        return "ssr://" + body.toBase64(UrlSafe);
+    }
+
+    template <typename S, typename Fields>
+    QByteArray encode(const Fields &fields, ProxyType kind) {
+        using Bean = typename S::Bean;
+        if (QByteArrayView(fields.utf8(Field::Server)).isEmpty()) {
+            return QByteArray();
+        }
+        if constexpr (std::is_same_v<Bean, VMessBean>) {
+            return vmessLink<S>(fields);
+        } else if constexpr (std::is_same_v<Bean, ShadowSocksRBean>) {
+            return ssrLink<S>(fields, kind);
+        } else {
+            QByteArray link = LinkEncoder::Scheme(kind);
+            link += "://";
+
+            if constexpr (std::is_same_v<Bean, ShadowSocksBean>) {
+                // SIP002
+                QByteArray userInfo = bytes(fields.utf8(Field::Method));
+                userInfo += ':';
+                userInfo.append(fields.utf8(Field::Password));
+                link += userInfo.toBase64(UrlSafe);
+                link += '@';
+            } else if constexpr (std::is_same_v<Bean, SocksHttpBean>) {
+                const QByteArray user = bytes(fields.utf8(Field::Username));
+                const QByteArray password = bytes(fields.utf8(Field::Password));
+                if (!password.isEmpty()) {
+                    LinkEncoder::AppendPercentEncoded(link, user);
+                    link += ':';
+                    LinkEncoder::AppendPercentEncoded(link, password);
+                    link += '@';
+                } else if (!user.isEmpty()) {
+                    // A bare user name could pass for v2rayN's base64("user:password")
+                    link += QByteArray(user + ':').toBase64(UrlSafe);
+                    link += '@';
+                }
+            } else if constexpr (std::is_same_v<Bean, TuicBean>) {
+                LinkEncoder::AppendPercentEncoded(link, fields.utf8(Field::Uuid));
+                link += ':';
+                LinkEncoder::AppendPercentEncoded(link, fields.utf8(Field::Password));
+                link += '@';
+            } else {
+                // Trojan / VLESS password or UUID, Hysteria2 auth, WireGuard private key
+                LinkEncoder::AppendPercentEncoded(link, fields.utf8(Field::Password));
+                link += '@';
+            }
+
+            appendAuthority(link, fields.utf8(Field::Server), fields.port());
+            appendParams<S>(link, fields, kind, "?", false);
+            appendName(link, fields.utf8(Field::Name));
+            return link;
+        }
+    }
+}
+
+QByteArray LinkEncoder::Encode(const ProxyBean &bean) {
+    QByteArray link;
+    ConfigSchema::Dispatch(bean.type, [&](auto schema) {
+        using S = decltype(schema);
+        if (auto typed = dynamic_cast<const typename S::Bean*>(&bean)) {
+            link = encode<S>(ConfigSchema::BeanFields<typename S::Bean>(*typed), bean.type);
+        }
+    });
+    return link;
+}
+
+QByteArray LinkEncoder::Encode(const ConfigStore &store, qsizetype row) {
+    QByteArray link;
+    const ProxyType kind = store.kind(row);
+    ConfigSchema::Dispatch(kind, [&](auto schema) {
+        link = encode<decltype(schema)>(ConfigSchema::RowFields(store, row), kind);
+    });
+    return link;
+}
+
+const char *LinkEncoder::Scheme(ProxyType type) {
+    switch (type) {
+    case ProxyType::Shadowsocks:
+        return "ss";
+    case ProxyType::ShadowsocksR:
+        return "ssr";
+    default:
+        // The type names of the others are their schemes
+        return ProxyTypeName(type);
+    }
+}
+
+void LinkEncoder::AppendPercentEncoded(QByteArray &out, QByteArrayView utf8) {
+    static const char HexDigits[] = "0123456789ABCDEF";
+    for (char c : utf8) {
+        if (isUnreserved(c)) {
+            out.append(c);
+        } else {
+            const uchar byte = uchar(c);
+            out.append('%');
+            out.append(HexDigits[byte >> 4]);
+            out.append(HexDigits[byte & 0xf]);
+        }
+    }
+}
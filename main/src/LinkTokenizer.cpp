@@ -0,0 +1,202 @@
+#include "../include/LinkTokenizer.h"
+
+namespace {
+    bool isSchemeChar(QChar c, bool first) {
+        const char16_t u = c.unicode();
+        if ((u >= 'a' && u <= 'z') || (u >= 'A' && u <= 'Z')) {
+            return true;
+        }
+        return !first && ((u >= '0' && u <= '9') || u == '+' || u == '-' || u == '.');
+    }
+
+    int hexValue(char16_t c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+
+    // Digits only and at most 65535, as QUrl requires
+    bool parsePort(QStringView text, int &port) {
+        if (text.isEmpty()) {
+            port = -1;
+            return true;
+        }
+        if (text.size() > 5) {
+            return false;
+        }
+        int value = 0;
+        for (QChar c : text) {
+            if (c < u'0' || c > u'9') {
+                return false;
+            }
+            value = value * 10 + (c.unicode() - '0');
+        }
+        if (value > 65535) {
+            return false;
+        }
+        port = value;
+        return true;
+    }
+}
+
+namespace LinkTokenizer {
+    bool Split(QStringView link, LinkParts &parts) {
+        parts = LinkParts();
+
+        const qsizetype schemeEnd = link.indexOf(u"://");
+        if (schemeEnd <= 0) {
+            return false;
+        }
+        for (qsizetype i = 0; i < schemeEnd; ++i) {
+            if (!isSchemeChar(link[i], i == 0)) {
+                return false;
+            }
+        }
+        parts.scheme = link.first(schemeEnd);
+
+        // Fragment first: '#' ends everything, and '?' or '/' may appear inside it
+        QStringView rest = link.sliced(schemeEnd + 3);
+        const qsizetype hash = rest.indexOf(u'#');
+        if (hash >= 0) {
+            parts.fragment = rest.sliced(hash + 1);
+            rest = rest.first(hash);
+        }
+
+        const qsizetype question = rest.indexOf(u'?');
+        if (question >= 0) {
+            parts.query = rest.sliced(question + 1);
+            rest = rest.first(question);
+        }
+
+        const qsizetype slash = rest.indexOf(u'/');
+        if (slash >= 0) {
+            parts.path = rest.sliced(slash);
+            rest = rest.first(slash);
+        }
+
+        return SplitAuthority(rest, parts);
+    }
+
+    bool SplitAuthority(QStringView authority, LinkParts &parts) {
+        // Passwords may contain unescaped '@'; the host never does
+        const qsizetype at = authority.lastIndexOf(u'@');
+        QStringView hostPort = authority;
+        if (at >= 0) {
+            QStringView userInfo = authority.first(at);
+            hostPort = authority.sliced(at + 1);
+            parts.hasUserInfo = true;
+
+            const qsizetype colon = userInfo.indexOf(u':');
+            if (colon >= 0) {
+                parts.userName = userInfo.first(colon);
+                parts.password = userInfo.sliced(colon + 1);
+                parts.hasPassword = true;
+            } else {
+                parts.userName = userInfo;
+            }
+        }
+
+        QStringView portText;
+        if (hostPort.startsWith(u'[')) {
+            const qsizetype close = hostPort.indexOf(u']');
+            if (close < 0) {
+                return false;
+            }
+            parts.host = hostPort.sliced(1, close - 1);
+            QStringView after = hostPort.sliced(close + 1);
+            if (!after.isEmpty()) {
+                if (!after.startsWith(u':')) {
+                    return false;
+                }
+                portText = after.sliced(1);
+            }
+        } else {
+            const qsizetype colon = hostPort.indexOf(u':');
+            if (colon >= 0) {
+                parts.host = hostPort.first(colon);
+                portText = hostPort.sliced(colon + 1);
+            } else {
+                parts.host = hostPort;
+            }
+        }
+
+        return parsePort(portText, parts.port);
+    }
+
+    QString Decoded(QStringView field) {
+        if (!field.contains(u'%')) {
+            return field.toString();
+        }
+
+        // Escapes are UTF-8 bytes, so decode into bytes and convert once
+        QByteArray bytes;
+        bytes.reserve(field.size());
+        const qsizetype size = field.size();
+        for (qsizetype i = 0; i < size; ++i) {
+            const char16_t c = field[i].unicode();
+            if (c == '%' && i + 2 < size && hexValue(field[i + 1].unicode()) >= 0 &&
+                hexValue(field[i + 2].unicode()) >= 0) {
+                bytes.append(char(hexValue(field[i + 1].unicode()) * 16 + hexValue(field[i + 2].unicode())));
+                i += 2;
+            } else if (c < 0x80) {
+                bytes.append(char(c));
+            } else {
+                // Rare non-ASCII run: convert up to the next escape in one go
+                qsizetype end = i + 1;
+                while (end < size && field[end].unicode() >= 0x80) {
+                    ++end;
+                }
+                bytes.append(field.sliced(i, end - i).toUtf8());
+                i = end - 1;
+            }
+        }
+        return QString::fromUtf8(bytes);
+    }
+
+    QString DecodedHost(QStringView host) {
+        QString decoded = Decoded(host);
+        for (QChar c : decoded) {
+            if (c.unicode() >= 'A' && c.unicode() <= 'Z') {
+                return decoded.toLower();
+            }
+        }
+        return decoded;
+    }
+}
+
+LinkQuery::LinkQuery(QStringView query) {
+    while (!query.isEmpty()) {
+        const qsizetype amp = query.indexOf(u'&');
+        QStringView item = amp >= 0 ? query.first(amp) : query;
+        query = amp >= 0 ? query.sliced(amp + 1) : QStringView();
+
+        if (item.isEmpty()) {
+            continue;
+        }
+        const qsizetype eq = item.indexOf(u'=');
+        if (eq >= 0) {
+            m_items.append(qMakePair(item.first(eq), item.sliced(eq + 1)));
+        } else {
+            m_items.append(qMakePair(item, QStringView()));
+        }
+    }
+}
+
+bool LinkQuery::contains(QStringView key) const {
+    for (const auto &item : m_items) {
+        if (item.first == key) {
+            return true;
+        }
+    }
+    return false;
+}
+
+QString LinkQuery::value(QStringView key, const QString &def) const {
+    for (const auto &item : m_items) {
+        if (item.first == key) {
+            return LinkTokenizer::Decoded(item.second);
+        }
+    }
+    return def;
+}
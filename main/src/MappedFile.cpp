@@ -0,0 +1,126 @@
+#include "../include/MappedFile.h"
+#include <cstring>
+
+MappedFile::MappedFile(qint64 windowSize)
+    : m_window(qMax<qint64>(windowSize, 4096)) {
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const QString &path) {
+    close();
+    m_error.clear();
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        return fail(QString("Cannot open %1: %2").arg(path, m_file.errorString()));
+    }
+    m_size = m_file.size();
+    return true;
+}
+
+void MappedFile::close() {
+    if (m_map) {
+        m_file.unmap(m_map);
+        m_map = nullptr;
+    }
+    m_file.close();
+    m_mapOffset = 0;
+    m_mapLength = 0;
+    m_size = 0;
+    m_position = 0;
+}
+
+bool MappedFile::advanceWindow(bool grow) {
+    qint64 length = grow && m_map && m_mapOffset == m_position ? m_mapLength * 2 : m_window;
+    length = qMin(length, m_size - m_position);
+
+    if (m_map) {
+        m_file.unmap(m_map);
+        m_map = nullptr;
+    }
+    // QFile::map takes care of aligning the offset to a page boundary
+    m_map = m_file.map(m_position, length);
+    if (!m_map) {
+        return fail(QString("Cannot map %1: %2").arg(m_file.fileName(), m_file.errorString()));
+    }
+    m_mapOffset = m_position;
+    m_mapLength = length;
+    return true;
+}
+
+bool MappedFile::readLine(QByteArrayView &line) {
+    while (!atEnd() && m_error.isEmpty()) {
+        const qint64 mapEnd = m_mapOffset + m_mapLength;
+        if (!m_map || m_position >= mapEnd) {
+            if (!advanceWindow(false)) {
+                return false;
+            }
+            continue;
+        }
+
+        const char *begin = reinterpret_cast<const char*>(m_map) + (m_position - m_mapOffset);
+        const qint64 available = mapEnd - m_position;
+        const char *newline = static_cast<const char*>(memchr(begin, '\n', size_t(available)));
+        qint64 length;
+        if (newline) {
+            length = newline - begin;
+            m_position += length + 1;
+        } else if (mapEnd >= m_size) {
+            // Last line without a line break
+            length = available;
+            m_position = m_size;
+        } else {
+            // The line runs past the window: map again starting at it
+            if (!advanceWindow(true)) {
+                return false;
+            }
+            continue;
+        }
+
+        if (length > 0 && begin[length - 1] == '\r') {
+            --length;
+        }
+        line = QByteArrayView(begin, length);
+        return true;
+    }
+    return false;
+}
+
+bool MappedFile::readBlock(QByteArrayView &block) {
+    while (!atEnd() && m_error.isEmpty()) {
+        const qint64 mapEnd = m_mapOffset + m_mapLength;
+        if (!m_map || m_position >= mapEnd) {
+            if (!advanceWindow(false)) {
+                return false;
+            }
+            continue;
+        }
+
+        const char *begin = reinterpret_cast<const char*>(m_map) + (m_position - m_mapOffset);
+        qint64 length = mapEnd - m_position;
+        if (mapEnd < m_size) {
+            // Stop after the last complete line in the window
+            while (length > 0 && begin[length - 1] != '\n') {
+                --length;
+            }
+            if (length == 0) {
+                if (!advanceWindow(true)) {
+                    return false;
+                }
+                continue;
+            }
+        }
+
+        m_position += length;
+        block = QByteArrayView(begin, length);
+        return true;
+    }
+    return false;
+}
+
+bool MappedFile::fail(const QString &error) {
+    m_error = error;
+    return false;
+}
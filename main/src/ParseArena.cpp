@@ -0,0 +1,12 @@
+#include "../include/ParseArena.h"
+
+thread_local const std::shared_ptr<ParseArena> *ParseArena::t_current = nullptr;
+
+ParseArena::Scope::Scope(std::shared_ptr<ParseArena> arena)
+    : m_arena(std::move(arena)), m_previous(t_current) {
+    t_current = &m_arena;
+}
+
+ParseArena::Scope::~Scope() {
+    t_current = m_previous;
+}
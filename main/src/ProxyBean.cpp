@@ -1,16 +1,81 @@
 #include "../include/ProxyBean.h"
 #include "../include/Utils.h"
-#include <QUrl>
-#include <QUrlQuery>
+#include "../include/Base64Decoder.h"
+#include "../include/LinkTokenizer.h"
+#include "../include/Deduplicator.h"
+#include "../include/ConfigSchema.h"
+#include "../include/LinkEncoder.h"
+#include <QJsonDocument>
+
+namespace {
+    bool isTrue(const QString &flag) {
+        return flag == "1" || flag == "true";
+    }
+
+    // Unpadded base64 / base64url text field; empty if it does not decode
+    QString decodedBase64(QStringView text) {
+        if (text.isEmpty()) {
+            return QString();
+        }
+        auto result = Base64Decoder::Decode(text);
+        return result ? QString::fromUtf8(result.decoded) : QString();
+    }
+
+    // "host:443,20000-30000" (port hopping) keeps only the first port
+    QString withoutPortHops(QStringView link) {
+        const qsizetype start = link.indexOf(u"://");
+        if (start < 0) {
+            return QString();
+        }
+        qsizetype end = start + 3;
+        while (end < link.size() && link[end] != u'/' && link[end] != u'?' && link[end] != u'#') {
+            ++end;
+        }
+        const QStringView authority = link.sliced(start + 3, end - start - 3);
+        const qsizetype comma = authority.indexOf(u',', authority.lastIndexOf(u':') + 1);
+        if (comma < 0) {
+            return QString();
+        }
+        QString result = link.first(start + 3 + comma).toString();
+        result += link.sliced(end);
+        return result;
+    }
+
+    template <typename Bean>
+    void visitSchema(const Bean &bean, JsonFieldVisitor &visitor) {
+        using S = ConfigSchema::Schema<Bean>;
+        const ProxyType kind = S::Kind != ProxyType::Unknown ? S::Kind : bean.type;
+        ConfigSchema::VisitJson<S>(ConfigSchema::BeanFields<Bean>(bean), kind, visitor);
+    }
+
+    template <typename Bean>
+    void hashSchema(const Bean &bean, ConfigSchema::Identity part, IdentityHasher &hasher) {
+        ConfigSchema::Hash<ConfigSchema::Schema<Bean>>(ConfigSchema::BeanFields<Bean>(bean), part, hasher);
+    }
+}
+
+QJsonObject ProxyBean::ToJson() const {
+    JsonObjectBuilder builder;
+    visitJson(builder);
+    return builder.object;
+}
+
+QString ProxyBean::ToLink() const {
+    return QString::fromLatin1(LinkEncoder::Encode(*this));
+}
 
 // VMess Parser
 bool VMessBean::TryParseLink(const QString &link) {
-    type = "vmess";
+    type = ProxyType::VMess;
 
     // V2RayN Format (Base64 encoded JSON)
-    auto linkN = DecodeB64IfValid(SubStrAfter(link, "vmess://"));
-    if (!linkN.isEmpty()) {
-        auto objN = QString2QJsonObject(linkN);
+    QStringView body = QStringView(link);
+    if (body.startsWith(u"vmess://")) {
+        body = body.sliced(8);
+    }
+    auto linkN = Base64Decoder::Decode(body);
+    if (linkN && !linkN.decoded.isEmpty()) {
+        auto objN = QJsonDocument::fromJson(linkN.decoded).object();
         if (objN.isEmpty()) return false;
 
         uuid = objN["id"].toString();
@@ -23,173 +88,172 @@ bool VMessBean::TryParseLink(const QString &link) {
         sni = objN["sni"].toString();
         network = objN["net"].toString();
         tls = objN["tls"].toString();
+        const QString cipher = objN["scy"].toString();
+        if (!cipher.isEmpty()) {
+            security = cipher;
+        }
 
         return true;
     }
 
     // Standard format
-    auto url = QUrl(link);
-    if (!url.isValid()) return false;
-    auto query = GetQuery(url);
+    LinkParts url;
+    if (!LinkTokenizer::Split(link, url)) return false;
+    LinkQuery query(url.query);
 
-    name = url.fragment(QUrl::FullyDecoded);
-    serverAddress = url.host();
-    serverPort = url.port();
-    uuid = url.userName();
+    name = LinkTokenizer::Decoded(url.fragment);
+    serverAddress = LinkTokenizer::DecodedHost(url.host);
+    serverPort = url.port;
+    uuid = LinkTokenizer::Decoded(url.userName);
 
-    security = GetQueryValue(query, "encryption", "auto");
-    network = GetQueryValue(query, "type", "tcp");
-    tls = GetQueryValue(query, "security", "");
-    sni = GetQueryValue(query, "sni");
+    security = query.value(u"encryption", "auto");
+    network = query.value(u"type", "tcp");
+    tls = query.value(u"security", "");
+    sni = query.value(u"sni");
 
     if (network == "ws") {
-        path = GetQueryValue(query, "path", "");
-        host = GetQueryValue(query, "host", "");
+        path = query.value(u"path", "");
+        host = query.value(u"host", "");
     }
 
     return !(uuid.isEmpty() || serverAddress.isEmpty());
 }
 
-QJsonObject VMessBean::ToJson() {
-    QJsonObject obj;
-    obj["type"] = "vmess";
-    obj["name"] = name;
-    obj["server"] = serverAddress;
-    obj["port"] = serverPort;
-    obj["uuid"] = uuid;
-    obj["alterId"] = aid;
-    obj["cipher"] = security;
-    obj["network"] = network;
-    if (!tls.isEmpty()) obj["tls"] = tls;
-    if (!sni.isEmpty()) obj["sni"] = sni;
-    if (!host.isEmpty()) obj["host"] = host;
-    if (!path.isEmpty()) obj["path"] = path;
-    if (!source.isEmpty()) obj["source"] = source;
-    return obj;
+void VMessBean::visitJson(JsonFieldVisitor &visitor) const {
+    visitSchema(*this, visitor);
 }
 
-// ShadowSocks Parser
-bool ShadowSocksBean::TryParseLink(const QString &link) {
-    type = "shadowsocks";
-
-    if (SubStrBefore(link, "#").contains("@")) {
-        auto url = QUrl(link);
-        if (!url.isValid()) return false;
+void VMessBean::HashCredentials(IdentityHasher &hasher) const {
+    hashSchema(*this, ConfigSchema::Identity::Credentials, hasher);
+}
 
-        name = url.fragment(QUrl::FullyDecoded);
-        serverAddress = url.host();
-        serverPort = url.port();
+void VMessBean::HashTransport(IdentityHasher &hasher) const {
+    hashSchema(*this, ConfigSchema::Identity::Transport, hasher);
+}
 
-        if (url.password().isEmpty()) {
-            auto method_password = DecodeB64IfValid(url.userName(), QByteArray::Base64UrlEncoding);
-            if (method_password.isEmpty()) return false;
-            method = SubStrBefore(method_password, ":");
-            password = SubStrAfter(method_password, ":");
+// ShadowSocks Parser
+bool ShadowSocksBean::TryParseLink(const QString &link) {
+    type = ProxyType::Shadowsocks;
+
+    QStringView view(link);
+    const qsizetype hash = view.indexOf(u'#');
+    QStringView beforeFragment = hash >= 0 ? view.first(hash) : view;
+
+    if (beforeFragment.contains(u'@')) {
+        LinkParts url;
+        if (!LinkTokenizer::Split(link, url)) return false;
+
+        name = LinkTokenizer::Decoded(url.fragment);
+        serverAddress = LinkTokenizer::DecodedHost(url.host);
+        serverPort = url.port;
+
+        if (url.password.isEmpty()) {
+            // SIP002: base64url("method:password") as the user info
+            QString escaped = url.userName.contains(u'%') ? LinkTokenizer::Decoded(url.userName) : QString();
+            auto userInfo = Base64Decoder::Decode(escaped.isNull() ? url.userName : QStringView(escaped));
+            if (!userInfo || userInfo.decoded.isEmpty()) return false;
+            QString methodPassword = QString::fromUtf8(userInfo.decoded);
+            method = SubStrBefore(methodPassword, ":");
+            password = SubStrAfter(methodPassword, ":");
         } else {
-            method = url.userName();
-            password = url.password();
+            method = LinkTokenizer::Decoded(url.userName);
+            password = LinkTokenizer::Decoded(url.password);
         }
     } else {
         // v2rayN format
-        QString linkN = DecodeB64IfValid(SubStrBefore(SubStrAfter(link, "://"), "#"), QByteArray::Base64UrlEncoding);
-        if (linkN.isEmpty()) return false;
-        auto url = QUrl("https://" + linkN);
-
-        serverAddress = url.host();
-        serverPort = url.port();
-        method = url.userName();
-        password = url.password();
-        if (link.contains("#")) {
-            name = SubStrAfter(link, "#");
+        const qsizetype schemeEnd = beforeFragment.indexOf(u"://");
+        QStringView payload = schemeEnd >= 0 ? beforeFragment.sliced(schemeEnd + 3) : QStringView();
+        auto decoded = Base64Decoder::Decode(payload);
+        if (!decoded || decoded.decoded.isEmpty()) return false;
+
+        QString linkN = QString::fromUtf8(decoded.decoded);
+        LinkParts url;
+        if (!LinkTokenizer::SplitAuthority(linkN, url)) return false;
+
+        serverAddress = LinkTokenizer::DecodedHost(url.host);
+        serverPort = url.port;
+        method = LinkTokenizer::Decoded(url.userName);
+        password = LinkTokenizer::Decoded(url.password);
+        if (hash >= 0) {
+            name = LinkTokenizer::Decoded(view.sliced(hash + 1));
         }
     }
 
     return !(serverAddress.isEmpty() || method.isEmpty() || password.isEmpty());
 }
 
-QJsonObject ShadowSocksBean::ToJson() {
-    QJsonObject obj;
-    obj["type"] = "shadowsocks";
-    obj["name"] = name;
-    obj["server"] = serverAddress;
-    obj["port"] = serverPort;
-    obj["method"] = method;
-    obj["password"] = password;
-    if (!source.isEmpty()) obj["source"] = source;
-    return obj;
+void ShadowSocksBean::visitJson(JsonFieldVisitor &visitor) const {
+    visitSchema(*this, visitor);
+}
+
+void ShadowSocksBean::HashCredentials(IdentityHasher &hasher) const {
+    hashSchema(*this, ConfigSchema::Identity::Credentials, hasher);
 }
 
 // Trojan/VLESS Parser
 bool TrojanVLESSBean::TryParseLink(const QString &link) {
-    auto url = QUrl(link);
-    if (!url.isValid()) return false;
-    auto query = GetQuery(url);
+    LinkParts url;
+    if (!LinkTokenizer::Split(link, url)) return false;
+    LinkQuery query(url.query);
 
-    if (link.startsWith("trojan://")) {
-        type = "trojan";
-    } else if (link.startsWith("vless://")) {
-        type = "vless";
+    const ProxyType scheme = ProxyTypeFromLink(link);
+    if (scheme == ProxyType::Trojan || scheme == ProxyType::VLESS) {
+        type = scheme;
     }
 
-    name = url.fragment(QUrl::FullyDecoded);
-    serverAddress = url.host();
-    serverPort = url.port();
-    password = url.userName();
+    name = LinkTokenizer::Decoded(url.fragment);
+    serverAddress = LinkTokenizer::DecodedHost(url.host);
+    serverPort = url.port;
+    password = LinkTokenizer::Decoded(url.userName);
 
-    network = GetQueryValue(query, "type", "tcp");
-    security = GetQueryValue(query, "security", "");
-    sni = GetQueryValue(query, "sni");
+    network = query.value(u"type", "tcp");
+    security = query.value(u"security", "");
+    sni = query.value(u"sni");
 
     if (network == "ws") {
-        path = GetQueryValue(query, "path", "");
-        host = GetQueryValue(query, "host", "");
+        path = query.value(u"path", "");
+        host = query.value(u"host", "");
     } else if (network == "grpc") {
-        path = GetQueryValue(query, "serviceName", "");
+        path = query.value(u"serviceName", "");
     }
 
-    if (type == "vless") {
-        flow = GetQueryValue(query, "flow", "");
+    if (type == ProxyType::VLESS) {
+        flow = query.value(u"flow", "");
     }
 
     return !(password.isEmpty() || serverAddress.isEmpty());
 }
 
-QJsonObject TrojanVLESSBean::ToJson() {
-    QJsonObject obj;
-    obj["type"] = type;
-    obj["name"] = name;
-    obj["server"] = serverAddress;
-    obj["port"] = serverPort;
-    obj["password"] = password;
-    if (!network.isEmpty()) obj["network"] = network;
-    if (!security.isEmpty()) obj["security"] = security;
-    if (!sni.isEmpty()) obj["sni"] = sni;
-    if (!host.isEmpty()) obj["host"] = host;
-    if (!path.isEmpty()) obj["path"] = path;
-    if (!flow.isEmpty() && type == "vless") obj["flow"] = flow;
-    if (!source.isEmpty()) obj["source"] = source;
-    return obj;
+void TrojanVLESSBean::visitJson(JsonFieldVisitor &visitor) const {
+    visitSchema(*this, visitor);
+}
+
+void TrojanVLESSBean::HashCredentials(IdentityHasher &hasher) const {
+    hashSchema(*this, ConfigSchema::Identity::Credentials, hasher);
+}
+
+void TrojanVLESSBean::HashTransport(IdentityHasher &hasher) const {
+    hashSchema(*this, ConfigSchema::Identity::Transport, hasher);
 }
 
 // SOCKS/HTTP Parser
 bool SocksHttpBean::TryParseLink(const QString &link) {
-    auto url = QUrl(link);
-    if (!url.isValid()) return false;
+    LinkParts url;
+    if (!LinkTokenizer::Split(link, url)) return false;
 
-    if (link.startsWith("socks")) {
-        type = "socks";
-    } else if (link.startsWith("http")) {
-        type = "http";
+    const ProxyType scheme = ProxyTypeFromLink(link);
+    if (scheme == ProxyType::Socks || scheme == ProxyType::Http) {
+        type = scheme;
     }
 
-    name = url.fragment(QUrl::FullyDecoded);
-    serverAddress = url.host();
-    serverPort = url.port();
-    username = url.userName();
-    password = url.password();
+    name = LinkTokenizer::Decoded(url.fragment);
+    serverAddress = LinkTokenizer::DecodedHost(url.host);
+    serverPort = url.port;
+    username = LinkTokenizer::Decoded(url.userName);
+    password = LinkTokenizer::Decoded(url.password);
 
     if (serverPort == -1) {
-        serverPort = (type == "http") ? 443 : 1080;
+        serverPort = (type == ProxyType::Http) ? 443 : 1080;
     }
 
     // v2rayN format
@@ -204,14 +268,183 @@ bool SocksHttpBean::TryParseLink(const QString &link) {
     return !serverAddress.isEmpty();
 }
 
-QJsonObject SocksHttpBean::ToJson() {
-    QJsonObject obj;
-    obj["type"] = type;
-    obj["name"] = name;
-    obj["server"] = serverAddress;
-    obj["port"] = serverPort;
-    if (!username.isEmpty()) obj["username"] = username;
-    if (!password.isEmpty()) obj["password"] = password;
-    if (!source.isEmpty()) obj["source"] = source;
-    return obj;
+void SocksHttpBean::visitJson(JsonFieldVisitor &visitor) const {
+    visitSchema(*this, visitor);
+}
+
+void SocksHttpBean::HashCredentials(IdentityHasher &hasher) const {
+    hashSchema(*this, ConfigSchema::Identity::Credentials, hasher);
+}
+
+// Hysteria2 Parser
+bool Hysteria2Bean::TryParseLink(const QString &link) {
+    type = ProxyType::Hysteria2;
+
+    LinkParts url;
+    QString rewritten;
+    if (!LinkTokenizer::Split(link, url)) {
+        rewritten = withoutPortHops(link);
+        if (rewritten.isEmpty() || !LinkTokenizer::Split(rewritten, url)) return false;
+    }
+    LinkQuery query(url.query);
+
+    name = LinkTokenizer::Decoded(url.fragment);
+    serverAddress = LinkTokenizer::DecodedHost(url.host);
+    serverPort = url.port == -1 ? 443 : url.port;
+    password = LinkTokenizer::Decoded(url.userName);
+    if (url.hasPassword) {
+        password += QLatin1Char(':');
+        password += LinkTokenizer::Decoded(url.password);
+    }
+
+    sni = query.value(u"sni", "");
+    obfs = query.value(u"obfs", "");
+    obfsPassword = query.value(u"obfs-password", "");
+    insecure = isTrue(query.value(u"insecure"));
+
+    return !(password.isEmpty() || serverAddress.isEmpty());
+}
+
+void Hysteria2Bean::visitJson(JsonFieldVisitor &visitor) const {
+    visitSchema(*this, visitor);
+}
+
+void Hysteria2Bean::HashCredentials(IdentityHasher &hasher) const {
+    hashSchema(*this, ConfigSchema::Identity::Credentials, hasher);
+}
+
+void Hysteria2Bean::HashTransport(IdentityHasher &hasher) const {
+    hashSchema(*this, ConfigSchema::Identity::Transport, hasher);
+}
+
+// TUIC Parser
+bool TuicBean::TryParseLink(const QString &link) {
+    type = ProxyType::Tuic;
+
+    LinkParts url;
+    if (!LinkTokenizer::Split(link, url)) return false;
+    LinkQuery query(url.query);
+
+    name = LinkTokenizer::Decoded(url.fragment);
+    serverAddress = LinkTokenizer::DecodedHost(url.host);
+    serverPort = url.port;
+    uuid = LinkTokenizer::Decoded(url.userName);
+    password = LinkTokenizer::Decoded(url.password);
+
+    congestionControl = query.value(u"congestion_control", "");
+    udpRelayMode = query.value(u"udp_relay_mode", "");
+    alpn = query.value(u"alpn", "");
+    sni = query.value(u"sni", "");
+    insecure = isTrue(query.value(u"allow_insecure")) || isTrue(query.value(u"insecure"));
+
+    return !(uuid.isEmpty() || password.isEmpty() || serverAddress.isEmpty() || serverPort <= 0);
+}
+
+void TuicBean::visitJson(JsonFieldVisitor &visitor) const {
+    visitSchema(*this, visitor);
+}
+
+void TuicBean::HashCredentials(IdentityHasher &hasher) const {
+    hashSchema(*this, ConfigSchema::Identity::Credentials, hasher);
+}
+
+void TuicBean::HashTransport(IdentityHasher &hasher) const {
+    hashSchema(*this, ConfigSchema::Identity::Transport, hasher);
+}
+
+// ShadowsocksR Parser
+bool ShadowSocksRBean::TryParseLink(const QString &link) {
+    type = ProxyType::ShadowsocksR;
+
+    // ssr://base64(host:port:protocol:method:obfs:base64(password)/?obfsparam=...&remarks=...)
+    QStringView view(link);
+    const qsizetype schemeEnd = view.indexOf(u"://");
+    if (schemeEnd < 0) return false;
+    const QString decoded = decodedBase64(view.sliced(schemeEnd + 3).trimmed());
+    if (decoded.isEmpty()) return false;
+
+    QStringView text(decoded);
+    QStringView params;
+    const qsizetype question = text.indexOf(u'?');
+    if (question >= 0) {
+        params = text.sliced(question + 1);
+        text = text.first(question);
+        if (text.endsWith(u'/')) {
+            text.chop(1);
+        }
+    }
+
+    // The host may be an IPv6 literal, so take the other five fields from the right
+    QStringView fields[5];
+    for (int i = 4; i >= 0; --i) {
+        const qsizetype colon = text.lastIndexOf(u':');
+        if (colon < 0) return false;
+        fields[i] = text.sliced(colon + 1);
+        text = text.first(colon);
+    }
+    if (text.startsWith(u'[') && text.endsWith(u']')) {
+        text = text.sliced(1, text.size() - 2);
+    }
+
+    bool ok = false;
+    serverAddress = LinkTokenizer::DecodedHost(text);
+    serverPort = fields[0].toInt(&ok);
+    if (!ok) return false;
+    protocol = fields[1].toString();
+    method = fields[2].toString();
+    obfs = fields[3].toString();
+    password = decodedBase64(fields[4]);
+
+    LinkQuery query(params);
+    protocolParam = decodedBase64(query.value(u"protoparam"));
+    obfsParam = decodedBase64(query.value(u"obfsparam"));
+    name = decodedBase64(query.value(u"remarks"));
+
+    return !(serverAddress.isEmpty() || method.isEmpty() || password.isEmpty() || serverPort <= 0);
+}
+
+void ShadowSocksRBean::visitJson(JsonFieldVisitor &visitor) const {
+    visitSchema(*this, visitor);
+}
+
+void ShadowSocksRBean::HashCredentials(IdentityHasher &hasher) const {
+    hashSchema(*this, ConfigSchema::Identity::Credentials, hasher);
+}
+
+void ShadowSocksRBean::HashTransport(IdentityHasher &hasher) const {
+    hashSchema(*this, ConfigSchema::Identity::Transport, hasher);
+}
+
+// WireGuard Parser
+bool WireGuardBean::TryParseLink(const QString &link) {
+    type = ProxyType::WireGuard;
+
+    LinkParts url;
+    if (!LinkTokenizer::Split(link, url)) return false;
+    LinkQuery query(url.query);
+
+    name = LinkTokenizer::Decoded(url.fragment);
+    serverAddress = LinkTokenizer::DecodedHost(url.host);
+    serverPort = url.port;
+    privateKey = LinkTokenizer::Decoded(url.userName);
+
+    publicKey = query.value(u"publickey", query.value(u"public_key"));
+    preSharedKey = query.value(u"presharedkey", query.value(u"pre_shared_key"));
+    localAddress = query.value(u"address", query.value(u"ip"));
+    reserved = query.value(u"reserved", "");
+    mtu = query.value(u"mtu").toInt();
+
+    return !(privateKey.isEmpty() || publicKey.isEmpty() || serverAddress.isEmpty() || serverPort <= 0);
+}
+
+void WireGuardBean::visitJson(JsonFieldVisitor &visitor) const {
+    visitSchema(*this, visitor);
+}
+
+void WireGuardBean::HashCredentials(IdentityHasher &hasher) const {
+    hashSchema(*this, ConfigSchema::Identity::Credentials, hasher);
+}
+
+void WireGuardBean::HashTransport(IdentityHasher &hasher) const {
+    hashSchema(*this, ConfigSchema::Identity::Transport, hasher);
 }
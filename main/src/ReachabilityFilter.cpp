@@ -0,0 +1,222 @@
+#include "../include/ReachabilityFilter.h"
+#include "../include/DnsCache.h"
+#include <QTcpSocket>
+#include <QSslSocket>
+#include <QTimer>
+#include <QEventLoop>
+#include <QLoggingCategory>
+#include <algorithm>
+
+Q_LOGGING_CATEGORY(REACHABILITY, "config.reachability")
+
+namespace {
+    using Kind = ConfigStore::Kind;
+    using Field = ConfigStore::Field;
+
+    bool isTlsSecurity(QByteArrayView security) {
+        return security == QByteArrayView("tls") || security == QByteArrayView("reality") ||
+               security == QByteArrayView("xtls");
+    }
+}
+
+ReachabilityFilter::ReachabilityFilter(const Options &options)
+    : m_options(options) {
+    m_options.maxConcurrent = qMax(1, m_options.maxConcurrent);
+    m_options.perHostConcurrent = qMax(1, m_options.perHostConcurrent);
+    m_options.timeoutMs = qMax(1, m_options.timeoutMs);
+    if (m_options.checkTls && !QSslSocket::supportsSsl()) {
+        qCWarning(REACHABILITY) << "TLS not available, probing with plain TCP connects";
+        m_options.checkTls = false;
+    }
+}
+
+ReachabilityFilter::~ReachabilityFilter() {
+    const auto sockets = m_inFlight.keys();
+    m_inFlight.clear();
+    for (QAbstractSocket *socket : sockets) {
+        socket->disconnect();
+        socket->abort();
+        socket->deleteLater();
+    }
+}
+
+int ReachabilityFilter::enqueue(const QString &host, quint16 port, const QString &tlsServerName) {
+    Probe probe;
+    probe.host = DnsCache::NormalizedHost(host);
+    probe.port = port;
+    probe.serverName = m_options.checkTls ? tlsServerName : QString();
+
+    bool resolveFailed = false;
+    if (m_resolver && !probe.host.isEmpty()) {
+        switch (m_resolver->status(probe.host)) {
+        case DnsCache::Status::Resolved:
+            probe.host = m_resolver->canonicalAddress(probe.host);
+            break;
+        case DnsCache::Status::Failed:
+            resolveFailed = true;
+            break;
+        case DnsCache::Status::Unknown:
+            break;
+        }
+    }
+
+    const QString key = QString("%1|%2|%3").arg(probe.host).arg(port).arg(probe.serverName);
+    auto it = m_ids.constFind(key);
+    if (it != m_ids.cend()) {
+        return it.value();
+    }
+
+    probe.id = int(m_results.size());
+    m_results.append(resolveFailed || probe.host.isEmpty() || port == 0 ? Unreachable : Pending);
+    m_ids.insert(key, probe.id);
+    if (m_results.last() == Pending) {
+        m_queue.enqueue(probe);
+    }
+    return probe.id;
+}
+
+int ReachabilityFilter::reachableCount() const {
+    return int(std::count(m_results.begin(), m_results.end(), Reachable));
+}
+
+void ReachabilityFilter::run() {
+    if (m_queue.isEmpty() && m_inFlight.isEmpty()) {
+        return;
+    }
+
+    QEventLoop loop;
+    m_idleCallback = [&loop]() { loop.quit(); };
+
+    startNext();
+    if (!m_queue.isEmpty() || !m_inFlight.isEmpty()) {
+        loop.exec();
+    }
+
+    m_idleCallback = nullptr;
+}
+
+void ReachabilityFilter::startNext() {
+    while (m_inFlight.size() < m_options.maxConcurrent && !m_queue.isEmpty()) {
+        Probe probe = m_queue.dequeue();
+        int &active = m_hostActive[probe.host];
+        if (active >= m_options.perHostConcurrent) {
+            // Released when one of this host's probes finishes
+            m_deferred[probe.host].enqueue(probe);
+            continue;
+        }
+        ++active;
+        start(probe);
+    }
+}
+
+void ReachabilityFilter::start(const Probe &probe) {
+    QAbstractSocket *socket;
+    if (!probe.serverName.isEmpty()) {
+        // Any completed handshake counts; certificates are not the question here
+        auto ssl = new QSslSocket();
+        ssl->setPeerVerifyMode(QSslSocket::VerifyNone);
+        QObject::connect(ssl, &QSslSocket::encrypted, ssl, [this, ssl]() { finish(ssl, true); });
+        ssl->connectToHostEncrypted(probe.host, probe.port, probe.serverName);
+        socket = ssl;
+    } else {
+        socket = new QTcpSocket();
+        QObject::connect(socket, &QAbstractSocket::connected, socket, [this, socket]() { finish(socket, true); });
+        socket->connectToHost(probe.host, probe.port);
+    }
+
+    m_inFlight.insert(socket, probe);
+    QObject::connect(socket, &QAbstractSocket::errorOccurred, socket, [this, socket]() {
+        finish(socket, false);
+    });
+    QTimer::singleShot(m_options.timeoutMs, socket, [this, socket]() { finish(socket, false); });
+}
+
+void ReachabilityFilter::finish(QAbstractSocket *socket, bool reachable) {
+    auto it = m_inFlight.find(socket);
+    if (it == m_inFlight.end()) {
+        return;
+    }
+    const Probe probe = it.value();
+    m_inFlight.erase(it);
+
+    socket->disconnect();
+    socket->abort();
+    socket->deleteLater();
+
+    m_results[probe.id] = reachable ? Reachable : Unreachable;
+    qCDebug(REACHABILITY) << probe.host << probe.port << (reachable ? "reachable" : "unreachable");
+
+    --m_hostActive[probe.host];
+    auto deferred = m_deferred.find(probe.host);
+    if (deferred != m_deferred.end()) {
+        m_queue.prepend(deferred->dequeue());
+        if (deferred->isEmpty()) {
+            m_deferred.erase(deferred);
+        }
+    }
+
+    startNext();
+
+    if (m_inFlight.isEmpty() && m_queue.isEmpty() && m_idleCallback) {
+        m_idleCallback();
+    }
+}
+
+QVector<qsizetype> ReachabilityFilter::filter(const QList<ConfigStore*> &stores) {
+    QVector<QVector<int>> ids(stores.size());
+    for (qsizetype s = 0; s < stores.size(); ++s) {
+        const ConfigStore &store = *stores[s];
+        ids[s].reserve(store.size());
+        for (qsizetype row = 0; row < store.size(); ++row) {
+            if (ProxyTypeUsesUdp(store.kind(row))) {
+                // QUIC / WireGuard servers never answer a TCP connect; keep them unprobed
+                ids[s].append(-1);
+                continue;
+            }
+            const int port = store.port(row);
+            ids[s].append(enqueue(store.fieldString(row, Field::Server),
+                                  port > 0 && port <= 65535 ? quint16(port) : 0,
+                                  TlsServerName(store, row)));
+        }
+    }
+
+    run();
+
+    QVector<qsizetype> removed(stores.size(), 0);
+    for (qsizetype s = 0; s < stores.size(); ++s) {
+        const QVector<int> &storeIds = ids[s];
+        removed[s] = stores[s]->removeIf([this, &storeIds](const ConfigRecord &record) {
+            const int id = storeIds[record.row()];
+            return id >= 0 && !isReachable(id);
+        });
+    }
+    return removed;
+}
+
+QString ReachabilityFilter::TlsServerName(const ConfigStore &store, qsizetype row) {
+    bool tls = false;
+    switch (store.kind(row)) {
+    case Kind::VMess:
+        tls = store.field(row, Field::Tls) == QByteArrayView("tls");
+        break;
+    case Kind::Trojan:
+        // Trojan is TLS unless a link says otherwise
+        tls = store.field(row, Field::Security).isEmpty() || isTlsSecurity(store.field(row, Field::Security));
+        break;
+    case Kind::VLESS:
+        tls = isTlsSecurity(store.field(row, Field::Security));
+        break;
+    default:
+        break;
+    }
+    if (!tls) {
+        return QString();
+    }
+
+    for (Field field : {Field::Sni, Field::Host, Field::Server}) {
+        if (!store.field(row, field).isEmpty()) {
+            return store.fieldString(row, field);
+        }
+    }
+    return QString();
+}
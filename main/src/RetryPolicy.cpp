@@ -0,0 +1,82 @@
+#include "../include/RetryPolicy.h"
+#include <algorithm>
+
+int RetryPolicy::delayMs(int attempt, QRandomGenerator &rng) const {
+    if (baseDelayMs <= 0 || maxDelayMs <= 0) {
+        return 0;
+    }
+
+    // Double per attempt without overflowing on large attempt counts
+    qint64 ceiling = baseDelayMs;
+    for (int i = 1; i < attempt && ceiling < maxDelayMs; ++i) {
+        ceiling *= 2;
+    }
+    ceiling = qMin<qint64>(ceiling, maxDelayMs);
+    return int(rng.bounded(quint32(ceiling) + 1));
+}
+
+CircuitBreaker::State CircuitBreaker::state(const QString &host) const {
+    if (!enabled()) {
+        return State::Closed;
+    }
+    auto it = m_hosts.constFind(host);
+    if (it == m_hosts.cend() || !it->tripped) {
+        return State::Closed;
+    }
+    return it->reopens.hasExpired() ? State::HalfOpen : State::Open;
+}
+
+void CircuitBreaker::recordSuccess(const QString &host) {
+    if (enabled()) {
+        m_hosts.remove(host);
+    }
+}
+
+void CircuitBreaker::recordFailure(const QString &host) {
+    if (!enabled()) {
+        return;
+    }
+
+    Host &entry = m_hosts[host];
+    ++entry.failures;
+    // A failed probe after the cooldown reopens straight away
+    if (entry.tripped ? entry.reopens.hasExpired() : entry.failures >= m_options.failureThreshold) {
+        entry.tripped = true;
+        entry.reopens = QDeadlineTimer(m_options.cooldownMs);
+    }
+}
+
+int CircuitBreaker::openCount() const {
+    int count = 0;
+    for (auto it = m_hosts.cbegin(); it != m_hosts.cend(); ++it) {
+        count += state(it.key()) == State::Open ? 1 : 0;
+    }
+    return count;
+}
+
+void LatencyEstimator::add(qint64 ms) {
+    if (m_samples.size() < m_window) {
+        m_samples.append(ms);
+    } else {
+        m_samples[m_next] = ms;
+    }
+    m_next = (m_next + 1) % m_window;
+}
+
+qint64 LatencyEstimator::percentile(double quantile) const {
+    if (m_samples.isEmpty()) {
+        return 0;
+    }
+    QVector<qint64> sorted = m_samples;
+    // Nearest rank
+    const qsizetype rank = qBound<qsizetype>(1, qsizetype(quantile * sorted.size() + 0.999999), sorted.size());
+    std::nth_element(sorted.begin(), sorted.begin() + (rank - 1), sorted.end());
+    return sorted[rank - 1];
+}
+
+qint64 LatencyEstimator::hedgeDelay(qint64 minimumMs) const {
+    if (samples() < MinimumSamples) {
+        return minimumMs;
+    }
+    return qMax(minimumMs, percentile(0.95));
+}
@@ -0,0 +1,229 @@
+#include "../include/RunMetrics.h"
+#include "../include/Utils.h"
+#include <QDir>
+#include <QDateTime>
+#include <QJsonArray>
+#include <QJsonDocument>
+
+namespace {
+    const char MetricPrefix[] = "configcollector_";
+
+    double toMs(qint64 ns) {
+        // Microsecond resolution is plenty and keeps the report readable
+        return double(ns / 1000) / 1000.0;
+    }
+
+    QByteArray seconds(qint64 ns) {
+        return QByteArray::number(double(ns) / 1e9, 'f', 6);
+    }
+
+    // Label values may contain anything a subscription URL does
+    QByteArray labelValue(const QString &value) {
+        QByteArray out;
+        const QByteArray utf8 = value.toUtf8();
+        out.reserve(utf8.size() + 2);
+        out.append('"');
+        for (char c : utf8) {
+            if (c == '\\' || c == '"') {
+                out.append('\\').append(c);
+            } else if (c == '\n') {
+                out.append("\\n");
+            } else {
+                out.append(c);
+            }
+        }
+        out.append('"');
+        return out;
+    }
+
+    QByteArray metricName(const QString &name) {
+        QByteArray out = MetricPrefix;
+        for (QChar c : name) {
+            out.append(c.isLetterOrNumber() && c.unicode() < 0x80 ? char(c.toLower().unicode()) : '_');
+        }
+        return out;
+    }
+
+    QJsonObject toObject(const QMap<QString, qint64> &values) {
+        QJsonObject object;
+        for (auto it = values.cbegin(); it != values.cend(); ++it) {
+            object[it.key()] = it.value();
+        }
+        return object;
+    }
+}
+
+RunMetrics::Timer::Timer(RunMetrics &metrics, Stage stage, int subscription)
+    : m_metrics(metrics), m_stage(stage), m_subscription(subscription) {
+    m_timer.start();
+}
+
+RunMetrics::Timer::~Timer() {
+    m_metrics.addTime(m_stage, m_timer.nsecsElapsed(), m_subscription);
+}
+
+RunMetrics::RunMetrics() {
+    m_run.start();
+    m_scopes[Global];
+}
+
+const char *RunMetrics::StageName(Stage stage) {
+    switch (stage) {
+    case Stage::Dns: return "dns";
+    case Stage::Connect: return "connect";
+    case Stage::Ttfb: return "ttfb";
+    case Stage::Download: return "download";
+    case Stage::Decode: return "decode";
+    case Stage::Parse: return "parse";
+    case Stage::Dedup: return "dedup";
+    case Stage::Filter: return "filter";
+    case Stage::Write: return "write";
+    case Stage::Count: break;
+    }
+    return "unknown";
+}
+
+void RunMetrics::setSubscription(int id, const QString &url) {
+    m_scopes[id].url = url;
+}
+
+void RunMetrics::addTime(Stage stage, qint64 ns, int subscription) {
+    if (stage == Stage::Count || ns < 0) {
+        return;
+    }
+    m_scopes[Global].stageNs[size_t(stage)] += ns;
+    if (subscription != Global) {
+        m_scopes[subscription].stageNs[size_t(stage)] += ns;
+    }
+}
+
+void RunMetrics::addCount(const QString &name, qint64 delta, int subscription) {
+    m_scopes[Global].counts[name] += delta;
+    if (subscription != Global) {
+        m_scopes[subscription].counts[name] += delta;
+    }
+}
+
+void RunMetrics::addParseFailures(const QString &protocol, qint64 count, int subscription) {
+    m_scopes[Global].parseFailures[protocol] += count;
+    if (subscription != Global) {
+        m_scopes[subscription].parseFailures[protocol] += count;
+    }
+}
+
+const RunMetrics::Scope *RunMetrics::scope(int subscription) const {
+    auto it = m_scopes.find(subscription);
+    return it == m_scopes.end() ? nullptr : &it->second;
+}
+
+qint64 RunMetrics::time(Stage stage, int subscription) const {
+    const Scope *s = scope(subscription);
+    return s && stage != Stage::Count ? s->stageNs[size_t(stage)] : 0;
+}
+
+qint64 RunMetrics::count(const QString &name, int subscription) const {
+    const Scope *s = scope(subscription);
+    return s ? s->counts.value(name) : 0;
+}
+
+qint64 RunMetrics::parseFailures(const QString &protocol, int subscription) const {
+    const Scope *s = scope(subscription);
+    return s ? s->parseFailures.value(protocol) : 0;
+}
+
+QJsonObject RunMetrics::toJson() const {
+    auto scopeJson = [](const Scope &s) {
+        QJsonObject stages;
+        for (int i = 0; i < int(Stage::Count); ++i) {
+            stages[StageName(Stage(i))] = toMs(s.stageNs[size_t(i)]);
+        }
+        QJsonObject object;
+        object["stagesMs"] = stages;
+        object["counts"] = toObject(s.counts);
+        object["parseFailures"] = toObject(s.parseFailures);
+        return object;
+    };
+
+    QJsonObject report = scopeJson(m_scopes.at(Global));
+    report["version"] = 1;
+    report["generated"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    report["wallMs"] = toMs(elapsedNs());
+
+    QJsonArray subscriptions;
+    for (const auto &[id, s] : m_scopes) {
+        if (id == Global) {
+            continue;
+        }
+        QJsonObject entry = scopeJson(s);
+        entry["id"] = id;
+        entry["url"] = s.url;
+        subscriptions.append(entry);
+    }
+    report["subscriptions"] = subscriptions;
+    return report;
+}
+
+QByteArray RunMetrics::toPrometheus() const {
+    QByteArray out;
+
+    auto labels = [](int id, const Scope &s, const QByteArray &first) {
+        QByteArray text = "{" + first;
+        if (id != Global) {
+            if (!first.isEmpty()) {
+                text += ',';
+            }
+            text += "subscription=" + labelValue(s.url);
+        }
+        return text + "}";
+    };
+
+    out += "# HELP configcollector_run_seconds Wall time of the run.\n";
+    out += "# TYPE configcollector_run_seconds gauge\n";
+    out += "configcollector_run_seconds " + seconds(elapsedNs()) + "\n";
+
+    out += "# HELP configcollector_stage_seconds Time spent per stage.\n";
+    out += "# TYPE configcollector_stage_seconds gauge\n";
+    for (const auto &[id, s] : m_scopes) {
+        for (int i = 0; i < int(Stage::Count); ++i) {
+            out += "configcollector_stage_seconds" +
+                   labels(id, s, QByteArray("stage=\"") + StageName(Stage(i)) + "\"") + " " +
+                   seconds(s.stageNs[size_t(i)]) + "\n";
+        }
+    }
+
+    // Subscription counts also land in the global scope, so it holds every name
+    const QStringList names = m_scopes.at(Global).counts.keys();
+    for (const QString &name : names) {
+        const QByteArray metric = metricName(name);
+        out += "# TYPE " + metric + " gauge\n";
+        for (const auto &[id, s] : m_scopes) {
+            auto it = s.counts.constFind(name);
+            if (it != s.counts.cend()) {
+                const QByteArray set = labels(id, s, QByteArray());
+                out += metric + (set == "{}" ? QByteArray() : set) + " " + QByteArray::number(it.value()) + "\n";
+            }
+        }
+    }
+
+    out += "# HELP configcollector_parse_failures Links that did not parse, by scheme.\n";
+    out += "# TYPE configcollector_parse_failures gauge\n";
+    for (const auto &[id, s] : m_scopes) {
+        for (auto it = s.parseFailures.cbegin(); it != s.parseFailures.cend(); ++it) {
+            out += "configcollector_parse_failures" + labels(id, s, "protocol=" + labelValue(it.key())) + " " +
+                   QByteArray::number(it.value()) + "\n";
+        }
+    }
+    return out;
+}
+
+bool RunMetrics::write(const QString &directory, QString *error) const {
+    const QDir dir(directory);
+    if (!Utils::writeFile(dir.filePath("run_report.json"), QJsonDocument(toJson()).toJson()) ||
+        !Utils::writeFile(dir.filePath("metrics.prom"), toPrometheus())) {
+        if (error) {
+            *error = Utils::getLastError();
+        }
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,201 @@
+#include "../include/ShardedWriter.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QSet>
+#include <QSemaphore>
+#include <QThreadPool>
+#include <algorithm>
+#include <numeric>
+
+namespace {
+    // Regional indicator symbols U+1F1E6..U+1F1FF encode as F0 9F 87 A6..BF
+    inline int regionalLetter(const uchar *p) {
+        if (p[0] == 0xF0 && p[1] == 0x9F && p[2] == 0x87 && p[3] >= 0xA6 && p[3] <= 0xBF) {
+            return 'A' + (p[3] - 0xA6);
+        }
+        return 0;
+    }
+}
+
+ShardedWriter::ShardedWriter(const QString &directory)
+    : m_directory(directory) {
+}
+
+int ShardedWriter::shard(const QString &relativePath, ConfigWriter::Format format, const QString &subscription) {
+    auto it = m_index.constFind(relativePath);
+    if (it != m_index.constEnd()) {
+        return it.value();
+    }
+    const int index = int(m_shards.size());
+    m_shards.append(Shard{relativePath, format, subscription, {}});
+    m_index.insert(relativePath, index);
+    return index;
+}
+
+void ShardedWriter::add(int shard, const ConfigStore &store, qsizetype row) {
+    m_shards[shard].rows.append(Row{&store, row});
+}
+
+void ShardedWriter::addAll(int shard, const ConfigStore &store) {
+    QVector<Row> &rows = m_shards[shard].rows;
+    rows.reserve(rows.size() + store.size());
+    for (qsizetype row = 0; row < store.size(); ++row) {
+        rows.append(Row{&store, row});
+    }
+}
+
+void ShardedWriter::route(Key key, const ConfigStore &store) {
+    if (key == Key::Source) {
+        return;
+    }
+    for (qsizetype row = 0; row < store.size(); ++row) {
+        add(shard(ShardPath(key, store, row), ConfigWriter::Format::Ndjson), store, row);
+    }
+}
+
+bool ShardedWriter::write(QThreadPool *pool) {
+    m_results = QVector<Result>(m_shards.size());
+
+    // mkpath stats every component, so do it once per directory rather than per file
+    QSet<QString> directories;
+    for (const Shard &shard : m_shards) {
+        directories.insert(QFileInfo(shard.relativePath).path());
+    }
+    QDir root(m_directory);
+    QSet<QString> missing;
+    for (const QString &directory : directories) {
+        if (!root.mkpath(directory)) {
+            missing.insert(directory);
+        }
+    }
+
+    // Largest shards first so one big file does not start last and hold up the run
+    QVector<int> order(m_shards.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [this](int a, int b) {
+        return m_shards[a].rows.size() > m_shards[b].rows.size();
+    });
+
+    // Each task only writes its own result slot
+    QSemaphore done;
+    int started = 0;
+    for (int index : order) {
+        const Shard &shard = m_shards[index];
+        if (missing.contains(QFileInfo(shard.relativePath).path())) {
+            m_results[index] = Result{shard.relativePath, 0, "Cannot create directory"};
+            continue;
+        }
+        if (pool) {
+            pool->start([this, index, &done]() {
+                m_results[index] = writeShard(m_shards[index]);
+                done.release();
+            });
+            ++started;
+        } else {
+            m_results[index] = writeShard(shard);
+        }
+    }
+    done.acquire(started);
+
+    return std::all_of(m_results.cbegin(), m_results.cend(),
+                       [](const Result &result) { return result.error.isEmpty(); });
+}
+
+ShardedWriter::Result ShardedWriter::writeShard(const Shard &shard) const {
+    Result result;
+    result.path = shard.relativePath;
+
+    ConfigWriter writer(shard.format);
+    bool ok = writer.open(QDir(m_directory).filePath(shard.relativePath), shard.subscription);
+    for (const Row &row : shard.rows) {
+        ok = ok && writer.write(*row.store, row.row);
+    }
+    if (!ok || !writer.commit()) {
+        result.error = writer.errorString();
+        return result;
+    }
+    result.count = writer.count();
+    return result;
+}
+
+QString ShardedWriter::KeyDirectory(Key key) {
+    switch (key) {
+    case Key::Protocol:
+        return "protocols";
+    case Key::Country:
+        return "countries";
+    case Key::Source:
+        break;
+    }
+    return QString();
+}
+
+QString ShardedWriter::KeyName(Key key) {
+    switch (key) {
+    case Key::Source:
+        return "source";
+    case Key::Protocol:
+        return "protocol";
+    case Key::Country:
+        return "country";
+    }
+    return QString();
+}
+
+bool ShardedWriter::KeyFromName(QStringView name, Key &key) {
+    for (Key candidate : {Key::Source, Key::Protocol, Key::Country}) {
+        if (name.compare(KeyName(candidate), Qt::CaseInsensitive) == 0) {
+            key = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ShardedWriter::ParseKeys(const QString &list, QList<Key> &keys) {
+    keys.clear();
+    for (QStringView name : QStringView(list).split(QLatin1Char(','), Qt::SkipEmptyParts)) {
+        Key key;
+        if (!KeyFromName(name.trimmed(), key)) {
+            return false;
+        }
+        if (!keys.contains(key)) {
+            keys.append(key);
+        }
+    }
+    return true;
+}
+
+QString ShardedWriter::CountryCode(QByteArrayView utf8Name) {
+    const uchar *data = reinterpret_cast<const uchar*>(utf8Name.data());
+    for (qsizetype i = 0; i + 8 <= utf8Name.size(); ++i) {
+        const int first = regionalLetter(data + i);
+        if (first == 0) {
+            continue;
+        }
+        const int second = regionalLetter(data + i + 4);
+        if (second != 0) {
+            return QString(QChar(first)) + QChar(second);
+        }
+        i += 3;
+    }
+    return "unknown";
+}
+
+QString ShardedWriter::ShardPath(Key key, const ConfigStore &store, qsizetype row) {
+    QString name;
+    switch (key) {
+    case Key::Protocol:
+        name = store.typeName(row);
+        break;
+    case Key::Country:
+        name = CountryCode(store.field(row, ConfigStore::Field::Name));
+        break;
+    case Key::Source:
+        return QString();
+    }
+    if (name.isEmpty()) {
+        name = "unknown";
+    }
+    return KeyDirectory(key) + QLatin1Char('/') + name + QLatin1String(".ndjson");
+}
@@ -0,0 +1,168 @@
+#include "../include/SourceHistory.h"
+#include "../include/ConfigManager.h"
+#include "../include/Utils.h"
+#include <QDir>
+#include <QFile>
+#include <QDateTime>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+namespace {
+    constexpr int FormatVersion = 1;
+    // Weight of the latest run in the smoothed yield
+    constexpr double YieldSmoothing = 0.5;
+}
+
+SourceHistory::SourceHistory(const QString &path, Options options)
+    : m_path(path), m_options(options) {
+}
+
+QString SourceHistory::defaultPath() {
+    return QDir(ConfigManager::getInstance().getDataDirectory()).filePath("source_history.json");
+}
+
+bool SourceHistory::load() {
+    m_records.clear();
+    m_touched.clear();
+    if (!QFile::exists(m_path)) {
+        return true;
+    }
+
+    QByteArray data;
+    if (!Utils::readFile(m_path, data)) {
+        return false;
+    }
+    QJsonParseError error;
+    const QJsonDocument doc = QJsonDocument::fromJson(data, &error);
+    if (error.error != QJsonParseError::NoError || !doc.isObject() ||
+        doc.object()["version"].toInt() != FormatVersion) {
+        return false;
+    }
+
+    const QJsonArray sources = doc.object()["sources"].toArray();
+    for (const QJsonValue &value : sources) {
+        const QJsonObject obj = value.toObject();
+        Record record;
+        record.url = obj["url"].toString();
+        if (record.url.isEmpty()) {
+            continue;
+        }
+        record.runs = obj["runs"].toInt();
+        record.latencyMs = obj["latencyMs"].toInteger(-1);
+        record.bytes = obj["bytes"].toInteger();
+        record.uniqueConfigs = obj["uniqueConfigs"].toInt();
+        record.duplicateRatio = obj["duplicateRatio"].toDouble();
+        record.yield = obj["yield"].toDouble();
+        record.failureStreak = obj["failureStreak"].toInt();
+        record.skipRuns = obj["skipRuns"].toInt();
+        record.lastFetched = obj["lastFetched"].toString();
+        m_records.insert(record.url, record);
+    }
+    return true;
+}
+
+bool SourceHistory::save() const {
+    QStringList urls(m_touched.cbegin(), m_touched.cend());
+    urls.sort();
+
+    QJsonArray sources;
+    for (const QString &url : urls) {
+        const Record record = m_records.value(url);
+        QJsonObject obj;
+        obj["url"] = record.url;
+        obj["runs"] = record.runs;
+        obj["latencyMs"] = record.latencyMs;
+        obj["bytes"] = record.bytes;
+        obj["uniqueConfigs"] = record.uniqueConfigs;
+        obj["duplicateRatio"] = record.duplicateRatio;
+        obj["yield"] = record.yield;
+        obj["failureStreak"] = record.failureStreak;
+        obj["skipRuns"] = record.skipRuns;
+        obj["lastFetched"] = record.lastFetched;
+        sources.append(obj);
+    }
+
+    QJsonObject root;
+    root["version"] = FormatVersion;
+    root["sources"] = sources;
+    return Utils::writeFile(m_path, QJsonDocument(root).toJson());
+}
+
+SourceHistory::Record SourceHistory::record(const QString &url) const {
+    auto it = m_records.constFind(url);
+    if (it != m_records.cend()) {
+        return it.value();
+    }
+    Record record;
+    record.url = url;
+    return record;
+}
+
+SourceHistory::Record &SourceHistory::touch(const QString &url) {
+    m_touched.insert(url);
+    Record &record = m_records[url];
+    record.url = url;
+    return record;
+}
+
+bool SourceHistory::takeSkip(const QString &url) {
+    Record &record = touch(url);
+    if (record.skipRuns <= 0) {
+        return false;
+    }
+    --record.skipRuns;
+    return true;
+}
+
+void SourceHistory::recordSuccess(const QString &url, qint64 latencyMs, qint64 bytes, int uniqueConfigs,
+                                  int totalConfigs) {
+    Record &record = touch(url);
+    record.yield = record.isKnown() ? (1 - YieldSmoothing) * record.yield + YieldSmoothing * uniqueConfigs
+                                    : uniqueConfigs;
+    ++record.runs;
+    record.latencyMs = latencyMs;
+    record.bytes = bytes;
+    record.uniqueConfigs = uniqueConfigs;
+    record.duplicateRatio = totalConfigs > 0 ? double(totalConfigs - uniqueConfigs) / totalConfigs : 0;
+    record.failureStreak = 0;
+    record.skipRuns = 0;
+    record.lastFetched = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+}
+
+void SourceHistory::recordFailure(const QString &url) {
+    Record &record = touch(url);
+    ++record.runs;
+    ++record.failureStreak;
+    // A failed run yields nothing
+    record.yield *= 1 - YieldSmoothing;
+    record.lastFetched = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+
+    if (m_options.failureThreshold > 0 && record.failureStreak >= m_options.failureThreshold) {
+        const int doublings = qMin(record.failureStreak - m_options.failureThreshold, 16);
+        record.skipRuns = qMin(1 << doublings, qMax(1, m_options.maxSkipRuns));
+    }
+}
+
+double SourceHistory::Score(const Record &record) {
+    if (!record.isKnown()) {
+        return std::numeric_limits<double>::infinity();
+    }
+    return record.yield * (1 - record.duplicateRatio / 2) / (1 + record.failureStreak);
+}
+
+QList<int> SourceHistory::prioritize(const QStringList &urls) const {
+    QList<double> scores;
+    scores.reserve(urls.size());
+    for (const QString &url : urls) {
+        scores.append(Score(record(url)));
+    }
+
+    QList<int> order(urls.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&scores](int a, int b) { return scores[a] > scores[b]; });
+    return order;
+}
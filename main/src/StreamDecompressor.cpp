@@ -0,0 +1,363 @@
+#include "../include/StreamDecompressor.h"
+#include <QStringView>
+
+#ifdef CONFIGCOLLECTOR_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef CONFIGCOLLECTOR_HAVE_ZSTD
+#include <zstd.h>
+#endif
+#ifdef CONFIGCOLLECTOR_HAVE_BROTLI
+#include <brotli/decode.h>
+#endif
+
+namespace {
+    constexpr qsizetype OutputChunk = 64 * 1024;
+    constexpr qsizetype MagicBytes = 4;
+}
+
+// Library state for the active format; exactly one member is in use
+struct StreamDecompressor::Codec {
+#ifdef CONFIGCOLLECTOR_HAVE_ZLIB
+    z_stream zlib{};
+    bool zlibActive = false;
+    bool zlibEnded = false;     // end of the current gzip member
+#endif
+#ifdef CONFIGCOLLECTOR_HAVE_ZSTD
+    ZSTD_DStream *zstd = nullptr;
+    size_t zstdHint = 1;        // 0 once a frame is complete
+#endif
+#ifdef CONFIGCOLLECTOR_HAVE_BROTLI
+    BrotliDecoderState *brotli = nullptr;
+#endif
+
+    ~Codec() {
+#ifdef CONFIGCOLLECTOR_HAVE_ZLIB
+        if (zlibActive) {
+            inflateEnd(&zlib);
+        }
+#endif
+#ifdef CONFIGCOLLECTOR_HAVE_ZSTD
+        ZSTD_freeDStream(zstd);
+#endif
+#ifdef CONFIGCOLLECTOR_HAVE_BROTLI
+        if (brotli) {
+            BrotliDecoderDestroyInstance(brotli);
+        }
+#endif
+    }
+};
+
+StreamDecompressor::StreamDecompressor(Format format)
+    : m_format(format) {
+    if (format != Format::Auto) {
+        start(format);
+    }
+}
+
+StreamDecompressor::~StreamDecompressor() = default;
+
+bool StreamDecompressor::IsSupported(Format format) {
+    switch (format) {
+    case Format::Identity:
+    case Format::Auto:
+        return true;
+    case Format::Gzip:
+    case Format::Zlib:
+#ifdef CONFIGCOLLECTOR_HAVE_ZLIB
+        return true;
+#else
+        return false;
+#endif
+    case Format::Zstd:
+#ifdef CONFIGCOLLECTOR_HAVE_ZSTD
+        return true;
+#else
+        return false;
+#endif
+    case Format::Brotli:
+#ifdef CONFIGCOLLECTOR_HAVE_BROTLI
+        return true;
+#else
+        return false;
+#endif
+    }
+    return false;
+}
+
+const char *StreamDecompressor::FormatName(Format format) {
+    switch (format) {
+    case Format::Identity: return "identity";
+    case Format::Auto: return "auto";
+    case Format::Gzip: return "gzip";
+    case Format::Zlib: return "deflate";
+    case Format::Zstd: return "zstd";
+    case Format::Brotli: return "br";
+    }
+    return "unknown";
+}
+
+QByteArray StreamDecompressor::AcceptEncoding() {
+    QByteArray value;
+    for (Format format : {Format::Zstd, Format::Brotli, Format::Gzip, Format::Zlib}) {
+        if (IsSupported(format)) {
+            if (!value.isEmpty()) {
+                value += ", ";
+            }
+            value += FormatName(format);
+        }
+    }
+    return value;
+}
+
+StreamDecompressor::Format StreamDecompressor::FromContentEncoding(QByteArrayView encoding) {
+    const QByteArray name = encoding.trimmed().toByteArray().toLower();
+    if (name == "gzip" || name == "x-gzip") {
+        return Format::Gzip;
+    }
+    if (name == "deflate") {
+        return Format::Zlib;
+    }
+    if (name == "zstd") {
+        return Format::Zstd;
+    }
+    if (name == "br") {
+        return Format::Brotli;
+    }
+    return Format::Identity;
+}
+
+StreamDecompressor::Format StreamDecompressor::FromFileName(QStringView name) {
+    if (name.endsWith(u".gz", Qt::CaseInsensitive) || name.endsWith(u".gzip", Qt::CaseInsensitive)) {
+        return Format::Gzip;
+    }
+    if (name.endsWith(u".zst", Qt::CaseInsensitive) || name.endsWith(u".zstd", Qt::CaseInsensitive)) {
+        return Format::Zstd;
+    }
+    if (name.endsWith(u".br", Qt::CaseInsensitive)) {
+        return Format::Brotli;
+    }
+    return Format::Auto;
+}
+
+StreamDecompressor::Format StreamDecompressor::Detect(QByteArrayView head) {
+    if (head.size() >= 2 && quint8(head[0]) == 0x1f && quint8(head[1]) == 0x8b) {
+        return Format::Gzip;
+    }
+    if (head.size() >= 4 && quint8(head[0]) == 0x28 && quint8(head[1]) == 0xb5 &&
+        quint8(head[2]) == 0x2f && quint8(head[3]) == 0xfd) {
+        return Format::Zstd;
+    }
+    return Format::Identity;
+}
+
+bool StreamDecompressor::fail(const QString &error) {
+    m_failed = true;
+    m_error = error;
+    return false;
+}
+
+bool StreamDecompressor::start(Format format) {
+    m_format = format;
+    if (!IsSupported(format)) {
+        return fail(QString("%1 support is not built in").arg(QString::fromLatin1(FormatName(format))));
+    }
+    if (format == Format::Identity) {
+        return true;
+    }
+
+    m_codec = std::make_unique<Codec>();
+    switch (format) {
+#ifdef CONFIGCOLLECTOR_HAVE_ZLIB
+    case Format::Gzip:
+    case Format::Zlib:
+        // 16: gzip wrapper, 0: zlib wrapper
+        if (inflateInit2(&m_codec->zlib, MAX_WBITS + (format == Format::Gzip ? 16 : 0)) != Z_OK) {
+            return fail("Cannot initialize zlib");
+        }
+        m_codec->zlibActive = true;
+        return true;
+#endif
+#ifdef CONFIGCOLLECTOR_HAVE_ZSTD
+    case Format::Zstd:
+        m_codec->zstd = ZSTD_createDStream();
+        if (!m_codec->zstd || ZSTD_isError(ZSTD_initDStream(m_codec->zstd))) {
+            return fail("Cannot initialize zstd");
+        }
+        return true;
+#endif
+#ifdef CONFIGCOLLECTOR_HAVE_BROTLI
+    case Format::Brotli:
+        m_codec->brotli = BrotliDecoderCreateInstance(nullptr, nullptr, nullptr);
+        if (!m_codec->brotli) {
+            return fail("Cannot initialize brotli");
+        }
+        return true;
+#endif
+    default:
+        return fail(QString("%1 support is not built in").arg(QString::fromLatin1(FormatName(format))));
+    }
+}
+
+bool StreamDecompressor::feed(QByteArrayView input, QByteArray &output) {
+    if (m_failed) {
+        return false;
+    }
+    m_bytesIn += input.size();
+
+    if (m_format == Format::Auto) {
+        // Hold the first bytes back until the magic number can be checked
+        m_head.append(input.data(), input.size());
+        if (m_head.size() < MagicBytes) {
+            return true;
+        }
+        if (!start(Detect(m_head))) {
+            return false;
+        }
+        const QByteArray head = std::move(m_head);
+        m_head.clear();
+        m_bytesIn -= head.size();
+        return feed(head, output);
+    }
+
+    if (input.isEmpty()) {
+        return true;
+    }
+
+    switch (m_format) {
+    case Format::Identity:
+        output.append(input.data(), input.size());
+        return true;
+
+#ifdef CONFIGCOLLECTOR_HAVE_ZLIB
+    case Format::Gzip:
+    case Format::Zlib: {
+        z_stream &zs = m_codec->zlib;
+        zs.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(input.data()));
+        zs.avail_in = uInt(input.size());
+        while (zs.avail_in > 0) {
+            if (m_codec->zlibEnded) {
+                // Concatenated gzip members form one stream; anything after a zlib stream is garbage
+                if (m_format != Format::Gzip || inflateReset(&zs) != Z_OK) {
+                    return fail("Trailing data after compressed stream");
+                }
+                m_codec->zlibEnded = false;
+            }
+
+            const qsizetype offset = output.size();
+            output.resize(offset + OutputChunk);
+            zs.next_out = reinterpret_cast<Bytef *>(output.data() + offset);
+            zs.avail_out = uInt(OutputChunk);
+            const int ret = inflate(&zs, Z_NO_FLUSH);
+            output.resize(offset + (OutputChunk - qsizetype(zs.avail_out)));
+
+            if (ret == Z_STREAM_END) {
+                m_codec->zlibEnded = true;
+            } else if (ret == Z_BUF_ERROR && zs.avail_out > 0) {
+                break;
+            } else if (ret != Z_OK && ret != Z_BUF_ERROR) {
+                return fail(QString("Corrupt %1 data: %2").arg(QString::fromLatin1(FormatName(m_format)), QString::fromLatin1(zs.msg ? zs.msg : "inflate failed")));
+            }
+        }
+        return true;
+    }
+#endif
+
+#ifdef CONFIGCOLLECTOR_HAVE_ZSTD
+    case Format::Zstd: {
+        ZSTD_inBuffer in{input.data(), size_t(input.size()), 0};
+        while (in.pos < in.size) {
+            const qsizetype offset = output.size();
+            output.resize(offset + OutputChunk);
+            ZSTD_outBuffer out{output.data() + offset, size_t(OutputChunk), 0};
+            const size_t ret = ZSTD_decompressStream(m_codec->zstd, &out, &in);
+            output.resize(offset + qsizetype(out.pos));
+            if (ZSTD_isError(ret)) {
+                return fail(QString("Corrupt zstd data: %1").arg(QString::fromLatin1(ZSTD_getErrorName(ret))));
+            }
+            m_codec->zstdHint = ret;
+        }
+        return true;
+    }
+#endif
+
+#ifdef CONFIGCOLLECTOR_HAVE_BROTLI
+    case Format::Brotli: {
+        size_t availableIn = size_t(input.size());
+        const uint8_t *nextIn = reinterpret_cast<const uint8_t *>(input.data());
+        for (;;) {
+            const qsizetype offset = output.size();
+            output.resize(offset + OutputChunk);
+            size_t availableOut = size_t(OutputChunk);
+            uint8_t *nextOut = reinterpret_cast<uint8_t *>(output.data() + offset);
+            const BrotliDecoderResult ret = BrotliDecoderDecompressStream(m_codec->brotli, &availableIn, &nextIn,
+                                                                          &availableOut, &nextOut, nullptr);
+            output.resize(offset + (OutputChunk - qsizetype(availableOut)));
+            if (ret == BROTLI_DECODER_RESULT_ERROR) {
+                return fail(QString("Corrupt brotli data: %1")
+                                .arg(QString::fromLatin1(BrotliDecoderErrorString(BrotliDecoderGetErrorCode(m_codec->brotli)))));
+            }
+            if (ret == BROTLI_DECODER_RESULT_SUCCESS) {
+                return availableIn == 0 ? true : fail("Trailing data after compressed stream");
+            }
+            if (ret == BROTLI_DECODER_RESULT_NEEDS_MORE_INPUT) {
+                return true;
+            }
+            // NEEDS_MORE_OUTPUT: go round with a fresh chunk
+        }
+    }
+#endif
+
+    default:
+        return fail(QString("%1 support is not built in").arg(QString::fromLatin1(FormatName(m_format))));
+    }
+}
+
+bool StreamDecompressor::finish(QByteArray &output) {
+    if (m_failed) {
+        return false;
+    }
+
+    if (m_format == Format::Auto) {
+        // Shorter than any magic number: plain text
+        if (!start(Format::Identity)) {
+            return false;
+        }
+        const QByteArray head = std::move(m_head);
+        m_head.clear();
+        m_bytesIn -= head.size();
+        if (!feed(head, output)) {
+            return false;
+        }
+    }
+
+    switch (m_format) {
+#ifdef CONFIGCOLLECTOR_HAVE_ZLIB
+    case Format::Gzip:
+    case Format::Zlib:
+        return m_codec->zlibEnded || m_bytesIn == 0 ? true : fail("Compressed stream is truncated");
+#endif
+#ifdef CONFIGCOLLECTOR_HAVE_ZSTD
+    case Format::Zstd:
+        return m_codec->zstdHint == 0 || m_bytesIn == 0 ? true : fail("Compressed stream is truncated");
+#endif
+#ifdef CONFIGCOLLECTOR_HAVE_BROTLI
+    case Format::Brotli:
+        return BrotliDecoderIsFinished(m_codec->brotli) || m_bytesIn == 0 ? true
+                                                                            : fail("Compressed stream is truncated");
+#endif
+    default:
+        return true;
+    }
+}
+
+bool StreamDecompressor::Decode(Format format, QByteArrayView input, QByteArray &output, QString *error) {
+    StreamDecompressor decompressor(format);
+    if (decompressor.feed(input, output) && decompressor.finish(output)) {
+        return true;
+    }
+    if (error) {
+        *error = decompressor.errorString();
+    }
+    return false;
+}
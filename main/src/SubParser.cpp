@@ -1,12 +1,24 @@
 #include "../include/SubParser.h"
 #include "../include/Utils.h"
+#include "../include/Base64Decoder.h"
+#include "../include/ParseArena.h"
 #include <QDebug>
+#include <QThreadPool>
+#include <QSemaphore>
+#include <QElapsedTimer>
+#include <cstring>
 
 QList<std::shared_ptr<ProxyBean>> SubParser::ParseSubscription(const QString &content) {
-    // Try Base64 decode
-    auto decoded = DecodeB64IfValid(content);
-    if (!decoded.isEmpty()) {
-        return ParseSubscription(QString::fromUtf8(decoded));
+    return ParseSubscription(content, 0);
+}
+
+QList<std::shared_ptr<ProxyBean>> SubParser::ParseSubscription(const QString &content, int depth) {
+    // Try Base64 decode, as deep as the streaming parser would
+    if (depth < MaxNestingDepth) {
+        auto decoded = DecodeB64IfValid(content);
+        if (!decoded.isEmpty()) {
+            return ParseSubscription(QString::fromUtf8(decoded), depth + 1);
+        }
     }
 
     // Multi-line
@@ -23,6 +35,38 @@ QList<std::shared_ptr<ProxyBean>> SubParser::ParseSubscription(const QString &co
     return result;
 }
 
+QList<std::shared_ptr<ProxyBean>> SubParser::ParseSubscription(const QByteArray &body, QThreadPool *pool) {
+    QList<std::shared_ptr<ProxyBean>> result;
+    SubStreamParser parser([&result](const std::shared_ptr<ProxyBean> &bean) {
+        result.append(bean);
+    });
+    parser.setThreadPool(pool);
+    parser.feed(body);
+    parser.finish();
+    return result;
+}
+
+bool SubParser::IsSubscriptionUrl(QByteArrayView link) {
+    if (ProxyTypeFromLink(link) != ProxyType::Http) {
+        return false;
+    }
+    qsizetype i = link.indexOf("://") + 3;
+    while (i < link.size() && link[i] != '/' && link[i] != '?' && link[i] != '#') {
+        if (link[i] == '@') {
+            return false;   // credentials: an HTTP proxy
+        }
+        ++i;
+    }
+    if (i >= link.size() || link[i] == '#') {
+        return false;       // bare host[:port]
+    }
+    if (link[i] == '?') {
+        return true;
+    }
+    // A path or query after the "/"; "http://host/#name" is still a proxy
+    return i + 1 < link.size() && link[i + 1] != '#';
+}
+
 QList<std::shared_ptr<ProxyBean>> SubParser::ParseMultiLine(const QString &str) {
     QList<std::shared_ptr<ProxyBean>> result;
     auto lines = str.split('\n', Qt::SkipEmptyParts);
@@ -43,42 +87,450 @@ QList<std::shared_ptr<ProxyBean>> SubParser::ParseMultiLine(const QString &str)
 }
 
 std::shared_ptr<ProxyBean> SubParser::ParseSingleLink(const QString &str) {
+    // UTF-16 units, never more than the line's UTF-8 bytes
+    if (str.size() > MaxLineBytes) {
+        return nullptr;
+    }
+
     std::shared_ptr<ProxyBean> bean;
 
-    // VMess
-    if (str.startsWith("vmess://")) {
-        bean = std::make_shared<VMessBean>();
-        if (!bean->TryParseLink(str)) return nullptr;
-    }
-    // ShadowSocks
-    else if (str.startsWith("ss://")) {
-        bean = std::make_shared<ShadowSocksBean>();
-        if (!bean->TryParseLink(str)) return nullptr;
-    }
-    // Trojan
-    else if (str.startsWith("trojan://")) {
-        auto trojanBean = std::make_shared<TrojanVLESSBean>();
-        trojanBean->type = "trojan";
-        if (!trojanBean->TryParseLink(str)) return nullptr;
-        bean = trojanBean;
-    }
-    // VLESS
-    else if (str.startsWith("vless://")) {
-        auto vlessBean = std::make_shared<TrojanVLESSBean>();
-        vlessBean->type = "vless";
-        if (!vlessBean->TryParseLink(str)) return nullptr;
-        bean = vlessBean;
-    }
-    // SOCKS
-    else if (str.startsWith("socks")) {
-        bean = std::make_shared<SocksHttpBean>();
-        if (!bean->TryParseLink(str)) return nullptr;
-    }
-    // HTTP
-    else if (str.startsWith("http://") || str.startsWith("https://")) {
-        bean = std::make_shared<SocksHttpBean>();
-        if (!bean->TryParseLink(str)) return nullptr;
+    const ProxyType type = ProxyTypeFromLink(str);
+    switch (type) {
+    case ProxyType::VMess:
+        bean = ParseArena::Make<VMessBean>();
+        break;
+    case ProxyType::Shadowsocks:
+        bean = ParseArena::Make<ShadowSocksBean>();
+        break;
+    case ProxyType::Trojan:
+    case ProxyType::VLESS:
+        bean = ParseArena::Make<TrojanVLESSBean>();
+        break;
+    case ProxyType::Socks:
+    case ProxyType::Http:
+        bean = ParseArena::Make<SocksHttpBean>();
+        break;
+    case ProxyType::Hysteria2:
+        bean = ParseArena::Make<Hysteria2Bean>();
+        break;
+    case ProxyType::Tuic:
+        bean = ParseArena::Make<TuicBean>();
+        break;
+    case ProxyType::ShadowsocksR:
+        bean = ParseArena::Make<ShadowSocksRBean>();
+        break;
+    case ProxyType::WireGuard:
+        bean = ParseArena::Make<WireGuardBean>();
+        break;
+    case ProxyType::Unknown:
+        return nullptr;
+    }
+
+    bean->type = type;
+    if (!bean->TryParseLink(str)) return nullptr;
+    return bean;
+}
+// Streaming parser
+namespace {
+    // Bytes of non-whitespace input inspected before deciding between plain lines and base64
+    constexpr qsizetype DetectionWindow = 256;
+
+    inline bool isSpace(char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
+
+    // Standard and URL-safe alphabets, without padding
+    inline bool isBase64Alphabet(char c) {
+        return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') ||
+               c == '+' || c == '/' || c == '-' || c == '_';
+    }
+}
+
+// Lines handed to a pool worker; the worker only touches this object
+struct SubStreamParser::ParseBatch {
+    QByteArray lines;
+    QList<std::shared_ptr<ProxyBean>> beans;
+    QStringList subscriptions;
+    bool collectSubscriptions = false;
+    Stats stats;
+    QSemaphore done;
+
+    void run() {
+        // Everything parsed here is released together once the batch's beans are gone
+        ParseArena::Scope scope(std::make_shared<ParseArena>());
+        const char *cursor = lines.constData();
+        const char *end = cursor + lines.size();
+        while (cursor < end) {
+            const char *newline = static_cast<const char*>(memchr(cursor, '\n', end - cursor));
+            const char *lineEnd = newline ? newline : end;
+            auto bean = SubStreamParser::parseLine(cursor, lineEnd - cursor, stats,
+                                                   collectSubscriptions ? &subscriptions : nullptr);
+            if (bean) {
+                beans.append(bean);
+            }
+            cursor = lineEnd + 1;
+        }
+        done.release();
+    }
+};
+
+SubStreamParser::SubStreamParser(BeanHandler handler, int depth)
+    : m_handler(std::move(handler)), m_depth(depth) {
+}
+
+// Workers own their batch through a shared_ptr, so nothing here has to wait for them
+SubStreamParser::~SubStreamParser() = default;
+
+int SubStreamParser::parsedCount() const {
+    return m_parsedCount + (m_inner ? m_inner->parsedCount() : 0);
+}
+
+void SubStreamParser::Stats::merge(const Stats &other) {
+    decodeNs += other.decodeNs;
+    decodedBytes += other.decodedBytes;
+    failedLines += other.failedLines;
+    oversizedLines += other.oversizedLines;
+    for (auto it = other.failuresByScheme.cbegin(); it != other.failuresByScheme.cend(); ++it) {
+        failuresByScheme[it.key()] += it.value();
+    }
+}
+
+SubStreamParser::Stats SubStreamParser::stats() const {
+    Stats result = m_stats;
+    if (m_inner) {
+        result.merge(m_inner->stats());
+    }
+    return result;
+}
+
+void SubStreamParser::feed(const char *data, qsizetype size) {
+    if (m_finished || size <= 0) {
+        return;
+    }
+    m_bytesFed += size;
+
+    switch (m_mode) {
+    case Mode::Detecting:
+        m_pending.append(data, size);
+        detect(false);
+        break;
+    case Mode::Lines:
+        feedLines(data, size);
+        break;
+    case Mode::Base64:
+        feedBase64(data, size);
+        break;
+    }
+}
+
+void SubStreamParser::detect(bool atEnd) {
+    bool plain = m_depth >= SubParser::MaxNestingDepth;
+    qsizetype significant = 0;
+
+    for (qsizetype i = 0; i < m_pending.size() && !plain; ++i) {
+        char c = m_pending.at(i);
+        if (isSpace(c)) {
+            continue;
+        }
+        if (!isBase64Alphabet(c) && c != '=') {
+            plain = true;
+        }
+        ++significant;
+    }
+
+    // Leading whitespace alone cannot hold the decision up forever
+    if (!plain && significant < DetectionWindow && !atEnd && m_pending.size() < SubParser::MaxLineBytes) {
+        // Not enough data to decide yet
+        return;
+    }
+
+    QByteArray buffered;
+    buffered.swap(m_pending);
+
+    if (plain || significant == 0) {
+        m_mode = Mode::Lines;
+        feedLines(buffered.constData(), buffered.size());
+    } else {
+        m_mode = Mode::Base64;
+        feedBase64(buffered.constData(), buffered.size());
+    }
+}
+
+void SubStreamParser::feedLines(const char *data, qsizetype size) {
+    if (m_skippingLine) {
+        const char *newline = static_cast<const char*>(memchr(data, '\n', size));
+        if (!newline) {
+            return;
+        }
+        m_skippingLine = false;
+        size -= newline + 1 - data;
+        data = newline + 1;
+    }
+
+    if (m_pool) {
+        queueLines(data, size);
+        return;
+    }
+
+    const char *cursor = data;
+    const char *end = data + size;
+
+    while (cursor < end) {
+        const char *newline = static_cast<const char*>(memchr(cursor, '\n', end - cursor));
+        if (!newline) {
+            // Keep the unfinished line for the next chunk
+            keepPartialLine(cursor, end - cursor);
+            return;
+        }
+
+        if (m_pending.isEmpty()) {
+            processLine(cursor, newline - cursor);
+        } else {
+            m_pending.append(cursor, newline - cursor);
+            processLine(m_pending.constData(), m_pending.size());
+            m_pending.resize(0);
+        }
+        cursor = newline + 1;
+    }
+}
+
+void SubStreamParser::keepPartialLine(const char *data, qsizetype size) {
+    if (m_pending.size() + size > SubParser::MaxLineBytes) {
+        // parseLine would reject it anyway; drop it up to its newline instead of buffering
+        m_pending.clear();
+        m_skippingLine = true;
+        ++m_stats.oversizedLines;
+        return;
+    }
+    m_pending.append(data, size);
+}
+
+void SubStreamParser::feedBase64(const char *data, qsizetype size) {
+    qsizetype i = 0;
+    while (i < size) {
+        qsizetype runStart = i;
+        while (i < size && isBase64Alphabet(data[i])) {
+            ++i;
+        }
+
+        if (i > runStart) {
+            if (m_paddingSeen) {
+                i = runStart;
+                break;  // data after padding, handled as garbage below
+            }
+            m_pending.append(data + runStart, i - runStart);
+        }
+
+        if (i >= size) {
+            break;
+        }
+
+        char c = data[i];
+        if (isSpace(c)) {
+            ++i;
+        } else if (c == '=') {
+            m_paddingSeen = true;
+            ++i;
+        } else {
+            break;
+        }
     }
 
+    if (i < size) {
+        // Not base64 after all: flush what was decoded and read the rest as plain lines
+        decodePendingBase64(true);
+        if (m_inner) {
+            m_inner->finish();
+        }
+        m_mode = Mode::Lines;
+        feedLines(data + i, size - i);
+        return;
+    }
+
+    decodePendingBase64(false);
+}
+
+void SubStreamParser::decodePendingBase64(bool atEnd) {
+    // Decode whole 4-character quanta; the remainder waits for the next chunk
+    qsizetype usable = atEnd ? m_pending.size() : (m_pending.size() / 4) * 4;
+    if (usable == 0) {
+        return;
+    }
+
+    // A lone trailing sextet carries no full byte; drop it instead of failing the tail
+    qsizetype decodable = usable % 4 == 1 ? usable - 1 : usable;
+    QElapsedTimer timer;
+    timer.start();
+    QByteArray decoded = Base64Decoder::Decode(m_pending.constData(), decodable).decoded;
+    m_stats.decodeNs += timer.nsecsElapsed();
+    m_stats.decodedBytes += decoded.size();
+    m_pending.remove(0, usable);
+
+    if (!m_inner) {
+        m_inner = std::make_unique<SubStreamParser>(m_handler, m_depth + 1);
+        m_inner->setThreadPool(m_pool);
+        m_inner->onSubscription(m_subscriptionHandler);
+    }
+    m_inner->feed(decoded);
+}
+
+std::shared_ptr<ProxyBean> SubStreamParser::parseLine(const char *data, qsizetype size, Stats &stats,
+                                                      QStringList *subscriptions) {
+    while (size > 0 && isSpace(data[0])) {
+        ++data;
+        --size;
+    }
+    while (size > 0 && isSpace(data[size - 1])) {
+        --size;
+    }
+
+    if (size < 5 || data[0] == '#' || (data[0] == '/' && data[1] == '/')) {
+        return nullptr;
+    }
+    if (size > SubParser::MaxLineBytes) {
+        ++stats.oversizedLines;
+        return nullptr;
+    }
+
+    if (subscriptions && SubParser::IsSubscriptionUrl(QByteArrayView(data, size))) {
+        subscriptions->append(QString::fromUtf8(data, size));
+        return nullptr;
+    }
+
+    std::shared_ptr<ProxyBean> bean;
+    // Lines without a known scheme are never converted to UTF-16
+    if (ProxyTypeFromLink(QByteArrayView(data, size)) != ProxyType::Unknown) {
+        bean = SubParser::ParseSingleLink(QString::fromUtf8(data, size));
+    }
+    if (!bean) {
+        // Attribute the failure to the link's scheme so broken parsers stand out
+        QByteArrayView line(data, size);
+        const qsizetype schemeEnd = line.indexOf("://");
+        const bool hasScheme = schemeEnd > 0 && schemeEnd <= 16;
+        ++stats.failedLines;
+        ++stats.failuresByScheme[hasScheme ? QString::fromLatin1(line.first(schemeEnd)).toLower()
+                                           : QStringLiteral("unknown")];
+    }
     return bean;
-}
\ No newline at end of file
+}
+
+void SubStreamParser::processLine(const char *data, qsizetype size) {
+    if (!m_arena || m_arena->bytesAllocated() >= ParseArena::RotateBytes) {
+        m_arena = std::make_shared<ParseArena>();
+    }
+    ParseArena::Scope scope(m_arena);
+    QStringList subscriptions;
+    auto bean = parseLine(data, size, m_stats, m_subscriptionHandler ? &subscriptions : nullptr);
+    if (bean) {
+        emitBean(bean);
+    }
+    for (const QString &url : subscriptions) {
+        m_subscriptionHandler(url);
+    }
+}
+
+void SubStreamParser::emitBean(const std::shared_ptr<ProxyBean> &bean) {
+    ++m_parsedCount;
+    if (m_handler) {
+        m_handler(bean);
+    }
+}
+
+void SubStreamParser::queueLines(const char *data, qsizetype size) {
+    // Everything up to the last newline joins the batch; the rest waits in m_pending
+    qsizetype complete = size;
+    while (complete > 0 && data[complete - 1] != '\n') {
+        --complete;
+    }
+    if (complete == 0) {
+        keepPartialLine(data, size);
+        return;
+    }
+
+    if (!m_pending.isEmpty()) {
+        m_batch.append(m_pending);
+        m_pending.resize(0);
+    }
+    m_batch.append(data, complete);
+    keepPartialLine(data + complete, size - complete);
+
+    if (m_batch.size() >= ParallelBatchBytes) {
+        submitBatch();
+    }
+    drainBatches(false);
+}
+
+void SubStreamParser::submitBatch() {
+    if (m_batch.isEmpty()) {
+        return;
+    }
+
+    auto batch = std::make_shared<ParseBatch>();
+    batch->lines.swap(m_batch);
+    batch->collectSubscriptions = bool(m_subscriptionHandler);
+    m_batches.push_back(batch);
+    m_pool->start([batch]() { batch->run(); });
+
+    // Bound the memory held by submitted but not yet emitted batches
+    const size_t maxQueued = size_t(qMax(1, m_pool->maxThreadCount()) * 2);
+    while (m_batches.size() > maxQueued) {
+        emitFrontBatch(true);
+    }
+}
+
+bool SubStreamParser::emitFrontBatch(bool wait) {
+    ParseBatch &front = *m_batches.front();
+    if (wait) {
+        front.done.acquire();
+    } else if (!front.done.tryAcquire()) {
+        return false;
+    }
+
+    for (const auto &bean : front.beans) {
+        emitBean(bean);
+    }
+    for (const QString &url : front.subscriptions) {
+        m_subscriptionHandler(url);
+    }
+    m_stats.merge(front.stats);
+    m_batches.pop_front();
+    return true;
+}
+
+void SubStreamParser::drainBatches(bool wait) {
+    while (!m_batches.empty() && emitFrontBatch(wait)) {
+    }
+}
+
+void SubStreamParser::finish(bool truncated) {
+    if (m_finished) {
+        return;
+    }
+
+    if (m_mode == Mode::Detecting) {
+        detect(true);
+    }
+    if (truncated) {
+        if (m_mode == Mode::Base64) {
+            decodePendingBase64(false);
+        }
+        m_pending.clear();
+    }
+
+    if (m_mode == Mode::Base64) {
+        decodePendingBase64(true);
+    } else if (m_pool) {
+        m_batch.append(m_pending);
+        m_pending.clear();
+        submitBatch();
+        drainBatches(true);
+    } else if (!m_pending.isEmpty()) {
+        processLine(m_pending.constData(), m_pending.size());
+        m_pending.clear();
+    }
+
+    if (m_inner) {
+        m_inner->finish(truncated);
+    }
+    m_finished = true;
+}
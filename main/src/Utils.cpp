@@ -1,5 +1,8 @@
 #include "Utils.h"
+#include "Base64Decoder.h"
+#include "MappedFile.h"
 #include <QFile>
+#include <QSaveFile>
 #include <QTextStream>
 #include <QDebug>
 #include <QCoreApplication>
@@ -15,28 +18,23 @@
 
 Q_LOGGING_CATEGORY(UTILS, "utils")
 
-QString Utils::m_lastError;
+thread_local QString Utils::m_lastError;
 
 // Base64 decoding implementation
 QByteArray DecodeB64IfValid(const QString &input, QByteArray::Base64Options options) {
-    if (input.isEmpty()) {
-        return QByteArray();
-    }
+    // Both alphabets are always accepted, so the options no longer change the result
+    Q_UNUSED(options);
 
-    // Remove whitespace and validate base64 characters
-    QString cleanInput = input.trimmed();
-    if (cleanInput.isEmpty()) {
+    if (input.isEmpty()) {
         return QByteArray();
     }
 
-    // Check for valid base64 characters
-    QRegularExpression base64Regex("^[A-Za-z0-9+/]*={0,2}$");
-    if (!base64Regex.match(cleanInput).hasMatch()) {
+    // One pass validates and decodes; anything malformed yields an empty result
+    auto result = Base64Decoder::Decode(QStringView(input));
+    if (!result) {
         return QByteArray();
     }
-
-    QByteArray decoded = QByteArray::fromBase64(cleanInput.toUtf8(), options);
-    return decoded;
+    return std::move(result.decoded);
 }
 
 // String helper functions
@@ -111,15 +109,18 @@ bool Utils::writeFileText(const QString& filePath, const QString& content) {
         return false;
     }
 
-    QFile file(filePath);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+    // Temp file + rename, so readers never see a half-written file
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
         setLastError(QString("Cannot open file for writing: %1 - %2").arg(filePath, file.errorString()));
         return false;
     }
 
-    QTextStream stream(&file);
-    stream << content;
-    file.close();
+    const QByteArray data = content.toUtf8();
+    if (file.write(data) != data.size() || !file.commit()) {
+        setLastError(QString("Cannot write file: %1 - %2").arg(filePath, file.errorString()));
+        return false;
+    }
 
     qCDebug(UTILS) << "Successfully wrote file:" << filePath << "Size:" << content.size() << "bytes";
     return true;
@@ -149,11 +150,38 @@ bool Utils::appendFileText(const QString& filePath, const QString& content) {
 }
 
 QStringList Utils::readFileLines(const QString& filePath) {
-    QString content = readFileText(filePath);
-    if (content.isEmpty()) {
-        return QStringList();
+    QStringList lines;
+    forEachLine(filePath, [&lines](QByteArrayView line) {
+        if (!line.isEmpty()) {
+            lines.append(QString::fromUtf8(line));
+        }
+        return true;
+    });
+    return lines;
+}
+
+bool Utils::forEachLine(const QString& filePath, const std::function<bool(QByteArrayView line)>& handler) {
+    clearError();
+
+    MappedFile file;
+    if (!file.open(filePath)) {
+        setLastError(file.errorString());
+        return false;
+    }
+
+    QByteArrayView line;
+    while (file.readLine(line)) {
+        if (!handler(line)) {
+            return true;
+        }
     }
-    return content.split('\n', Qt::SkipEmptyParts);
+    if (!file.errorString().isEmpty()) {
+        setLastError(file.errorString());
+        return false;
+    }
+
+    qCDebug(UTILS) << "Successfully read lines from:" << filePath << "Size:" << file.size() << "bytes";
+    return true;
 }
 
 bool Utils::writeFileLines(const QString& filePath, const QStringList& lines) {
@@ -191,16 +219,14 @@ bool Utils::writeFile(const QString& filePath, const QByteArray& data) {
         return false;
     }
 
-    QFile file(filePath);
+    QSaveFile file(filePath);
     if (!file.open(QIODevice::WriteOnly)) {
         setLastError(QString("Cannot open file for writing: %1 - %2").arg(filePath, file.errorString()));
         return false;
     }
 
     qint64 written = file.write(data);
-    file.close();
-
-    if (written != data.size()) {
+    if (written != data.size() || !file.commit()) {
         setLastError(QString("Incomplete write to file: %1").arg(filePath));
         return false;
     }
@@ -291,6 +317,18 @@ QString Utils::normalizePath(const QString& path) {
     return QDir::cleanPath(path);
 }
 
+QString Utils::localFilePath(const QString& link) {
+    const QUrl url(link);
+    if (url.isLocalFile()) {
+        return url.toLocalFile();
+    }
+    // "C:/dump.txt" parses with a one-letter scheme
+    if ((url.scheme().isEmpty() || url.scheme().size() == 1) && QFileInfo(link).isFile()) {
+        return link;
+    }
+    return QString();
+}
+
 // Validation utilities
 bool Utils::isValidUrl(const QString& url) {
     QUrl testUrl(url);
@@ -343,7 +381,10 @@ QString Utils::cleanString(const QString& input) {
 
 bool Utils::containsValidConfig(const QString& content) {
     return content.contains("vmess://") || content.contains("ss://") ||
-           content.contains("vless://") || content.contains("trojan://");
+           content.contains("vless://") || content.contains("trojan://") ||
+           content.contains("ssr://") || content.contains("hysteria2://") ||
+           content.contains("hy2://") || content.contains("tuic://") ||
+           content.contains("wireguard://") || content.contains("wg://");
 }
 
 // Data conversion utilities
@@ -1,16 +1,41 @@
 #include <QCoreApplication>
 #include <QDebug>
 #include <QDir>
-#include <QMap>
 #include <QException>
 #include <QLoggingCategory>
 #include <QStandardPaths>
 #include <QTimer>
 #include <QEventLoop>
 #include <QNetworkReply>
+#include <QThread>
+#include <QThreadPool>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QElapsedTimer>
+#include <QDeadlineTimer>
+#include <QSet>
+#include <QUrl>
+#include <map>
+#include <memory>
 
 #include "Utils.h"
 #include "HttpHelper.h"
+#include "IngestPipeline.h"
+#include "DownloadScheduler.h"
+#include "FetchCache.h"
+#include "Deduplicator.h"
+#include "ConfigStore.h"
+#include "ConfigWriter.h"
+#include "MappedFile.h"
+#include "StreamDecompressor.h"
+#include "ShardedWriter.h"
+#include "ConfigSnapshot.h"
+#include "ConfigDelta.h"
+#include "ReachabilityFilter.h"
+#include "DnsCache.h"
+#include "RunMetrics.h"
+#include "SourceHistory.h"
 #include "SubParser.h"
 #include "ConfigManager.h"
 
@@ -26,20 +51,158 @@ struct SubStats {
     int totalConfigs = 0;
     int uniqueConfigs = 0;
     int duplicates = 0;
+    int unreachable = 0;
+    int added = -1;     // against the previous run; -1 without a baseline
+    int removed = -1;
     QString status;
     QString errorMessage;
-    qint64 downloadTime = 0;
+    qint64 downloadTime = 0;    // milliseconds from request to complete body
+    bool fromCache = false;
+    int depth = 0;              // 0 for Sub.txt entries, +1 per index it was listed in
+    int nested = 0;             // subscriptions it listed that were new to this run
+    int parent = -1;            // id of the index that listed it
+    qint64 bytes = 0;           // body size
 };
 
-// Generate unique key for deduplication (protocol + server + port)
-QString GenerateConfigKey(const std::shared_ptr<ProxyBean> &bean) {
-    if (!bean) {
-        return QString();
+// Per-download parse state; configs are stored while the body streams in
+struct SubscriptionJob {
+    std::unique_ptr<SubStreamParser> parser;
+    ConfigStore configs;
+    qint64 parseNs = 0;     // ingest thread time spent in the parser, decode included
+    QStringList pendingHosts;   // server names to prefetch on the event loop thread
+    bool expand = false;        // collect listed subscription URLs instead of parsing them
+    int depth = 0;
+    int listed = 0;             // subscription URLs seen in the body
+    QStringList nested;         // listed, not yet queued
+};
+
+SubStreamParser& streamParserFor(SubscriptionJob& job, const QString& subUrl, QThreadPool* parsePool,
+                                 DnsCache* resolver) {
+    if (!job.parser) {
+        job.parser = std::make_unique<SubStreamParser>([&job, subUrl, resolver](const std::shared_ptr<ProxyBean>& bean) {
+            bean->source = subUrl;
+            job.configs.append(*bean);
+            // Resolve while the remaining downloads are still running
+            if (resolver) {
+                job.pendingHosts.append(bean->serverAddress);
+            }
+        });
+        job.parser->setThreadPool(parsePool);
+        if (job.expand) {
+            job.parser->onSubscription([&job](const QString& url) {
+                ++job.listed;
+                job.nested.append(url);
+            });
+        }
+    }
+    return *job.parser;
+}
+
+// Key for the visited set: scheme and host are case-insensitive, the fragment is a label
+QString normalizedSubscriptionUrl(const QString& url) {
+    return QUrl(url).adjusted(QUrl::RemoveFragment | QUrl::NormalizePathSegments).toString();
+}
+
+// Keep the first occurrence of every proxy, in subscription order, and record
+// per-subscription unique/duplicate counts
+void deduplicateSubscriptions(Deduplicator& dedup, std::map<int, SubscriptionJob>& jobs, QList<SubStats>& allStats,
+                              RunMetrics& metrics) {
+    qsizetype expected = 0;
+    for (const auto& entry : jobs) {
+        expected += entry.second.configs.size();
+    }
+    dedup.reserve(expected);
+
+    for (auto& entry : jobs) {
+        SubStats& stats = allStats[entry.first];
+        ConfigStore& configs = entry.second.configs;
+
+        RunMetrics::Timer timer(metrics, RunMetrics::Stage::Dedup, entry.first);
+        stats.duplicates = int(configs.deduplicate(dedup));
+        stats.uniqueConfigs = int(configs.size());
+    }
+}
+
+// Incremental mode: compare with the previous run's snapshot and write the configs that
+// appeared (added.ndjson) and disappeared (removed.ndjson) since, plus per-subscription
+// counts (delta.json). Must run before the new snapshot replaces the old one.
+bool writeDelta(QDir outDir, Deduplicator::Mode mode, std::map<int, SubscriptionJob>& jobs,
+                QList<SubStats>& allStats) {
+    const QStringList deltaFiles = {"added.ndjson", "removed.ndjson", "delta.json"};
+
+    ConfigSnapshot previous;
+    previous.open(outDir.filePath("configs.snapshot"));
+    ConfigDelta delta(previous, mode);
+    if (!delta.hasBaseline()) {
+        // A stale delta would describe some earlier run
+        for (const QString& name : deltaFiles) {
+            outDir.remove(name);
+        }
+        qCInfo(CONFIG_INFO) << "No comparable previous snapshot; skipping delta"
+                            << (previous.isOpen() ? "(dedup mode changed)" : "");
+        return false;
+    }
+
+    QJsonArray subscriptions;
+    qsizetype totalAdded = 0;
+    qsizetype totalUnchanged = 0;
+
+    ConfigWriter added(ConfigWriter::Format::Ndjson);
+    added.open(outDir.filePath(deltaFiles[0]));
+    std::map<int, ConfigDelta::Counts> countsById;
+    for (auto& [id, job] : jobs) {
+        QVector<qsizetype> addedRows;
+        const ConfigDelta::Counts counts = delta.compare(job.configs, &addedRows);
+        for (qsizetype row : addedRows) {
+            added.write(job.configs, row);
+        }
+        countsById[id] = counts;
+        totalAdded += counts.added;
+        totalUnchanged += counts.unchanged;
+    }
+
+    // Only known once every store has been compared
+    const QHash<QByteArray, qsizetype> removedBySource = delta.removedBySource();
+    for (const auto& [id, counts] : countsById) {
+        SubStats& stats = allStats[id];
+        stats.added = int(counts.added);
+        stats.removed = int(removedBySource.value(stats.url.toUtf8()));
+
+        QJsonObject entry;
+        entry["subscription"] = stats.url;
+        entry["added"] = stats.added;
+        entry["removed"] = stats.removed;
+        entry["unchanged"] = qint64(counts.unchanged);
+        subscriptions.append(entry);
+    }
+
+    // Gone configs only exist in the old snapshot; copy them out to serialize them
+    ConfigStore gone;
+    for (qsizetype row : delta.removedRows()) {
+        previous.appendRowTo(gone, row);
     }
-    return QString("%1://%2:%3")
-        .arg(bean->type)
-        .arg(bean->serverAddress)
-        .arg(bean->serverPort);
+    ConfigWriter removed(ConfigWriter::Format::Ndjson);
+    removed.open(outDir.filePath(deltaFiles[1]));
+    for (qsizetype row = 0; row < gone.size(); ++row) {
+        removed.write(gone, row);
+    }
+
+    QJsonObject summary;
+    summary["mode"] = Deduplicator::ModeName(mode);
+    summary["added"] = qint64(totalAdded);
+    summary["removed"] = qint64(gone.size());
+    summary["unchanged"] = qint64(totalUnchanged);
+    summary["subscriptions"] = subscriptions;
+
+    if (!added.commit() || !removed.commit() ||
+        !Utils::writeFile(outDir.filePath(deltaFiles[2]), QJsonDocument(summary).toJson())) {
+        qCWarning(CONFIG_ERROR) << "Failed to save delta files:" << added.errorString() << removed.errorString();
+        return false;
+    }
+
+    qCInfo(CONFIG_INFO) << "Delta against previous run:" << totalAdded << "added," << gone.size()
+                        << "removed," << totalUnchanged << "unchanged";
+    return true;
 }
 
 // Custom exception class for ConfigCollector
@@ -96,46 +259,141 @@ bool validatePaths() {
     return true;
 }
 
-// Enhanced subscription processing
-bool processSubscription(const QString& subUrl, SubStats& stats) {
+// Local dumps (file:// links or plain paths) are memory-mapped and handed to the
+// parser in place instead of being read through QNetworkAccessManager's buffers
+HttpResponse readLocalSubscription(const QString& path, SubscriptionJob& job, const QString& subUrl,
+                                   QThreadPool* parsePool, DnsCache* resolver, bool decompress) {
+    HttpResponse response;
+    QElapsedTimer timer;
+    timer.start();
+
+    MappedFile file;
+    if (!file.open(path)) {
+        response.error = file.errorString();
+        return response;
+    }
+
+    SubStreamParser& parser = streamParserFor(job, subUrl, parsePool, resolver);
+    std::unique_ptr<StreamDecompressor> decoder;
+    QByteArray decoded;
+    QByteArrayView block;
+    bool first = true;
+    while (file.readBlock(block)) {
+        if (first) {
+            first = false;
+            StreamDecompressor::Format format = StreamDecompressor::FromFileName(path);
+            if (format == StreamDecompressor::Format::Auto) {
+                format = StreamDecompressor::Detect(block);
+            }
+            if (decompress && format != StreamDecompressor::Format::Identity) {
+                decoder = std::make_unique<StreamDecompressor>(format);
+            }
+        }
+        if (!decoder) {
+            parser.feed(block.data(), block.size());
+            response.bytesReceived += block.size();
+            continue;
+        }
+        decoded.resize(0);
+        if (!decoder->feed(block, decoded)) {
+            response.error = decoder->errorString();
+            return response;
+        }
+        parser.feed(decoded);
+        response.bytesReceived += decoded.size();
+    }
+    if (!file.errorString().isEmpty()) {
+        response.error = file.errorString();
+        return response;
+    }
+    if (decoder) {
+        decoded.resize(0);
+        if (!decoder->finish(decoded)) {
+            response.error = decoder->errorString();
+            return response;
+        }
+        parser.feed(decoded);
+        response.bytesReceived += decoded.size();
+    }
+
+    response.statusCode = 200;
+    response.transferBytes = file.size();
+    response.totalNs = timer.nsecsElapsed();
+    job.parseNs += response.totalNs;
+    return response;
+}
+
+// Enhanced subscription processing (runs as each download completes)
+bool processSubscription(const QString& subUrl, const HttpResponse& response, SubscriptionJob& job, SubStats& stats,
+                         QThreadPool* parsePool, DnsCache* resolver) {
     try {
         stats.url = subUrl;
         stats.status = "Processing";
 
         qCInfo(CONFIG_INFO) << "Processing subscription:" << subUrl;
 
-        // Download content with timeout and error handling
-        HttpHelper httpHelper;
-        HttpResponse response = httpHelper.HttpGet(subUrl);
+        if (response.cancelled) {
+            // Cut off at the run deadline: keep the links that arrived whole
+            SubStreamParser& parser = streamParserFor(job, subUrl, parsePool, resolver);
+            QElapsedTimer parseTimer;
+            parseTimer.start();
+            parser.finish(true);
+            job.parseNs += parseTimer.nsecsElapsed();
+            stats.totalConfigs = int(job.configs.size());
+            stats.status = job.configs.isEmpty() ? "Cancelled" : "Partial";
+            stats.errorMessage = response.error;
+            qCWarning(CONFIG_INFO) << "Run deadline: kept" << stats.totalConfigs << "configs from" << subUrl;
+            return true;
+        }
 
         if (!response.error.isEmpty()) {
+            // Anything streamed before the failure is incomplete; discard it
+            job.parser.reset();
+            job.configs.clear();
             stats.status = "Failed";
             stats.errorMessage = "Network error: " + response.error;
             qCCritical(CONFIG_ERROR) << "Failed to download content from:" << subUrl << "Error:" << response.error;
             return false;
         }
 
-        if (response.data.isEmpty()) {
+        if (response.bytesReceived == 0) {
             stats.status = "Failed";
             stats.errorMessage = "Empty content received";
             qCCritical(CONFIG_ERROR) << "Empty content from:" << subUrl;
             return false;
         }
 
-        stats.downloadTime = QDateTime::currentMSecsSinceEpoch();
+        stats.downloadTime = qMax<qint64>(0, response.totalNs / 1000000);
+        stats.fromCache = response.fromCache;
+        if (response.fromCache) {
+            qCInfo(CONFIG_INFO) << "Not modified since last run, using cached copy:" << subUrl;
+        }
+
+        // Finish parsing; most of the body was already parsed while it streamed in
+        SubStreamParser& parser = streamParserFor(job, subUrl, parsePool, resolver);
+        QElapsedTimer parseTimer;
+        parseTimer.start();
+        if (!response.data.isEmpty()) {
+            parser.feed(response.data);
+        }
+        parser.finish();
+        job.parseNs += parseTimer.nsecsElapsed();
+        const ConfigStore& configs = job.configs;
 
-        // Parse content
-        SubParser parser;
-        auto beans = parser.ParseSubscription(QString::fromUtf8(response.data));
+        if (configs.isEmpty() && job.listed > 0) {
+            stats.status = "Index";
+            qCInfo(CONFIG_INFO) << "Subscription index with" << job.listed << "entries:" << subUrl;
+            return true;
+        }
 
-        if (beans.isEmpty()) {
+        if (configs.isEmpty()) {
             stats.status = "No configs";
             stats.errorMessage = "No valid proxy configurations found";
             qCWarning(CONFIG_INFO) << "No valid configs found in:" << subUrl;
             return true;
         }
 
-        stats.totalConfigs = beans.size();
+        stats.totalConfigs = int(configs.size());
 
         // Return processed stats
         return true;
@@ -174,6 +432,10 @@ int main(int argc, char *argv[]) {
         "config.info.*=true\n"
     );
 
+    // The run deadline counts from here
+    QElapsedTimer runTimer;
+    runTimer.start();
+
     try {
         qCInfo(CONFIG_MAIN) << "=== ConfigCollector Started ===";
         qCInfo(CONFIG_MAIN) << "Version:" << app.applicationVersion();
@@ -196,28 +458,30 @@ int main(int argc, char *argv[]) {
         QString subFilePath = configMgr.getSubFilePath();
         qCInfo(CONFIG_INFO) << "Reading subscriptions from:" << subFilePath;
 
-        // Read subscription file with error handling
-        QString subContent = Utils::readFileText(subFilePath);
+        if (!QFile::exists(subFilePath)) {
+            qCCritical(CONFIG_ERROR) << "Subscription file not found:" << subFilePath;
+            qCInfo(CONFIG_INFO) << "Please create the file with subscription URLs (one per line)";
+            return 1;
+        }
+        if (QFileInfo(subFilePath).size() == 0) {
+            qCCritical(CONFIG_ERROR) << "Subscription file is empty:" << subFilePath;
+            return 1;
+        }
 
-        if (subContent.isEmpty()) {
-            // Check if file exists
-            if (!QFile::exists(subFilePath)) {
-                qCCritical(CONFIG_ERROR) << "Subscription file not found:" << subFilePath;
-                qCInfo(CONFIG_INFO) << "Please create the file with subscription URLs (one per line)";
-                return 1;
-            } else {
-                qCCritical(CONFIG_ERROR) << "Subscription file is empty:" << subFilePath;
-                return 1;
+        // Parse subscription URLs, skipping comments and empty lines
+        QStringList subLinks;
+        const bool readOk = Utils::forEachLine(subFilePath, [&subLinks](QByteArrayView line) {
+            const QByteArrayView link = line.trimmed();
+            if (!link.isEmpty() && !link.startsWith('#')) {
+                subLinks.append(QString::fromUtf8(link));
             }
+            return true;
+        });
+        if (!readOk) {
+            qCCritical(CONFIG_ERROR) << "Cannot read subscription file:" << Utils::getLastError();
+            return 1;
         }
 
-        // Parse subscription URLs
-        auto subLinks = subContent.split('\n', Qt::SkipEmptyParts);
-        // Remove comments and empty lines
-        subLinks.erase(std::remove_if(subLinks.begin(), subLinks.end(), [](const QString& line) {
-            return line.trimmed().startsWith('#') || line.trimmed().isEmpty();
-        }), subLinks.end());
-
         qCInfo(CONFIG_INFO) << "Found" << subLinks.size() << "valid subscription links";
 
         if (subLinks.isEmpty()) {
@@ -227,41 +491,446 @@ int main(int argc, char *argv[]) {
 
         // Statistics tracking
         int totalConfigs = 0;
+        int uniqueCount = 0;
         int duplicateCount = 0;
+        int unreachableCount = 0;
         int configIndex = 1;
-        QMap<QString, std::shared_ptr<ProxyBean>> uniqueConfigs;
-        QList<SubStats> allStats;
+        QList<SubStats> allStats(subLinks.size());
+        std::map<int, SubscriptionJob> jobs;
+        RunMetrics metrics;
+
+        // Download all subscriptions concurrently; each reply is parsed as soon as it arrives
+        DownloadScheduler scheduler(configMgr.getConfig().maxConcurrentDownloads,
+                                    configMgr.getConfig().requestTimeout);
+
+        // A flaky mirror costs a retry, a dead one is cut off, a slow one gets hedged
+        RetryPolicy retryPolicy;
+        retryPolicy.maxAttempts = 1 + configMgr.getConfig().downloadRetries;
+        retryPolicy.baseDelayMs = configMgr.getConfig().retryBaseDelay;
+        retryPolicy.maxDelayMs = configMgr.getConfig().retryMaxDelay;
+        scheduler.setRetryPolicy(retryPolicy);
+        CircuitBreaker::Options breakerOptions;
+        breakerOptions.failureThreshold = configMgr.getConfig().circuitBreakerThreshold;
+        breakerOptions.cooldownMs = configMgr.getConfig().circuitBreakerCooldown * 1000;
+        scheduler.setCircuitBreaker(breakerOptions);
+        scheduler.setHedgeDelay(configMgr.getConfig().hedgeDelay);
+        scheduler.setPerHostLimit(configMgr.getConfig().perHostDownloads);
+        // Downloads stop early enough for whatever arrived to be written before the deadline
+        // (QDeadlineTimer reads a negative time as "never", hence the clamps)
+        QDeadlineTimer runDeadline(QDeadlineTimer::Forever);
+        if (configMgr.getConfig().runDeadline > 0) {
+            const qint64 remainingMs = qint64(configMgr.getConfig().runDeadline) * 1000 - runTimer.elapsed();
+            runDeadline.setRemainingTime(qMax<qint64>(0, remainingMs));
+            scheduler.setDeadline(QDeadlineTimer(
+                qMax<qint64>(0, remainingMs - qint64(configMgr.getConfig().deadlineReserve) * 1000)));
+        }
+        scheduler.setDecompression(configMgr.getConfig().enableCompression);
+        FetchCache fetchCache;
+        if (configMgr.getConfig().enableFetchCache) {
+            scheduler.setCache(&fetchCache);
+            qCInfo(CONFIG_INFO) << "Fetch cache:" << fetchCache.directory();
+        }
 
-        // Process each subscription
-        for (const QString& subUrl : subLinks) {
-            SubStats stats;
+        // Link parsing runs on a worker pool unless a single thread is configured
+        const int parseThreads = configMgr.getConfig().parseThreads > 0 ? configMgr.getConfig().parseThreads
+                                                                         : QThread::idealThreadCount();
+        QThreadPool parseWorkers;
+        parseWorkers.setMaxThreadCount(parseThreads);
+        QThreadPool* parsePool = parseThreads > 1 ? &parseWorkers : nullptr;
+        qCInfo(CONFIG_INFO) << "Parsing with" << parseThreads << "thread(s)";
+
+        // One lookup per server name, shared by resolved-address dedup and the prefilter
+        Deduplicator::Mode dedupMode = Deduplicator::Mode::Endpoint;
+        Deduplicator::ParseMode(configMgr.getConfig().dedupMode, dedupMode);
+        DnsCache::Options dnsOptions;
+        dnsOptions.maxConcurrent = configMgr.getConfig().dnsConcurrency;
+        dnsOptions.ttlMs = configMgr.getConfig().dnsTtl * 1000;
+        dnsOptions.negativeTtlMs = configMgr.getConfig().dnsNegativeTtl * 1000;
+        DnsCache dnsCache(dnsOptions);
+        DnsCache* resolver = dedupMode == Deduplicator::Mode::Resolved || configMgr.getConfig().enableReachabilityFilter
+                                 ? &dnsCache : nullptr;
+
+        // Every job exists before the ingest thread starts working on them
+        const bool expandNested = configMgr.getConfig().expandSubscriptions;
+        const int maxDepth = configMgr.getConfig().maxSubscriptionDepth;
+        QSet<QString> visited;      // normalized URLs; a cycle of indexes ends here
+        for (int id = 0; id < subLinks.size(); ++id) {
+            subLinks[id] = subLinks[id].trimmed();
+            metrics.setSubscription(id, subLinks[id]);
+            jobs[id].expand = expandNested;
+            visited.insert(normalizedSubscriptionUrl(subLinks[id]));
+        }
+        const QStringList rootLinks = subLinks;     // subLinks grows on the ingest thread
+
+        // Productive sources are fetched first; chronic failures sit out a few runs
+        const bool useHistory = configMgr.getConfig().enableSourceHistory;
+        SourceHistory::Options historyOptions;
+        historyOptions.failureThreshold = configMgr.getConfig().sourceSkipAfterFailures;
+        historyOptions.maxSkipRuns = configMgr.getConfig().sourceMaxSkipRuns;
+        SourceHistory history(SourceHistory::defaultPath(), historyOptions);
+        if (useHistory && !history.load()) {
+            qCWarning(CONFIG_ERROR) << "Ignoring unreadable source history:" << history.path();
+        }
+        // Without a loaded history every source is unknown and the file order stays
+        QList<int> fetchOrder;
+        for (int id : history.prioritize(rootLinks)) {
+            if (useHistory && history.takeSkip(rootLinks[id])) {
+                const SourceHistory::Record record = history.record(rootLinks[id]);
+                allStats[id].url = rootLinks[id];
+                allStats[id].status = "Skipped";
+                allStats[id].errorMessage = QString("Failed %1 times in a row; skipped for %2 more run(s)")
+                                                .arg(record.failureStreak).arg(record.skipRuns);
+                metrics.addCount("skipped", 1, id);
+                qCInfo(CONFIG_INFO) << "Skipping" << rootLinks[id] << "after" << record.failureStreak
+                                    << "consecutive failures";
+                continue;
+            }
+            fetchOrder.append(id);
+        }
 
-            if (processSubscription(subUrl, stats)) {
-                // Add to statistics
-                allStats.append(stats);
-                totalConfigs += stats.totalConfigs;
-            } else {
-                // Still add to statistics for reporting
+        // Runs on the ingest thread, like everything the pipeline handler calls
+        auto finishSubscription = [&allStats, &jobs, &metrics, parsePool, resolver](int id, const QString& subUrl,
+                                                                                    const HttpResponse& response) {
+            SubStats& stats = allStats[id];
+            if (!processSubscription(subUrl, response, jobs.at(id), stats, parsePool, resolver)) {
                 stats.status = "Failed";
-                allStats.append(stats);
             }
+
+            // Request phases as consecutive durations
+            metrics.addTime(RunMetrics::Stage::Connect, response.connectNs, id);
+            if (response.ttfbNs >= 0) {
+                metrics.addTime(RunMetrics::Stage::Ttfb, response.ttfbNs - qMax<qint64>(0, response.connectNs), id);
+                metrics.addTime(RunMetrics::Stage::Download, response.totalNs - response.ttfbNs, id);
+            } else {
+                metrics.addTime(RunMetrics::Stage::Download, response.totalNs, id);
+            }
+            stats.bytes = response.bytesReceived;
+            metrics.addCount("bytes_downloaded", response.bytesReceived, id);
+            metrics.addCount("bytes_transferred", response.transferBytes, id);
+            metrics.addCount("from_cache", response.fromCache ? 1 : 0, id);
+            metrics.addCount("failed", stats.status == "Failed" ? 1 : 0, id);
+            metrics.addCount("retries", response.attempts - 1, id);
+            metrics.addCount("hedged", response.hedged ? 1 : 0, id);
+            metrics.addCount("cancelled", response.cancelled ? 1 : 0, id);
+        };
+
+        // fetch -> decode/parse/store: the event loop only posts, the ingest thread parses
+        IngestPipeline ingest;
+        const bool decompressLocal = configMgr.getConfig().enableCompression;
+        QList<int> subIds;
+        ingest.onMessage([&](IngestPipeline::Message& message) {
+            SubscriptionJob& job = jobs.at(message.id);
+            const QString subUrl = subLinks[message.id];
+            switch (message.type) {
+            case IngestPipeline::Message::Type::Chunk: {
+                // Bodies are parsed line by line as they arrive instead of being buffered whole
+                QElapsedTimer parseTimer;
+                parseTimer.start();
+                streamParserFor(job, subUrl, parsePool, resolver).feed(message.data);
+                job.parseNs += parseTimer.nsecsElapsed();
+                break;
+            }
+            case IngestPipeline::Message::Type::Restart:
+                // A retried download streams from the start again
+                job.parser.reset();
+                job.configs.clear();
+                job.pendingHosts.clear();
+                job.nested.clear();
+                job.listed = 0;
+                break;
+            case IngestPipeline::Message::Type::Finished:
+                finishSubscription(message.id, message.text, message.response);
+                break;
+            case IngestPipeline::Message::Type::LocalFile:
+                finishSubscription(message.id, subUrl,
+                                   readLocalSubscription(message.text, job, subUrl, parsePool, resolver,
+                                                         decompressLocal));
+                break;
+            case IngestPipeline::Message::Type::Stop:
+                break;
+            }
+
+            // DnsCache lives on the event loop thread
+            if (!job.pendingHosts.isEmpty()) {
+                ingest.postBack([resolver, hosts = std::move(job.pendingHosts)]() {
+                    for (const QString& host : hosts) {
+                        resolver->prefetch(host);
+                    }
+                });
+                job.pendingHosts.clear();
+            }
+
+            // Listed subscriptions join the same download queue as new subscription ids
+            for (const QString& url : std::as_const(job.nested)) {
+                if (job.depth >= maxDepth) {
+                    qCWarning(CONFIG_INFO) << "Not following" << url << "from" << subUrl << "- depth limit"
+                                           << maxDepth << "reached";
+                    continue;
+                }
+                if (visited.contains(normalizedSubscriptionUrl(url))) {
+                    continue;
+                }
+                visited.insert(normalizedSubscriptionUrl(url));
+                if (useHistory && history.takeSkip(url)) {
+                    qCInfo(CONFIG_INFO) << "Skipping nested subscription" << url << "after"
+                                        << history.record(url).failureStreak << "consecutive failures";
+                    continue;
+                }
+
+                const int nestedId = int(subLinks.size());
+                subLinks.append(url);
+                SubscriptionJob& nestedJob = jobs[nestedId];
+                nestedJob.expand = true;
+                nestedJob.depth = job.depth + 1;
+                allStats.append(SubStats());
+                allStats.last().depth = nestedJob.depth;
+                allStats.last().parent = message.id;
+                ++allStats[message.id].nested;
+                metrics.setSubscription(nestedId, url);
+                qCInfo(CONFIG_INFO) << "Queued nested subscription" << url << "from" << subUrl;
+                ingest.postBack([&scheduler, &subIds, url, nestedId]() {
+                    scheduler.enqueue(url);
+                    subIds.append(nestedId);
+                });
+            }
+            job.nested.clear();
+        });
+
+        // Local files never go through the scheduler, so its job ids map back to subscription ids
+        scheduler.onChunk([&ingest, &subIds](int jobId, const QByteArray& chunk) {
+            ingest.chunk(subIds[jobId], chunk);
+        });
+        scheduler.onRestart([&ingest, &subIds](int jobId) {
+            ingest.restart(subIds[jobId]);
+        });
+        scheduler.onFinished([&ingest, &subIds](int jobId, const QString& subUrl, const HttpResponse& response) {
+            ingest.finished(subIds[jobId], subUrl, response);
+        });
+
+        ingest.start();
+        for (int id : std::as_const(fetchOrder)) {
+            const QString localPath = Utils::localFilePath(rootLinks[id]);
+            if (!localPath.isEmpty()) {
+                ingest.localFile(id, localPath);
+                continue;
+            }
+            scheduler.enqueue(rootLinks[id]);
+            subIds.append(id);
+        }
+
+        qCInfo(CONFIG_INFO) << "Downloading with up to" << scheduler.maxConcurrent() << "concurrent requests";
+        // An index parsed after the last download finished queues more work
+        do {
+            scheduler.run();
+            ingest.sync();
+        } while (scheduler.pending() > 0);
+        if (scheduler.retries() > 0 || scheduler.hedges() > 0 || scheduler.rejected() > 0) {
+            qCInfo(CONFIG_INFO) << "Downloads needed" << scheduler.retries() << "retries," << scheduler.hedges()
+                                << "hedged requests (" << scheduler.hedgeWins() << "won);" << scheduler.rejected()
+                                << "skipped on open circuits";
+        }
+        ingest.finish();
+        metrics.addCount("ingest_messages", ingest.messages());
+        metrics.addCount("ingest_stalls", ingest.stalls());
+        const bool deadlineReached = scheduler.cancelled() > 0;
+        if (deadlineReached) {
+            qCWarning(CONFIG_INFO) << "Download cutoff reached:" << scheduler.cancelled()
+                                   << "downloads cancelled; writing partial output";
+        }
+
+        for (auto& [id, job] : jobs) {
+            if (!job.parser) {
+                continue;
+            }
+            const SubStreamParser::Stats parseStats = job.parser->stats();
+            metrics.addTime(RunMetrics::Stage::Decode, parseStats.decodeNs, id);
+            metrics.addTime(RunMetrics::Stage::Parse, qMax<qint64>(0, job.parseNs - parseStats.decodeNs), id);
+            metrics.addCount("decoded_bytes", parseStats.decodedBytes, id);
+            metrics.addCount("configs_parsed", job.configs.size(), id);
+            metrics.addCount("failed_lines", parseStats.failedLines, id);
+            metrics.addCount("oversized_lines", parseStats.oversizedLines, id);
+            for (auto it = parseStats.failuresByScheme.cbegin(); it != parseStats.failuresByScheme.cend(); ++it) {
+                metrics.addParseFailures(it.key(), it.value(), id);
+            }
+        }
+
+        if (resolver) {
+            resolver->run();
+            metrics.addTime(RunMetrics::Stage::Dns, resolver->lookupNs());
+            metrics.addCount("dns_lookups", resolver->lookups());
+            metrics.addCount("dns_failures", resolver->failures());
+            qCInfo(CONFIG_INFO) << "Resolved" << resolver->size() << "server names with" << resolver->lookups()
+                                << "lookups (" << resolver->failures() << "failed)";
+        }
+
+        // The same proxies appear in many feeds; keep one of each
+        Deduplicator dedup(dedupMode);
+        dedup.setResolver(resolver);
+        deduplicateSubscriptions(dedup, jobs, allStats, metrics);
+        qCInfo(CONFIG_INFO) << "Deduplicating by" << Deduplicator::ModeName(dedupMode);
+
+        // Dead endpoints are cheap to spot here and expensive to find in the xray tester
+        if (configMgr.getConfig().enableReachabilityFilter && runDeadline.hasExpired()) {
+            qCWarning(CONFIG_INFO) << "Skipping the reachability filter: run deadline passed";
+        } else if (configMgr.getConfig().enableReachabilityFilter) {
+            RunMetrics::Timer timer(metrics, RunMetrics::Stage::Filter);
+            ReachabilityFilter::Options probeOptions;
+            probeOptions.maxConcurrent = configMgr.getConfig().reachabilityConcurrency;
+            probeOptions.perHostConcurrent = configMgr.getConfig().reachabilityPerHost;
+            probeOptions.timeoutMs = configMgr.getConfig().reachabilityTimeout;
+            probeOptions.checkTls = configMgr.getConfig().reachabilityCheckTls;
+            ReachabilityFilter prefilter(probeOptions);
+            prefilter.setResolver(resolver);
+
+            QList<ConfigStore*> stores;
+            QList<int> ids;
+            for (auto& [id, job] : jobs) {
+                stores.append(&job.configs);
+                ids.append(id);
+            }
+            const QVector<qsizetype> removed = prefilter.filter(stores);
+            for (qsizetype i = 0; i < ids.size(); ++i) {
+                allStats[ids[i]].unreachable = int(removed[i]);
+            }
+            qCInfo(CONFIG_INFO) << "Reachability:" << prefilter.reachableCount() << "of"
+                                << prefilter.probeCount() << "endpoints answered";
+        }
+
+        for (const SubStats& stats : allStats) {
+            totalConfigs += stats.totalConfigs;
+            uniqueCount += stats.uniqueConfigs;
+            duplicateCount += stats.duplicates;
+            unreachableCount += stats.unreachable;
+        }
+        for (int id = 0; id < allStats.size(); ++id) {
+            metrics.addCount("configs_unique", allStats[id].uniqueConfigs, id);
+            metrics.addCount("duplicates", allStats[id].duplicates, id);
+            metrics.addCount("unreachable", allStats[id].unreachable, id);
         }
 
+        // What each source was worth this run, for the next run's order
+        if (useHistory) {
+            // A source is credited with the configs of the subscriptions it listed too, so
+            // an index (which holds none itself) is not ranked last along with its children.
+            // Nested ids are always higher than their parent's.
+            QVector<int> yielded(allStats.size(), 0);
+            QVector<int> yieldedTotal(allStats.size(), 0);
+            for (int id = int(allStats.size()) - 1; id >= 0; --id) {
+                const SubStats& stats = allStats[id];
+                yielded[id] += stats.uniqueConfigs - stats.unreachable;
+                yieldedTotal[id] += stats.totalConfigs;
+                if (stats.parent >= 0) {
+                    yielded[stats.parent] += yielded[id];
+                    yieldedTotal[stats.parent] += yieldedTotal[id];
+                }
+            }
+            for (int id = 0; id < allStats.size(); ++id) {
+                const SubStats& stats = allStats[id];
+                if (stats.status == "Skipped" || stats.status == "Cancelled" || stats.status == "Partial") {
+                    // Not the source's doing
+                    continue;
+                }
+                if (stats.status == "Failed" || stats.status == "Error") {
+                    history.recordFailure(subLinks[id]);
+                } else {
+                    history.recordSuccess(subLinks[id], stats.downloadTime, stats.bytes, yielded[id],
+                                          yieldedTotal[id]);
+                }
+            }
+            if (!history.save()) {
+                qCWarning(CONFIG_ERROR) << "Failed to save source history:" << Utils::getLastError();
+            }
+        }
+        QElapsedTimer writeTimer;
+        writeTimer.start();
+
         // Save results
         QString outputDir = configMgr.getConfigOutputDirectory();
         qCInfo(CONFIG_INFO) << "Saving results to:" << outputDir;
 
-        // Save each subscription's results
-        for (const SubStats& stats : allStats) {
-            if (stats.totalConfigs > 0) {
-                QString fileName = QString("config_%1.json").arg(configIndex++, 4, 10, QChar('0'));
-                QString filePath = QDir(outputDir).filePath(fileName);
+        QList<ShardedWriter::Key> shardKeys;
+        ShardedWriter::ParseKeys(configMgr.getConfig().outputShards, shardKeys);
 
-                // This would need to be implemented to save the actual configs
-                // For now, just create placeholder files
-                Utils::writeFileText(filePath, QString("{\"subscription\": \"%1\", \"configs\": []}").arg(stats.url));
+        // Configs from earlier runs would otherwise be mixed in with this one
+        QDir outDir(outputDir);
+        for (const QString& stale : outDir.entryList({"config_*.json"}, QDir::Files)) {
+            outDir.remove(stale);
+        }
+        for (ShardedWriter::Key key : {ShardedWriter::Key::Protocol, ShardedWriter::Key::Country}) {
+            QDir shardDir(outDir.filePath(ShardedWriter::KeyDirectory(key)));
+            for (const QString& stale : shardDir.entryList({"*.ndjson"}, QDir::Files)) {
+                shardDir.remove(stale);
+            }
+        }
 
-                qCInfo(CONFIG_INFO) << "Saved" << stats.totalConfigs << "configs to" << fileName;
+        // Each subscription gets its own document; configs.ndjson holds all of them
+        // one per line so readers can consume it incrementally, links.txt the same
+        // configs as share links. All files are serialized in parallel on the parse
+        // workers, which are idle by now.
+        ShardedWriter output(outputDir);
+        const int allShard = output.shard("configs.ndjson", ConfigWriter::Format::Ndjson);
+        const int linkShard = configMgr.getConfig().writeLinks
+                                  ? output.shard("links.txt", ConfigWriter::Format::Links)
+                                  : -1;
+        if (linkShard < 0) {
+            outDir.remove("links.txt");
+        }
+        for (auto& [id, job] : jobs) {
+            if (job.configs.isEmpty()) {
+                continue;
+            }
+            QString fileName = QString("config_%1.json").arg(configIndex++, 4, 10, QChar('0'));
+            output.addAll(output.shard(fileName, ConfigWriter::Format::JsonDocument, allStats[id].url), job.configs);
+            output.addAll(allShard, job.configs);
+            if (linkShard >= 0) {
+                output.addAll(linkShard, job.configs);
+            }
+            for (ShardedWriter::Key key : shardKeys) {
+                output.route(key, job.configs);
+            }
+        }
+        output.write(parsePool);
+        for (const ShardedWriter::Result& result : output.results()) {
+            if (!result.error.isEmpty()) {
+                qCWarning(CONFIG_ERROR) << "Failed to save" << result.path << ":" << result.error;
+            } else {
+                qCInfo(CONFIG_INFO) << "Saved" << result.count << "configs to" << result.path;
+            }
+        }
+        metrics.addCount("output_files", output.shardCount());
+
+        if (configMgr.getConfig().incrementalMode && deadlineReached) {
+            // Configs of the cancelled sources would all show up as removed
+            qCInfo(CONFIG_INFO) << "Skipping the delta for a partial run";
+        } else if (configMgr.getConfig().incrementalMode) {
+            writeDelta(outDir, dedupMode, jobs, allStats);
+        }
+
+        // Binary image of the same set for later runs and tools (see ConfigSnapshot).
+        // A partial set would make the next delta report the cancelled sources as
+        // added, so a cut-off run keeps the last full run's snapshot instead.
+        if (configMgr.getConfig().writeSnapshot && deadlineReached) {
+            qCInfo(CONFIG_INFO) << "Keeping the previous configs.snapshot for a partial run";
+        } else if (configMgr.getConfig().writeSnapshot) {
+            QList<const ConfigStore*> stores;
+            for (const auto& [id, job] : jobs) {
+                stores.append(&job.configs);
+            }
+            QString snapshotError;
+            if (ConfigSnapshot::Write(outDir.filePath("configs.snapshot"), stores, dedupMode, &snapshotError)) {
+                qCInfo(CONFIG_INFO) << "Saved snapshot to configs.snapshot";
+            } else {
+                qCWarning(CONFIG_ERROR) << "Failed to save configs.snapshot:" << snapshotError;
+            }
+        }
+        metrics.addTime(RunMetrics::Stage::Write, writeTimer.nsecsElapsed());
+
+        if (configMgr.getConfig().writeRunReport) {
+            QString reportError;
+            if (metrics.write(outputDir, &reportError)) {
+                qCInfo(CONFIG_INFO) << "Saved run report to run_report.json and metrics.prom";
+            } else {
+                qCWarning(CONFIG_ERROR) << "Failed to save run report:" << reportError;
             }
         }
 
@@ -269,18 +938,40 @@ int main(int argc, char *argv[]) {
         qCInfo(CONFIG_MAIN) << "=== Collection Summary ===";
         qCInfo(CONFIG_MAIN) << "Total subscriptions processed:" << allStats.size();
         qCInfo(CONFIG_MAIN) << "Total configs found:" << totalConfigs;
-        qCInfo(CONFIG_MAIN) << "Unique configs:" << uniqueConfigs.size();
+        qCInfo(CONFIG_MAIN) << "Served from fetch cache:"
+                            << std::count_if(allStats.begin(), allStats.end(),
+                                             [](const SubStats& stats) { return stats.fromCache; });
+        qCInfo(CONFIG_MAIN) << "Unique configs:" << uniqueCount;
         qCInfo(CONFIG_MAIN) << "Duplicates removed:" << duplicateCount;
+        if (configMgr.getConfig().enableReachabilityFilter) {
+            qCInfo(CONFIG_MAIN) << "Unreachable dropped:" << unreachableCount;
+        }
 
         // Per-subscription breakdown
         qCInfo(CONFIG_MAIN) << "=== Per-Subscription Results ===";
         for (const SubStats& stats : allStats) {
             qCInfo(CONFIG_MAIN) << QString("URL: %1").arg(stats.url);
             qCInfo(CONFIG_MAIN) << QString("  Status: %1").arg(stats.status);
+            if (stats.depth > 0) {
+                qCInfo(CONFIG_MAIN) << QString("  Listed by an index (depth %1)").arg(stats.depth);
+            }
+            if (stats.nested > 0) {
+                qCInfo(CONFIG_MAIN) << QString("  Nested subscriptions queued: %1").arg(stats.nested);
+            }
             if (!stats.errorMessage.isEmpty()) {
                 qCInfo(CONFIG_MAIN) << QString("  Error: %1").arg(stats.errorMessage);
             }
-            qCInfo(CONFIG_MAIN) << QString("  Configs: %1").arg(stats.totalConfigs);
+            qCInfo(CONFIG_MAIN) << QString("  Configs: %1 (unique: %2, duplicates: %3)")
+                                       .arg(stats.totalConfigs).arg(stats.uniqueConfigs).arg(stats.duplicates);
+            if (stats.downloadTime > 0) {
+                qCInfo(CONFIG_MAIN) << QString("  Download time: %1 ms").arg(stats.downloadTime);
+            }
+            if (stats.unreachable > 0) {
+                qCInfo(CONFIG_MAIN) << QString("  Unreachable (dropped): %1").arg(stats.unreachable);
+            }
+            if (stats.added >= 0) {
+                qCInfo(CONFIG_MAIN) << QString("  Since last run: +%1 / -%2").arg(stats.added).arg(stats.removed);
+            }
         }
 
         qCInfo(CONFIG_MAIN) << "=== ConfigCollector Completed Successfully ===";
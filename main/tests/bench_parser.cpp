@@ -0,0 +1,245 @@
+#include <QTest>
+#include <QCoreApplication>
+#include <QTemporaryDir>
+#include <QThreadPool>
+#include <QThread>
+
+#include "Utils.h"
+#include "Base64Decoder.h"
+#include "SubParser.h"
+#include "Deduplicator.h"
+#include "ConfigStore.h"
+#include "ConfigWriter.h"
+#include "corpus_generator.h"
+
+namespace {
+    // A fresh bean per link, as the parser allocates one
+    bool tryParseLink(CorpusGenerator::Protocol protocol, const QString &link) {
+        switch (protocol) {
+        case CorpusGenerator::Protocol::VMess:
+            return VMessBean().TryParseLink(link);
+        case CorpusGenerator::Protocol::Shadowsocks:
+            return ShadowSocksBean().TryParseLink(link);
+        case CorpusGenerator::Protocol::Trojan:
+        case CorpusGenerator::Protocol::Vless:
+            return TrojanVLESSBean().TryParseLink(link);
+        case CorpusGenerator::Protocol::Socks:
+            return SocksHttpBean().TryParseLink(link);
+        }
+        return false;
+    }
+}
+
+// Hot-path benchmarks; run ConfigCollectorBench (or the run-bench target) on a
+// release build, e.g. "ConfigCollectorBench -median 5 parseSubscription".
+class BenchParser : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void decodeB64IfValid_data();
+    void decodeB64IfValid();
+    void decodeImplementation_data();
+    void decodeImplementation();
+    void tryParseLink_data();
+    void tryParseLink();
+    void parseSubscription_data();
+    void parseSubscription();
+    void identityKey_data();
+    void identityKey();
+    void storeDeduplicate();
+    void beanToJson();
+    void writeNdjson();
+
+private:
+    const CorpusGenerator::Corpus &corpus(int lines);
+
+    QHash<int, CorpusGenerator::Corpus> m_corpora;
+    QList<std::shared_ptr<ProxyBean>> m_beans;     // parsed 10k corpus
+    ConfigStore m_store;
+};
+
+void BenchParser::initTestCase() {
+    // Setup test data
+    m_beans = SubParser::ParseSubscription(corpus(10000).body, nullptr);
+    QVERIFY(!m_beans.isEmpty());
+    for (const auto &bean : m_beans) {
+        m_store.append(*bean);
+    }
+}
+
+void BenchParser::cleanupTestCase() {
+    // Cleanup test data
+    Base64Decoder::ForceImplementation(Base64Decoder::Implementation::Auto);
+}
+
+const CorpusGenerator::Corpus &BenchParser::corpus(int lines) {
+    auto it = m_corpora.find(lines);
+    if (it == m_corpora.end()) {
+        it = m_corpora.insert(lines, CorpusGenerator::Subscription(lines));
+    }
+    return it.value();
+}
+
+void BenchParser::decodeB64IfValid_data() {
+    QTest::addColumn<int>("lines");
+    QTest::newRow("1k lines") << 1000;
+    QTest::newRow("10k lines") << 10000;
+}
+
+void BenchParser::decodeB64IfValid() {
+    QFETCH(int, lines);
+    const QString encoded = QString::fromLatin1(corpus(lines).body.toBase64());
+
+    QByteArray decoded;
+    QBENCHMARK {
+        decoded = DecodeB64IfValid(encoded);
+    }
+    QCOMPARE(decoded, corpus(lines).body);
+}
+
+void BenchParser::decodeImplementation_data() {
+    QTest::addColumn<int>("implementation");
+    QTest::newRow("scalar") << int(Base64Decoder::Implementation::Scalar);
+    QTest::newRow("ssse3") << int(Base64Decoder::Implementation::Ssse3);
+    QTest::newRow("avx2") << int(Base64Decoder::Implementation::Avx2);
+    QTest::newRow("neon") << int(Base64Decoder::Implementation::Neon);
+}
+
+void BenchParser::decodeImplementation() {
+    QFETCH(int, implementation);
+    if (!Base64Decoder::ForceImplementation(Base64Decoder::Implementation(implementation))) {
+        QSKIP("Not supported on this CPU");
+    }
+    const QByteArray encoded = corpus(10000).body.toBase64();
+
+    qsizetype size = 0;
+    QBENCHMARK {
+        size = Base64Decoder::Decode(encoded).decoded.size();
+    }
+    Base64Decoder::ForceImplementation(Base64Decoder::Implementation::Auto);
+    QCOMPARE(size, corpus(10000).body.size());
+}
+
+void BenchParser::tryParseLink_data() {
+    QTest::addColumn<int>("protocol");
+    QTest::newRow("vmess") << int(CorpusGenerator::Protocol::VMess);
+    QTest::newRow("shadowsocks") << int(CorpusGenerator::Protocol::Shadowsocks);
+    QTest::newRow("trojan") << int(CorpusGenerator::Protocol::Trojan);
+    QTest::newRow("vless") << int(CorpusGenerator::Protocol::Vless);
+    QTest::newRow("socks") << int(CorpusGenerator::Protocol::Socks);
+}
+
+void BenchParser::tryParseLink() {
+    QFETCH(int, protocol);
+    QRandomGenerator rng(7);
+    QList<QString> links;
+    for (int i = 0; i < 1000; ++i) {
+        links.append(QString::fromUtf8(CorpusGenerator::Link(CorpusGenerator::Protocol(protocol), rng)));
+    }
+
+    int parsed = 0;
+    QBENCHMARK {
+        parsed = 0;
+        for (const QString &link : links) {
+            parsed += tryParseLink(CorpusGenerator::Protocol(protocol), link) ? 1 : 0;
+        }
+    }
+    QCOMPARE(parsed, int(links.size()));
+}
+
+void BenchParser::parseSubscription_data() {
+    QTest::addColumn<int>("lines");
+    QTest::addColumn<bool>("base64");
+    QTest::addColumn<int>("threads");
+    for (int lines : {10000, 100000}) {
+        for (bool base64 : {false, true}) {
+            for (int threads : {1, QThread::idealThreadCount()}) {
+                const QByteArray tag = QByteArray::number(lines / 1000) + "k " + (base64 ? "base64" : "plain") +
+                                       " " + QByteArray::number(threads) + "t";
+                QTest::newRow(tag.constData()) << lines << base64 << threads;
+            }
+        }
+    }
+}
+
+void BenchParser::parseSubscription() {
+    QFETCH(int, lines);
+    QFETCH(bool, base64);
+    QFETCH(int, threads);
+    const CorpusGenerator::Corpus &input = corpus(lines);
+    const QByteArray body = base64 ? input.body.toBase64() : input.body;
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(threads);
+    qsizetype parsed = 0;
+    QBENCHMARK {
+        parsed = SubParser::ParseSubscription(body, threads > 1 ? &pool : nullptr).size();
+    }
+    QCOMPARE(parsed, qsizetype(input.links));
+}
+
+void BenchParser::identityKey_data() {
+    QTest::addColumn<QString>("mode");
+    QTest::newRow("endpoint") << "endpoint";
+    QTest::newRow("credentials") << "credentials";
+    QTest::newRow("full") << "full";
+}
+
+void BenchParser::identityKey() {
+    QFETCH(QString, mode);
+    Deduplicator::Mode dedupMode;
+    QVERIFY(Deduplicator::ParseMode(mode, dedupMode));
+
+    quint64 combined = 0;
+    QBENCHMARK {
+        for (const auto &bean : m_beans) {
+            combined ^= Deduplicator::IdentityKey(*bean, dedupMode);
+        }
+    }
+    Q_UNUSED(combined);
+
+    // The columnar store computes the same keys without the beans
+    QCOMPARE(m_store.identityKey(0, dedupMode), Deduplicator::IdentityKey(*m_beans.first(), dedupMode));
+}
+
+void BenchParser::storeDeduplicate() {
+    qsizetype removed = 0;
+    QBENCHMARK {
+        ConfigStore copy = m_store;
+        Deduplicator dedup;
+        removed = copy.deduplicate(dedup);
+    }
+    QVERIFY(removed > 0);
+}
+
+void BenchParser::beanToJson() {
+    qsizetype keys = 0;
+    QBENCHMARK {
+        keys = 0;
+        for (const auto &bean : m_beans) {
+            keys += bean->ToJson().size();
+        }
+    }
+    QVERIFY(keys > 0);
+}
+
+void BenchParser::writeNdjson() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    bool ok = false;
+    QBENCHMARK {
+        ConfigWriter writer(ConfigWriter::Format::Ndjson);
+        ok = writer.open(dir.filePath("bench.ndjson"));
+        for (qsizetype row = 0; row < m_store.size(); ++row) {
+            ok = writer.write(m_store, row) && ok;
+        }
+        ok = writer.commit() && ok;
+    }
+    QVERIFY(ok);
+}
+
+QTEST_MAIN(BenchParser)
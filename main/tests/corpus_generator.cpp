@@ -0,0 +1,126 @@
+#include "corpus_generator.h"
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QList>
+#include <iterator>
+
+namespace {
+    const char *const Countries[] = {"US", "DE", "NL", "JP", "SG", "GB", "FR", "IR", "TR", "CA"};
+
+    QByteArray number(QRandomGenerator &rng, int bound) {
+        return QByteArray::number(rng.bounded(bound));
+    }
+
+    QByteArray host(QRandomGenerator &rng) {
+        // Some feeds use raw addresses, most use names
+        if (rng.bounded(4) == 0) {
+            return number(rng, 223) + "." + number(rng, 256) + "." + number(rng, 256) + "." + number(rng, 256);
+        }
+        return "node" + number(rng, 1000000) + ".cdn" + number(rng, 50) + ".example.com";
+    }
+
+    QByteArray uuid(QRandomGenerator &rng) {
+        QByteArray hex;
+        for (int i = 0; i < 4; ++i) {
+            hex += QByteArray::number(rng.generate(), 16).rightJustified(8, '0');
+        }
+        return hex.left(8) + "-" + hex.mid(8, 4) + "-" + hex.mid(12, 4) + "-" + hex.mid(16, 4) + "-" + hex.mid(20, 12);
+    }
+
+    QByteArray name(QRandomGenerator &rng) {
+        // Regional indicator flag, percent-encoded the way feeds ship it
+        const char *country = Countries[rng.bounded(int(std::size(Countries)))];
+        QByteArray flag;
+        for (int i = 0; i < 2; ++i) {
+            const char32_t code = U'\U0001F1E6' + char32_t(country[i] - 'A');
+            flag += QString::fromUcs4(&code, 1).toUtf8();
+        }
+        return (flag + country + "-" + number(rng, 10000)).toPercentEncoding("-");
+    }
+
+    int port(QRandomGenerator &rng) {
+        static const int Common[] = {443, 443, 443, 8443, 2053, 2083, 80, 8080};
+        return rng.bounded(3) == 0 ? 10000 + rng.bounded(50000) : Common[rng.bounded(int(std::size(Common)))];
+    }
+
+    CorpusGenerator::Protocol protocol(QRandomGenerator &rng) {
+        // vless 35%, vmess 25%, trojan 20%, shadowsocks 15%, socks 5%
+        const int roll = rng.bounded(100);
+        if (roll < 35) return CorpusGenerator::Protocol::Vless;
+        if (roll < 60) return CorpusGenerator::Protocol::VMess;
+        if (roll < 80) return CorpusGenerator::Protocol::Trojan;
+        if (roll < 95) return CorpusGenerator::Protocol::Shadowsocks;
+        return CorpusGenerator::Protocol::Socks;
+    }
+}
+
+QByteArray CorpusGenerator::Link(Protocol protocol, QRandomGenerator &rng) {
+    const QByteArray server = host(rng);
+    const QByteArray serverPort = QByteArray::number(port(rng));
+
+    switch (protocol) {
+    case Protocol::VMess: {
+        QJsonObject object;
+        object["v"] = "2";
+        object["ps"] = QString::fromUtf8(QByteArray::fromPercentEncoding(name(rng)));
+        object["add"] = QString::fromLatin1(server);
+        object["port"] = QString::fromLatin1(serverPort);
+        object["id"] = QString::fromLatin1(uuid(rng));
+        object["aid"] = "0";
+        object["net"] = rng.bounded(2) ? "ws" : "tcp";
+        object["type"] = "none";
+        object["host"] = QString::fromLatin1(server);
+        object["path"] = "/" + QString::number(rng.bounded(1000));
+        object["tls"] = rng.bounded(3) ? "tls" : "";
+        return "vmess://" + QJsonDocument(object).toJson(QJsonDocument::Compact).toBase64();
+    }
+    case Protocol::Shadowsocks: {
+        const QByteArray userInfo = "chacha20-ietf-poly1305:" + uuid(rng).left(16);
+        return "ss://" + userInfo.toBase64(QByteArray::Base64UrlEncoding | QByteArray::OmitTrailingEquals) + "@" +
+               server + ":" + serverPort + "#" + name(rng);
+    }
+    case Protocol::Trojan:
+        return "trojan://" + uuid(rng).left(12) + "@" + server + ":" + serverPort +
+               "?security=tls&sni=" + server + "&type=ws&host=" + server + "&path=%2Fws" + number(rng, 100) +
+               "#" + name(rng);
+    case Protocol::Vless:
+        return "vless://" + uuid(rng) + "@" + server + ":" + serverPort +
+               "?encryption=none&security=reality&sni=www.example.com&fp=chrome&pbk=" +
+               uuid(rng).replace('-', "") + "&sid=" + number(rng, 65536) + "&type=grpc&serviceName=grpc" +
+               number(rng, 10) + "&flow=xtls-rprx-vision#" + name(rng);
+    case Protocol::Socks:
+        return "socks://user" + number(rng, 100) + ":pass" + number(rng, 100000) + "@" + server + ":1080#" + name(rng);
+    }
+    return QByteArray();
+}
+
+CorpusGenerator::Corpus CorpusGenerator::Subscription(int lines, quint32 seed, int duplicatePercent) {
+    QRandomGenerator rng(seed);
+    Corpus corpus;
+    QList<QByteArray> emitted;
+    emitted.reserve(lines);
+    corpus.body.reserve(qsizetype(lines) * 200);
+
+    for (int i = 0; i < lines; ++i) {
+        const int roll = rng.bounded(100);
+        if (roll == 0) {
+            corpus.body += "# updated " + number(rng, 100000) + "\n";
+            ++corpus.noise;
+            continue;
+        }
+        if (roll == 1) {
+            corpus.body += "vmess://{broken}\n";
+            ++corpus.noise;
+            continue;
+        }
+
+        if (!emitted.isEmpty() && rng.bounded(100) < duplicatePercent) {
+            corpus.body += emitted[rng.bounded(int(emitted.size()))] + "\n";
+        } else {
+            emitted.append(Link(protocol(rng), rng));
+            corpus.body += emitted.last() + "\n";
+        }
+        ++corpus.links;
+    }
+    return corpus;
+}
@@ -0,0 +1,34 @@
+#ifndef CORPUS_GENERATOR_H
+#define CORPUS_GENERATOR_H
+
+#include <QByteArray>
+#include <QRandomGenerator>
+
+// Deterministic synthetic subscription bodies for tests and benchmarks. The mix
+// follows what public feeds look like: mostly vless/vmess/trojan, percent-encoded
+// emoji names, TLS/REALITY query strings, a share of repeated links and the odd
+// comment or broken line.
+namespace CorpusGenerator {
+    enum class Protocol {
+        VMess,
+        Shadowsocks,
+        Trojan,
+        Vless,
+        Socks
+    };
+
+    struct Corpus {
+        QByteArray body;
+        int links = 0;      // lines that parse into a config
+        int noise = 0;      // comments and broken lines
+    };
+
+    // One well-formed link
+    QByteArray Link(Protocol protocol, QRandomGenerator &rng);
+
+    // lines lines, of which about duplicatePercent repeat an earlier link; the same
+    // seed always produces the same body
+    Corpus Subscription(int lines, quint32 seed = 1, int duplicatePercent = 20);
+}
+
+#endif // CORPUS_GENERATOR_H
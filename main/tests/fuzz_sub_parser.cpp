@@ -0,0 +1,26 @@
+#include <QByteArray>
+#include <QString>
+#include <cstdint>
+
+#include "SubParser.h"
+
+// libFuzzer target for subscription bodies; configure with Clang and
+// -DCONFIGCOLLECTOR_FUZZ=ON, then e.g. "ConfigCollectorFuzz -max_len=8388608 corpus/".
+// AFL++ runs the same binary when it is built with afl-clang-fast.
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    const QByteArray body = QByteArray::fromRawData(reinterpret_cast<const char*>(data), qsizetype(size));
+
+    // The whole-body parse, including its recursive base64 path
+    SubParser::ParseSubscription(QString::fromUtf8(body));
+
+    // Streaming, with the chunk size taken from the first byte so line and
+    // base64 quantum splits move around
+    const qsizetype chunkSize = size > 0 ? qsizetype(1) << (data[0] % 17) : 1;
+    SubStreamParser parser([](const std::shared_ptr<ProxyBean>&) {});
+    parser.onSubscription([](const QString&) {});
+    for (qsizetype offset = 0; offset < body.size(); offset += chunkSize) {
+        parser.feed(body.constData() + offset, qMin(chunkSize, body.size() - offset));
+    }
+    parser.finish();
+    return 0;
+}
@@ -0,0 +1,183 @@
+#include <QTest>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSysInfo>
+#include <QThread>
+#include <QThreadPool>
+
+#include "SubParser.h"
+#include "Utils.h"
+#include "corpus_generator.h"
+
+// Million-line parser run gated on a baseline file: a row fails when its lines/sec
+// drop, or the memory it adds on top of the corpus grows, by more than the
+// baseline's tolerance. Only meaningful on an optimized build, and only against
+// numbers recorded on the same machine. The baseline is tests/stress_baseline.json
+// unless CONFIGCOLLECTOR_STRESS_BASELINE names another file; a missing file starts
+// from the committed one. A baseline without rows is recorded by the run that finds
+// it, as is any baseline when CONFIGCOLLECTOR_UPDATE_BASELINE=1 is set (after an
+// intended change). CONFIGCOLLECTOR_STRESS_LINES shrinks the corpus for a quick
+// local run; rows recorded at another corpus size are not compared.
+class StressParser : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void parseCorpus_data();
+    void parseCorpus();
+
+private:
+    static bool resetPeakRss();
+    static qint64 procStatusKb(const QByteArray &field);
+
+    // Fixed so the parallel row means the same on every machine that has the cores
+    static constexpr int ParallelThreads = 4;
+
+    CorpusGenerator::Corpus m_corpus;
+    int m_lines = 1000000;
+    QString m_baselinePath;
+    QJsonObject m_baseline;
+    QJsonObject m_measured;
+    bool m_update = false;
+};
+
+void StressParser::initTestCase() {
+    // Setup test data
+    m_lines = qEnvironmentVariableIntValue("CONFIGCOLLECTOR_STRESS_LINES");
+    if (m_lines <= 0) {
+        m_lines = 1000000;
+    }
+    m_update = qEnvironmentVariableIsSet("CONFIGCOLLECTOR_UPDATE_BASELINE");
+    m_corpus = CorpusGenerator::Subscription(m_lines);
+
+    m_baselinePath = qEnvironmentVariable("CONFIGCOLLECTOR_STRESS_BASELINE", CONFIGCOLLECTOR_STRESS_BASELINE);
+    QByteArray data;
+    if (!Utils::readFile(m_baselinePath, data)) {
+        QVERIFY2(Utils::readFile(CONFIGCOLLECTOR_STRESS_BASELINE, data), CONFIGCOLLECTOR_STRESS_BASELINE);
+    }
+    m_baseline = QJsonDocument::fromJson(data).object();
+    QVERIFY(m_baseline["rows"].isObject());
+    if (m_baseline["rows"].toObject().isEmpty()) {
+        qInfo("No baseline rows in %s yet; recording this run's numbers", qPrintable(m_baselinePath));
+        m_update = true;
+    }
+}
+
+void StressParser::cleanupTestCase() {
+    if (!m_update) {
+        return;
+    }
+    QJsonObject baseline = m_baseline;
+    baseline["rows"] = m_measured;
+    // Where the numbers came from, since they only hold for that machine
+    QJsonObject recorded;
+    recorded["command"] = QCoreApplication::arguments().join(' ');
+    recorded["cpus"] = QThread::idealThreadCount();
+    recorded["date"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    recorded["lines"] = m_lines;
+    recorded["os"] = QSysInfo::prettyProductName();
+    recorded["qt"] = QString::fromLatin1(qVersion());
+    baseline["recorded"] = recorded;
+    QVERIFY(Utils::writeFileText(m_baselinePath,
+                                 QString::fromUtf8(QJsonDocument(baseline).toJson(QJsonDocument::Indented))));
+    qInfo("Wrote baseline %s", qPrintable(m_baselinePath));
+}
+
+// The kernel's high-water mark, reset so each row measures its own peak (Linux 4.0+)
+bool StressParser::resetPeakRss() {
+    QFile clearRefs("/proc/self/clear_refs");
+    return clearRefs.open(QIODevice::WriteOnly) && clearRefs.write("5") == 1;
+}
+
+qint64 StressParser::procStatusKb(const QByteArray &field) {
+    QFile status("/proc/self/status");
+    if (!status.open(QIODevice::ReadOnly)) {
+        return -1;
+    }
+    // "VmHWM:     1234 kB"
+    for (const QByteArray &line : status.readAll().split('\n')) {
+        if (line.startsWith(field + ':')) {
+            return line.mid(field.size() + 1).trimmed().split(' ').first().toLongLong();
+        }
+    }
+    return -1;
+}
+
+void StressParser::parseCorpus_data() {
+    QTest::addColumn<QString>("encoding");
+    QTest::addColumn<int>("threads");
+    QTest::newRow("plain") << "plain" << 1;
+    QTest::newRow("base64") << "base64" << 1;
+    QTest::newRow("plain 4 threads") << "plain" << ParallelThreads;
+}
+
+void StressParser::parseCorpus() {
+    QFETCH(QString, encoding);
+    QFETCH(int, threads);
+
+    if (threads > QThread::idealThreadCount()) {
+        QSKIP("Fewer cores than the row's threads");
+    }
+
+    const QByteArray body = encoding == "base64" ? m_corpus.body.toBase64() : m_corpus.body;
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(threads);
+    const bool measureRss = resetPeakRss();
+    const qint64 rssBeforeKb = procStatusKb("VmRSS");
+
+    // Fed the way downloads arrive; beans are dropped as they come
+    qint64 beans = 0;
+    SubStreamParser parser([&beans](const std::shared_ptr<ProxyBean>&) { ++beans; });
+    parser.setThreadPool(threads > 1 ? &pool : nullptr);
+    QElapsedTimer timer;
+    timer.start();
+    constexpr qsizetype ChunkSize = 64 * 1024;
+    for (qsizetype offset = 0; offset < body.size(); offset += ChunkSize) {
+        parser.feed(body.constData() + offset, qMin(ChunkSize, body.size() - offset));
+    }
+    parser.finish();
+    const qint64 elapsedNs = qMax<qint64>(1, timer.nsecsElapsed());
+
+    QCOMPARE(beans, qint64(m_corpus.links));
+
+    const double linesPerSec = double(m_lines) * 1e9 / double(elapsedNs);
+    const double addedRssMb = measureRss ? qMax<qint64>(0, procStatusKb("VmHWM") - rssBeforeKb) / 1024.0 : -1;
+    qInfo("%s: %.0f lines/s, +%.1f MB peak RSS", QTest::currentDataTag(), linesPerSec, addedRssMb);
+
+    const QString tag = QString::fromLatin1(QTest::currentDataTag());
+    QJsonObject row;
+    row["linesPerSec"] = qRound64(linesPerSec);
+    row["peakRssMb"] = qRound64(qMax(0.0, addedRssMb));
+    m_measured[tag] = row;
+    if (m_update) {
+        return;
+    }
+
+    const double tolerance = m_baseline["tolerance"].toDouble(0.25);
+    const QJsonObject expected = m_baseline["rows"].toObject()[tag].toObject();
+    QVERIFY2(!expected.isEmpty(), "No baseline for this row; run with CONFIGCOLLECTOR_UPDATE_BASELINE=1");
+    if (m_baseline["recorded"].toObject()["lines"].toInt(m_lines) != m_lines) {
+        QSKIP("Baseline was recorded with another corpus size");
+    }
+
+    const double minLinesPerSec = expected["linesPerSec"].toDouble() * (1.0 - tolerance);
+    QVERIFY2(linesPerSec >= minLinesPerSec,
+             qPrintable(QString("%1 lines/s, baseline allows %2").arg(qRound64(linesPerSec)).arg(qRound64(minLinesPerSec))));
+
+    if (!measureRss) {
+        QSKIP("Peak RSS needs /proc/self/clear_refs");
+    }
+    // Small working sets need some room for allocator noise
+    const double maxRssMb = expected["peakRssMb"].toDouble() * (1.0 + tolerance) + m_baseline["rssSlackMb"].toDouble(16);
+    QVERIFY2(addedRssMb <= maxRssMb,
+             qPrintable(QString("+%1 MB peak RSS, baseline allows %2").arg(addedRssMb, 0, 'f', 1).arg(maxRssMb, 0, 'f', 1)));
+}
+
+QTEST_MAIN(StressParser)
@@ -0,0 +1,168 @@
+#include <QTest>
+#include <QCoreApplication>
+#include <QRandomGenerator>
+
+#include "Base64Decoder.h"
+#include "Utils.h"
+
+using Base64Decoder::Implementation;
+using Qt515Base64::Base64DecodingStatus;
+
+class TestBase64Decoder : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void testMatchesQtDecoder();
+    void testUtf16Input();
+    void testUrlSafeAlphabet();
+    void testLineBreaks();
+    void testPadding();
+    void testInvalidInput();
+    void testDecodeB64IfValid();
+
+private:
+    QList<Implementation> supportedImplementations() const;
+    QByteArray randomBytes(int size) const;
+};
+
+void TestBase64Decoder::initTestCase() {
+    qDebug() << "Base64 decoder implementation:" << Base64Decoder::ActiveImplementation();
+}
+
+void TestBase64Decoder::cleanupTestCase() {
+    Base64Decoder::ForceImplementation(Implementation::Auto);
+}
+
+QList<Implementation> TestBase64Decoder::supportedImplementations() const {
+    QList<Implementation> result;
+    for (Implementation implementation : {Implementation::Scalar, Implementation::Ssse3,
+                                          Implementation::Avx2, Implementation::Neon}) {
+        if (Base64Decoder::IsSupported(implementation)) {
+            result.append(implementation);
+        }
+    }
+    return result;
+}
+
+QByteArray TestBase64Decoder::randomBytes(int size) const {
+    QByteArray bytes(size, Qt::Uninitialized);
+    for (char &c : bytes) {
+        c = char(QRandomGenerator::global()->bounded(256));
+    }
+    return bytes;
+}
+
+void TestBase64Decoder::testMatchesQtDecoder() {
+    // Sizes around every block width, with and without padding
+    for (Implementation implementation : supportedImplementations()) {
+        QVERIFY(Base64Decoder::ForceImplementation(implementation));
+        for (int size = 0; size < 300; ++size) {
+            QByteArray raw = randomBytes(size);
+            QByteArray padded = raw.toBase64();
+            QByteArray unpadded = raw.toBase64(QByteArray::OmitTrailingEquals);
+
+            auto result = Base64Decoder::Decode(padded);
+            QVERIFY(result);
+            QCOMPARE(result.decoded, raw);
+
+            result = Base64Decoder::Decode(unpadded);
+            QVERIFY(result);
+            QCOMPARE(result.decoded, raw);
+        }
+    }
+    Base64Decoder::ForceImplementation(Implementation::Auto);
+}
+
+void TestBase64Decoder::testUtf16Input() {
+    QByteArray raw = randomBytes(200);
+    QString encoded = QString::fromLatin1(raw.toBase64());
+
+    for (Implementation implementation : supportedImplementations()) {
+        QVERIFY(Base64Decoder::ForceImplementation(implementation));
+        auto result = Base64Decoder::Decode(QStringView(encoded));
+        QVERIFY(result);
+        QCOMPARE(result.decoded, raw);
+
+        // A code unit whose low byte is a valid character must still be rejected
+        QString wide = encoded;
+        wide[100] = QChar(0x4100 + 'A');
+        QCOMPARE(Base64Decoder::Decode(QStringView(wide)).decodingStatus, Base64DecodingStatus::IllegalCharacter);
+    }
+    Base64Decoder::ForceImplementation(Implementation::Auto);
+}
+
+void TestBase64Decoder::testUrlSafeAlphabet() {
+    QByteArray raw = randomBytes(150);
+    QByteArray urlSafe = raw.toBase64(QByteArray::Base64UrlEncoding | QByteArray::OmitTrailingEquals);
+
+    for (Implementation implementation : supportedImplementations()) {
+        QVERIFY(Base64Decoder::ForceImplementation(implementation));
+        auto result = Base64Decoder::Decode(urlSafe);
+        QVERIFY(result);
+        QCOMPARE(result.decoded, raw);
+    }
+    Base64Decoder::ForceImplementation(Implementation::Auto);
+}
+
+void TestBase64Decoder::testLineBreaks() {
+    QByteArray raw = randomBytes(500);
+    QByteArray encoded = raw.toBase64();
+    QByteArray wrapped;
+    for (qsizetype offset = 0; offset < encoded.size(); offset += 76) {
+        wrapped += encoded.mid(offset, 76) + "\r\n";
+    }
+
+    for (Implementation implementation : supportedImplementations()) {
+        QVERIFY(Base64Decoder::ForceImplementation(implementation));
+        auto result = Base64Decoder::Decode(wrapped);
+        QVERIFY(result);
+        QCOMPARE(result.decoded, raw);
+    }
+    Base64Decoder::ForceImplementation(Implementation::Auto);
+
+    // Surrounding whitespace is trimmed
+    QCOMPARE(Base64Decoder::Decode(QByteArray("  aGVsbG8=\t\n")).decoded, QByteArray("hello"));
+}
+
+void TestBase64Decoder::testPadding() {
+    QCOMPARE(Base64Decoder::Decode(QByteArray("QQ==")).decoded, QByteArray("A"));
+    QCOMPARE(Base64Decoder::Decode(QByteArray("QUI=")).decoded, QByteArray("AB"));
+    QCOMPARE(Base64Decoder::Decode(QByteArray("QQ")).decoded, QByteArray("A"));
+
+    QCOMPARE(Base64Decoder::Decode(QByteArray("Q===")).decodingStatus, Base64DecodingStatus::IllegalPadding);
+    QCOMPARE(Base64Decoder::Decode(QByteArray("QUI==")).decodingStatus, Base64DecodingStatus::IllegalPadding);
+    QCOMPARE(Base64Decoder::Decode(QByteArray("QUJD=")).decodingStatus, Base64DecodingStatus::IllegalPadding);
+    QCOMPARE(Base64Decoder::Decode(QByteArray("QQ==QQ==")).decodingStatus, Base64DecodingStatus::IllegalPadding);
+    QCOMPARE(Base64Decoder::Decode(QByteArray("Q")).decodingStatus, Base64DecodingStatus::IllegalInputLength);
+}
+
+void TestBase64Decoder::testInvalidInput() {
+    QByteArray encoded = randomBytes(120).toBase64();
+    for (Implementation implementation : supportedImplementations()) {
+        QVERIFY(Base64Decoder::ForceImplementation(implementation));
+        for (qsizetype position : {qsizetype(0), qsizetype(17), qsizetype(63), encoded.size() - 5}) {
+            QByteArray broken = encoded;
+            broken[position] = '!';
+            auto result = Base64Decoder::Decode(broken);
+            QVERIFY(!result);
+            QCOMPARE(result.decodingStatus, Base64DecodingStatus::IllegalCharacter);
+            QVERIFY(result.decoded.isEmpty());
+        }
+    }
+    Base64Decoder::ForceImplementation(Implementation::Auto);
+
+    QVERIFY(!Base64Decoder::Decode(QByteArray("hello world")));
+}
+
+void TestBase64Decoder::testDecodeB64IfValid() {
+    QCOMPARE(DecodeB64IfValid("aGVsbG8gd29ybGQ="), QByteArray("hello world"));
+    QCOMPARE(DecodeB64IfValid("  aGVsbG8gd29ybGQ=  "), QByteArray("hello world"));
+    QCOMPARE(DecodeB64IfValid("-_8", QByteArray::Base64UrlEncoding), QByteArray("\xfb\xff"));
+    QVERIFY(DecodeB64IfValid("").isEmpty());
+    QVERIFY(DecodeB64IfValid("not base64!").isEmpty());
+}
+
+QTEST_MAIN(TestBase64Decoder)
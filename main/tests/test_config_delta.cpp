@@ -0,0 +1,180 @@
+#include <QTest>
+#include <QCoreApplication>
+#include <QTemporaryDir>
+
+#include "ConfigDelta.h"
+#include "ConfigSnapshot.h"
+#include "ConfigStore.h"
+
+class TestConfigDelta : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void testAddedRemovedUnchanged();
+    void testNoBaseline();
+    void testModeMismatch();
+    void testMovedBetweenSubscriptions();
+    void testRemovedBySourceAfterAllStores();
+    void testResolvedModeKeysByName();
+
+private:
+    static void addProxy(ConfigStore &store, const QString &server, int port, const QString &source);
+    QTemporaryDir m_dir;
+};
+
+void TestConfigDelta::initTestCase() {
+    // Setup test data
+    QVERIFY(m_dir.isValid());
+}
+
+void TestConfigDelta::cleanupTestCase() {
+    // Cleanup test data
+}
+
+void TestConfigDelta::addProxy(ConfigStore &store, const QString &server, int port, const QString &source) {
+    TrojanVLESSBean bean;
+    bean.type = ProxyType::Trojan;
+    bean.name = server;
+    bean.serverAddress = server;
+    bean.serverPort = port;
+    bean.password = "pw";
+    bean.source = source;
+    store.append(bean);
+}
+
+void TestConfigDelta::testAddedRemovedUnchanged() {
+    ConfigStore before;
+    addProxy(before, "a.example.com", 443, "sub1");
+    addProxy(before, "b.example.com", 443, "sub1");
+    addProxy(before, "c.example.com", 443, "sub2");
+    const QString path = m_dir.filePath("previous.snapshot");
+    QVERIFY(ConfigSnapshot::Write(path, {&before}, Deduplicator::Mode::Endpoint));
+
+    ConfigSnapshot previous;
+    QVERIFY(previous.open(path));
+    ConfigDelta delta(previous, Deduplicator::Mode::Endpoint);
+    QVERIFY(delta.hasBaseline());
+
+    ConfigStore sub1;
+    addProxy(sub1, "a.example.com", 443, "sub1");
+    addProxy(sub1, "d.example.com", 443, "sub1");
+    QVector<qsizetype> added;
+    ConfigDelta::Counts counts = delta.compare(sub1, &added);
+    QCOMPARE(counts.added, qsizetype(1));
+    QCOMPARE(counts.unchanged, qsizetype(1));
+    QCOMPARE(added, QVector<qsizetype>({1}));
+
+    ConfigStore sub2;
+    addProxy(sub2, "c.example.com", 443, "sub2");
+    counts = delta.compare(sub2);
+    QCOMPARE(counts.added, qsizetype(0));
+    QCOMPARE(counts.unchanged, qsizetype(1));
+
+    QCOMPARE(delta.removedRows(), QVector<qsizetype>({1}));
+    QVERIFY(previous.field(1, ConfigStore::Field::Server) == QByteArrayView("b.example.com"));
+    const auto bySource = delta.removedBySource();
+    QCOMPARE(bySource.value("sub1"), qsizetype(1));
+    QCOMPARE(bySource.value("sub2"), qsizetype(0));
+}
+
+void TestConfigDelta::testNoBaseline() {
+    ConfigSnapshot previous;
+    QVERIFY(!previous.open(m_dir.filePath("missing.snapshot")));
+    ConfigDelta delta(previous, Deduplicator::Mode::Endpoint);
+    QVERIFY(!delta.hasBaseline());
+
+    ConfigStore store;
+    addProxy(store, "a.example.com", 443, "sub1");
+    addProxy(store, "b.example.com", 443, "sub1");
+    ConfigDelta::Counts counts = delta.compare(store);
+    QCOMPARE(counts.added, qsizetype(2));
+    QCOMPARE(counts.unchanged, qsizetype(0));
+    QVERIFY(delta.removedRows().isEmpty());
+}
+
+void TestConfigDelta::testModeMismatch() {
+    ConfigStore before;
+    addProxy(before, "a.example.com", 443, "sub1");
+    const QString path = m_dir.filePath("full.snapshot");
+    QVERIFY(ConfigSnapshot::Write(path, {&before}, Deduplicator::Mode::Full));
+
+    ConfigSnapshot previous;
+    QVERIFY(previous.open(path));
+    // Keys from another mode are not comparable
+    ConfigDelta delta(previous, Deduplicator::Mode::Endpoint);
+    QVERIFY(!delta.hasBaseline());
+    QCOMPARE(delta.compare(before).added, qsizetype(1));
+}
+
+void TestConfigDelta::testMovedBetweenSubscriptions() {
+    ConfigStore before;
+    addProxy(before, "a.example.com", 443, "sub1");
+    const QString path = m_dir.filePath("moved.snapshot");
+    QVERIFY(ConfigSnapshot::Write(path, {&before}, Deduplicator::Mode::Endpoint));
+
+    ConfigSnapshot previous;
+    QVERIFY(previous.open(path));
+    ConfigDelta delta(previous, Deduplicator::Mode::Endpoint);
+
+    // Same endpoint now served by another feed: neither added nor removed
+    ConfigStore sub2;
+    addProxy(sub2, "a.example.com", 443, "sub2");
+    QCOMPARE(delta.compare(sub2).unchanged, qsizetype(1));
+    QVERIFY(delta.removedRows().isEmpty());
+}
+
+void TestConfigDelta::testRemovedBySourceAfterAllStores() {
+    ConfigStore before;
+    addProxy(before, "a.example.com", 443, "sub1");
+    addProxy(before, "b.example.com", 443, "sub1");
+    addProxy(before, "c.example.com", 443, "sub2");
+    addProxy(before, "d.example.com", 443, "sub2");
+    addProxy(before, "e.example.com", 443, "sub3");
+    const QString path = m_dir.filePath("sources.snapshot");
+    QVERIFY(ConfigSnapshot::Write(path, {&before}, Deduplicator::Mode::Endpoint));
+
+    ConfigSnapshot previous;
+    QVERIFY(previous.open(path));
+    ConfigDelta delta(previous, Deduplicator::Mode::Endpoint);
+
+    // Nothing compared yet: everything still looks removed
+    QCOMPARE(delta.removedBySource().value("sub1"), qsizetype(2));
+
+    ConfigStore sub1;
+    addProxy(sub1, "a.example.com", 443, "sub1");
+    addProxy(sub1, "b.example.com", 443, "sub1");
+    delta.compare(sub1);
+    ConfigStore sub2;
+    addProxy(sub2, "c.example.com", 443, "sub2");
+    addProxy(sub2, "f.example.com", 443, "sub2");
+    delta.compare(sub2);
+    // sub3 did not deliver this run
+
+    const auto bySource = delta.removedBySource();
+    QCOMPARE(bySource.value("sub1"), qsizetype(0));
+    QCOMPARE(bySource.value("sub2"), qsizetype(1));
+    QCOMPARE(bySource.value("sub3"), qsizetype(1));
+    QCOMPARE(delta.removedRows().size(), qsizetype(2));
+}
+
+void TestConfigDelta::testResolvedModeKeysByName() {
+    ConfigStore before;
+    addProxy(before, "a.example.com", 443, "sub1");
+    const QString path = m_dir.filePath("resolved.snapshot");
+    QVERIFY(ConfigSnapshot::Write(path, {&before}, Deduplicator::Mode::Resolved));
+
+    // Resolved sets are stored by name, so the next run needs no lookups to compare
+    ConfigSnapshot previous;
+    QVERIFY(previous.open(path));
+    QCOMPARE(previous.mode(), Deduplicator::Mode::Endpoint);
+    QCOMPARE(previous.identityKey(0), before.identityKey(0, Deduplicator::Mode::Endpoint));
+
+    ConfigDelta delta(previous, Deduplicator::Mode::Resolved);
+    QVERIFY(delta.hasBaseline());
+    QCOMPARE(delta.compare(before).unchanged, qsizetype(1));
+}
+
+QTEST_MAIN(TestConfigDelta)
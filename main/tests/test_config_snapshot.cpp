@@ -0,0 +1,182 @@
+#include <QTest>
+#include <QCoreApplication>
+#include <QTemporaryDir>
+#include <QFile>
+
+#include "ConfigSnapshot.h"
+#include "ConfigStore.h"
+#include "Utils.h"
+
+class TestConfigSnapshot : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void testRoundTrip();
+    void testMultipleStoresShareStrings();
+    void testFindByIdentityKey();
+    void testAppendToStore();
+    void testEmptySnapshot();
+    void testRejectsCorruptFiles();
+
+private:
+    ConfigStore sampleStore() const;
+    QTemporaryDir m_dir;
+};
+
+void TestConfigSnapshot::initTestCase() {
+    // Setup test data
+    QVERIFY(m_dir.isValid());
+}
+
+void TestConfigSnapshot::cleanupTestCase() {
+    // Cleanup test data
+}
+
+ConfigStore TestConfigSnapshot::sampleStore() const {
+    ConfigStore store;
+
+    VMessBean vmess;
+    vmess.type = ProxyType::VMess;
+    vmess.name = QString::fromUtf8("\xF0\x9F\x87\xA9\xF0\x9F\x87\xAA Germany");
+    vmess.serverAddress = "vmess.example.com";
+    vmess.serverPort = 443;
+    vmess.uuid = "12345678-1234-1234-1234-123456789012";
+    vmess.aid = 4;
+    vmess.network = "ws";
+    vmess.path = "/ray";
+    vmess.source = "https://example.com/sub.txt";
+    store.append(vmess);
+
+    ShadowSocksBean ss;
+    ss.type = ProxyType::Shadowsocks;
+    ss.name = "SS";
+    ss.serverAddress = "1.2.3.4";
+    ss.serverPort = 8388;
+    ss.method = "aes-256-gcm";
+    ss.password = "secret";
+    ss.source = "https://example.com/sub.txt";
+    store.append(ss);
+
+    SocksHttpBean socks;
+    socks.type = ProxyType::Http;
+    socks.name = "Http";
+    socks.serverAddress = "proxy.example.com";
+    socks.serverPort = 8080;
+    socks.username = "user";
+    store.append(socks);
+
+    return store;
+}
+
+void TestConfigSnapshot::testRoundTrip() {
+    const ConfigStore store = sampleStore();
+    const QString path = m_dir.filePath("roundtrip.snapshot");
+    QString error;
+    QVERIFY2(ConfigSnapshot::Write(path, {&store}, Deduplicator::Mode::Full, &error), qPrintable(error));
+
+    ConfigSnapshot snapshot;
+    QVERIFY2(snapshot.open(path), qPrintable(snapshot.errorString()));
+    QCOMPARE(snapshot.size(), store.size());
+    QCOMPARE(snapshot.mode(), Deduplicator::Mode::Full);
+
+    for (qsizetype row = 0; row < store.size(); ++row) {
+        QCOMPARE(snapshot.kind(row), store.kind(row));
+        QCOMPARE(snapshot.port(row), store.port(row));
+        QCOMPARE(snapshot.alterId(row), store.alterId(row));
+        QCOMPARE(snapshot.identityKey(row), store.identityKey(row, Deduplicator::Mode::Full));
+        for (int f = 0; f < int(ConfigStore::Field::Count); ++f) {
+            QVERIFY(snapshot.field(row, ConfigStore::Field(f)) == store.field(row, ConfigStore::Field(f)));
+        }
+    }
+}
+
+void TestConfigSnapshot::testMultipleStoresShareStrings() {
+    const ConfigStore first = sampleStore();
+    const ConfigStore second = sampleStore();
+    const QString path = m_dir.filePath("shared.snapshot");
+    QVERIFY(ConfigSnapshot::Write(path, {&first, &second}, Deduplicator::Mode::Endpoint));
+
+    const QString single = m_dir.filePath("single.snapshot");
+    QVERIFY(ConfigSnapshot::Write(single, {&first}, Deduplicator::Mode::Endpoint));
+
+    ConfigSnapshot snapshot;
+    QVERIFY(snapshot.open(path));
+    QCOMPARE(snapshot.size(), first.size() + second.size());
+    QVERIFY(snapshot.field(4, ConfigStore::Field::Password) == QByteArrayView("secret"));
+
+    // The second store's strings are all duplicates, so only records and index grow
+    QVERIFY(QFile(path).size() - QFile(single).size() < 4 * 80 + 256);
+}
+
+void TestConfigSnapshot::testFindByIdentityKey() {
+    const ConfigStore store = sampleStore();
+    const QString path = m_dir.filePath("find.snapshot");
+    QVERIFY(ConfigSnapshot::Write(path, {&store, &store}, Deduplicator::Mode::Endpoint));
+
+    ConfigSnapshot snapshot;
+    QVERIFY(snapshot.open(path));
+    for (qsizetype row = 0; row < store.size(); ++row) {
+        // Duplicates resolve to the first row
+        QCOMPARE(snapshot.find(store.identityKey(row, Deduplicator::Mode::Endpoint)), row);
+    }
+    QCOMPARE(snapshot.find(0x1234), qsizetype(-1));
+    QVERIFY(!snapshot.contains(store.identityKey(0, Deduplicator::Mode::Full)));
+}
+
+void TestConfigSnapshot::testAppendToStore() {
+    const ConfigStore store = sampleStore();
+    const QString path = m_dir.filePath("append.snapshot");
+    QVERIFY(ConfigSnapshot::Write(path, {&store}, Deduplicator::Mode::Endpoint));
+
+    ConfigSnapshot snapshot;
+    QVERIFY(snapshot.open(path));
+    ConfigStore restored;
+    snapshot.appendTo(restored);
+    snapshot.close();
+
+    QCOMPARE(restored.size(), store.size());
+    for (qsizetype row = 0; row < store.size(); ++row) {
+        QCOMPARE(restored.toJson(row), store.toJson(row));
+    }
+}
+
+void TestConfigSnapshot::testEmptySnapshot() {
+    const ConfigStore store;
+    const QString path = m_dir.filePath("empty.snapshot");
+    QVERIFY(ConfigSnapshot::Write(path, {&store}, Deduplicator::Mode::Endpoint));
+
+    ConfigSnapshot snapshot;
+    QVERIFY(snapshot.open(path));
+    QCOMPARE(snapshot.size(), qsizetype(0));
+    QCOMPARE(snapshot.find(42), qsizetype(-1));
+}
+
+void TestConfigSnapshot::testRejectsCorruptFiles() {
+    const ConfigStore store = sampleStore();
+    const QString path = m_dir.filePath("corrupt.snapshot");
+    QVERIFY(ConfigSnapshot::Write(path, {&store}, Deduplicator::Mode::Endpoint));
+    QByteArray data;
+    QVERIFY(Utils::readFile(path, data));
+
+    ConfigSnapshot snapshot;
+    QVERIFY(!snapshot.open(m_dir.filePath("missing.snapshot")));
+
+    QVERIFY(Utils::writeFile(path, data.left(100)));
+    QVERIFY(!snapshot.open(path));
+    QVERIFY(!snapshot.isOpen());
+
+    QByteArray badMagic = data;
+    badMagic[0] = 'X';
+    QVERIFY(Utils::writeFile(path, badMagic));
+    QVERIFY(!snapshot.open(path));
+
+    QByteArray badVersion = data;
+    badVersion[8] = char(99);
+    QVERIFY(Utils::writeFile(path, badVersion));
+    QVERIFY(!snapshot.open(path));
+}
+
+QTEST_MAIN(TestConfigSnapshot)
@@ -0,0 +1,287 @@
+#include <QTest>
+#include <QCoreApplication>
+
+#include "ConfigStore.h"
+#include "ConfigSchema.h"
+#include "SubParser.h"
+
+class TestConfigStore : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void testRoundTripBeans();
+    void testJsonMatchesBeans();
+    void testIdentityKeyMatchesDeduplicator();
+    void testInterning();
+    void testRemoveIfAndDeduplicate();
+    void testUnknownType();
+    void testUdpAndLegacyProtocols();
+    void testSchemaFieldOrder();
+
+private:
+    QList<std::shared_ptr<ProxyBean>> sampleBeans() const;
+};
+
+void TestConfigStore::initTestCase() {
+    // Setup test data
+}
+
+void TestConfigStore::cleanupTestCase() {
+    // Cleanup test data
+}
+
+QList<std::shared_ptr<ProxyBean>> TestConfigStore::sampleBeans() const {
+    QList<std::shared_ptr<ProxyBean>> beans;
+
+    auto vmess = std::make_shared<VMessBean>();
+    vmess->type = ProxyType::VMess;
+    vmess->name = QString::fromUtf8("\xF0\x9F\x87\xA9\xF0\x9F\x87\xAA Germany");
+    vmess->serverAddress = "VMess.Example.com";
+    vmess->serverPort = 443;
+    vmess->uuid = "12345678-1234-1234-1234-123456789012";
+    vmess->aid = 2;
+    vmess->network = "ws";
+    vmess->tls = "tls";
+    vmess->path = "/ray";
+    beans.append(vmess);
+
+    auto ss = std::make_shared<ShadowSocksBean>();
+    ss->type = ProxyType::Shadowsocks;
+    ss->name = "SS";
+    ss->serverAddress = "1.2.3.4";
+    ss->serverPort = 8388;
+    ss->method = "aes-256-gcm";
+    ss->password = "secret";
+    beans.append(ss);
+
+    auto vless = std::make_shared<TrojanVLESSBean>();
+    vless->type = ProxyType::VLESS;
+    vless->name = "VLESS";
+    vless->serverAddress = "vless.example.com";
+    vless->serverPort = 8443;
+    vless->password = "uuid";
+    vless->flow = "xtls-rprx-vision";
+    vless->security = "reality";
+    vless->sni = "www.example.com";
+    beans.append(vless);
+
+    auto socks = std::make_shared<SocksHttpBean>();
+    socks->type = ProxyType::Socks;
+    socks->name = "Socks";
+    socks->serverAddress = "socks.example.com";
+    socks->serverPort = 1080;
+    socks->username = "user";
+    socks->password = "pass";
+    beans.append(socks);
+
+    for (const auto &bean : beans) {
+        bean->source = "https://example.com/sub.txt";
+    }
+    return beans;
+}
+
+void TestConfigStore::testRoundTripBeans() {
+    ConfigStore store;
+    const auto beans = sampleBeans();
+    for (const auto &bean : beans) {
+        QVERIFY(store.append(*bean) >= 0);
+    }
+    QCOMPARE(store.size(), beans.size());
+
+    for (qsizetype row = 0; row < store.size(); ++row) {
+        auto restored = store.bean(row);
+        QVERIFY(restored);
+        QCOMPARE(restored->ToJson(), beans[row]->ToJson());
+    }
+
+    QCOMPARE(store.kind(0), ConfigStore::Kind::VMess);
+    QCOMPARE(store.alterId(0), 2);
+    QCOMPARE(store.fieldString(0, ConfigStore::Field::Name), beans[0]->name);
+    QVERIFY(store.field(2, ConfigStore::Field::Flow) == QByteArrayView("xtls-rprx-vision"));
+}
+
+void TestConfigStore::testJsonMatchesBeans() {
+    ConfigStore store;
+    const auto beans = sampleBeans();
+    for (const auto &bean : beans) {
+        store.append(*bean);
+    }
+
+    qsizetype row = 0;
+    for (ConfigRecord record : store) {
+        QCOMPARE(store.toJson(record.row()), beans[row]->ToJson());
+        QCOMPARE(record.port(), beans[row]->serverPort);
+        QCOMPARE(record.typeName(), QString(ProxyTypeName(beans[row]->type)));
+        ++row;
+    }
+    QCOMPARE(row, beans.size());
+}
+
+void TestConfigStore::testIdentityKeyMatchesDeduplicator() {
+    ConfigStore store;
+    const auto beans = sampleBeans();
+    for (const auto &bean : beans) {
+        store.append(*bean);
+    }
+
+    for (auto mode : {Deduplicator::Mode::Endpoint, Deduplicator::Mode::Credentials, Deduplicator::Mode::Full}) {
+        for (qsizetype row = 0; row < store.size(); ++row) {
+            QCOMPARE(store.identityKey(row, mode), Deduplicator::IdentityKey(*beans[row], mode));
+        }
+    }
+}
+
+void TestConfigStore::testInterning() {
+    ConfigStore store;
+    auto beans = sampleBeans();
+    for (int i = 0; i < 1000; ++i) {
+        for (const auto &bean : beans) {
+            store.append(*bean);
+        }
+    }
+
+    // Repeated values are stored once: the arena does not grow with the row count
+    QCOMPARE(store.size(), qsizetype(4000));
+    QVERIFY(store.uniqueStrings() < 40);
+    QCOMPARE(store.fieldString(3999, ConfigStore::Field::Source), QString("https://example.com/sub.txt"));
+}
+
+void TestConfigStore::testRemoveIfAndDeduplicate() {
+    ConfigStore store;
+    const auto beans = sampleBeans();
+    for (const auto &bean : beans) {
+        store.append(*bean);
+    }
+    for (const auto &bean : beans) {
+        store.append(*bean);
+    }
+
+    Deduplicator dedup(Deduplicator::Mode::Endpoint);
+    QCOMPARE(store.deduplicate(dedup), qsizetype(4));
+    QCOMPARE(store.size(), qsizetype(4));
+    QCOMPARE(store.typeName(0), QString("vmess"));
+    QCOMPARE(store.typeName(3), QString("socks"));
+
+    qsizetype removed = store.removeIf([](const ConfigRecord &record) {
+        return record.port() == 8388;
+    });
+    QCOMPARE(removed, qsizetype(1));
+    QCOMPARE(store.size(), qsizetype(3));
+    QCOMPARE(store.kind(1), ConfigStore::Kind::VLESS);
+    QVERIFY(store.field(1, ConfigStore::Field::Server) == QByteArrayView("vless.example.com"));
+}
+
+void TestConfigStore::testUnknownType() {
+    TrojanVLESSBean bean;
+    bean.type = ProxyType::Unknown;
+    ConfigStore store;
+    QCOMPARE(store.append(bean), qsizetype(-1));
+    QVERIFY(store.isEmpty());
+}
+
+void TestConfigStore::testUdpAndLegacyProtocols() {
+    QList<std::shared_ptr<ProxyBean>> beans;
+
+    auto hy2 = std::make_shared<Hysteria2Bean>();
+    hy2->type = ProxyType::Hysteria2;
+    hy2->serverAddress = "hy2.example.com";
+    hy2->serverPort = 443;
+    hy2->password = "pw";
+    hy2->obfs = "salamander";
+    hy2->obfsPassword = "cry";
+    hy2->insecure = true;
+    beans.append(hy2);
+
+    auto tuic = std::make_shared<TuicBean>();
+    tuic->type = ProxyType::Tuic;
+    tuic->serverAddress = "tuic.example.com";
+    tuic->serverPort = 443;
+    tuic->uuid = "12345678-1234-1234-1234-123456789012";
+    tuic->password = "pw";
+    tuic->congestionControl = "bbr";
+    tuic->alpn = "h3";
+    beans.append(tuic);
+
+    auto ssr = std::make_shared<ShadowSocksRBean>();
+    ssr->type = ProxyType::ShadowsocksR;
+    ssr->serverAddress = "1.2.3.4";
+    ssr->serverPort = 8989;
+    ssr->method = "aes-256-cfb";
+    ssr->password = "pw";
+    ssr->protocol = "auth_aes128_md5";
+    ssr->obfsParam = "cdn.example.com";
+    beans.append(ssr);
+
+    auto wg = std::make_shared<WireGuardBean>();
+    wg->type = ProxyType::WireGuard;
+    wg->serverAddress = "162.159.192.1";
+    wg->serverPort = 2408;
+    wg->privateKey = "private";
+    wg->publicKey = "public";
+    wg->localAddress = "172.16.0.2/32";
+    wg->mtu = 1280;
+    beans.append(wg);
+
+    ConfigStore store;
+    for (const auto &bean : beans) {
+        QVERIFY(store.append(*bean) >= 0);
+    }
+    for (qsizetype row = 0; row < store.size(); ++row) {
+        QCOMPARE(store.bean(row)->ToJson(), beans[row]->ToJson());
+        QCOMPARE(store.toJson(row), beans[row]->ToJson());
+        for (auto mode : {Deduplicator::Mode::Endpoint, Deduplicator::Mode::Credentials, Deduplicator::Mode::Full}) {
+            QCOMPARE(store.identityKey(row, mode), Deduplicator::IdentityKey(*beans[row], mode));
+        }
+    }
+    QCOMPARE(store.alterId(3), 1280);
+    QVERIFY(store.toJson(0)["insecure"].toBool());
+}
+
+void TestConfigStore::testSchemaFieldOrder() {
+    struct KeyRecorder : JsonFieldVisitor {
+        QStringList keys;
+        void string(const char *key, QByteArrayView) override { keys.append(key); }
+        void number(const char *key, qint64) override { keys.append(key); }
+        void boolean(const char *key, bool) override { keys.append(key); }
+    };
+
+    TrojanVLESSBean vless;
+    vless.type = ProxyType::VLESS;
+    vless.serverAddress = "vless.example.com";
+    vless.serverPort = 443;
+    vless.password = "uuid";
+    vless.flow = "xtls-rprx-vision";
+    vless.source = "https://example.com/sub";
+
+    ConfigStore store;
+    QCOMPARE(store.append(vless), qsizetype(0));
+    KeyRecorder fromBean;
+    vless.visitJson(fromBean);
+    KeyRecorder fromRow;
+    store.visitJson(0, fromRow);
+    const QStringList expected{"type", "name", "server", "port", "password", "network", "flow", "source"};
+    QCOMPARE(fromBean.keys, expected);
+    QCOMPARE(fromRow.keys, expected);
+
+    // Trojan never writes flow, but it still tells full identities apart
+    TrojanVLESSBean trojan = vless;
+    trojan.type = ProxyType::Trojan;
+    QVERIFY(!trojan.ToJson().contains("flow"));
+    TrojanVLESSBean plain = trojan;
+    plain.flow.clear();
+    QVERIFY(Deduplicator::IdentityKey(trojan, Deduplicator::Mode::Full) !=
+            Deduplicator::IdentityKey(plain, Deduplicator::Mode::Full));
+    QCOMPARE(Deduplicator::IdentityKey(trojan, Deduplicator::Mode::Credentials),
+             Deduplicator::IdentityKey(plain, Deduplicator::Mode::Credentials));
+
+    // One list per bean class covers its kinds, Unknown has none
+    QVERIFY(ConfigSchema::Dispatch(ProxyType::Http, [](auto schema) {
+        QVERIFY((std::is_same_v<typename decltype(schema)::Bean, SocksHttpBean>));
+    }));
+    QVERIFY(!ConfigSchema::Dispatch(ProxyType::Unknown, [](auto) {}));
+}
+
+QTEST_MAIN(TestConfigStore)
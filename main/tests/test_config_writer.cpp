@@ -0,0 +1,192 @@
+#include <QTest>
+#include <QCoreApplication>
+#include <QTemporaryDir>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonArray>
+
+#include "ConfigWriter.h"
+#include "ConfigStore.h"
+#include "Utils.h"
+
+class TestConfigWriter : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void testDocumentRoundTrip();
+    void testNdjsonLines();
+    void testEscaping();
+    void testEmptyDocument();
+    void testSmallBufferFlushes();
+    void testUncommittedLeavesOldFile();
+
+private:
+    ConfigStore sampleStore() const;
+    QTemporaryDir m_dir;
+};
+
+void TestConfigWriter::initTestCase() {
+    // Setup test data
+    QVERIFY(m_dir.isValid());
+}
+
+void TestConfigWriter::cleanupTestCase() {
+    // Cleanup test data
+}
+
+ConfigStore TestConfigWriter::sampleStore() const {
+    ConfigStore store;
+
+    VMessBean vmess;
+    vmess.type = ProxyType::VMess;
+    vmess.name = QString::fromUtf8("\xF0\x9F\x87\xA9\xF0\x9F\x87\xAA Germany");
+    vmess.serverAddress = "vmess.example.com";
+    vmess.serverPort = 443;
+    vmess.uuid = "12345678-1234-1234-1234-123456789012";
+    vmess.network = "ws";
+    vmess.path = "/ray";
+    vmess.source = "https://example.com/sub.txt";
+    store.append(vmess);
+
+    ShadowSocksBean ss;
+    ss.type = ProxyType::Shadowsocks;
+    ss.name = "SS \"quoted\" \\ back";
+    ss.serverAddress = "1.2.3.4";
+    ss.serverPort = 8388;
+    ss.method = "aes-256-gcm";
+    ss.password = "line1\nline2\ttab\x01";
+    store.append(ss);
+
+    TrojanVLESSBean trojan;
+    trojan.type = ProxyType::Trojan;
+    trojan.name = QString::fromUtf8("\xD0\x9C\xD0\xBE\xD1\x81\xD0\xBA\xD0\xB2\xD0\xB0");
+    trojan.serverAddress = "trojan.example.com";
+    trojan.serverPort = 443;
+    trojan.password = "pw";
+    trojan.sni = "sni.example.com";
+    store.append(trojan);
+
+    return store;
+}
+
+void TestConfigWriter::testDocumentRoundTrip() {
+    const ConfigStore store = sampleStore();
+    const QString path = m_dir.filePath("config_0001.json");
+
+    ConfigWriter writer(ConfigWriter::Format::JsonDocument);
+    QVERIFY(writer.open(path, "https://example.com/sub.txt"));
+    for (qsizetype row = 0; row < store.size(); ++row) {
+        QVERIFY(writer.write(store, row));
+    }
+    QVERIFY(writer.commit());
+    QCOMPARE(writer.count(), store.size());
+
+    QByteArray data;
+    QVERIFY(Utils::readFile(path, data));
+    QJsonParseError error;
+    QJsonDocument doc = QJsonDocument::fromJson(data, &error);
+    QCOMPARE(error.error, QJsonParseError::NoError);
+
+    QCOMPARE(doc.object()["subscription"].toString(), QString("https://example.com/sub.txt"));
+    QJsonArray configs = doc.object()["configs"].toArray();
+    QCOMPARE(configs.size(), store.size());
+    for (qsizetype row = 0; row < store.size(); ++row) {
+        QCOMPARE(configs[row].toObject(), store.toJson(row));
+    }
+}
+
+void TestConfigWriter::testNdjsonLines() {
+    const ConfigStore store = sampleStore();
+    const QString path = m_dir.filePath("configs.ndjson");
+
+    ConfigWriter writer(ConfigWriter::Format::Ndjson);
+    QVERIFY(writer.open(path));
+    for (qsizetype row = 0; row < store.size(); ++row) {
+        QVERIFY(writer.write(store, row));
+    }
+    auto bean = store.bean(0);
+    QVERIFY(writer.write(*bean));
+    QVERIFY(writer.commit());
+
+    QByteArray data;
+    QVERIFY(Utils::readFile(path, data));
+    QVERIFY(data.endsWith('\n'));
+    const QList<QByteArray> lines = data.trimmed().split('\n');
+    QCOMPARE(lines.size(), store.size() + 1);
+
+    for (qsizetype i = 0; i < lines.size(); ++i) {
+        QJsonParseError error;
+        QJsonDocument doc = QJsonDocument::fromJson(lines[i], &error);
+        QCOMPARE(error.error, QJsonParseError::NoError);
+        QCOMPARE(doc.object(), store.toJson(i < store.size() ? i : 0));
+    }
+}
+
+void TestConfigWriter::testEscaping() {
+    QByteArray out;
+    ConfigWriter::AppendString(out, QByteArrayView("a\"b\\c\nd\re\tf\x01g"));
+    QCOMPARE(out, QByteArray("\"a\\\"b\\\\c\\nd\\re\\tf\\u0001g\""));
+
+    // Non-ASCII text is left as UTF-8
+    out.clear();
+    const QByteArray utf8 = QString::fromUtf8("\xD0\x9C\xC3\xA9").toUtf8();
+    ConfigWriter::AppendString(out, utf8);
+    QCOMPARE(out, "\"" + utf8 + "\"");
+}
+
+void TestConfigWriter::testEmptyDocument() {
+    const QString path = m_dir.filePath("empty.json");
+    ConfigWriter writer(ConfigWriter::Format::JsonDocument);
+    QVERIFY(writer.open(path, "sub"));
+    QVERIFY(writer.commit());
+
+    QByteArray data;
+    QVERIFY(Utils::readFile(path, data));
+    QJsonDocument doc = QJsonDocument::fromJson(data);
+    QVERIFY(doc.isObject());
+    QVERIFY(doc.object()["configs"].toArray().isEmpty());
+}
+
+void TestConfigWriter::testSmallBufferFlushes() {
+    ConfigStore store;
+    ConfigStore sample = sampleStore();
+    auto bean = sample.bean(2);
+    for (int i = 0; i < 5000; ++i) {
+        bean->serverPort = 1000 + i;
+        store.append(*bean);
+    }
+
+    const QString path = m_dir.filePath("large.ndjson");
+    ConfigWriter writer(ConfigWriter::Format::Ndjson, 1024);
+    QVERIFY(writer.open(path));
+    for (qsizetype row = 0; row < store.size(); ++row) {
+        QVERIFY(writer.write(store, row));
+    }
+    QVERIFY(writer.commit());
+
+    QByteArray data;
+    QVERIFY(Utils::readFile(path, data));
+    QCOMPARE(data.count('\n'), qsizetype(5000));
+    QVERIFY(data.endsWith("\"port\":5999,\"password\":\"pw\",\"sni\":\"sni.example.com\"}\n"));
+}
+
+void TestConfigWriter::testUncommittedLeavesOldFile() {
+    const QString path = m_dir.filePath("keep.json");
+    QVERIFY(Utils::writeFile(path, QByteArray("old")));
+
+    {
+        ConfigWriter writer(ConfigWriter::Format::JsonDocument);
+        QVERIFY(writer.open(path, "sub"));
+        ConfigStore store = sampleStore();
+        QVERIFY(writer.write(store, 0));
+    }
+
+    QByteArray data;
+    QVERIFY(Utils::readFile(path, data));
+    QCOMPARE(data, QByteArray("old"));
+}
+
+QTEST_MAIN(TestConfigWriter)
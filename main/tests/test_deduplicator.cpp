@@ -0,0 +1,167 @@
+#include <QTest>
+#include <QCoreApplication>
+
+#include "Deduplicator.h"
+
+class TestDeduplicator : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void testHashSetInsertAndGrow();
+    void testHashSetZeroKey();
+    void testHasherFieldBoundaries();
+    void testEndpointMode();
+    void testCredentialsMode();
+    void testFullMode();
+    void testParseMode();
+
+private:
+    TrojanVLESSBean makeTrojan(const QString &password, const QString &sni) const;
+};
+
+void TestDeduplicator::initTestCase() {
+    // Setup test data
+}
+
+void TestDeduplicator::cleanupTestCase() {
+    // Cleanup test data
+}
+
+TrojanVLESSBean TestDeduplicator::makeTrojan(const QString &password, const QString &sni) const {
+    TrojanVLESSBean bean;
+    bean.type = ProxyType::Trojan;
+    bean.name = "node";
+    bean.serverAddress = "trojan.example.com";
+    bean.serverPort = 443;
+    bean.password = password;
+    bean.sni = sni;
+    return bean;
+}
+
+void TestDeduplicator::testHashSetInsertAndGrow() {
+    HashSet64 set;
+    const qsizetype initialCapacity = set.capacity();
+    for (quint64 key = 1; key <= 10000; ++key) {
+        QVERIFY(set.insert(key * 0x9E3779B97F4A7C15ULL));
+    }
+    QCOMPARE(set.size(), qsizetype(10000));
+    QVERIFY(set.capacity() > initialCapacity);
+    QVERIFY(set.size() * 2 <= set.capacity());
+
+    for (quint64 key = 1; key <= 10000; ++key) {
+        QVERIFY(set.contains(key * 0x9E3779B97F4A7C15ULL));
+        QVERIFY(!set.insert(key * 0x9E3779B97F4A7C15ULL));
+    }
+    QVERIFY(!set.contains(12345));
+
+    set.clear();
+    QCOMPARE(set.size(), qsizetype(0));
+    QVERIFY(!set.contains(0x9E3779B97F4A7C15ULL));
+}
+
+void TestDeduplicator::testHashSetZeroKey() {
+    // Zero is the empty marker internally but still a usable key
+    HashSet64 set;
+    QVERIFY(!set.contains(0));
+    QVERIFY(set.insert(0));
+    QVERIFY(set.contains(0));
+    QVERIFY(!set.insert(0));
+}
+
+void TestDeduplicator::testHasherFieldBoundaries() {
+    IdentityHasher a;
+    a.add(QStringView(u"ab"));
+    a.add(QStringView(u"c"));
+
+    IdentityHasher b;
+    b.add(QStringView(u"a"));
+    b.add(QStringView(u"bc"));
+    QVERIFY(a.result() != b.result());
+
+    IdentityHasher c;
+    c.add(QStringView(u"ab"));
+    c.add(QStringView(u"c"));
+    QCOMPARE(a.result(), c.result());
+
+    IdentityHasher upper;
+    upper.addHost(u"Example.COM");
+    IdentityHasher lower;
+    lower.addHost(u"example.com");
+    QCOMPARE(upper.result(), lower.result());
+}
+
+void TestDeduplicator::testEndpointMode() {
+    Deduplicator dedup(Deduplicator::Mode::Endpoint);
+    TrojanVLESSBean first = makeTrojan("one", "a.com");
+    TrojanVLESSBean otherPassword = makeTrojan("two", "b.com");
+    otherPassword.name = "renamed";
+
+    QVERIFY(dedup.insert(first));
+    QVERIFY(!dedup.insert(otherPassword));
+
+    TrojanVLESSBean otherPort = first;
+    otherPort.serverPort = 8443;
+    QVERIFY(dedup.insert(otherPort));
+
+    // Same endpoint under another protocol is a different proxy
+    TrojanVLESSBean vless = first;
+    vless.type = ProxyType::VLESS;
+    QVERIFY(dedup.insert(vless));
+
+    QCOMPARE(dedup.size(), qsizetype(3));
+}
+
+void TestDeduplicator::testCredentialsMode() {
+    Deduplicator dedup(Deduplicator::Mode::Credentials);
+    QVERIFY(dedup.insert(makeTrojan("one", "a.com")));
+    QVERIFY(dedup.insert(makeTrojan("two", "a.com")));
+    QVERIFY(!dedup.insert(makeTrojan("one", "b.com")));
+
+    // Method and password must not be interchangeable
+    ShadowSocksBean ss;
+    ss.type = ProxyType::Shadowsocks;
+    ss.serverAddress = "ss.example.com";
+    ss.serverPort = 8388;
+    ss.method = "aes-256-gcm";
+    ss.password = "secret";
+    ShadowSocksBean swapped = ss;
+    swapped.method = "secret";
+    swapped.password = "aes-256-gcm";
+    QVERIFY(dedup.insert(ss));
+    QVERIFY(dedup.insert(swapped));
+}
+
+void TestDeduplicator::testFullMode() {
+    Deduplicator dedup(Deduplicator::Mode::Full);
+    QVERIFY(dedup.insert(makeTrojan("one", "a.com")));
+    QVERIFY(dedup.insert(makeTrojan("one", "b.com")));
+    QVERIFY(!dedup.insert(makeTrojan("one", "a.com")));
+
+    TrojanVLESSBean ws = makeTrojan("one", "a.com");
+    ws.network = "ws";
+    ws.path = "/ws";
+    QVERIFY(dedup.insert(ws));
+}
+
+void TestDeduplicator::testParseMode() {
+    Deduplicator::Mode mode = Deduplicator::Mode::Endpoint;
+    QVERIFY(Deduplicator::ParseMode("credentials", mode));
+    QCOMPARE(mode, Deduplicator::Mode::Credentials);
+    QVERIFY(Deduplicator::ParseMode(" FULL ", mode));
+    QCOMPARE(mode, Deduplicator::Mode::Full);
+    QVERIFY(Deduplicator::ParseMode("endpoint", mode));
+    QCOMPARE(mode, Deduplicator::Mode::Endpoint);
+    QVERIFY(!Deduplicator::ParseMode("name", mode));
+    QCOMPARE(mode, Deduplicator::Mode::Endpoint);
+
+    for (auto m : {Deduplicator::Mode::Endpoint, Deduplicator::Mode::Credentials, Deduplicator::Mode::Full}) {
+        Deduplicator::Mode parsed;
+        QVERIFY(Deduplicator::ParseMode(Deduplicator::ModeName(m), parsed));
+        QCOMPARE(parsed, m);
+    }
+}
+
+QTEST_MAIN(TestDeduplicator)
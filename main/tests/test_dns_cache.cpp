@@ -0,0 +1,155 @@
+#include <QTest>
+#include <QCoreApplication>
+
+#include "DnsCache.h"
+#include "Deduplicator.h"
+#include "ConfigStore.h"
+
+class TestDnsCache : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void testIpLiteralsSkipResolver();
+    void testLookupOncePerName();
+    void testNegativeCaching();
+    void testExpiry();
+    void testExpiredBeforeDedup();
+    void testResolvedDedupMode();
+
+private:
+    static TrojanVLESSBean bean(const QString &server, int port);
+};
+
+void TestDnsCache::initTestCase() {
+    // Setup test data
+}
+
+void TestDnsCache::cleanupTestCase() {
+    // Cleanup test data
+}
+
+TrojanVLESSBean TestDnsCache::bean(const QString &server, int port) {
+    TrojanVLESSBean bean;
+    bean.type = ProxyType::Trojan;
+    bean.serverAddress = server;
+    bean.serverPort = port;
+    bean.password = "pw";
+    return bean;
+}
+
+void TestDnsCache::testIpLiteralsSkipResolver() {
+    DnsCache cache;
+    cache.prefetch("1.2.3.4");
+    cache.prefetch("[2001:DB8::1]");
+    QCOMPARE(cache.pending(), 0);
+    cache.run();
+
+    QCOMPARE(cache.lookups(), 0);
+    QCOMPARE(cache.status("1.2.3.4"), DnsCache::Status::Resolved);
+    QCOMPARE(cache.canonicalAddress("1.2.3.4"), QString("1.2.3.4"));
+    QCOMPARE(cache.canonicalAddress("[2001:db8::1]"), QString("2001:db8::1"));
+}
+
+void TestDnsCache::testLookupOncePerName() {
+    DnsCache cache;
+    cache.prefetch("localhost");
+    cache.prefetch("LOCALHOST");
+    cache.prefetch(" localhost ");
+    cache.run();
+
+    QCOMPARE(cache.lookups(), 1);
+    QCOMPARE(cache.status("localhost"), DnsCache::Status::Resolved);
+    QVERIFY(!cache.addresses("localhost").isEmpty());
+    // IPv4 answers sort first
+    QCOMPARE(cache.canonicalAddress("localhost"), QString("127.0.0.1"));
+
+    cache.prefetch("localhost");
+    cache.run();
+    QCOMPARE(cache.lookups(), 1);
+}
+
+void TestDnsCache::testNegativeCaching() {
+    DnsCache cache;
+    cache.prefetch("does-not-exist.invalid");
+    cache.run();
+
+    QCOMPARE(cache.status("does-not-exist.invalid"), DnsCache::Status::Failed);
+    QVERIFY(cache.canonicalAddress("does-not-exist.invalid").isEmpty());
+    QCOMPARE(cache.failures(), 1);
+
+    cache.prefetch("does-not-exist.invalid");
+    cache.run();
+    QCOMPARE(cache.lookups(), 1);
+}
+
+void TestDnsCache::testExpiry() {
+    DnsCache::Options options;
+    options.ttlMs = 0;
+    options.negativeTtlMs = 0;
+    DnsCache cache(options);
+    cache.prefetch("localhost");
+    cache.prefetch("does-not-exist.invalid");
+    cache.run();
+
+    // Expired entries keep their last answer and are looked up again
+    QCOMPARE(cache.status("localhost"), DnsCache::Status::Resolved);
+    QCOMPARE(cache.status("does-not-exist.invalid"), DnsCache::Status::Failed);
+    cache.prefetch("localhost");
+    cache.run();
+    QCOMPARE(cache.lookups(), 4);
+    QCOMPARE(cache.status("unqueued.example.com"), DnsCache::Status::Unknown);
+}
+
+void TestDnsCache::testExpiredBeforeDedup() {
+    DnsCache::Options options;
+    options.ttlMs = 0;
+    DnsCache cache(options);
+
+    // Answered during the downloads, expired by the time dedup drains the cache
+    cache.prefetch("localhost");
+    QTRY_COMPARE(cache.pending(), 0);
+    QCOMPARE(cache.lookups(), 1);
+    cache.run();
+    QCOMPARE(cache.lookups(), 2);
+
+    QCOMPARE(cache.status("localhost"), DnsCache::Status::Resolved);
+    QCOMPARE(cache.canonicalAddress("localhost"), QString("127.0.0.1"));
+    QCOMPARE(Deduplicator::IdentityKey(bean("localhost", 443), Deduplicator::Mode::Resolved, &cache),
+             Deduplicator::IdentityKey(bean("127.0.0.1", 443), Deduplicator::Mode::Resolved, &cache));
+}
+
+void TestDnsCache::testResolvedDedupMode() {
+    Deduplicator::Mode mode;
+    QVERIFY(Deduplicator::ParseMode("resolved", mode));
+    QCOMPARE(mode, Deduplicator::Mode::Resolved);
+    QCOMPARE(Deduplicator::ModeName(mode), QString("resolved"));
+
+    DnsCache cache;
+    cache.prefetch("localhost");
+    cache.prefetch("127.0.0.1");
+    cache.run();
+
+    const TrojanVLESSBean byName = bean("localhost", 443);
+    const TrojanVLESSBean byAddress = bean("127.0.0.1", 443);
+    QVERIFY(Deduplicator::IdentityKey(byName, mode) != Deduplicator::IdentityKey(byAddress, mode));
+    QCOMPARE(Deduplicator::IdentityKey(byName, mode, &cache), Deduplicator::IdentityKey(byAddress, mode, &cache));
+
+    Deduplicator dedup(mode);
+    dedup.setResolver(&cache);
+    QVERIFY(dedup.insert(byName));
+    QVERIFY(!dedup.insert(byAddress));
+
+    // ConfigStore computes the same keys
+    ConfigStore store;
+    store.append(byName);
+    store.append(byAddress);
+    QCOMPARE(store.identityKey(0, mode, &cache), Deduplicator::IdentityKey(byName, mode, &cache));
+    Deduplicator storeDedup(mode);
+    storeDedup.setResolver(&cache);
+    QCOMPARE(store.deduplicate(storeDedup), qsizetype(1));
+}
+
+QTEST_MAIN(TestDnsCache)
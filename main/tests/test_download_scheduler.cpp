@@ -0,0 +1,374 @@
+#include <QTest>
+#include <QCoreApplication>
+#include <QTemporaryDir>
+#include <QUrl>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QHostAddress>
+#include <QFile>
+#include <QElapsedTimer>
+#include <QDeadlineTimer>
+
+#include "DownloadScheduler.h"
+#include "Utils.h"
+
+class TestDownloadScheduler : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void testAllJobsFinish();
+    void testConcurrencyWindow();
+    void testFailedJobReported();
+    void testEmptyQueue();
+    void testRetriesTransientFailure();
+    void testNoRetryOnClientError();
+    void testCircuitBreakerSkipsHost();
+    void testHedgedRequestWins();
+    void testDecompressesPrecompressedFile();
+    void testPerHostLimit();
+    void testEnqueueWhileRunning();
+    void testDeadlineCancelsRemainingJobs();
+
+private:
+    QString writeSubscription(const QString& name, const QString& content);
+    // Answer the n-th request with script[n]: an HTTP status, or 0 to never answer
+    void serve(const QList<int>& script);
+
+    QTemporaryDir m_tempDir;
+    QTcpServer m_server;
+    QList<int> m_script;
+    int m_requests = 0;
+};
+
+void TestDownloadScheduler::initTestCase() {
+    QVERIFY(m_tempDir.isValid());
+    QVERIFY(m_server.listen(QHostAddress::LocalHost));
+    connect(&m_server, &QTcpServer::newConnection, this, [this]() {
+        while (QTcpSocket* socket = m_server.nextPendingConnection()) {
+            connect(socket, &QTcpSocket::readyRead, socket, [this, socket]() {
+                if (!socket->readAll().contains("\r\n\r\n")) {
+                    return;
+                }
+                const int status = m_requests < m_script.size() ? m_script[m_requests] : 200;
+                ++m_requests;
+                if (status == 0) {
+                    return;
+                }
+                const QByteArray body = status == 200 ? "trojan://pw@host.example.com:443#ok\n" : "";
+                socket->write("HTTP/1.1 " + QByteArray::number(status) + " Status\r\n"
+                              "Content-Length: " + QByteArray::number(body.size()) + "\r\n"
+                              "Connection: close\r\n\r\n" + body);
+                socket->disconnectFromHost();
+            });
+            connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+        }
+    });
+}
+
+void TestDownloadScheduler::serve(const QList<int>& script) {
+    m_script = script;
+    m_requests = 0;
+}
+
+void TestDownloadScheduler::cleanupTestCase() {
+    // Clean up will be handled by QTemporaryDir destructor
+}
+
+QString TestDownloadScheduler::writeSubscription(const QString& name, const QString& content) {
+    QString path = m_tempDir.filePath(name);
+    Utils::writeFileText(path, content);
+    return QUrl::fromLocalFile(path).toString();
+}
+
+void TestDownloadScheduler::testAllJobsFinish() {
+    DownloadScheduler scheduler(4, 5000);
+
+    QList<QString> urls;
+    for (int i = 0; i < 10; ++i) {
+        urls.append(writeSubscription(QString("sub_%1.txt").arg(i), QString("content %1").arg(i)));
+    }
+
+    QList<QByteArray> bodies(urls.size());
+    int finishedCount = 0;
+    scheduler.onFinished([&](int id, const QString& url, const HttpResponse& response) {
+        QCOMPARE(url, urls[id]);
+        QVERIFY(response.error.isEmpty());
+        bodies[id] = response.data;
+        ++finishedCount;
+    });
+
+    for (const QString& url : urls) {
+        scheduler.enqueue(url);
+    }
+    scheduler.run();
+
+    QCOMPARE(finishedCount, urls.size());
+    for (int i = 0; i < bodies.size(); ++i) {
+        QCOMPARE(bodies[i], QString("content %1").arg(i).toUtf8());
+    }
+    QCOMPARE(scheduler.inFlight(), 0);
+    QCOMPARE(scheduler.pending(), 0);
+}
+
+void TestDownloadScheduler::testConcurrencyWindow() {
+    DownloadScheduler scheduler(2, 5000);
+    QCOMPARE(scheduler.maxConcurrent(), 2);
+
+    int maxSeen = 0;
+    scheduler.onFinished([&](int, const QString&, const HttpResponse&) {
+        // The finished job has already left the window
+        maxSeen = qMax(maxSeen, scheduler.inFlight() + 1);
+    });
+
+    for (int i = 0; i < 8; ++i) {
+        scheduler.enqueue(writeSubscription(QString("window_%1.txt").arg(i), "data"));
+    }
+    scheduler.run();
+
+    QVERIFY(maxSeen <= 2);
+
+    // Non-positive limits fall back to a single slot
+    DownloadScheduler serial(0, 5000);
+    QCOMPARE(serial.maxConcurrent(), 1);
+}
+
+void TestDownloadScheduler::testFailedJobReported() {
+    DownloadScheduler scheduler(2, 5000);
+
+    QString error;
+    scheduler.onFinished([&](int, const QString&, const HttpResponse& response) {
+        error = response.error;
+    });
+
+    scheduler.enqueue(QUrl::fromLocalFile(m_tempDir.filePath("missing.txt")).toString());
+    scheduler.run();
+
+    QVERIFY(!error.isEmpty());
+}
+
+void TestDownloadScheduler::testEmptyQueue() {
+    DownloadScheduler scheduler(2, 5000);
+    // Must return immediately instead of blocking in the event loop
+    scheduler.run();
+    QCOMPARE(scheduler.inFlight(), 0);
+}
+
+void TestDownloadScheduler::testRetriesTransientFailure() {
+    serve({503, 502, 200});
+    DownloadScheduler scheduler(2, 5000);
+    RetryPolicy policy;
+    policy.maxAttempts = 3;
+    policy.baseDelayMs = 10;
+    policy.maxDelayMs = 20;
+    scheduler.setRetryPolicy(policy);
+
+    HttpResponse result;
+    int finished = 0;
+    scheduler.onFinished([&](int, const QString&, const HttpResponse& response) {
+        result = response;
+        ++finished;
+    });
+    scheduler.enqueue(QString("http://127.0.0.1:%1/sub").arg(m_server.serverPort()));
+    scheduler.run();
+
+    // Only the final outcome is reported
+    QCOMPARE(finished, 1);
+    QVERIFY(result.error.isEmpty());
+    QCOMPARE(result.attempts, 3);
+    QCOMPARE(scheduler.retries(), 2);
+    QCOMPARE(m_requests, 3);
+    QCOMPARE(scheduler.pending(), 0);
+}
+
+void TestDownloadScheduler::testNoRetryOnClientError() {
+    serve({404, 200});
+    DownloadScheduler scheduler(2, 5000);
+    RetryPolicy policy;
+    policy.maxAttempts = 3;
+    policy.baseDelayMs = 10;
+    scheduler.setRetryPolicy(policy);
+
+    HttpResponse result;
+    scheduler.onFinished([&](int, const QString&, const HttpResponse& response) {
+        result = response;
+    });
+    scheduler.enqueue(QString("http://127.0.0.1:%1/missing").arg(m_server.serverPort()));
+    scheduler.run();
+
+    QVERIFY(!result.error.isEmpty());
+    QVERIFY(!result.transient);
+    QCOMPARE(m_requests, 1);
+}
+
+void TestDownloadScheduler::testCircuitBreakerSkipsHost() {
+    serve({503, 503, 503, 503});
+    DownloadScheduler scheduler(1, 5000);
+    scheduler.setCircuitBreaker(CircuitBreaker::Options{2, 60000});
+
+    QStringList errors;
+    scheduler.onFinished([&](int, const QString&, const HttpResponse& response) {
+        errors.append(response.error);
+    });
+    for (int i = 0; i < 4; ++i) {
+        scheduler.enqueue(QString("http://127.0.0.1:%1/sub%2").arg(m_server.serverPort()).arg(i));
+    }
+    scheduler.run();
+
+    // Two failures open the circuit; the rest fail without a request
+    QCOMPARE(errors.size(), 4);
+    QCOMPARE(m_requests, 2);
+    QCOMPARE(scheduler.rejected(), 2);
+    QVERIFY(errors.last().contains("Circuit open"));
+}
+
+void TestDownloadScheduler::testHedgedRequestWins() {
+    // The first request hangs; the hedge answers
+    serve({0, 200});
+    DownloadScheduler scheduler(2, 10000);
+    scheduler.setHedgeDelay(50);
+
+    HttpResponse result;
+    scheduler.onFinished([&](int, const QString&, const HttpResponse& response) {
+        result = response;
+    });
+    QElapsedTimer timer;
+    timer.start();
+    scheduler.enqueue(QString("http://127.0.0.1:%1/slow").arg(m_server.serverPort()));
+    scheduler.run();
+
+    QVERIFY(result.error.isEmpty());
+    QVERIFY(result.hedged);
+    QCOMPARE(scheduler.hedges(), 1);
+    QCOMPARE(scheduler.hedgeWins(), 1);
+    QVERIFY(timer.elapsed() < 5000);
+    QCOMPARE(scheduler.inFlight(), 0);
+}
+
+void TestDownloadScheduler::testDecompressesPrecompressedFile() {
+    if (!StreamDecompressor::IsSupported(StreamDecompressor::Format::Gzip)) {
+        QSKIP("zlib not available in this build");
+    }
+
+    // gzip -9 of two links
+    const QByteArray plain = "trojan://pw@host.example.com:443#compressed\n"
+                             "vless://12345678-1234-1234-1234-123456789012@vless.example.com:443?type=ws#v\n";
+    const QByteArray gzipped = QByteArray::fromHex(
+        "1f8b08000000000002032b29cacf4accb3d2d72f2877c8c82f2ed14bad48cc2d"
+        "c849d54bcecfb53231315606d20545a9c5c5a9295c6539401aa8d4d0c8d8c4d4"
+        "ccdc4217c4402340e2960686460e60c5e8a6d9975416a4da96172b977101000c"
+        "e5fd2679000000");
+    // No extension: found by its magic bytes
+    QFile file(m_tempDir.filePath("feed"));
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(gzipped);
+    file.close();
+    const QString url = QUrl::fromLocalFile(file.fileName()).toString();
+
+    for (bool streaming : {false, true}) {
+        DownloadScheduler scheduler(1, 5000);
+        scheduler.setDecompression(true);
+        QByteArray streamed;
+        if (streaming) {
+            scheduler.onChunk([&](int, const QByteArray& chunk) { streamed += chunk; });
+        }
+        HttpResponse result;
+        scheduler.onFinished([&](int, const QString&, const HttpResponse& response) { result = response; });
+        scheduler.enqueue(url);
+        scheduler.run();
+
+        QVERIFY(result.error.isEmpty());
+        QCOMPARE(streaming ? streamed : result.data, plain);
+        QCOMPARE(result.bytesReceived, qint64(plain.size()));
+        QCOMPARE(result.transferBytes, qint64(gzipped.size()));
+    }
+}
+
+void TestDownloadScheduler::testPerHostLimit() {
+    serve({});
+    DownloadScheduler scheduler(4, 5000);
+    scheduler.setPerHostLimit(1);
+
+    const QString base = QString("http://127.0.0.1:%1/").arg(m_server.serverPort());
+    int maxSeen = 0;
+    int finishedCount = 0;
+    scheduler.onFinished([&](int, const QString& url, const HttpResponse& response) {
+        QVERIFY(response.error.isEmpty());
+        ++finishedCount;
+        if (url.startsWith(base)) {
+            // Only the local file can run next to a server request
+            maxSeen = qMax(maxSeen, scheduler.inFlight() + 1);
+        }
+    });
+
+    for (int i = 0; i < 4; ++i) {
+        scheduler.enqueue(base + QString("sub_%1").arg(i));
+    }
+    scheduler.enqueue(writeSubscription("per_host.txt", "data"));
+    scheduler.run();
+
+    QCOMPARE(finishedCount, 5);
+    QCOMPARE(m_requests, 4);
+    QVERIFY(maxSeen <= 2);
+}
+
+void TestDownloadScheduler::testEnqueueWhileRunning() {
+    DownloadScheduler scheduler(2, 5000);
+    const QString nested = writeSubscription("nested.txt", "nested");
+
+    QList<QByteArray> bodies;
+    scheduler.onFinished([&](int id, const QString&, const HttpResponse& response) {
+        bodies.append(response.data);
+        if (id == 0) {
+            QCOMPARE(scheduler.enqueue(nested), 1);
+        }
+    });
+
+    scheduler.enqueue(writeSubscription("index.txt", "index"));
+    scheduler.run();
+
+    QCOMPARE(bodies, QList<QByteArray>({"index", "nested"}));
+    QCOMPARE(scheduler.pending(), 0);
+}
+
+void TestDownloadScheduler::testDeadlineCancelsRemainingJobs() {
+    // Neither request is ever answered; the second one never gets a slot
+    serve({0, 0});
+    DownloadScheduler scheduler(1, 30000);
+    scheduler.setDeadline(QDeadlineTimer(300));
+
+    QList<HttpResponse> responses;
+    scheduler.onFinished([&](int, const QString&, const HttpResponse& response) {
+        responses.append(response);
+    });
+    const QString base = QString("http://127.0.0.1:%1/").arg(m_server.serverPort());
+    scheduler.enqueue(base + "slow");
+    scheduler.enqueue(base + "queued");
+
+    QElapsedTimer timer;
+    timer.start();
+    scheduler.run();
+    QVERIFY(timer.elapsed() < 10000);
+
+    QCOMPARE(responses.size(), 2);
+    for (const HttpResponse& response : responses) {
+        QVERIFY(response.cancelled);
+        QVERIFY(!response.error.isEmpty());
+        QCOMPARE(response.bytesReceived, qint64(0));
+    }
+    QCOMPARE(scheduler.cancelled(), 2);
+    QCOMPARE(scheduler.inFlight(), 0);
+
+    // Work queued after the deadline is cancelled without a request
+    const int requests = m_requests;
+    scheduler.enqueue(writeSubscription("late.txt", "late"));
+    scheduler.run();
+    QCOMPARE(responses.size(), 3);
+    QVERIFY(responses.last().cancelled);
+    QCOMPARE(m_requests, requests);
+    QCOMPARE(scheduler.pending(), 0);
+}
+
+QTEST_MAIN(TestDownloadScheduler)
@@ -0,0 +1,94 @@
+#include <QTest>
+#include <QCoreApplication>
+#include <QTemporaryDir>
+
+#include "FetchCache.h"
+
+class TestFetchCache : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void testStoreAndLookup();
+    void testValidatorsHeaders();
+    void testStoreWithoutValidators();
+    void testRemove();
+    void testMissingEntry();
+
+private:
+    QTemporaryDir m_tempDir;
+};
+
+void TestFetchCache::initTestCase() {
+    QVERIFY(m_tempDir.isValid());
+}
+
+void TestFetchCache::cleanupTestCase() {
+    // Clean up will be handled by QTemporaryDir destructor
+}
+
+void TestFetchCache::testStoreAndLookup() {
+    FetchCache cache(m_tempDir.filePath("cache"));
+    const QString url = "https://raw.githubusercontent.com/example/sub.txt";
+
+    QVERIFY(cache.store(url, "\"abc123\"", "Wed, 21 Oct 2015 07:28:00 GMT", "vmess://body"));
+
+    FetchCache::Entry entry = cache.lookup(url);
+    QVERIFY(entry.isValid());
+    QVERIFY(entry.hasValidators());
+    QCOMPARE(entry.url, url);
+    QCOMPARE(entry.etag, QByteArray("\"abc123\""));
+    QCOMPARE(entry.lastModified, QByteArray("Wed, 21 Oct 2015 07:28:00 GMT"));
+    QCOMPARE(entry.size, qint64(12));
+
+    QByteArray body;
+    QVERIFY(cache.loadBody(url, body));
+    QCOMPARE(body, QByteArray("vmess://body"));
+}
+
+void TestFetchCache::testValidatorsHeaders() {
+    FetchCache::Entry entry;
+    entry.url = "https://example.com";
+    entry.etag = "\"v1\"";
+    entry.lastModified = "Wed, 21 Oct 2015 07:28:00 GMT";
+
+    HttpRequestOptions options;
+    FetchCache::addValidators(entry, options);
+
+    QCOMPARE(options.headers.size(), 2);
+    QCOMPARE(options.headers[0].first, QByteArray("If-None-Match"));
+    QCOMPARE(options.headers[0].second, QByteArray("\"v1\""));
+    QCOMPARE(options.headers[1].first, QByteArray("If-Modified-Since"));
+}
+
+void TestFetchCache::testStoreWithoutValidators() {
+    FetchCache cache(m_tempDir.filePath("cache"));
+    const QString url = "https://example.com/no-validators.txt";
+
+    // Responses without ETag or Last-Modified cannot be revalidated and are not stored
+    QVERIFY(!cache.store(url, QByteArray(), QByteArray(), "body"));
+    QVERIFY(!cache.lookup(url).isValid());
+}
+
+void TestFetchCache::testRemove() {
+    FetchCache cache(m_tempDir.filePath("cache"));
+    const QString url = "https://example.com/remove.txt";
+
+    QVERIFY(cache.store(url, "\"etag\"", QByteArray(), "body"));
+    QVERIFY(cache.lookup(url).isValid());
+
+    QVERIFY(cache.remove(url));
+    QVERIFY(!cache.lookup(url).isValid());
+}
+
+void TestFetchCache::testMissingEntry() {
+    FetchCache cache(m_tempDir.filePath("empty_cache"));
+    QVERIFY(!cache.lookup("https://example.com/unknown").isValid());
+
+    QByteArray body;
+    QVERIFY(!cache.loadBody("https://example.com/unknown", body));
+}
+
+QTEST_MAIN(TestFetchCache)
@@ -20,6 +20,8 @@ private slots:
     void testTimeoutHandling();
     void testInvalidUrl();
     void testNetworkManagerCleanup();
+    void testSharedClientReusesManager();
+    void testRequestOptions();
 
 private:
     QNetworkAccessManager* m_networkManager;
@@ -103,4 +105,33 @@ void TestHttpHelper::testNetworkManagerCleanup() {
     // (In real scenario, would need memory leak detection tools)
 }
 
+void TestHttpHelper::testSharedClientReusesManager() {
+    // The shared client must hand out the same manager so connections are pooled
+    QNetworkAccessManager* first = HttpHelper::shared().manager();
+    QNetworkAccessManager* second = HttpHelper::shared().manager();
+    QVERIFY(first != nullptr);
+    QVERIFY(first == second);
+
+    // Separate clients keep separate pools
+    HttpHelper client;
+    QVERIFY(client.manager() != first);
+}
+
+void TestHttpHelper::testRequestOptions() {
+    HttpRequestOptions options;
+    options.timeoutMs = 1234;
+    options.headers.append(qMakePair(QByteArray("X-Test"), QByteArray("value")));
+
+    QNetworkRequest request = HttpHelper::buildRequest("https://example.com/sub.txt", options);
+    QCOMPARE(request.url(), QUrl("https://example.com/sub.txt"));
+    QCOMPARE(request.transferTimeout(), 1234);
+    QCOMPARE(request.rawHeader("X-Test"), QByteArray("value"));
+    QVERIFY(request.attribute(QNetworkRequest::Http2AllowedAttribute).toBool());
+
+    // Without an explicit timeout the configured request timeout is used
+    QNetworkRequest defaults = HttpHelper::buildRequest("https://example.com", HttpRequestOptions());
+    QCOMPARE(defaults.transferTimeout(), HttpHelper::defaultTimeout());
+    QVERIFY(HttpHelper::defaultTimeout() > 0);
+}
+
 QTEST_MAIN(TestHttpHelper)
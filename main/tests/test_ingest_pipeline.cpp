@@ -0,0 +1,211 @@
+#include <QTest>
+#include <QCoreApplication>
+#include <QThread>
+#include <memory>
+
+#include "RingBuffer.h"
+#include "IngestPipeline.h"
+
+class TestIngestPipeline : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void testRingFullAndEmpty();
+    void testRingAcrossThreads();
+    void testChunksCoalescedInOrder();
+    void testRestartDropsPendingChunks();
+    void testBackpressure();
+    void testPostBackRunsOnPostingThread();
+    void testSyncKeepsThreadRunning();
+};
+
+void TestIngestPipeline::initTestCase() {
+    // Setup test data
+}
+
+void TestIngestPipeline::cleanupTestCase() {
+    // Cleanup test data
+}
+
+void TestIngestPipeline::testRingFullAndEmpty() {
+    SpscRing<int> ring(3);
+    QCOMPARE(ring.capacity(), qsizetype(4));
+    QVERIFY(ring.isEmpty());
+
+    for (int i = 0; i < 4; ++i) {
+        int value = i;
+        QVERIFY(ring.tryPush(std::move(value)));
+    }
+    int extra = 99;
+    QVERIFY(!ring.tryPush(std::move(extra)));
+    QCOMPARE(extra, 99);
+    QCOMPARE(ring.size(), qsizetype(4));
+
+    int value = -1;
+    for (int i = 0; i < 4; ++i) {
+        QVERIFY(ring.tryPop(value));
+        QCOMPARE(value, i);
+    }
+    QVERIFY(!ring.tryPop(value));
+
+    // Popped slots drop their payload
+    SpscRing<std::shared_ptr<int>> owners(2);
+    auto shared = std::make_shared<int>(7);
+    std::shared_ptr<int> copy = shared;
+    QVERIFY(owners.tryPush(std::move(copy)));
+    std::shared_ptr<int> popped;
+    QVERIFY(owners.tryPop(popped));
+    popped.reset();
+    QCOMPARE(shared.use_count(), long(1));
+}
+
+void TestIngestPipeline::testRingAcrossThreads() {
+    SpscRing<quint64> ring(64);
+    const quint64 count = 200000;
+    quint64 sum = 0;
+    bool ordered = true;
+
+    std::unique_ptr<QThread> consumer(QThread::create([&]() {
+        quint64 expected = 0;
+        for (quint64 i = 0; i < count; ++i) {
+            quint64 value = 0;
+            ring.pop(value);
+            ordered = ordered && value == expected++;
+            sum += value;
+        }
+    }));
+    consumer->start();
+    for (quint64 i = 0; i < count; ++i) {
+        quint64 value = i;
+        ring.push(std::move(value));
+    }
+    QVERIFY(consumer->wait(30000));
+
+    QVERIFY(ordered);
+    QCOMPARE(sum, count * (count - 1) / 2);
+    QVERIFY(ring.isEmpty());
+}
+
+void TestIngestPipeline::testChunksCoalescedInOrder() {
+    QList<QPair<int, QByteArray>> seen;
+    QList<QString> finished;
+    IngestPipeline ingest(16, 8);
+    ingest.onMessage([&](IngestPipeline::Message &message) {
+        switch (message.type) {
+        case IngestPipeline::Message::Type::Chunk:
+            seen.append({message.id, message.data});
+            break;
+        case IngestPipeline::Message::Type::Finished:
+            finished.append(message.text);
+            break;
+        default:
+            break;
+        }
+    });
+    ingest.start();
+
+    ingest.chunk(1, "abc");
+    ingest.chunk(2, "xy");
+    ingest.chunk(1, "defgh");      // reaches 8 bytes: posted
+    ingest.chunk(2, "z");
+    HttpResponse response;
+    ingest.finished(2, "https://example.com/2", response);
+    ingest.chunk(1, "tail");
+    ingest.finish();
+
+    QCOMPARE(seen.size(), 3);
+    QCOMPARE(seen[0], qMakePair(1, QByteArray("abcdefgh")));
+    QCOMPARE(seen[1], qMakePair(2, QByteArray("xyz")));
+    QCOMPARE(seen[2], qMakePair(1, QByteArray("tail")));
+    QCOMPARE(finished, QList<QString>{"https://example.com/2"});
+}
+
+void TestIngestPipeline::testRestartDropsPendingChunks() {
+    QByteArray body;
+    int restarts = 0;
+    IngestPipeline ingest(16, 1024);
+    ingest.onMessage([&](IngestPipeline::Message &message) {
+        if (message.type == IngestPipeline::Message::Type::Restart) {
+            ++restarts;
+            body.clear();
+        } else if (message.type == IngestPipeline::Message::Type::Chunk) {
+            body += message.data;
+        }
+    });
+    ingest.start();
+
+    ingest.chunk(0, "half of the first attempt");
+    ingest.restart(0);
+    ingest.chunk(0, "second attempt");
+    ingest.finished(0, "https://example.com", HttpResponse());
+    ingest.finish();
+
+    QCOMPARE(restarts, 1);
+    QCOMPARE(body, QByteArray("second attempt"));
+}
+
+void TestIngestPipeline::testBackpressure() {
+    // A slow handler and a tiny ring: the poster has to wait, nothing is lost
+    int handled = 0;
+    IngestPipeline ingest(2, 1);
+    ingest.onMessage([&handled](IngestPipeline::Message &) {
+        QThread::msleep(2);
+        ++handled;
+    });
+    ingest.start();
+    for (int i = 0; i < 50; ++i) {
+        ingest.chunk(i % 3, "x");
+    }
+    ingest.finish();
+
+    QCOMPARE(handled, 50);
+    QCOMPARE(ingest.messages(), qint64(51));   // plus the stop message
+    QVERIFY(ingest.stalls() > 0);
+}
+
+void TestIngestPipeline::testPostBackRunsOnPostingThread() {
+    QThread *poster = QThread::currentThread();
+    QList<QThread*> ranOn;
+    IngestPipeline ingest(4, 1);
+    ingest.onMessage([&](IngestPipeline::Message &) {
+        ingest.postBack([&ranOn]() { ranOn.append(QThread::currentThread()); });
+    });
+    ingest.start();
+    for (int i = 0; i < 20; ++i) {
+        ingest.chunk(0, "x");
+    }
+    ingest.finish();
+
+    QCOMPARE(ranOn.size(), 20);
+    for (QThread *thread : ranOn) {
+        QCOMPARE(thread, poster);
+    }
+}
+
+void TestIngestPipeline::testSyncKeepsThreadRunning() {
+    int handled = 0;
+    int postedBack = 0;
+    IngestPipeline ingest(4, 1024);
+    ingest.onMessage([&](IngestPipeline::Message &) {
+        QThread::msleep(1);
+        ++handled;
+        ingest.postBack([&postedBack]() { ++postedBack; });
+    });
+    ingest.start();
+
+    for (int round = 1; round <= 3; ++round) {
+        ingest.chunk(0, "buffered until sync");
+        ingest.localFile(1, "sub.txt");
+        ingest.sync();
+        // Everything posted so far was handled and its tasks ran
+        QCOMPARE(handled, round * 2);
+        QCOMPARE(postedBack, round * 2);
+    }
+    ingest.finish();
+    QCOMPARE(handled, 6);
+}
+
+QTEST_MAIN(TestIngestPipeline)
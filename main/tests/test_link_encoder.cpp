@@ -0,0 +1,254 @@
+#include <QTest>
+#include <QCoreApplication>
+#include <QTemporaryDir>
+#include <QUrl>
+
+#include "LinkEncoder.h"
+#include "ConfigStore.h"
+#include "ConfigWriter.h"
+#include "SubParser.h"
+#include "Utils.h"
+
+class TestLinkEncoder : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void testRoundTrip();
+    void testCanonicalForm();
+    void testStoreMatchesBeans();
+    void testLinksFile();
+
+private:
+    QList<std::shared_ptr<ProxyBean>> sampleBeans() const;
+    static QJsonObject withoutSource(QJsonObject json);
+    static std::shared_ptr<ProxyBean> parseLink(const QString &link);
+
+    QTemporaryDir m_dir;
+};
+
+void TestLinkEncoder::initTestCase() {
+    QVERIFY(m_dir.isValid());
+}
+
+void TestLinkEncoder::cleanupTestCase() {
+    // Clean up will be handled by QTemporaryDir destructor
+}
+
+QJsonObject TestLinkEncoder::withoutSource(QJsonObject json) {
+    // Links do not carry the subscription
+    json.remove("source");
+    return json;
+}
+
+std::shared_ptr<ProxyBean> TestLinkEncoder::parseLink(const QString &link) {
+    // Through the public parser, as the tester's input would be read back
+    const auto beans = SubParser::ParseSubscription(link);
+    return beans.size() == 1 ? beans.first() : nullptr;
+}
+
+QList<std::shared_ptr<ProxyBean>> TestLinkEncoder::sampleBeans() const {
+    QList<std::shared_ptr<ProxyBean>> beans;
+
+    auto vmess = std::make_shared<VMessBean>();
+    vmess->type = ProxyType::VMess;
+    vmess->name = QString::fromUtf8("\xF0\x9F\x87\xA9\xF0\x9F\x87\xAA Germany");
+    vmess->serverAddress = "vmess.example.com";
+    vmess->serverPort = 443;
+    vmess->uuid = "12345678-1234-1234-1234-123456789012";
+    vmess->aid = 2;
+    vmess->security = "aes-128-gcm";
+    vmess->network = "ws";
+    vmess->tls = "tls";
+    vmess->path = "/ray?ed=2048";
+    beans.append(vmess);
+
+    auto ss = std::make_shared<ShadowSocksBean>();
+    ss->type = ProxyType::Shadowsocks;
+    ss->name = "SS #1";
+    ss->serverAddress = "1.2.3.4";
+    ss->serverPort = 8388;
+    ss->method = "chacha20-ietf-poly1305";
+    ss->password = "p@ss:word";
+    beans.append(ss);
+
+    auto trojan = std::make_shared<TrojanVLESSBean>();
+    trojan->type = ProxyType::Trojan;
+    trojan->name = "Trojan";
+    trojan->serverAddress = "2001:db8::1";
+    trojan->serverPort = 443;
+    trojan->password = "pass word&more";
+    trojan->network = "ws";
+    trojan->security = "tls";
+    trojan->sni = "cdn.example.com";
+    trojan->host = "cdn.example.com";
+    trojan->path = "/ws";
+    beans.append(trojan);
+
+    auto vless = std::make_shared<TrojanVLESSBean>();
+    vless->type = ProxyType::VLESS;
+    vless->name = "VLESS";
+    vless->serverAddress = "vless.example.com";
+    vless->serverPort = 8443;
+    vless->password = "uuid";
+    vless->flow = "xtls-rprx-vision";
+    vless->network = "grpc";
+    vless->security = "reality";
+    vless->path = "grpc-service";
+    beans.append(vless);
+
+    auto socks = std::make_shared<SocksHttpBean>();
+    socks->type = ProxyType::Socks;
+    socks->name = "Socks";
+    socks->serverAddress = "socks.example.com";
+    socks->serverPort = 1080;
+    socks->username = "user";
+    beans.append(socks);
+
+    auto http = std::make_shared<SocksHttpBean>();
+    http->type = ProxyType::Http;
+    http->serverAddress = "http.example.com";
+    http->serverPort = 8080;
+    http->username = "user";
+    http->password = "pass";
+    beans.append(http);
+
+    auto hy2 = std::make_shared<Hysteria2Bean>();
+    hy2->type = ProxyType::Hysteria2;
+    hy2->name = "Hy2";
+    hy2->serverAddress = "hy2.example.com";
+    hy2->serverPort = 443;
+    hy2->password = "user:pass";
+    hy2->sni = "hy2.example.com";
+    hy2->obfs = "salamander";
+    hy2->obfsPassword = "cry";
+    hy2->insecure = true;
+    beans.append(hy2);
+
+    auto tuic = std::make_shared<TuicBean>();
+    tuic->type = ProxyType::Tuic;
+    tuic->name = "TUIC";
+    tuic->serverAddress = "tuic.example.com";
+    tuic->serverPort = 443;
+    tuic->uuid = "12345678-1234-1234-1234-123456789012";
+    tuic->password = "pw";
+    tuic->congestionControl = "bbr";
+    tuic->alpn = "h3";
+    tuic->insecure = true;
+    beans.append(tuic);
+
+    auto ssr = std::make_shared<ShadowSocksRBean>();
+    ssr->type = ProxyType::ShadowsocksR;
+    ssr->name = QString::fromUtf8("SSR \xF0\x9F\x87\xAF\xF0\x9F\x87\xB5");
+    ssr->serverAddress = "ssr.example.com";
+    ssr->serverPort = 8989;
+    ssr->method = "aes-256-cfb";
+    ssr->password = "pw";
+    ssr->protocol = "auth_aes128_md5";
+    ssr->protocolParam = "32:abc";
+    ssr->obfs = "tls1.2_ticket_auth";
+    ssr->obfsParam = "cdn.example.com";
+    beans.append(ssr);
+
+    auto wg = std::make_shared<WireGuardBean>();
+    wg->type = ProxyType::WireGuard;
+    wg->name = "WG";
+    wg->serverAddress = "162.159.192.1";
+    wg->serverPort = 2408;
+    wg->privateKey = "cHJpdmF0ZS9rZXk+Cg==";
+    wg->publicKey = "cHVibGljK2tleQo=";
+    wg->localAddress = "172.16.0.2/32,fd01::2/128";
+    wg->reserved = "1,2,3";
+    wg->mtu = 1280;
+    beans.append(wg);
+
+    for (const auto &bean : beans) {
+        bean->source = "https://example.com/sub.txt";
+    }
+    return beans;
+}
+
+void TestLinkEncoder::testRoundTrip() {
+    for (const auto &bean : sampleBeans()) {
+        const QString link = bean->ToLink();
+        QVERIFY2(!link.isEmpty(), ProxyTypeName(bean->type));
+        QVERIFY2(link.startsWith(QLatin1String(LinkEncoder::Scheme(bean->type)) + "://"), qPrintable(link));
+
+        auto parsed = parseLink(link);
+        QVERIFY2(parsed, qPrintable(link));
+        QCOMPARE(parsed->type, bean->type);
+        QCOMPARE(withoutSource(parsed->ToJson()), withoutSource(bean->ToJson()));
+        // Already canonical
+        QCOMPARE(parsed->ToLink(), link);
+    }
+
+    // No server, no link
+    TrojanVLESSBean empty;
+    empty.type = ProxyType::Trojan;
+    QVERIFY(empty.ToLink().isEmpty());
+}
+
+void TestLinkEncoder::testCanonicalForm() {
+    // Parameters sorted, unknown ones dropped, host lower-cased, name re-encoded
+    auto bean = parseLink(
+        "trojan://pw@Node.Example.COM:443?utm_source=feed&type=tcp&sni=a.example.com&security=tls#My+node%20%F0%9F%9A%80");
+    QVERIFY(bean);
+    const QString name = bean->name;
+    QCOMPARE(bean->ToLink(), QString("trojan://pw@node.example.com:443?security=tls&sni=a.example.com&type=tcp#")
+                                 + QString::fromLatin1(QUrl::toPercentEncoding(name)));
+
+    // Spelling differences do not survive
+    auto other = parseLink(
+        "trojan://pw@node.example.com:443?security=tls&type=tcp&sni=a.example.com#" +
+        QString::fromLatin1(QUrl::toPercentEncoding(name)));
+    QVERIFY(other);
+    QCOMPARE(other->ToLink(), bean->ToLink());
+
+    QByteArray out;
+    LinkEncoder::AppendPercentEncoded(out, QByteArrayView("a b/c~d-_.e%"));
+    QCOMPARE(out, QByteArray("a%20b%2Fc~d-_.e%25"));
+}
+
+void TestLinkEncoder::testStoreMatchesBeans() {
+    const auto beans = sampleBeans();
+    ConfigStore store;
+    for (const auto &bean : beans) {
+        QVERIFY(store.append(*bean) >= 0);
+    }
+    for (qsizetype row = 0; row < store.size(); ++row) {
+        QCOMPARE(LinkEncoder::Encode(store, row), LinkEncoder::Encode(*beans[row]));
+    }
+}
+
+void TestLinkEncoder::testLinksFile() {
+    const auto beans = sampleBeans();
+    ConfigStore store;
+    for (const auto &bean : beans) {
+        QVERIFY(store.append(*bean) >= 0);
+    }
+    // The same config from another subscription gives the same link
+    beans[0]->source = "https://mirror.example.com/sub.txt";
+    QVERIFY(store.append(*beans[0]) >= 0);
+
+    const QString path = m_dir.filePath("links.txt");
+    ConfigWriter writer(ConfigWriter::Format::Links);
+    QVERIFY(writer.open(path));
+    for (qsizetype row = 0; row < store.size(); ++row) {
+        QVERIFY(writer.write(store, row));
+    }
+    QVERIFY(writer.write(*beans[1]));
+    QVERIFY(writer.commit());
+    QCOMPARE(writer.count(), qsizetype(beans.size()));
+
+    QByteArray data;
+    QVERIFY(Utils::readFile(path, data));
+    const QList<QByteArray> lines = data.trimmed().split('\n');
+    QCOMPARE(lines.size(), beans.size());
+    for (qsizetype i = 0; i < lines.size(); ++i) {
+        QCOMPARE(lines[i], LinkEncoder::Encode(*beans[i]));
+    }
+}
+
+QTEST_MAIN(TestLinkEncoder)
@@ -0,0 +1,131 @@
+#include <QTest>
+#include <QCoreApplication>
+#include <QTemporaryDir>
+#include <QFile>
+
+#include "MappedFile.h"
+
+class TestMappedFile : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void testLines();
+    void testEmptyAndMissing();
+    void testLinesAcrossWindows();
+    void testBlocksEndOnLineBreaks();
+
+private:
+    QString writeFile(const QString &name, const QByteArray &content);
+    static QList<QByteArray> readLines(const QString &path, qint64 window);
+    QTemporaryDir m_dir;
+};
+
+void TestMappedFile::initTestCase() {
+    // Setup test data
+    QVERIFY(m_dir.isValid());
+}
+
+void TestMappedFile::cleanupTestCase() {
+    // Cleanup test data
+}
+
+QString TestMappedFile::writeFile(const QString &name, const QByteArray &content) {
+    const QString path = m_dir.filePath(name);
+    QFile file(path);
+    if (file.open(QIODevice::WriteOnly)) {
+        file.write(content);
+    }
+    return path;
+}
+
+QList<QByteArray> TestMappedFile::readLines(const QString &path, qint64 window) {
+    QList<QByteArray> lines;
+    MappedFile file(window);
+    if (!file.open(path)) {
+        return lines;
+    }
+    QByteArrayView line;
+    while (file.readLine(line)) {
+        lines.append(line.toByteArray());
+    }
+    return lines;
+}
+
+void TestMappedFile::testLines() {
+    const QString path = writeFile("lines.txt", "vmess://a\r\nss://b\n\ntrojan://c");
+    QCOMPARE(readLines(path, MappedFile::DefaultWindow),
+             (QList<QByteArray>{"vmess://a", "ss://b", "", "trojan://c"}));
+
+    MappedFile file;
+    QVERIFY(file.open(path));
+    QCOMPARE(file.size(), qint64(29));
+    QByteArrayView line;
+    QVERIFY(file.readLine(line));
+    QCOMPARE(file.position(), qint64(11));
+    while (file.readLine(line)) {
+    }
+    QVERIFY(file.atEnd());
+    QVERIFY(file.errorString().isEmpty());
+}
+
+void TestMappedFile::testEmptyAndMissing() {
+    MappedFile empty;
+    QVERIFY(empty.open(writeFile("empty.txt", QByteArray())));
+    QByteArrayView view;
+    QVERIFY(!empty.readLine(view));
+    QVERIFY(!empty.readBlock(view));
+    QVERIFY(empty.errorString().isEmpty());
+
+    MappedFile missing;
+    QVERIFY(!missing.open(m_dir.filePath("missing.txt")));
+    QVERIFY(!missing.errorString().isEmpty());
+}
+
+void TestMappedFile::testLinesAcrossWindows() {
+    // Lines straddle the 4 KiB window, and one is longer than several windows
+    QList<QByteArray> expected;
+    QByteArray content;
+    for (int i = 0; i < 300; ++i) {
+        QByteArray line = QByteArray("ss://line-") + QByteArray::number(i) + QByteArray(i % 37, 'x');
+        if (i == 150) {
+            line += QByteArray(20000, 'y');
+        }
+        expected.append(line);
+        content += line + '\n';
+    }
+    const QString path = writeFile("windows.txt", content);
+
+    QCOMPARE(readLines(path, 4096), expected);
+    QCOMPARE(readLines(path, MappedFile::DefaultWindow), expected);
+}
+
+void TestMappedFile::testBlocksEndOnLineBreaks() {
+    QByteArray content;
+    for (int i = 0; i < 2000; ++i) {
+        content += "vless://" + QByteArray::number(i) + "@example.com:443\n";
+    }
+    content += "tail-without-newline";
+    const QString path = writeFile("blocks.txt", content);
+
+    MappedFile file(4096);
+    QVERIFY(file.open(path));
+    QByteArray joined;
+    QByteArrayView block;
+    int blocks = 0;
+    while (file.readBlock(block)) {
+        ++blocks;
+        QVERIFY(block.size() <= 4096);
+        if (!file.atEnd()) {
+            QVERIFY(block.endsWith('\n'));
+        }
+        joined += block;
+    }
+    QVERIFY(blocks > 1);
+    QCOMPARE(joined, content);
+    QVERIFY(file.errorString().isEmpty());
+}
+
+QTEST_MAIN(TestMappedFile)
@@ -0,0 +1,100 @@
+#include <QTest>
+#include <QCoreApplication>
+#include <QThreadPool>
+
+#include "ParseArena.h"
+#include "SubParser.h"
+
+class TestParseArena : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void testMakeUsesCurrentArena();
+    void testScopesNest();
+    void testBeansKeepArenaAlive();
+    void testParserResultsUnchanged();
+};
+
+void TestParseArena::initTestCase() {
+    // Setup test data
+}
+
+void TestParseArena::cleanupTestCase() {
+    // Cleanup test data
+}
+
+void TestParseArena::testMakeUsesCurrentArena() {
+    QVERIFY(!ParseArena::Current());
+    auto heap = ParseArena::Make<VMessBean>();
+    QVERIFY(heap);
+
+    auto arena = std::make_shared<ParseArena>();
+    {
+        ParseArena::Scope scope(arena);
+        QCOMPARE(ParseArena::Current(), arena);
+        auto bean = ParseArena::Make<ShadowSocksBean>();
+        bean->method = "aes-256-gcm";
+        QVERIFY(arena->bytesAllocated() >= sizeof(ShadowSocksBean));
+        QCOMPARE(quintptr(bean.get()) % alignof(ShadowSocksBean), quintptr(0));
+    }
+    QVERIFY(!ParseArena::Current());
+}
+
+void TestParseArena::testScopesNest() {
+    auto outer = std::make_shared<ParseArena>();
+    auto inner = std::make_shared<ParseArena>();
+    ParseArena::Scope outerScope(outer);
+    {
+        ParseArena::Scope innerScope(inner);
+        ParseArena::Make<TrojanVLESSBean>();
+        QCOMPARE(ParseArena::Current(), inner);
+    }
+    QCOMPARE(ParseArena::Current(), outer);
+    QVERIFY(inner->bytesAllocated() > 0);
+    QCOMPARE(outer->bytesAllocated(), size_t(0));
+}
+
+void TestParseArena::testBeansKeepArenaAlive() {
+    std::weak_ptr<ParseArena> weak;
+    QList<std::shared_ptr<ProxyBean>> beans;
+    {
+        auto arena = std::make_shared<ParseArena>();
+        weak = arena;
+        ParseArena::Scope scope(arena);
+        for (int i = 0; i < 1000; ++i) {
+            auto bean = ParseArena::Make<VMessBean>();
+            bean->serverPort = i;
+            beans.append(bean);
+        }
+    }
+    QVERIFY(!weak.expired());
+    QCOMPARE(beans.last()->serverPort, 999);
+
+    beans.clear();
+    QVERIFY(weak.expired());
+}
+
+void TestParseArena::testParserResultsUnchanged() {
+    QByteArray body;
+    for (int i = 0; i < 3000; ++i) {
+        body += "trojan://pw" + QByteArray::number(i) + "@h" + QByteArray::number(i) + ".example.com:443#n\n";
+    }
+
+    // Serial parsing rotates its arena, the pool gives each batch its own
+    const auto serial = SubParser::ParseSubscription(body, nullptr);
+    QThreadPool pool;
+    pool.setMaxThreadCount(4);
+    const auto parallel = SubParser::ParseSubscription(body, &pool);
+
+    QCOMPARE(serial.size(), 3000);
+    QCOMPARE(parallel.size(), 3000);
+    for (int i = 0; i < serial.size(); i += 250) {
+        QCOMPARE(serial[i]->serverAddress, QString("h%1.example.com").arg(i));
+        QCOMPARE(parallel[i]->serverAddress, serial[i]->serverAddress);
+    }
+}
+
+QTEST_MAIN(TestParseArena)
@@ -0,0 +1,168 @@
+#include <QTest>
+#include <QCoreApplication>
+#include <QTcpServer>
+#include <QHostAddress>
+
+#include "ReachabilityFilter.h"
+#include "ConfigStore.h"
+
+class TestReachabilityFilter : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void testOpenAndClosedPorts();
+    void testDuplicateEndpointsShareProbe();
+    void testPerHostLimit();
+    void testFilterDropsDeadRows();
+    void testTlsServerName();
+    void testUdpProtocolsKept();
+
+private:
+    static quint16 closedPort();
+    static void addTrojan(ConfigStore &store, const QString &server, int port, const QString &security);
+
+    QTcpServer m_server;
+};
+
+void TestReachabilityFilter::initTestCase() {
+    // Setup test data
+    QVERIFY(m_server.listen(QHostAddress::LocalHost));
+}
+
+void TestReachabilityFilter::cleanupTestCase() {
+    // Cleanup test data
+    m_server.close();
+}
+
+quint16 TestReachabilityFilter::closedPort() {
+    // A port that was just free; nothing listens on it any more
+    QTcpServer server;
+    server.listen(QHostAddress::LocalHost);
+    quint16 port = server.serverPort();
+    server.close();
+    return port;
+}
+
+void TestReachabilityFilter::addTrojan(ConfigStore &store, const QString &server, int port,
+                                       const QString &security) {
+    TrojanVLESSBean bean;
+    bean.type = ProxyType::Trojan;
+    bean.serverAddress = server;
+    bean.serverPort = port;
+    bean.password = "pw";
+    bean.security = security;
+    store.append(bean);
+}
+
+void TestReachabilityFilter::testOpenAndClosedPorts() {
+    ReachabilityFilter::Options options;
+    options.timeoutMs = 2000;
+    ReachabilityFilter filter(options);
+
+    int open = filter.enqueue("127.0.0.1", m_server.serverPort());
+    int closed = filter.enqueue("127.0.0.1", closedPort());
+    int invalid = filter.enqueue("", 443);
+    filter.run();
+
+    QVERIFY(filter.isReachable(open));
+    QVERIFY(!filter.isReachable(closed));
+    QVERIFY(!filter.isReachable(invalid));
+    QCOMPARE(filter.reachableCount(), 1);
+}
+
+void TestReachabilityFilter::testDuplicateEndpointsShareProbe() {
+    ReachabilityFilter filter(ReachabilityFilter::Options{});
+    int first = filter.enqueue("LocalHost", 1234);
+    int second = filter.enqueue("localhost", 1234);
+    int other = filter.enqueue("localhost", 1235);
+
+    QCOMPARE(first, second);
+    QVERIFY(other != first);
+    QCOMPARE(filter.probeCount(), 2);
+}
+
+void TestReachabilityFilter::testPerHostLimit() {
+    ReachabilityFilter::Options options;
+    options.perHostConcurrent = 1;
+    options.timeoutMs = 2000;
+    ReachabilityFilter filter(options);
+
+    QList<int> ids;
+    ids.append(filter.enqueue("127.0.0.1", m_server.serverPort()));
+    for (int i = 0; i < 5; ++i) {
+        ids.append(filter.enqueue("127.0.0.1", closedPort()));
+    }
+    filter.run();
+
+    // Every probe still completes when the host is only allowed one at a time
+    QVERIFY(filter.isReachable(ids.first()));
+    QCOMPARE(filter.reachableCount(), 1);
+}
+
+void TestReachabilityFilter::testFilterDropsDeadRows() {
+    ConfigStore store;
+    addTrojan(store, "127.0.0.1", m_server.serverPort(), "none");
+    addTrojan(store, "127.0.0.1", closedPort(), "none");
+    addTrojan(store, "127.0.0.1", m_server.serverPort(), "none");
+
+    ReachabilityFilter::Options options;
+    options.timeoutMs = 2000;
+    ReachabilityFilter filter(options);
+    const QVector<qsizetype> removed = filter.filter({&store});
+
+    QCOMPARE(removed, QVector<qsizetype>({1}));
+    QCOMPARE(store.size(), qsizetype(2));
+    QCOMPARE(store.port(1), int(m_server.serverPort()));
+    QCOMPARE(filter.probeCount(), 2);
+}
+
+void TestReachabilityFilter::testTlsServerName() {
+    ConfigStore store;
+    addTrojan(store, "trojan.example.com", 443, "");
+    addTrojan(store, "plain.example.com", 443, "none");
+
+    TrojanVLESSBean vless;
+    vless.type = ProxyType::VLESS;
+    vless.serverAddress = "1.2.3.4";
+    vless.serverPort = 443;
+    vless.security = "reality";
+    vless.sni = "www.example.com";
+    store.append(vless);
+
+    ShadowSocksBean ss;
+    ss.type = ProxyType::Shadowsocks;
+    ss.serverAddress = "ss.example.com";
+    ss.serverPort = 8388;
+    store.append(ss);
+
+    QCOMPARE(ReachabilityFilter::TlsServerName(store, 0), QString("trojan.example.com"));
+    QVERIFY(ReachabilityFilter::TlsServerName(store, 1).isEmpty());
+    QCOMPARE(ReachabilityFilter::TlsServerName(store, 2), QString("www.example.com"));
+    QVERIFY(ReachabilityFilter::TlsServerName(store, 3).isEmpty());
+}
+
+void TestReachabilityFilter::testUdpProtocolsKept() {
+    ConfigStore store;
+    Hysteria2Bean hy2;
+    hy2.type = ProxyType::Hysteria2;
+    hy2.serverAddress = "127.0.0.1";
+    hy2.serverPort = closedPort();
+    hy2.password = "pw";
+    store.append(hy2);
+    addTrojan(store, "127.0.0.1", closedPort(), "none");
+
+    ReachabilityFilter::Options options;
+    options.timeoutMs = 2000;
+    ReachabilityFilter filter(options);
+    const QVector<qsizetype> removed = filter.filter({&store});
+
+    // A TCP connect says nothing about a QUIC server
+    QCOMPARE(removed, QVector<qsizetype>({1}));
+    QCOMPARE(store.kind(0), ConfigStore::Kind::Hysteria2);
+    QCOMPARE(filter.probeCount(), 1);
+}
+
+QTEST_MAIN(TestReachabilityFilter)
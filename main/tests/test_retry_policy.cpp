@@ -0,0 +1,129 @@
+#include <QTest>
+#include <QCoreApplication>
+
+#include "RetryPolicy.h"
+#include "HttpHelper.h"
+#include <QNetworkReply>
+
+class TestRetryPolicy : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void testBackoffBounds();
+    void testTransientClassification();
+    void testCircuitBreakerTrips();
+    void testCircuitBreakerHalfOpen();
+    void testCircuitBreakerDisabled();
+    void testLatencyPercentile();
+};
+
+void TestRetryPolicy::initTestCase() {
+    // Setup test data
+}
+
+void TestRetryPolicy::cleanupTestCase() {
+    // Cleanup test data
+}
+
+void TestRetryPolicy::testBackoffBounds() {
+    RetryPolicy policy;
+    policy.baseDelayMs = 100;
+    policy.maxDelayMs = 1000;
+    QRandomGenerator rng(3);
+
+    // Full jitter: never above the doubled ceiling, capped at the maximum
+    const int ceilings[] = {100, 200, 400, 800, 1000, 1000};
+    for (int attempt = 1; attempt <= 6; ++attempt) {
+        int highest = 0;
+        for (int i = 0; i < 500; ++i) {
+            const int delay = policy.delayMs(attempt, rng);
+            QVERIFY(delay >= 0);
+            QVERIFY(delay <= ceilings[attempt - 1]);
+            highest = qMax(highest, delay);
+        }
+        QVERIFY(highest > ceilings[attempt - 1] / 2);
+    }
+    QVERIFY(policy.delayMs(1000, rng) <= 1000);
+
+    policy.baseDelayMs = 0;
+    QCOMPARE(policy.delayMs(3, rng), 0);
+}
+
+void TestRetryPolicy::testTransientClassification() {
+    QVERIFY(HttpHelper::IsTransient(QNetworkReply::NoError, 503));
+    QVERIFY(HttpHelper::IsTransient(QNetworkReply::NoError, 429));
+    QVERIFY(HttpHelper::IsTransient(QNetworkReply::NoError, 408));
+    QVERIFY(!HttpHelper::IsTransient(QNetworkReply::ContentNotFoundError, 404));
+    QVERIFY(!HttpHelper::IsTransient(QNetworkReply::ContentAccessDenied, 403));
+    QVERIFY(HttpHelper::IsTransient(QNetworkReply::OperationCanceledError, 0));
+    QVERIFY(HttpHelper::IsTransient(QNetworkReply::RemoteHostClosedError, 0));
+    QVERIFY(!HttpHelper::IsTransient(QNetworkReply::HostNotFoundError, 0));
+    QVERIFY(!HttpHelper::IsTransient(QNetworkReply::ProtocolUnknownError, 0));
+}
+
+void TestRetryPolicy::testCircuitBreakerTrips() {
+    CircuitBreaker breaker(CircuitBreaker::Options{3, 60000});
+    breaker.recordFailure("a.example.com");
+    breaker.recordFailure("a.example.com");
+    QVERIFY(breaker.allow("a.example.com"));
+
+    // A success resets the streak
+    breaker.recordSuccess("a.example.com");
+    breaker.recordFailure("a.example.com");
+    breaker.recordFailure("a.example.com");
+    QVERIFY(breaker.allow("a.example.com"));
+
+    breaker.recordFailure("a.example.com");
+    QCOMPARE(breaker.state("a.example.com"), CircuitBreaker::State::Open);
+    QVERIFY(!breaker.allow("a.example.com"));
+    QVERIFY(breaker.allow("b.example.com"));
+    QCOMPARE(breaker.openCount(), 1);
+}
+
+void TestRetryPolicy::testCircuitBreakerHalfOpen() {
+    CircuitBreaker breaker(CircuitBreaker::Options{1, 0});
+    breaker.recordFailure("a.example.com");
+    QCOMPARE(breaker.state("a.example.com"), CircuitBreaker::State::HalfOpen);
+    QVERIFY(breaker.allow("a.example.com"));
+
+    breaker.recordSuccess("a.example.com");
+    QCOMPARE(breaker.state("a.example.com"), CircuitBreaker::State::Closed);
+
+    CircuitBreaker slow(CircuitBreaker::Options{1, 60000});
+    slow.recordFailure("a.example.com");
+    QVERIFY(!slow.allow("a.example.com"));
+}
+
+void TestRetryPolicy::testCircuitBreakerDisabled() {
+    CircuitBreaker breaker(CircuitBreaker::Options{0, 60000});
+    QVERIFY(!breaker.enabled());
+    for (int i = 0; i < 10; ++i) {
+        breaker.recordFailure("a.example.com");
+    }
+    QVERIFY(breaker.allow("a.example.com"));
+}
+
+void TestRetryPolicy::testLatencyPercentile() {
+    LatencyEstimator latency(100);
+    QCOMPARE(latency.percentile(0.95), qint64(0));
+    QCOMPARE(latency.hedgeDelay(250), qint64(250));
+
+    for (int ms = 1; ms <= 100; ++ms) {
+        latency.add(ms);
+    }
+    QCOMPARE(latency.percentile(0.95), qint64(95));
+    QCOMPARE(latency.percentile(0.5), qint64(50));
+    QCOMPARE(latency.hedgeDelay(10), qint64(95));
+    QCOMPARE(latency.hedgeDelay(500), qint64(500));
+
+    // Old samples drop out of the window
+    for (int i = 0; i < 100; ++i) {
+        latency.add(1000);
+    }
+    QCOMPARE(latency.percentile(0.5), qint64(1000));
+}
+
+QTEST_MAIN(TestRetryPolicy)
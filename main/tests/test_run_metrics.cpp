@@ -0,0 +1,112 @@
+#include <QTest>
+#include <QCoreApplication>
+#include <QTemporaryDir>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include "RunMetrics.h"
+
+class TestRunMetrics : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void testTotalsIncludeSubscriptions();
+    void testTimer();
+    void testJsonReport();
+    void testPrometheusText();
+    void testWrite();
+
+private:
+    static RunMetrics sample();
+};
+
+void TestRunMetrics::initTestCase() {
+    // Setup test data
+}
+
+void TestRunMetrics::cleanupTestCase() {
+    // Cleanup test data
+}
+
+RunMetrics TestRunMetrics::sample() {
+    RunMetrics metrics;
+    metrics.setSubscription(0, "https://a.example.com/sub");
+    metrics.setSubscription(1, "https://b.example.com/sub?x=\"q\"");
+    metrics.addTime(RunMetrics::Stage::Download, 2000000, 0);
+    metrics.addTime(RunMetrics::Stage::Download, 3000000, 1);
+    metrics.addTime(RunMetrics::Stage::Write, 1500000);
+    metrics.addCount("bytes_downloaded", 100, 0);
+    metrics.addCount("bytes_downloaded", 50, 1);
+    metrics.addParseFailures("vmess", 2, 1);
+    return metrics;
+}
+
+void TestRunMetrics::testTotalsIncludeSubscriptions() {
+    RunMetrics metrics = sample();
+    QCOMPARE(metrics.time(RunMetrics::Stage::Download), qint64(5000000));
+    QCOMPARE(metrics.time(RunMetrics::Stage::Download, 1), qint64(3000000));
+    QCOMPARE(metrics.time(RunMetrics::Stage::Write, 0), qint64(0));
+    QCOMPARE(metrics.count("bytes_downloaded"), qint64(150));
+    QCOMPARE(metrics.count("bytes_downloaded", 0), qint64(100));
+    QCOMPARE(metrics.parseFailures("vmess"), qint64(2));
+    QCOMPARE(metrics.count("missing", 7), qint64(0));
+
+    // Unobserved phases are passed as -1 and ignored
+    metrics.addTime(RunMetrics::Stage::Connect, -1, 0);
+    QCOMPARE(metrics.time(RunMetrics::Stage::Connect), qint64(0));
+}
+
+void TestRunMetrics::testTimer() {
+    RunMetrics metrics;
+    {
+        RunMetrics::Timer timer(metrics, RunMetrics::Stage::Dedup, 3);
+        QTest::qWait(5);
+    }
+    QVERIFY(metrics.time(RunMetrics::Stage::Dedup, 3) >= 5000000);
+    QCOMPARE(metrics.time(RunMetrics::Stage::Dedup), metrics.time(RunMetrics::Stage::Dedup, 3));
+}
+
+void TestRunMetrics::testJsonReport() {
+    const QJsonObject report = sample().toJson();
+    QCOMPARE(report["version"].toInt(), 1);
+    QCOMPARE(report["stagesMs"].toObject()["download"].toDouble(), 5.0);
+    QCOMPARE(report["stagesMs"].toObject()["write"].toDouble(), 1.5);
+    QCOMPARE(report["counts"].toObject()["bytes_downloaded"].toInteger(), qint64(150));
+
+    const QJsonArray subscriptions = report["subscriptions"].toArray();
+    QCOMPARE(subscriptions.size(), 2);
+    QCOMPARE(subscriptions[0].toObject()["url"].toString(), QString("https://a.example.com/sub"));
+    QCOMPARE(subscriptions[1].toObject()["parseFailures"].toObject()["vmess"].toInteger(), qint64(2));
+}
+
+void TestRunMetrics::testPrometheusText() {
+    const QByteArray text = sample().toPrometheus();
+    QVERIFY(text.contains("# TYPE configcollector_stage_seconds gauge\n"));
+    QVERIFY(text.contains("configcollector_stage_seconds{stage=\"download\"} 0.005000\n"));
+    QVERIFY(text.contains("configcollector_stage_seconds{stage=\"download\",subscription=\"https://a.example.com/sub\"} 0.002000\n"));
+    QVERIFY(text.contains("configcollector_bytes_downloaded 150\n"));
+    // Quotes in label values are escaped
+    QVERIFY(text.contains("configcollector_parse_failures{protocol=\"vmess\","
+                          "subscription=\"https://b.example.com/sub?x=\\\"q\\\"\"} 2\n"));
+    QVERIFY(text.contains("configcollector_run_seconds "));
+}
+
+void TestRunMetrics::testWrite() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QString error;
+    QVERIFY(sample().write(dir.path(), &error));
+    QVERIFY(error.isEmpty());
+
+    QFile report(dir.filePath("run_report.json"));
+    QVERIFY(report.open(QIODevice::ReadOnly));
+    QVERIFY(QJsonDocument::fromJson(report.readAll()).isObject());
+    QVERIFY(QFile::exists(dir.filePath("metrics.prom")));
+}
+
+QTEST_MAIN(TestRunMetrics)
@@ -0,0 +1,203 @@
+#include <QTest>
+#include <QCoreApplication>
+#include <QTemporaryDir>
+#include <QThreadPool>
+#include <QFile>
+#include <QDir>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+
+#include "ShardedWriter.h"
+#include "ConfigStore.h"
+
+class TestShardedWriter : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void testCountryCode();
+    void testParseKeys();
+    void testProtocolAndCountryShards();
+    void testParallelMatchesSerial();
+    void testSourceDocument();
+
+private:
+    ConfigStore sampleStore() const;
+    static QList<QByteArray> lines(const QString &path);
+    QTemporaryDir m_dir;
+};
+
+void TestShardedWriter::initTestCase() {
+    // Setup test data
+    QVERIFY(m_dir.isValid());
+}
+
+void TestShardedWriter::cleanupTestCase() {
+    // Cleanup test data
+}
+
+ConfigStore TestShardedWriter::sampleStore() const {
+    ConfigStore store;
+
+    VMessBean vmess;
+    vmess.type = ProxyType::VMess;
+    vmess.name = QString::fromUtf8("\xF0\x9F\x87\xA9\xF0\x9F\x87\xAA Germany");
+    vmess.serverAddress = "vmess.example.com";
+    vmess.serverPort = 443;
+    vmess.uuid = "12345678-1234-1234-1234-123456789012";
+    store.append(vmess);
+
+    ShadowSocksBean ss;
+    ss.type = ProxyType::Shadowsocks;
+    ss.name = QString::fromUtf8("Fast \xF0\x9F\x87\xBA\xF0\x9F\x87\xB8 01");
+    ss.serverAddress = "1.2.3.4";
+    ss.serverPort = 8388;
+    ss.method = "aes-256-gcm";
+    ss.password = "pw";
+    store.append(ss);
+
+    TrojanVLESSBean trojan;
+    trojan.type = ProxyType::Trojan;
+    trojan.name = "no flag";
+    trojan.serverAddress = "trojan.example.com";
+    trojan.serverPort = 443;
+    trojan.password = "pw";
+    store.append(trojan);
+
+    ShadowSocksBean ss2 = ss;
+    ss2.name = QString::fromUtf8("\xF0\x9F\x87\xA9\xF0\x9F\x87\xAA backup");
+    ss2.serverPort = 8389;
+    store.append(ss2);
+
+    return store;
+}
+
+QList<QByteArray> TestShardedWriter::lines(const QString &path) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return {};
+    }
+    QList<QByteArray> result;
+    for (const QByteArray &line : file.readAll().split('\n')) {
+        if (!line.isEmpty()) {
+            result.append(line);
+        }
+    }
+    return result;
+}
+
+void TestShardedWriter::testCountryCode() {
+    QCOMPARE(ShardedWriter::CountryCode("\xF0\x9F\x87\xA9\xF0\x9F\x87\xAA Germany"), QString("DE"));
+    QCOMPARE(ShardedWriter::CountryCode("Node \xF0\x9F\x87\xAF\xF0\x9F\x87\xB5"), QString("JP"));
+    QCOMPARE(ShardedWriter::CountryCode("plain name"), QString("unknown"));
+    // A lone indicator is not a flag
+    QCOMPARE(ShardedWriter::CountryCode("\xF0\x9F\x87\xA9 x"), QString("unknown"));
+    QCOMPARE(ShardedWriter::CountryCode(""), QString("unknown"));
+}
+
+void TestShardedWriter::testParseKeys() {
+    QList<ShardedWriter::Key> keys;
+    QVERIFY(ShardedWriter::ParseKeys("", keys));
+    QVERIFY(keys.isEmpty());
+
+    QVERIFY(ShardedWriter::ParseKeys("protocol, Country,protocol", keys));
+    QCOMPARE(keys.size(), 2);
+    QCOMPARE(keys[0], ShardedWriter::Key::Protocol);
+    QCOMPARE(keys[1], ShardedWriter::Key::Country);
+
+    QVERIFY(!ShardedWriter::ParseKeys("protocol,planet", keys));
+}
+
+void TestShardedWriter::testProtocolAndCountryShards() {
+    const ConfigStore store = sampleStore();
+    const QString dir = m_dir.filePath("keys");
+
+    ShardedWriter writer(dir);
+    writer.route(ShardedWriter::Key::Protocol, store);
+    writer.route(ShardedWriter::Key::Country, store);
+    QCOMPARE(writer.shardCount(), qsizetype(6));
+    QVERIFY(writer.write());
+
+    QCOMPARE(lines(dir + "/protocols/shadowsocks.ndjson").size(), 2);
+    QCOMPARE(lines(dir + "/protocols/vmess.ndjson").size(), 1);
+    QCOMPARE(lines(dir + "/protocols/trojan.ndjson").size(), 1);
+    QCOMPARE(lines(dir + "/countries/DE.ndjson").size(), 2);
+    QCOMPARE(lines(dir + "/countries/US.ndjson").size(), 1);
+    QCOMPARE(lines(dir + "/countries/unknown.ndjson").size(), 1);
+
+    // Rows keep their store order inside a shard
+    const QList<QByteArray> germany = lines(dir + "/countries/DE.ndjson");
+    QCOMPARE(QJsonDocument::fromJson(germany[0]).object()["type"].toString(), QString("vmess"));
+    QCOMPARE(QJsonDocument::fromJson(germany[1]).object()["port"].toInt(), 8389);
+
+    for (const ShardedWriter::Result &result : writer.results()) {
+        QVERIFY(result.error.isEmpty());
+        QVERIFY(result.count > 0);
+    }
+}
+
+void TestShardedWriter::testParallelMatchesSerial() {
+    ConfigStore store;
+    for (int i = 0; i < 500; ++i) {
+        ShadowSocksBean ss;
+        ss.type = ProxyType::Shadowsocks;
+        ss.name = QString("node %1").arg(i);
+        ss.serverAddress = QString("10.0.%1.%2").arg(i / 250).arg(i % 250);
+        ss.serverPort = 8388;
+        ss.method = "aes-256-gcm";
+        ss.password = "pw";
+        store.append(ss);
+    }
+
+    auto build = [&store](const QString &dir) {
+        ShardedWriter writer(dir);
+        for (int i = 0; i < 20; ++i) {
+            const int shard = writer.shard(QString("part/%1.ndjson").arg(i), ConfigWriter::Format::Ndjson);
+            for (qsizetype row = i; row < store.size(); row += 20) {
+                writer.add(shard, store, row);
+            }
+        }
+        return writer;
+    };
+
+    ShardedWriter serial = build(m_dir.filePath("serial"));
+    QVERIFY(serial.write());
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(4);
+    ShardedWriter parallel = build(m_dir.filePath("parallel"));
+    QVERIFY(parallel.write(&pool));
+
+    QCOMPARE(parallel.results().size(), serial.results().size());
+    for (int i = 0; i < 20; ++i) {
+        const QString name = QString("/part/%1.ndjson").arg(i);
+        QCOMPARE(lines(m_dir.filePath("parallel") + name), lines(m_dir.filePath("serial") + name));
+        QCOMPARE(parallel.results()[i].count, qsizetype(25));
+    }
+}
+
+void TestShardedWriter::testSourceDocument() {
+    const ConfigStore store = sampleStore();
+    const QString dir = m_dir.filePath("source");
+
+    ShardedWriter writer(dir);
+    const int document = writer.shard("config_0001.json", ConfigWriter::Format::JsonDocument,
+                                      "https://example.com/sub.txt");
+    QCOMPARE(writer.shard("config_0001.json", ConfigWriter::Format::JsonDocument), document);
+    writer.addAll(document, store);
+    QVERIFY(writer.write());
+
+    QFile file(dir + "/config_0001.json");
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+    QCOMPARE(root["subscription"].toString(), QString("https://example.com/sub.txt"));
+    QCOMPARE(root["configs"].toArray().size(), 4);
+
+    // No temp files are left next to the committed output
+    QCOMPARE(QDir(dir).entryList(QDir::Files), QStringList{"config_0001.json"});
+}
+
+QTEST_MAIN(TestShardedWriter)
@@ -0,0 +1,148 @@
+#include <QTest>
+#include <QCoreApplication>
+#include <QTemporaryDir>
+
+#include "SourceHistory.h"
+#include "Utils.h"
+
+class TestSourceHistory : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void testMissingFileIsEmpty();
+    void testPrioritizeByYield();
+    void testFailureBackoff();
+    void testSuccessResetsStreak();
+    void testSaveAndLoad();
+    void testUnreadableFile();
+
+private:
+    QTemporaryDir m_tempDir;
+};
+
+void TestSourceHistory::initTestCase() {
+    QVERIFY(m_tempDir.isValid());
+}
+
+void TestSourceHistory::cleanupTestCase() {
+    // Clean up will be handled by QTemporaryDir destructor
+}
+
+void TestSourceHistory::testMissingFileIsEmpty() {
+    SourceHistory history(m_tempDir.filePath("missing.json"));
+    QVERIFY(history.load());
+    QCOMPARE(history.size(), 0);
+    QVERIFY(!history.record("https://example.com/sub").isKnown());
+    QVERIFY(!history.takeSkip("https://example.com/sub"));
+
+    // Nothing known: file order
+    QCOMPARE(history.prioritize({"a", "b", "c"}), QList<int>({0, 1, 2}));
+}
+
+void TestSourceHistory::testPrioritizeByYield() {
+    SourceHistory history(m_tempDir.filePath("order.json"));
+    history.recordSuccess("small", 100, 1000, 10, 20);
+    history.recordSuccess("large", 100, 50000, 2000, 2500);
+    history.recordSuccess("copies", 100, 50000, 0, 3000);
+    history.recordFailure("flaky");
+
+    // Unknown sources come first so they get measured, ties keep file order
+    const QList<int> order = history.prioritize({"copies", "small", "new", "flaky", "large", "other"});
+    QCOMPARE(order, QList<int>({2, 5, 4, 1, 0, 3}));
+
+    const SourceHistory::Record record = history.record("copies");
+    QCOMPARE(record.duplicateRatio, 1.0);
+    QCOMPARE(record.runs, 1);
+}
+
+void TestSourceHistory::testFailureBackoff() {
+    SourceHistory::Options options;
+    options.failureThreshold = 2;
+    options.maxSkipRuns = 4;
+    SourceHistory history(m_tempDir.filePath("backoff.json"), options);
+    const QString url = "https://dead.example.com/sub";
+
+    history.recordFailure(url);
+    QVERIFY(!history.takeSkip(url));
+
+    // Skips 1, 2, 4, 4 runs after each further failure
+    const QList<int> expected{1, 2, 4, 4};
+    for (int skips : expected) {
+        history.recordFailure(url);
+        for (int i = 0; i < skips; ++i) {
+            QVERIFY(history.takeSkip(url));
+        }
+        QVERIFY(!history.takeSkip(url));
+    }
+    QCOMPARE(history.record(url).failureStreak, 5);
+
+    // No threshold: never skipped
+    SourceHistory patient(m_tempDir.filePath("patient.json"), SourceHistory::Options{0, 8});
+    for (int i = 0; i < 10; ++i) {
+        patient.recordFailure(url);
+    }
+    QVERIFY(!patient.takeSkip(url));
+}
+
+void TestSourceHistory::testSuccessResetsStreak() {
+    SourceHistory history(m_tempDir.filePath("reset.json"), SourceHistory::Options{1, 8});
+    const QString url = "https://example.com/sub";
+    history.recordSuccess(url, 250, 4096, 100, 120);
+    history.recordFailure(url);
+    QCOMPARE(history.record(url).failureStreak, 1);
+    QCOMPARE(history.record(url).yield, 50.0);
+
+    history.recordSuccess(url, 300, 8192, 150, 150);
+    const SourceHistory::Record record = history.record(url);
+    QCOMPARE(record.failureStreak, 0);
+    QCOMPARE(record.skipRuns, 0);
+    QCOMPARE(record.yield, 100.0);
+    QCOMPARE(record.latencyMs, qint64(300));
+    QCOMPARE(record.runs, 3);
+    QVERIFY(!history.takeSkip(url));
+}
+
+void TestSourceHistory::testSaveAndLoad() {
+    const QString path = m_tempDir.filePath("history.json");
+    {
+        SourceHistory history(path);
+        history.recordSuccess("https://a.example.com/sub", 120, 2048, 40, 50);
+        for (int i = 0; i < 3; ++i) {
+            history.recordFailure("https://b.example.com/sub");
+        }
+        QVERIFY(history.save());
+    }
+
+    SourceHistory loaded(path);
+    QVERIFY(loaded.load());
+    QCOMPARE(loaded.size(), 2);
+    const SourceHistory::Record a = loaded.record("https://a.example.com/sub");
+    QCOMPARE(a.latencyMs, qint64(120));
+    QCOMPARE(a.bytes, qint64(2048));
+    QCOMPARE(a.uniqueConfigs, 40);
+    QCOMPARE(a.duplicateRatio, 0.2);
+    QVERIFY(!a.lastFetched.isEmpty());
+    QCOMPARE(loaded.record("https://b.example.com/sub").skipRuns, 1);
+
+    // Sources not seen in a run are dropped on the next save
+    QVERIFY(loaded.takeSkip("https://b.example.com/sub"));
+    QVERIFY(loaded.save());
+    SourceHistory pruned(path);
+    QVERIFY(pruned.load());
+    QCOMPARE(pruned.size(), 1);
+    QVERIFY(!pruned.record("https://a.example.com/sub").isKnown());
+    QCOMPARE(pruned.record("https://b.example.com/sub").skipRuns, 0);
+}
+
+void TestSourceHistory::testUnreadableFile() {
+    const QString path = m_tempDir.filePath("broken.json");
+    QVERIFY(Utils::writeFileText(path, "{ not json"));
+    SourceHistory history(path);
+    QVERIFY(!history.load());
+    QCOMPARE(history.size(), 0);
+}
+
+QTEST_MAIN(TestSourceHistory)
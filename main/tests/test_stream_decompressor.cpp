@@ -0,0 +1,166 @@
+#include <QTest>
+#include <QCoreApplication>
+
+#include "StreamDecompressor.h"
+
+namespace {
+
+const QByteArray Plain =
+    "trojan://pw@host.example.com:443#compressed\n"
+    "vless://12345678-1234-1234-1234-123456789012@vless.example.com:443?type=ws#v\n";
+
+// Plain, compressed with gzip -9, zstd -19 and brotli -q 11
+const QByteArray Gzipped = QByteArray::fromHex(
+    "1f8b08000000000002032b29cacf4accb3d2d72f2877c8c82f2ed14bad48cc2d"
+    "c849d54bcecfb53231315606d20545a9c5c5a9295c6539401aa8d4d0c8d8c4d4"
+    "ccdc4217c4402340e2960686460e60c5e8a6d9975416a4da96172b977101000c"
+    "e5fd2679000000");
+const QByteArray Zstded = QByteArray::fromHex(
+    "28b52ffd2479e50200740474726f6a616e3a2f2f707740686f73742e6578616d"
+    "706c652e636f6d3a34343323707265737365640a766c3a2f2f31323334353637"
+    "382d39303132403f747970653d777323760a0700514000d5e94e2b501ab05809"
+    "002881fb04069babb4");
+const QByteArray Brotlied = QByteArray::fromHex(
+    "1b78000064f09c4f74dc453aad47eae4800f887d8527a88365b1e636447ec143"
+    "a860ffbdcfb5f7b679428ebf66253c65d6d55e4a01596f56e39be1be19175269"
+    "6311ae489b1d65bc0608ef0cbb642fa5288735ff0d3f00");
+
+// Feed input in pieces of the given size, as a slow download would deliver it
+bool decodeInChunks(StreamDecompressor::Format format, const QByteArray &input, int chunkSize, QByteArray &output) {
+    StreamDecompressor decoder(format);
+    for (qsizetype i = 0; i < input.size(); i += chunkSize) {
+        if (!decoder.feed(QByteArrayView(input).mid(i, chunkSize), output)) {
+            return false;
+        }
+    }
+    return decoder.finish(output);
+}
+
+}
+
+class TestStreamDecompressor : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void testFormatNames();
+    void testDetect();
+    void testChunkedDecode_data();
+    void testChunkedDecode();
+    void testAutoPassesThroughPlainText();
+    void testTruncatedStream();
+    void testCorruptStream();
+};
+
+void TestStreamDecompressor::initTestCase() {
+    // Setup test data
+}
+
+void TestStreamDecompressor::cleanupTestCase() {
+    // Cleanup test data
+}
+
+void TestStreamDecompressor::testFormatNames() {
+    using Format = StreamDecompressor::Format;
+    QCOMPARE(StreamDecompressor::FromContentEncoding("gzip"), Format::Gzip);
+    QCOMPARE(StreamDecompressor::FromContentEncoding("x-gzip"), Format::Gzip);
+    QCOMPARE(StreamDecompressor::FromContentEncoding(" Deflate "), Format::Zlib);
+    QCOMPARE(StreamDecompressor::FromContentEncoding("zstd"), Format::Zstd);
+    QCOMPARE(StreamDecompressor::FromContentEncoding("br"), Format::Brotli);
+    QCOMPARE(StreamDecompressor::FromContentEncoding("identity"), Format::Identity);
+    QCOMPARE(StreamDecompressor::FromContentEncoding(""), Format::Identity);
+
+    QCOMPARE(StreamDecompressor::FromFileName(u"/subs/feed.txt.gz"), Format::Gzip);
+    QCOMPARE(StreamDecompressor::FromFileName(u"/subs/feed.ZST"), Format::Zstd);
+    QCOMPARE(StreamDecompressor::FromFileName(u"/subs/feed.br"), Format::Brotli);
+    QCOMPARE(StreamDecompressor::FromFileName(u"/subs/feed.txt"), Format::Auto);
+
+    // Only what this build can decode is offered
+    const QByteArray accept = StreamDecompressor::AcceptEncoding();
+    QCOMPARE(accept.contains("gzip"), StreamDecompressor::IsSupported(Format::Gzip));
+    QCOMPARE(accept.contains("zstd"), StreamDecompressor::IsSupported(Format::Zstd));
+    QCOMPARE(accept.contains("br"), StreamDecompressor::IsSupported(Format::Brotli));
+}
+
+void TestStreamDecompressor::testDetect() {
+    using Format = StreamDecompressor::Format;
+    QCOMPARE(StreamDecompressor::Detect(Gzipped), Format::Gzip);
+    QCOMPARE(StreamDecompressor::Detect(Zstded), Format::Zstd);
+    QCOMPARE(StreamDecompressor::Detect(Plain), Format::Identity);
+    QCOMPARE(StreamDecompressor::Detect(QByteArrayView(Gzipped).first(1)), Format::Identity);
+}
+
+void TestStreamDecompressor::testChunkedDecode_data() {
+    QTest::addColumn<int>("format");
+    QTest::addColumn<QByteArray>("input");
+    QTest::addColumn<int>("chunkSize");
+
+    for (int chunkSize : {1, 3, 7, 1000}) {
+        const QByteArray size = QByteArray::number(chunkSize);
+        QTest::newRow("gzip/" + size) << int(StreamDecompressor::Format::Gzip) << Gzipped << chunkSize;
+        QTest::newRow("gzip-auto/" + size) << int(StreamDecompressor::Format::Auto) << Gzipped << chunkSize;
+        QTest::newRow("zstd/" + size) << int(StreamDecompressor::Format::Zstd) << Zstded << chunkSize;
+        QTest::newRow("zstd-auto/" + size) << int(StreamDecompressor::Format::Auto) << Zstded << chunkSize;
+        QTest::newRow("brotli/" + size) << int(StreamDecompressor::Format::Brotli) << Brotlied << chunkSize;
+    }
+}
+
+void TestStreamDecompressor::testChunkedDecode() {
+    QFETCH(int, format);
+    QFETCH(QByteArray, input);
+    QFETCH(int, chunkSize);
+
+    // Auto resolves to whatever the magic bytes say
+    const auto resolved = StreamDecompressor::Format(format) == StreamDecompressor::Format::Auto
+        ? StreamDecompressor::Detect(input)
+        : StreamDecompressor::Format(format);
+    if (!StreamDecompressor::IsSupported(resolved)) {
+        QSKIP("Decoder not available in this build");
+    }
+
+    QByteArray output;
+    QVERIFY(decodeInChunks(StreamDecompressor::Format(format), input, chunkSize, output));
+    QCOMPARE(output, Plain);
+}
+
+void TestStreamDecompressor::testAutoPassesThroughPlainText() {
+    QByteArray output;
+    QVERIFY(decodeInChunks(StreamDecompressor::Format::Auto, Plain, 5, output));
+    QCOMPARE(output, Plain);
+
+    // Shorter than any magic number
+    output.clear();
+    QVERIFY(StreamDecompressor::Decode(StreamDecompressor::Format::Auto, "v", output));
+    QCOMPARE(output, QByteArray("v"));
+}
+
+void TestStreamDecompressor::testTruncatedStream() {
+    if (!StreamDecompressor::IsSupported(StreamDecompressor::Format::Gzip)) {
+        QSKIP("zlib not available in this build");
+    }
+
+    StreamDecompressor decoder(StreamDecompressor::Format::Gzip);
+    QByteArray output;
+    QVERIFY(decoder.feed(QByteArrayView(Gzipped).first(Gzipped.size() - 10), output));
+    QVERIFY(!decoder.finish(output));
+    QVERIFY(!decoder.errorString().isEmpty());
+}
+
+void TestStreamDecompressor::testCorruptStream() {
+    if (!StreamDecompressor::IsSupported(StreamDecompressor::Format::Gzip)) {
+        QSKIP("zlib not available in this build");
+    }
+
+    QByteArray corrupt = Gzipped;
+    for (qsizetype i = 12; i < 40; ++i) {
+        corrupt[i] = char(0xff);
+    }
+    QByteArray output;
+    QString error;
+    QVERIFY(!StreamDecompressor::Decode(StreamDecompressor::Format::Gzip, corrupt, output, &error));
+    QVERIFY(!error.isEmpty());
+}
+
+QTEST_MAIN(TestStreamDecompressor)
@@ -19,6 +19,8 @@ private slots:
     void testTextProcessing();
     void testDataConversion();
     void testErrorHandling();
+    void testForEachLine();
+    void testLocalFilePath();
 
 private:
     QTemporaryDir m_tempDir;
@@ -153,4 +155,34 @@ void TestUtils::testErrorHandling() {
     QVERIFY(!Utils::hasError());
 }
 
+void TestUtils::testForEachLine() {
+    const QString path = m_tempDir.filePath("lines.txt");
+    QVERIFY(Utils::writeFile(path, "vmess://a\r\n\n# comment\nss://b"));
+
+    QList<QByteArray> lines;
+    QVERIFY(Utils::forEachLine(path, [&lines](QByteArrayView line) {
+        lines.append(line.toByteArray());
+        return true;
+    }));
+    QCOMPARE(lines, (QList<QByteArray>{"vmess://a", "", "# comment", "ss://b"}));
+
+    // Stopping early is not an error
+    int seen = 0;
+    QVERIFY(Utils::forEachLine(path, [&seen](QByteArrayView) { return ++seen < 2; }));
+    QCOMPARE(seen, 2);
+
+    QCOMPARE(Utils::readFileLines(path), (QStringList{"vmess://a", "# comment", "ss://b"}));
+
+    QVERIFY(!Utils::forEachLine("/non/existent/file", [](QByteArrayView) { return true; }));
+    QVERIFY(Utils::hasError());
+}
+
+void TestUtils::testLocalFilePath() {
+    QVERIFY(Utils::writeFile(m_testFilePath, "x"));
+    QCOMPARE(Utils::localFilePath(QUrl::fromLocalFile(m_testFilePath).toString()), m_testFilePath);
+    QCOMPARE(Utils::localFilePath(m_testFilePath), m_testFilePath);
+    QVERIFY(Utils::localFilePath("https://example.com/sub.txt").isEmpty());
+    QVERIFY(Utils::localFilePath("/non/existent/file").isEmpty());
+}
+
 QTEST_MAIN(TestUtils)
\ No newline at end of file
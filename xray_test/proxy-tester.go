@@ -2,6 +2,7 @@ package main
 
 import (
 	"bufio"
+	"bytes"
 	"context"
 	"encoding/base64"
 	"encoding/json"
@@ -852,6 +853,81 @@ func (pt *ProxyTester) LoadConfigFromCollectorJSON(filePath string) (*ProxyConfi
 		return nil, err
 	}
 
+	return pt.parseCollectorConfig(rawConfig)
+}
+
+// LoadConfigsFromCollectorDocument loads every config of a per-subscription file
+// ({"subscription": ..., "configs": [...]}); a single config object is also accepted
+func (pt *ProxyTester) LoadConfigsFromCollectorDocument(filePath string) ([]ProxyConfig, error) {
+	file, err := os.Open(filePath)
+	if err != nil {
+		return nil, err
+	}
+	defer file.Close()
+
+	var document map[string]interface{}
+	if err := json.NewDecoder(file).Decode(&document); err != nil {
+		return nil, err
+	}
+
+	entries, ok := document["configs"].([]interface{})
+	if !ok {
+		config, err := pt.parseCollectorConfig(document)
+		if err != nil {
+			return nil, err
+		}
+		return []ProxyConfig{*config}, nil
+	}
+
+	configs := make([]ProxyConfig, 0, len(entries))
+	for _, entry := range entries {
+		rawConfig, ok := entry.(map[string]interface{})
+		if !ok {
+			continue
+		}
+		if config, err := pt.parseCollectorConfig(rawConfig); err == nil {
+			configs = append(configs, *config)
+		}
+	}
+	return configs, nil
+}
+
+// LoadConfigsFromCollectorNDJSON streams configs.ndjson (one config object per line),
+// skipping lines that fail to parse or validate
+func (pt *ProxyTester) LoadConfigsFromCollectorNDJSON(filePath string) ([]ProxyConfig, int, error) {
+	file, err := os.Open(filePath)
+	if err != nil {
+		return nil, 0, err
+	}
+	defer file.Close()
+
+	var configs []ProxyConfig
+	skipped := 0
+	reader := bufio.NewReaderSize(file, 256*1024)
+	for {
+		line, err := reader.ReadBytes('\n')
+		if len(bytes.TrimSpace(line)) > 0 {
+			var rawConfig map[string]interface{}
+			if jsonErr := json.Unmarshal(line, &rawConfig); jsonErr != nil {
+				skipped++
+			} else if config, parseErr := pt.parseCollectorConfig(rawConfig); parseErr != nil {
+				skipped++
+			} else {
+				configs = append(configs, *config)
+			}
+		}
+		if err == io.EOF {
+			break
+		}
+		if err != nil {
+			return configs, skipped, err
+		}
+	}
+	return configs, skipped, nil
+}
+
+// parseCollectorConfig maps one ConfigCollector config object onto a ProxyConfig
+func (pt *ProxyTester) parseCollectorConfig(rawConfig map[string]interface{}) (*ProxyConfig, error) {
 	configType, ok := rawConfig["type"].(string)
 	if !ok {
 		return nil, fmt.Errorf("missing or invalid 'type' field")
@@ -902,6 +978,34 @@ func (pt *ProxyTester) LoadConfigFromCollectorJSON(filePath string) (*ProxyConfi
 		config.Password = getString(rawConfig, "password")
 		config.Network = "tcp"
 
+	case "shadowsocksr":
+		config.Protocol = ProtocolShadowsocksR
+		config.Method = getString(rawConfig, "method")
+		config.Password = getString(rawConfig, "password")
+		config.Protocol_Param = getString(rawConfig, "protocol_param")
+		config.Obfs = getString(rawConfig, "obfs")
+		config.ObfsParam = getString(rawConfig, "obfs_param")
+		config.Network = "tcp"
+
+	case "hysteria2":
+		config.Protocol = ProtocolHysteria2
+		config.Password = getString(rawConfig, "password")
+		config.SNI = getString(rawConfig, "sni")
+		config.Obfs = getString(rawConfig, "obfs")
+		config.ObfsParam = getString(rawConfig, "obfs_param")
+		config.Insecure = getBool(rawConfig, "insecure")
+		config.Network = "udp"
+
+	case "tuic":
+		config.Protocol = ProtocolTUIC
+		config.UUID = getString(rawConfig, "uuid")
+		config.Password = getString(rawConfig, "password")
+		config.CongestionCtrl = getString(rawConfig, "congestion_control")
+		config.ALPN = getString(rawConfig, "alpn")
+		config.SNI = getString(rawConfig, "sni")
+		config.Insecure = getBool(rawConfig, "insecure")
+		config.Network = "udp"
+
 	default:
 		return nil, fmt.Errorf("unsupported protocol: %s", configType)
 	}
@@ -930,6 +1034,15 @@ func getStringOrDefault(data map[string]interface{}, key, defaultValue string) s
 	return defaultValue
 }
 
+func getBool(data map[string]interface{}, key string) bool {
+	if val, ok := data[key]; ok {
+		if b, ok := val.(bool); ok {
+			return b
+		}
+	}
+	return false
+}
+
 func getInt(data map[string]interface{}, key string) int {
 	if val, ok := data[key]; ok {
 		switch v := val.(type) {
@@ -2489,31 +2602,51 @@ func main() {
 	log.Printf(" Loading configurations from: %s", configDir)
 	log.Println(strings.Repeat("=", 70))
 
-	// Find all JSON files in Config directory
-	jsonFiles, err := filepath.Glob(filepath.Join(configDir, "*.json"))
-	if err != nil {
-		log.Fatalf("Failed to find config files: %v", err)
-	}
-
-	if len(jsonFiles) == 0 {
-		log.Printf("No JSON config files found in: %s", configDir)
-		log.Println("No working configurations found")
-		return
-	}
-
-	log.Printf("Found %d configuration files", len(jsonFiles))
-
 	// Load all configs
 	var allConfigs []ProxyConfig
 
-	for _, jsonFile := range jsonFiles {
-		config, err := tester.LoadConfigFromCollectorJSON(jsonFile)
+	// Prefer the NDJSON stream written alongside the per-subscription files. With
+	// TEST_ONLY_ADDED set, only configs that are new since the collector's previous
+	// run are tested (added.ndjson, written in incremental mode)
+	ndjsonPath := filepath.Join(configDir, "configs.ndjson")
+	if getEnvBoolOrDefault("TEST_ONLY_ADDED", false) {
+		addedPath := filepath.Join(configDir, "added.ndjson")
+		if _, err := os.Stat(addedPath); err == nil {
+			log.Printf("Testing only configs added since the previous run")
+			ndjsonPath = addedPath
+		}
+	}
+	if _, err := os.Stat(ndjsonPath); err == nil {
+		configs, skipped, err := tester.LoadConfigsFromCollectorNDJSON(ndjsonPath)
 		if err != nil {
-			log.Printf("Failed to load %s: %v", filepath.Base(jsonFile), err)
-			continue
+			log.Printf("Failed to read %s: %v", filepath.Base(ndjsonPath), err)
 		}
-		if config != nil {
-			allConfigs = append(allConfigs, *config)
+		if skipped > 0 {
+			log.Printf("Skipped %d invalid lines in %s", skipped, filepath.Base(ndjsonPath))
+		}
+		allConfigs = configs
+	} else {
+		// Find all JSON files in Config directory
+		jsonFiles, err := filepath.Glob(filepath.Join(configDir, "*.json"))
+		if err != nil {
+			log.Fatalf("Failed to find config files: %v", err)
+		}
+
+		if len(jsonFiles) == 0 {
+			log.Printf("No JSON config files found in: %s", configDir)
+			log.Println("No working configurations found")
+			return
+		}
+
+		log.Printf("Found %d configuration files", len(jsonFiles))
+
+		for _, jsonFile := range jsonFiles {
+			configs, err := tester.LoadConfigsFromCollectorDocument(jsonFile)
+			if err != nil {
+				log.Printf("Failed to load %s: %v", filepath.Base(jsonFile), err)
+				continue
+			}
+			allConfigs = append(allConfigs, configs...)
 		}
 	}
 